@@ -32,7 +32,7 @@ gboolean showPolarCursorInfo( cairo_t *cr, tGridParameters *pGrid, eChannel chan
 
 void     setCairoFontSize( cairo_t *cr, gdouble fSize );
 void     setCairoColor( cairo_t *cr, eColor color );
-void     setTraceColor( cairo_t *cr,gboolean bOverlay, eChannel channel );
+void     setTraceColor( cairo_t *cr, tGlobal *pGlobal, gboolean bOverlay, eChannel channel );
 void     leftJustifiedCairoText(cairo_t *cr, gchar *sLabel, gdouble x, gdouble y);
 void     rightJustifiedCairoText(cairo_t *cr, gchar *sLabel, gdouble x, gdouble y);
 void     centreJustifiedCairoText(cairo_t *cr, gchar *label, gdouble x, gdouble y);
@@ -43,7 +43,7 @@ void     multiLineText( cairo_t *cr, gchar *sLabel, gint nLine, gdouble lineSpac
 		                gdouble x, gdouble y1stLine, tTxtPosn ePos );
 gchar   *engNotation(gdouble value, gint digits, tEngNotation eVariant, gchar **sPrefix);
 gboolean showStimulusInformation (cairo_t *cr, tGridParameters *pGrid, eChannel channel, tGlobal *pGlobal);
-void     showTitleAndTime( cairo_t *cr, tGridParameters *pGrid, gchar *sTitle, gchar *sTime);
+void     showTitleAndTime( cairo_t *cr, tGridParameters *pGrid, tGlobal *pGlobal, gchar *sTitle, gchar *sTime);
 gdouble  calculateSegmentLinearlyInterpolatedResponse( gint nStart, gint nEnd, tChannel *pChannel, gdouble freq );
 
 #define NUM_LOG_GRIDS 10
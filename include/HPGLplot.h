@@ -37,6 +37,53 @@ typedef enum { CHPGL_LINE2PT=0, CHPGL_LINE=1, CHPGL_PEN=2, CHPGL_LINETYPE=3,
 typedef struct {
 		guint16 x, y;
 	} tCoord;
-#define QUANTIZE(x, y) ((gint)(((gdouble)(x)/(y))+1) * y)
 
-gboolean parseHPGL( gchar *sHPGL, tGlobal *pGlobal );
+// The compiled HPGL is accumulated in fixed size chunks (so it is not copied as it grows)
+// and joined once when the plot is complete
+#define HPGL_ARENA_CHUNK_SIZE	16384
+typedef struct {
+	GPtrArray	*chunks;
+	gsize		nUsedInLast;		// bytes used in the last chunk
+	gsize		nTotal;				// bytes in all chunks
+} tHPGLarena;
+
+#define HPGL_MAX_PARAMETERS		8
+#define HPGL_MAX_LABEL			254
+
+typedef enum { eHPGL_MNEMONIC1, eHPGL_MNEMONIC2, eHPGL_PARAMETERS, eHPGL_LABEL } eHPGLparseState;
+
+// Everything needed to parse an HPGL stream, so that more than one can be parsed
+// at a time (see parseHPGLstream)
+typedef struct {
+	// tokenizer
+	eHPGLparseState	state;
+	guint16		mnemonic;						// e.g. HPGL_POSN_ABS
+	gdouble		parameters[ HPGL_MAX_PARAMETERS ];
+	gint		nParameters;
+	gboolean	bInNumber, bNegative;
+	gdouble		number, fractionScale;			// fractionScale is 0.0 before a decimal point
+	gchar		label[ HPGL_MAX_LABEL + 2 ];		// (with two trailing nulls)
+	gint		labelLength;
+	gboolean	bLabelTerminated;				// label ended with HPGL_LINE_TERMINATOR_CHARACTER
+
+	// plotter
+	tCoord		posn;
+	gboolean	bPenDown, bNewPosition;
+	GArray		*currentLine;					// tCoord of the line being drawn
+	gfloat		charSizeX, charSizeY;
+	gint		lineType, colour;
+	gint		scaleX, scaleY, scalePtX, scalePtY;
+
+	// show a scan arrow rather than "Hld" for a channel not in hold
+	gboolean	bScanArrowUpper, bScanArrowLower;
+	gboolean	bPresumedEnd;					// pen 0 (white) was selected
+	guint		nCommands;
+
+	tHPGLarena	arena;
+} tHPGLparser;
+
+void     initHPGLparser( tHPGLparser *pParser, tGlobal *pGlobal );
+gboolean parseHPGLstream( tHPGLparser *pParser, const gchar *pHPGL, gsize length );
+void    *finishHPGLparser( tHPGLparser *pParser );
+void     freeHPGLparser( tHPGLparser *pParser );
+gint     benchmarkHPGLparser( gchar **sFiles, gint nRepeat );
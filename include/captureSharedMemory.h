@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2026 Michael G. Katzmann
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/*
+ * Layout of the shared memory object (/hp8753-capture) to which each completed
+ * capture is published (see captureSharedMemory.c).
+ *
+ * Only fixed size types are used so that other processes (and languages) can map it.
+ *
+ * To read the latest capture:
+ *   1. index = header.latest % header.nSlots  (header.latest is 0 until the first capture)
+ *   2. s1 = slot.seqlock (acquire); if odd, the slot is being written, retry
+ *   3. copy the slot
+ *   4. s2 = slot.seqlock (after an acquire fence); if s1 != s2 the copy is torn, retry
+ */
+
+#ifndef CAPTURESHAREDMEMORY_H_
+#define CAPTURESHAREDMEMORY_H_
+
+#include <stdint.h>
+
+#define CAPTURE_SHM_NAME        "/hp8753-capture"
+#define CAPTURE_SHM_MAGIC       0x33353738      // "8753" in memory (little endian)
+#define CAPTURE_SHM_VERSION     1
+#define CAPTURE_SHM_SLOTS       4
+#define CAPTURE_SHM_MAX_POINTS  1601
+#define CAPTURE_SHM_CHANNELS    2
+#define CAPTURE_SHM_MARKERS     5
+
+typedef struct {
+    int32_t     nPoints;                // 0 if the channel has no data
+    int32_t     format;                 // tFormat
+    int32_t     sweepType;              // tSweepType
+    uint32_t    markersOn;              // bit n set if marker n+1 is on
+    double      markers[ CAPTURE_SHM_MARKERS ][3];      // stimulus, real, imaginary
+    double      stimulus[ CAPTURE_SHM_MAX_POINTS ];
+    double      response[ CAPTURE_SHM_MAX_POINTS ][2];  // real, imaginary
+} tCaptureShmChannel;
+
+typedef struct {
+    uint32_t    seqlock;                // odd while the slot is being written
+    uint32_t    sequence;               // of the GPIB command that made the capture
+    uint64_t    captureNumber;          // 1 for the first capture published
+    int64_t     timeStamp;              // µs since the epoch
+    char        dateTime[ 32 ];         // as shown on the plot
+    uint32_t    bDualChannel;
+    uint32_t    reserved;
+    tCaptureShmChannel channels[ CAPTURE_SHM_CHANNELS ];
+} tCaptureShmSlot;
+
+typedef struct {
+    uint32_t    magic;
+    uint32_t    version;
+    uint32_t    nSlots;
+    uint32_t    slotSize;               // sizeof( tCaptureShmSlot )
+    uint64_t    latest;                 // captureNumber of the newest complete slot
+    uint64_t    reserved[3];
+    tCaptureShmSlot slots[ CAPTURE_SHM_SLOTS ];
+} tCaptureShm;
+
+#endif /* CAPTURESHAREDMEMORY_H_ */
@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2026 Michael G. Katzmann
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/*
+ * Exports (PDF, SVG & PNG files and printing) are rendered on worker threads
+ * from a snapshot of the traces (see exportWorker.c).
+ */
+
+#ifndef EXPORTWORKER_H_
+#define EXPORTWORKER_H_
+
+typedef struct _tExport tExport;
+typedef struct _tExportJob tExportJob;
+
+// One file (or printed page) of an export
+struct _tExportJob {
+	tExport		*pExport;
+	gint		(*render)( tExportJob * );				// on a worker thread (returns OK or ERROR)
+	void		(*complete)( tGlobal *, tExportJob * );	// then in the main loop (or NULL)
+
+	gchar		*sFilename;				// file written (freed with the job)
+	tFileType	fileType;
+	gint		page;					// page to print
+	gdouble		width, height;			// of the printed page
+	gpointer	pPrintContext;			// GtkPrintContext (referenced)
+	cairo_surface_t *pRecording;		// printed page rendered by the worker
+
+	gint		status;					// returned by render
+};
+
+// The jobs rendering one capture
+struct _tExport {
+	tGlobal		*pSnapshot;				// the traces and plot options (never changed once taken)
+	gchar		*sName;					// shown in the progress messages (or NULL)
+	gint		bCancel;				// (atomic) the jobs not yet started are skipped
+	guint		nJobs, nComplete, nFailed;
+	gboolean	bReleased;				// by the owner .. freed when the jobs are complete
+	GtkPrintOperation *pPrintOp;		// if printing (cancelled with the export)
+};
+
+tExport    *newExport			( tGlobal *pGlobal, const gchar *sName );
+void        queueExportJob		( tExport *pExport, tExportJob *pJob );
+void        releaseExport		( tExport *pExport );
+void        exportJobComplete	( tGlobal *pGlobal, tExportJob *pJob );
+gboolean    isExportCancelled	( tExport *pExport );
+gint        cancelExports		( void );
+void        stopExportWorkers	( void );
+tGlobal    *snapshotTraces		( tGlobal *pGlobal );
+void        snapshotPlotOptions	( tGlobal *pSnapshot, tGlobal *pGlobal );
+void        freeTraceSnapshot	( tGlobal *pSnapshot );
+
+#endif /* EXPORTWORKER_H_ */
@@ -143,6 +143,13 @@ typedef enum { eA4 = 0, eLetter = 1, eA3 = 2, eTabloid = 3, eNumPaperSizes = 4 }
 
 typedef enum { ePDF, eSVG, ePNG, eCSV } tFileType;
 
+// Requests that can be made of a running instance (see automation.c)
+typedef enum {
+    eAUTO_GET_TRACE, eAUTO_GET_SETUPandCAL, eAUTO_RESTORE_SETUPandCAL,
+    eAUTO_CAPTURE_S2P, eAUTO_CAPTURE_S1P, eAUTO_SAVE_TRACE, eAUTO_EXPORT,
+    eAUTO_NUM_COMMANDS
+} tAutomationCommand;
+
 extern const tGrid gridType[];
 
 #define MKR_FREQ		0
@@ -165,6 +172,15 @@ typedef struct {
 	gdouble startFreq, stopFreq;
 } tSegment;
 
+#define MAX_SEGMENTS	30
+// Derived from the segments of a list frequency sweep (see indexSegments)
+typedef struct {
+	gint	nSegments;							// number of segments indexed
+	gint	firstPoint[ MAX_SEGMENTS + 1 ];		// first sample of each segment (and one after the last)
+	gint	byStart[ MAX_SEGMENTS ];			// segment numbers in order of start frequency
+	gdouble	maxStop[ MAX_SEGMENTS ];			// highest stop frequency of byStart[0] to byStart[n]
+} tSegmentIndex;
+
 // This must match the positions in optMeasurementType
 #define S11_MEAS  0
 #define S22_MEAS  3
@@ -203,9 +219,17 @@ typedef struct {
 	guint iNumSegments [2]; // number of segments defined
 } tLearnStringIndexes;
 
+// Samples of a trace kept when it is drawn on fewer pixel columns than it has points
+typedef struct {
+	gint	nColumns;				// pixel columns of the grid
+	GArray	*indexes;				// guint indexes of the samples kept (or NULL)
+} tDecimatedTrace;
+
 typedef struct {
 	tComplex *responsePoints;
 	gdouble  *stimulusPoints;
+	tComplex *splineControlPoints;	// Bezier control points (see getSplineControlPoints)
+	tDecimatedTrace decimated;		// min/max envelope of the trace (see decimateTrace)
 	struct {
 		guint32 bSweepHold      : 1;
 		guint32 bValidData      : 1;
@@ -244,9 +268,9 @@ typedef struct {
 	gdouble scaleRefPos;
 	gdouble scaleRefVal;
 
-#define MAX_SEGMENTS	30
 	gint nSegments;
 	tSegment segments[MAX_SEGMENTS];
+	tSegmentIndex segmentIndex;
 
 	tMeasurement measurementType;
 } tChannel;
@@ -301,6 +325,7 @@ typedef struct {
 	// compiled HPGL plot data
 	// initial integer is the length of the malloced data
 	void *plotHPGL;
+	guint HPGLgeneration;		// changed whenever plotHPGL is replaced (see plotScreen)
 	tS2P S2P;
 
 	tLearnStringIndexes analyzedLSindexes;
@@ -366,6 +391,21 @@ typedef struct {
 	tProjectAndName     projectAndName;
 } tHP8753traceAbstract;
 
+typedef struct {
+	GHashTable *        pIndex;         // "project<ETX>name" -> item
+	GHashTable *        pProjects;      // project -> GtkStringList of names (sorted)
+	GHashTable *        pLoaded;        // projects whose profiles have been read from the database
+	gsize               projectAndNameOffset;
+} tCatalog;
+
+typedef struct {
+	gchar *             sProject;
+	gchar *             sName;
+	gchar *             sTitle;
+	gchar *             sNote;
+	gchar *             sDateTime;
+} tProfileSearchRow;
+
 typedef struct {
     gdouble x, y;
 } tCoordinate;
@@ -428,15 +468,25 @@ typedef struct {
 	GList *             pCalList;		// list containing tHP8753cal objects
 	GList *             pTraceList;		// list containing tHP8753traceAbstract objects
 	GList *             pCalKitList;
+	tCatalog            calCatalog;     // index of pCalList
+	tCatalog            traceCatalog;   // index of pTraceList
 
 	GThread *           pGThread;
 
 	tComplex            mousePosition[ eNUM_CH ];
 	gdouble             mouseXpercentHeld;
 
+	// colors to plot with (the color tables, or a copy of them in a snapshot)
+	GdkRGBA *           plotElementColors;
+	GdkRGBA *           HPGLpens;
+	gboolean            bSnapshot;      // a copy of the traces drawn off screen (see snapshotTraces)
+
     gpointer            widgets[eW_N_WIDGETS];
 } tGlobal;
 
+// called when a request queued with queueAutomationCommand completes
+typedef void (*tAutomationDone)( tGlobal *, gboolean, const gchar *, gpointer );
+
 
 
 typedef union {
@@ -483,14 +533,22 @@ typedef struct {
 
 	gdouble textMargin;
 	gdouble makerAreaWidth;
+	gdouble maxYlabelWidth;		// widest y label of the Cartesian grid(s) drawn
 
 	gdouble fontSize;
 	gdouble lineSpacing;
 	gdouble scale;
+	guint   layers;			// PLOT_LAYER_ bits to draw
 
 	cairo_matrix_t initialMatrix;
 } tGridParameters;
 
+// The static layer of the screen plots is cached so that moving the live marker
+// only redraws the live layer over it
+#define PLOT_LAYER_STATIC	0x01	// grid, annotation, traces and markers
+#define PLOT_LAYER_LIVE		0x02	// live marker and its values
+#define PLOT_LAYER_ALL		(PLOT_LAYER_STATIC | PLOT_LAYER_LIVE)
+
 typedef struct {
     guint   height, width;
     gdouble margin;
@@ -546,6 +604,7 @@ void        buildWidgetList                     ( tGlobal *,  GtkBuilder * );
 
 void        initializeMainDialog                ( tGlobal *, tInitFn );
 void        initializeRenameDialog              ( tGlobal *, tInitFn );
+void        initializeProfileBrowser            ( tGlobal *, tInitFn );
 void        initializeNotebookPageCalibration   ( tGlobal *, tInitFn );
 void        initializeNotebookPageTraces        ( tGlobal *, tInitFn );
 void        initializeNotebookPageData          ( tGlobal *, tInitFn );
@@ -554,6 +613,8 @@ void        initializeNotebookPageGPIB          ( tGlobal *, tInitFn );
 void        initializeNotebookPageCalKit        ( tGlobal *, tInitFn );
 void        initializeNotebookPageColor         ( tGlobal *, tInitFn );
 
+struct sqlite3;     // database connection (sqlite3.h)
+
 void        CB_DR_RenameResponse                ( GtkDialog *, gint, gpointer );
 void        CB_DR_RenameShow                    ( GtkDialog *, gint, gpointer );
 void        CB_DR_radioTarget                   ( GtkCheckButton *, gpointer );
@@ -581,10 +642,25 @@ void        CB_drawingArea_A_Draw               ( GtkDrawingArea *, cairo_t *, g
 void        CB_drawingArea_B_Draw               ( GtkDrawingArea *, cairo_t *, gint, gint, gpointer );
 
 void        cairo_renderHewlettPackardLogo      ( cairo_t *, gboolean, gboolean, gdouble, gdouble );
+void        broadcastLiveView                   ( tGlobal * );
+void        catalogAdd                          ( tCatalog *, gpointer );
+void        catalogFree                         ( tCatalog * );
+gboolean    catalogIsProjectLoaded              ( tCatalog *, const gchar * );
+gpointer    catalogLookup                       ( tCatalog *, const gchar *, const gchar * );
+gpointer    catalogNthInProject                 ( tCatalog *, const gchar *, guint );
+guint       catalogProjectCount                 ( tCatalog *, const gchar * );
+GListModel* catalogProjectModel                 ( tCatalog *, const gchar * );
+void        catalogRebuild                      ( tCatalog *, GList * );
+void        catalogRemove                       ( tCatalog *, gpointer );
+void        catalogSetProjectLoaded             ( tCatalog *, const gchar * );
 gint        checkMessageQueue                   ( GAsyncQueue * );
 void        clearHP8753traces                   ( tHP8753 * );
+void        clearHPGLrecording                  ( void );
+void        clearDerivedTraceData               ( tChannel * );
+void        clearSplineControlPoints            ( tChannel * );
 tHP8753cal* cloneCalibrationProfile             ( tHP8753cal *, gchar * );
 tHP8753traceAbstract*   cloneTraceProfileAbstract( tHP8753traceAbstract *, gchar * );
+void        closeCaptureSharedMemory            ( void );
 void        closeDB                             ( void );
 
 gint        compareCalItemsForFind              ( gpointer , gpointer );
@@ -596,39 +672,73 @@ gint        compareTraceItemsForSort            ( gpointer , gpointer );
 GList*      createIconList                      ( void );
 guint       deleteDBentry                       ( tGlobal *, gchar *, gchar *, tDBtable );
 gchar*      doubleToStringWithSpaces            ( gdouble, gchar * );
-void        drawBezierSpline                    ( cairo_t *, const tComplex *, gint );
+void        drawBezierSpline                    ( cairo_t *, const tComplex *, const tComplex *, gint );
 void        drawHPlogo                          ( cairo_t *, gchar *, gdouble , gdouble , gdouble );
+void        drawPlotFilePage                    ( cairo_t *, tGlobal *, tFileType, gint );
 void        drawMarkers                         ( cairo_t *, tGlobal *, tGridParameters *, eChannel , gdouble, gdouble );
 gchar*      engNotation                         ( gdouble, gint, tEngNotation, gchar ** );
+void        exportPlotFile                      ( tGlobal *, const gchar *, tFileType );
+void        finalizeAutomation                  ( tGlobal * );
+tProfileSearchRow*  fetchProfileSearchRow       ( gint64 );
+guchar*     fetchTraceThumbnail                 ( gint64, gsize * );
+gint        findSegment                         ( tChannel *, gdouble );
 void        flipCairoText                       ( cairo_t * );
 gint        getTimeStamp                        ( gchar ** );
+gdouble*    getStimulusPoints                   ( tChannel * );
+tSegmentIndex*  getSegmentIndex                 ( tChannel * );
+tComplex*   getSplineControlPoints              ( tChannel * );
 void        freeCalListItem                     ( gpointer );
 void        freeCalKitIdentifierItem            ( gpointer );
+void        freeProfileSearchRow                ( gpointer );
 void        freeTraceListItem                   ( gpointer );
+void        indexSegments                       ( tChannel * );
+void        initializeAutomation                ( tGlobal *, GApplication * );
 void        initializeFORM1exponentTable        ( void );
+void        invalidatePlotCache                 ( void );
+gint        inventoryProject                    ( tGlobal *, const gchar * );
 gint        inventoryProjects                   ( tGlobal * );
 gint        inventorySavedCalibrationKits       ( tGlobal * );
 gint        inventorySavedSetupsAndCal          ( tGlobal * );
 guint       inventorySavedTraceNames            ( tGlobal * );
 void        logVersion                          ( void );
+gint        openCaptureSharedMemory             ( void );
 gint        openOrCreateDB                      ( void ) ;
+struct sqlite3* openReadOnlyDBconnection        ( void );
 gboolean    plotA                               ( guint, guint, gdouble, cairo_t *, tGlobal * );
 gboolean    plotB                               ( guint, guint, gdouble, cairo_t *, tGlobal * );
+gint        plotFilePageCount                   ( tGlobal * );
+gchar*      plotFilePageName                    ( const gchar *, tFileType, gint, gint );
+void        plotFilePageSize                    ( tGlobal *, tFileType, gdouble *, gdouble * );
 gint        populateCalComboBoxWidget           ( tGlobal * );
 gint        populateProjectComboBoxWidget       ( tGlobal * );
 gint        populateTraceComboBoxWidget         ( tGlobal * );
+void        publishCaptureToSharedMemory        ( tGlobal *, guint );
+void        populateTraceHistoryWidget          ( tGlobal * );
+void        projectArchiveComplete              ( tGlobal *, gpointer );
+void        queueLiveMarkerDraw                 ( tGlobal *, gdouble, gdouble );
+void        queueAutomationCommand              ( tGlobal *, tAutomationCommand, const gchar *, tAutomationDone, gpointer );
+gchar**     queryTraceHistory                   ( const gchar *, const gchar *, const gchar *, const gchar * );
 gint        recoverCalibrationAndSetup          ( tGlobal *, gchar *, gchar * );
 gint        recoverCalibrationKit               ( tGlobal *, gchar * );
 gint        recoverProgramOptions               ( tGlobal * );
 gint        recoverTraceData                    ( tGlobal *, gchar *, gchar * );
+gint        recoverTraceDataFromDB              ( struct sqlite3 *, tGlobal *, const gchar *, const gchar * );
+gint        recoverTraceHistory                 ( tGlobal *, const gchar *, const gchar *, const gchar * );
+gint        renderProject                       ( tGlobal *, const gchar *, tFileType, const gchar *, const gchar * );
+guchar*     renderTraceThumbnail                ( tGlobal *, gsize * );
 gint        renameMoveCopyDBitems               (tGlobal *, tRMCtarget, tRMCpurpose, gchar *, gchar *, gchar *);
 void        rightJustifiedCairoText             ( cairo_t *, gchar *, gdouble, gdouble );
+gint        runBatchJobs                        ( tGlobal *, const gchar *, gboolean );
+gint        runRenderBenchmark                  ( tGlobal *, const gchar * );
 gint        saveCalibrationAndSetup             ( tGlobal *, gchar *, gchar * );
 gint        saveCalKit                          ( tGlobal * );
+void        saveGeneratedThumbnail              ( tGlobal *, gpointer );
 gint        saveLearnStringAnalysis             ( tGlobal *, tLearnStringIndexes * );
 gint        saveProgramOptions                  ( tGlobal * );
 tHP8753cal* selectCalibrationProfile            ( tGlobal *, gchar *, gchar * );
 gint        saveTraceData                       ( tGlobal *, gchar *, gchar * );
+gint        saveTraceProfile                    ( tGlobal *, gchar * );
+gchar**     searchProfiles                      ( tDBtable, const gchar *, const gchar *, gboolean );
 tHP8753cal* selectFirstCalibrationProfileInProject      ( tGlobal * );
 tHP8753traceAbstract*   selectFirstTraceProfileInProject( tGlobal * );
 tHP8753traceAbstract*   selectTraceProfile              ( tGlobal *, gchar *, gchar * );
@@ -640,12 +750,25 @@ gboolean    setGtkComboBox                      ( GtkComboBox *, gchar * );
 gint        setNotePageColorButton              ( tGlobal *, gboolean );
 void        setUseGPIBcardNoAndPID              ( tGlobal *, gboolean );
 void        showCalInfo                         ( tHP8753cal *, tGlobal * );
+void        showProjectArchiveResult            ( tGlobal *, gboolean, const gchar *, gint );
 void        showRenameMoveCopyDialog            ( tGlobal * );
 gint        smithHighResPDF                     ( tGlobal *, gchar *, eChannel );
-gint        splineInterpolate                   ( gint, tComplex [], gdouble, tComplex * );
+gint        startLiveViewServer                 ( tGlobal *, gint );
+gint        startProjectArchive                 ( gboolean, const gchar *, const gchar * );
+gint        startSocketServer                   ( tGlobal *, gboolean, gint );
+void        startThumbnailGeneration            ( void );
+void        stopLiveViewServer                  ( void );
+void        stopSocketServer                    ( void );
+gint        splineInterpolate                   ( gint, tComplex [], const tComplex [], gdouble, tComplex * );
 gpointer    threadGPIB                          ( gpointer );
 void        updateCalComboBox                   ( gpointer , gpointer );
 void        visibilityFramePlot_B               ( tGlobal *, gint );
+gint        writeCSVfile                        ( tGlobal *, const gchar * );
+gint        writeHighResSmithFile               ( tGlobal *, const gchar * );
+gint        writePlotFile                       ( tGlobal *, const gchar *, tFileType );
+gint        writePlotPages                      ( tGlobal *, const gchar *, tFileType, gint * );
+gint        writeS1Pfile                        ( tGlobal *, const gchar * );
+gint        writeS2Pfile                        ( tGlobal *, const gchar * );
 
 gint        splashCreate                        (tGlobal *pGlobal);
 gint        splashDestroy                       (tGlobal *pGlobal);
@@ -729,7 +852,7 @@ g_memdup2(gconstpointer mem, gsize byte_size) {
 	if( globalData.flags.bbDebug >= level ) \
 		LOG( G_LOG_LEVEL_DEBUG, message, ## __VA_ARGS__)
 
-#define CURRENT_DB_SCHEMA	2
+#define CURRENT_DB_SCHEMA	6
 // This character separates project name from item name in database
 // ... its more complicated to ensure compatability with older database schemas
 #define ETX 0x03
@@ -36,6 +36,10 @@ enum _threadmessage
 	TM_SAVE_LEARN_STRING_ANALYSIS,		// save analyzed learn string indexes
 	TM_SAVE_S1P,						// save calibration and setup to database
 	TM_SAVE_S2P,
+	TM_SAVE_THUMBNAIL,					// draw and save the thumbnail of a recovered trace
+	TM_NEW_CAPTURE,						// trace(s) and markers of a capture are complete
+	TM_EXPORT_COMPLETE,					// an export job is complete (see exportWorker.c)
+	TM_PROJECT_ARCHIVE_COMPLETE,		// a project archive has been exported or imported
 	TG_SETUP_GPIB,						// configure GPIB
 	TG_RETRIEVE_SETUPandCAL_from_HP8753,// get current calibration and setup
 	TG_SEND_SETUPandCAL_to_HP8753,		// restore calbration and setup
@@ -56,16 +60,20 @@ typedef struct
     gchar *		sMessage;
     void  *		data;
     gint		dataLength;
+    guint		sequence;			// of a command to the GPIB thread (returned on TM_COMPLETE_GPIB)
+    gboolean	bFromGPIBthread;	// posted by the GPIB thread
 } messageEventData;
 
 
 extern GSourceFuncs 	messageEventFunctions;
 
 
+void automationMessage (tGlobal *pGlobal, messageEventData *message);
+void automationSaveResult (gboolean bSaved, const gchar *sError);
 void postMessageToMainLoop (enum _threadmessage Command, gchar *sMessage);
 void postInfoWithCount(gchar *sMessageWithFormat, gint number, gint number2);
 void postDataToMainLoop (enum _threadmessage Command, void *data);
-void postDataToGPIBThread (enum _threadmessage Command, void *data);
+guint postDataToGPIBThread (enum _threadmessage Command, void *data);
 
 #define postInfo(x)		postMessageToMainLoop( TM_INFO, (x) )
 #define postError(x)	{ postMessageToMainLoop( TM_ERROR, (x) ); LOG( G_LOG_LEVEL_CRITICAL, (x) ); }
@@ -41,6 +41,7 @@ typedef enum {
     eW_nbTrace_buf_Title,
     eW_nbTrace_box_PlotType,
     eW_nbTrace_lbl_Time,
+    eW_nbTrace_dd_History,
     eW_nbTrace_rbtn_PlotTypeHighRes,
     eW_nbTrace_rbtn_PlotTypeHPGL,
     eW_nbTrace_txtV_TraceNote,
@@ -57,6 +58,8 @@ typedef enum {
     eW_nbOpts_cbtn_ShowHPlogo,
     eW_nbOpts_btn_AnalyzeLS,
     eW_nbOpts_lbl_Firmware,
+    eW_nbOpts_btn_ExportProject,
+    eW_nbOpts_btn_ImportProject,
     eW_nbOpts_rbtn_PDF_A4,
     eW_nbOpts_rbtn_PDF_LTR,
     eW_nbOpts_rbtn_PDF_A3,
@@ -127,6 +130,14 @@ typedef enum {
     eW_DR_lbl_From,
     eW_DR_lbl_To,
 
+    // Profile browser
+    eW_dlg_Browse,
+    eW_PB_search_Text,
+    eW_PB_chk_ThisProject,
+    eW_PB_chk_ByDate,
+    eW_PB_cv_Profiles,
+    eW_PB_lbl_Count,
+
     eW_Splash,
     eW_lbl_Version,
 
@@ -391,7 +391,7 @@ threadGPIB(gpointer _pGlobal) {
                 if ((pGlobal->HP8753.firmwareVersion = get8753firmwareVersion( &GPIB_HP8753,
                         &pGlobal->HP8753.sProduct )) == INVALID) {
                     postError("Cannot query identity - cannot proceed");
-                    postMessageToMainLoop(TM_COMPLETE_GPIB, NULL);
+                    postDataToMainLoop(TM_COMPLETE_GPIB, GUINT_TO_POINTER( message->sequence ));
                     GPIBtimeout( &GPIB_HP8753, T1s, &currentTimeout, eTMO_RESTORE );
                     continue;
                 }
@@ -400,7 +400,7 @@ threadGPIB(gpointer _pGlobal) {
             // This must be an 8753 otherwise all bets are off
             if (strncmp("8753", pGlobal->HP8753.sProduct, 4) != 0) {
                 postError("Not an HP8753 - cannot proceed");
-                postMessageToMainLoop(TM_COMPLETE_GPIB, NULL);
+                postDataToMainLoop(TM_COMPLETE_GPIB, GUINT_TO_POINTER( message->sequence ));
                 pGlobal->HP8753.firmwareVersion = 0;
                 GPIBtimeout( &GPIB_HP8753, T1s, &currentTimeout, eTMO_RESTORE );
                 continue;
@@ -551,6 +551,18 @@ threadGPIB(gpointer _pGlobal) {
                 if (GPIBfailed( GPIB_HP8753.status ))
                     break;
 
+                // The stimulus values (known now that any list segments have been read) are filled
+                // here, before the capture is published or drawn, so that they are never allocated
+                // by the readers of the channels (the plots and live view on the main loop)
+                for( eChannel channel = eCH_ONE; channel < eNUM_CH; channel++ ) {
+                    if( pGlobal->HP8753.channels[ channel ].chFlags.bValidData )
+                        getStimulusPoints( &pGlobal->HP8753.channels[ channel ] );
+                }
+
+                // make it available to other processes (if enabled)
+                publishCaptureToSharedMemory( pGlobal, message->sequence );
+                postDataToMainLoop(TM_NEW_CAPTURE, NULL);
+
                 // Display the new data
                 if( !pGlobal->HP8753.flags.bShowHPGLplot )
                     postDataToMainLoop(TM_REFRESH_TRACE, eCH_ONE);
@@ -765,7 +777,7 @@ threadGPIB(gpointer _pGlobal) {
         if (GPIBfailed( GPIB_HP8753.status )) {
             postError("GPIB error or timeout");
         }
-        postMessageToMainLoop(TM_COMPLETE_GPIB, NULL);
+        postDataToMainLoop(TM_COMPLETE_GPIB, GUINT_TO_POINTER( message->sequence ));
 
         g_free(message->sMessage);
         g_free(message->data);
@@ -26,6 +26,7 @@
 
 #include "hp8753.h"
 #include "messageEvent.h"
+#include "exportWorker.h"
 
 // Blast ... the combobox is deprecated without a suitable replacement
 #pragma GCC diagnostic push
@@ -199,6 +200,7 @@ CB_KeyPressed (GtkEventControllerKey *self, guint keyval, guint keycode,
            switch ( state & (GDK_SHIFT_MASK | GDK_CONTROL_MASK | GDK_ALT_MASK | GDK_SUPER_MASK) ) {
            default:
                     postDataToGPIBThread (TG_ABORT, NULL);
+                    cancelExports();
                     break;
            case GDK_SHIFT_MASK:
                     postDataToGPIBThread (TG_SETUP_GPIB, NULL);
@@ -258,7 +260,7 @@ void CB_on_drawingAreaMouseMotion ( GtkEventControllerMotion* eventGesture, gdou
 {
     GtkDrawingArea *wDrawingArea= GTK_DRAWING_AREA( gtk_event_controller_get_widget( GTK_EVENT_CONTROLLER( eventGesture ) ));
     tGlobal *pGlobal = (tGlobal *)g_object_get_data(G_OBJECT(gtk_widget_get_root(GTK_WIDGET(wDrawingArea))), "data");
-
+    gdouble xOld = pGlobal->mousePosition[ eCH_ONE ].r;
 
     for( gint channel=0; channel < MAX_CHANNELS; channel++ )
         switch ( GPOINTER_TO_INT( action ) ) {
@@ -275,8 +277,8 @@ void CB_on_drawingAreaMouseMotion ( GtkEventControllerMotion* eventGesture, gdou
             break;
         }
 
-    gtk_widget_queue_draw ( GTK_WIDGET( pGlobal->widgets[ eW_drawingArea_Plot_A ] ) );
-    gtk_widget_queue_draw ( GTK_WIDGET( pGlobal->widgets[ eW_drawingArea_Plot_B ] ) );
+    // only the live marker changes (the cached grid and traces are not redrawn)
+    queueLiveMarkerDraw( pGlobal, xOld, pGlobal->mousePosition[ eCH_ONE ].r );
 }
 
 /*!     \brief  Callback from "Get Trace" button
@@ -298,6 +300,7 @@ CB_btn_GetTrace (GtkButton *wButton, gpointer udata)
         gtk_check_button_set_active( GTK_CHECK_BUTTON( pGlobal->widgets[ eW_nbTrace_rbtn_PlotTypeHighRes ] ), TRUE);
         g_free( pGlobal->HP8753.plotHPGL );
         pGlobal->HP8753.plotHPGL = NULL;
+        pGlobal->HP8753.HPGLgeneration++;
     }
     postDataToGPIBThread (TG_RETRIEVE_TRACE_from_HP8753, NULL);
     gtk_widget_set_sensitive (GTK_WIDGET( pGlobal->widgets[ eW_box_SaveRecallDelete ] ), FALSE);
@@ -346,6 +349,28 @@ sensitizeRecallSaveDeleteButtons( tGlobal *pGlobal ) {
     return bFound;
 }
 
+/*!     \brief  Read the profiles of the chosen project (if not already read)
+ *
+ * Called when the project is chosen from the dropdown box, or when its name has been
+ * typed and is entered or the entry loses focus .. not on each keystroke.
+ * Only a project in the database is read.
+ *
+ * \param  pGlobal  pointer to global data
+ */
+static void
+loadChosenProject( tGlobal *pGlobal )
+{
+    if( pGlobal->sProject == NULL
+            || !g_list_find_custom( pGlobal->pProjectList, pGlobal->sProject, (GCompareFunc)strcmp )
+            || ( catalogIsProjectLoaded( &pGlobal->calCatalog, pGlobal->sProject )
+                    && catalogIsProjectLoaded( &pGlobal->traceCatalog, pGlobal->sProject ) ) )
+        return;
+
+    inventoryProject( pGlobal, pGlobal->sProject );
+    populateCalComboBoxWidget( pGlobal );
+    populateTraceComboBoxWidget( pGlobal );
+}
+
 /*!     \brief  Callback when user selects a new project from the dropdown box
  *
  * Callback (MD6) when user selects a new project from the dropdown box
@@ -363,8 +388,9 @@ CB_cbt_ProjectName( GtkComboBoxText *wComboBoxProject, gpointer udata )
     GtkWidget *wTraceCombo = GTK_WIDGET( pGlobal->widgets[ eW_cbt_TraceProfile ] );
     gchar *sProfileName = NULL;
 
-    if( n != INVALID ) {
-    }
+    // the entry (and so pGlobal->sProject) has already been changed to the project chosen
+    if( n != INVALID )
+        loadChosenProject( pGlobal );
     GtkCheckButton *wRadioCal = GTK_CHECK_BUTTON( pGlobal->widgets[ eW_rbtn_Cal ] );
     GtkNotebook *wNotebook = GTK_NOTEBOOK(  pGlobal->widgets[ eW_notebook ] );
 
@@ -414,6 +440,7 @@ CB_editable_ProjectName( GtkEditable *wEditable, gpointer udata )
         pGlobal->sProject = (gchar *)0;
         g_free( pProjectName );
     }
+    // the profiles of a project are read when it is chosen (see loadChosenProject)
     populateCalComboBoxWidget( pGlobal );
     populateTraceComboBoxWidget( pGlobal );
 }
@@ -431,18 +458,12 @@ CB_cbt_CalibrationProfileName (GtkComboBoxText *wCalSelection, gpointer udata )
     tGlobal *pGlobal = (tGlobal *)g_object_get_data(G_OBJECT( wCalSelection ), "data");
 
     gchar *sCalProfileName = NULL;
-    tProjectAndName *pProjectAndName;
+    tHP8753cal *pCal;
     sCalProfileName = gtk_combo_box_text_get_active_text(wCalSelection);
-    for( GList *l = pGlobal->pCalList; l != NULL; l = l->next ){
-        pProjectAndName = &((tHP8753cal *)l->data)->projectAndName;
-
-        if( g_strcmp0(  pProjectAndName->sProject, pGlobal->sProject ) == 0 ) {
-            pProjectAndName->bbFlags.bSelected = FALSE;
-            if( g_strcmp0(  pProjectAndName->sName, sCalProfileName ) == 0 ) {
-                pProjectAndName->bbFlags.bSelected = TRUE;
-            }
-        }
-    }
+    for( guint i = 0; (pCal = catalogNthInProject( &pGlobal->calCatalog, pGlobal->sProject, i )) != NULL; i++ )
+        pCal->projectAndName.bbFlags.bSelected = FALSE;
+    if( (pCal = catalogLookup( &pGlobal->calCatalog, pGlobal->sProject, sCalProfileName )) != NULL )
+        pCal->projectAndName.bbFlags.bSelected = TRUE;
     g_free( sCalProfileName );
 }
 
@@ -512,21 +533,14 @@ CB_cbt_TraceProfileName( GtkComboBoxText *wTraceSelection, gpointer udata )
 {
     tGlobal *pGlobal = (tGlobal *)g_object_get_data(G_OBJECT( wTraceSelection ), "data");
 
-    tProjectAndName *pProjectAndName;
+    tHP8753traceAbstract *pTraceAbstract;
     gchar *sTraceProfileName = NULL;
     sTraceProfileName = gtk_combo_box_text_get_active_text(wTraceSelection);
 
-    for( GList *l = pGlobal->pTraceList; l != NULL; l = l->next ){
-        pProjectAndName = &(((tHP8753traceAbstract *)(l->data))->projectAndName);
-
-        if( g_strcmp0(  pProjectAndName->sProject, pGlobal->sProject ) == 0 ) {
-            pProjectAndName->bbFlags.bSelected = FALSE;
-
-            if( g_strcmp0(  pProjectAndName->sName, sTraceProfileName ) == 0 ) {
-                pProjectAndName->bbFlags.bSelected = TRUE;
-            }
-        }
-    }
+    for( guint i = 0; (pTraceAbstract = catalogNthInProject( &pGlobal->traceCatalog, pGlobal->sProject, i )) != NULL; i++ )
+        pTraceAbstract->projectAndName.bbFlags.bSelected = FALSE;
+    if( (pTraceAbstract = catalogLookup( &pGlobal->traceCatalog, pGlobal->sProject, sTraceProfileName )) != NULL )
+        pTraceAbstract->projectAndName.bbFlags.bSelected = TRUE;
     g_free( sTraceProfileName );
 }
 
@@ -759,6 +773,72 @@ CB_adlg_Remove_choice( GObject *source_object, GAsyncResult *res, gpointer gpGlo
 }
 
 
+/*!     \brief  Save the trace(s) as a trace profile of the current project
+*
+* Save the trace data to the database and add (or update) the profile in the
+* lists and the profile combobox.
+*
+* \param  pGlobal           pointer to global data
+* \param  sProfileName      name of the trace profile
+* \return                   0 on success or ERROR
+*/
+gint
+saveTraceProfile( tGlobal *pGlobal, gchar *sProfileName ) {
+    GtkComboBoxText *wComboBoxTextProfile = GTK_COMBO_BOX_TEXT( pGlobal->widgets[ eW_cbt_TraceProfile ] );
+    GtkWidget *wTraceNote = GTK_WIDGET( pGlobal->widgets[ eW_nbTrace_txtV_TraceNote ] );
+    gint saveStatus;
+
+    saveStatus = saveTraceData(pGlobal, pGlobal->sProject, sProfileName);
+    // add to the list
+    tHP8753traceAbstract *pTraceAbstract = catalogLookup( &pGlobal->traceCatalog,
+            pGlobal->sProject, sProfileName );
+    if( pTraceAbstract ) {
+        // This is an existing profile ... just update the abstract
+        g_free( pTraceAbstract->sTitle );
+        pTraceAbstract->sTitle = g_strdup( pGlobal->HP8753.sTitle );
+        g_free( pTraceAbstract->sNote );
+        pTraceAbstract->sNote = g_strdup( pGlobal->HP8753.sNote );
+        g_free( pTraceAbstract->sDateTime );
+        pTraceAbstract->sDateTime = g_strdup( pGlobal->HP8753.dateTime );
+    } else {
+        // This is a new profile ... create the abstract
+        pTraceAbstract = g_new0( tHP8753traceAbstract, 1 );
+        pTraceAbstract->projectAndName.sProject = g_strdup( pGlobal->sProject );
+        pTraceAbstract->projectAndName.sName = g_strdup( sProfileName );
+        pTraceAbstract->sTitle = g_strdup( pGlobal->HP8753.sTitle );
+        pTraceAbstract->sNote = g_strdup( pGlobal->HP8753.sNote );
+        pTraceAbstract->sDateTime = g_strdup( pGlobal->HP8753.dateTime );
+        pGlobal->pTraceList = g_list_insert_sorted( pGlobal->pTraceList, pTraceAbstract,
+                (GCompareFunc)compareTraceItemsForSort );
+        catalogAdd( &pGlobal->traceCatalog, pTraceAbstract );
+        GListModel *pNames = catalogProjectModel( &pGlobal->traceCatalog, pGlobal->sProject );
+        gtk_combo_box_text_remove_all ( wComboBoxTextProfile  );
+        for( guint i = 0; i < g_list_model_get_n_items( pNames ); i++ )
+            gtk_combo_box_text_append_text( wComboBoxTextProfile,
+                    gtk_string_list_get_string( GTK_STRING_LIST( pNames ), i ) );
+        if( !g_list_find_custom (pGlobal->pProjectList, pGlobal->sProject, (GCompareFunc) strcmp ) ) {
+            // This is also a new project
+            pGlobal->pProjectList = g_list_prepend( pGlobal->pProjectList, g_strdup( pGlobal->sProject ) );
+            pGlobal->pProjectList = g_list_sort (pGlobal->pProjectList, (GCompareFunc)g_strcmp0);
+            populateProjectComboBoxWidget( pGlobal );
+        }
+    }
+    pGlobal->pTraceAbstract = pTraceAbstract;
+
+    gtk_widget_set_sensitive( pGlobal->widgets[ eW_btn_Recall ] , TRUE);
+    gtk_widget_set_sensitive(  pGlobal->widgets[ eW_btn_Delete ], TRUE);
+
+    if( saveStatus == 0 ) { // successful save
+        // Restore the color of the title entry window
+        gtk_widget_remove_css_class( GTK_WIDGET( pGlobal->widgets[ eW_nbTrace_entry_Title ] ), "italicFont" );
+        gtk_widget_remove_css_class( GTK_WIDGET( wTraceNote ), "italicFont" );
+        populateTraceHistoryWidget( pGlobal );
+    }
+    gtk_label_set_text( pGlobal->widgets[ eW_lbl_Status], "Saved");
+
+    return( saveStatus );
+}
+
 /*!     \brief  Callback from alert dialog when attempting to overwrite file
 *
 * Callback from alert dialog when attempting to overwrite file
@@ -810,52 +890,7 @@ saveCalibrationOrTrace( gboolean bCalibrationOrTrace, tGlobal *pGlobal ) {
     } else {
         g_free( pGlobal->HP8753.sNote );
         pGlobal->HP8753.sNote = sNote;
-        saveStatus = saveTraceData(pGlobal, pGlobal->sProject, sProfileName);
-        // add to the list
-        GList *liTraceAbstract = g_list_find_custom( pGlobal->pTraceList, &projectAndName,
-                (GCompareFunc)compareTraceItemsForFind );
-        if( liTraceAbstract ) {
-            // This is an existing profile ... just update the abstract
-            tHP8753traceAbstract *pTraceAbstract = (tHP8753traceAbstract *)liTraceAbstract->data;
-            g_free( pTraceAbstract->sTitle );
-            pTraceAbstract->sTitle = g_strdup( pGlobal->HP8753.sTitle );
-            g_free( pTraceAbstract->sNote );
-            pTraceAbstract->sNote = g_strdup( pGlobal->HP8753.sNote );
-            g_free( pTraceAbstract->sDateTime );
-            pTraceAbstract->sDateTime = g_strdup( pGlobal->HP8753.dateTime );
-        } else {
-            // This is a new profile ... create the abstract
-            tHP8753traceAbstract *pTraceAbstract = g_new0( tHP8753traceAbstract, 1 );
-            pTraceAbstract->projectAndName.sProject = g_strdup( pGlobal->sProject );
-            pTraceAbstract->projectAndName.sName = g_strdup( sProfileName );
-            pTraceAbstract->sTitle = g_strdup( pGlobal->HP8753.sTitle );
-            pTraceAbstract->sNote = g_strdup( pGlobal->HP8753.sNote );
-            pTraceAbstract->sDateTime = g_strdup( pGlobal->HP8753.dateTime );
-            pGlobal->pTraceList = g_list_prepend(pGlobal->pTraceList, pTraceAbstract);
-            pGlobal->pTraceList = g_list_sort (pGlobal->pTraceList, (GCompareFunc)compareTraceItemsForSort);
-            gtk_combo_box_text_remove_all ( wComboBoxTextProfile  );
-            for( GList *l = pGlobal->pTraceList; l != NULL; l = l->next ){
-                if( g_strcmp0( ((tHP8753traceAbstract *)l->data)->projectAndName.sProject, pGlobal->sProject ) == 0 )
-                    gtk_combo_box_text_append_text( wComboBoxTextProfile, ((tHP8753traceAbstract *)l->data)->projectAndName.sName );
-            }
-            if( !g_list_find_custom (pGlobal->pProjectList, pGlobal->sProject, (GCompareFunc) strcmp ) ) {
-                // This is also a new project
-                pGlobal->pProjectList = g_list_prepend( pGlobal->pProjectList, g_strdup( pGlobal->sProject ) );
-                pGlobal->pProjectList = g_list_sort (pGlobal->pProjectList, (GCompareFunc)g_strcmp0);
-                populateProjectComboBoxWidget( pGlobal );
-            }
-        }
-        pGlobal->pTraceAbstract = g_list_find_custom( pGlobal->pTraceList, &projectAndName, (GCompareFunc)compareTraceItemsForFind )->data;
-
-        gtk_widget_set_sensitive( pGlobal->widgets[ eW_btn_Recall ] , TRUE);
-        gtk_widget_set_sensitive(  pGlobal->widgets[ eW_btn_Delete ], TRUE);
-
-        if( saveStatus == 0 ) { // successful save
-            // Restore the color of the title entry window
-            gtk_widget_remove_css_class( GTK_WIDGET( pGlobal->widgets[ eW_nbTrace_entry_Title ] ), "italicFont" );
-            gtk_widget_remove_css_class( GTK_WIDGET( wTraceNote ), "italicFont" );
-        }
-        gtk_label_set_text( pGlobal->widgets[ eW_lbl_Status], "Saved");
+        saveStatus = saveTraceProfile( pGlobal, sProfileName );
     }
     return( saveStatus );
 }
@@ -915,11 +950,9 @@ CB_btn_Save (GtkButton *wButton, gpointer udata)
 
         // Look to see if we are replacing an existing profile
         if( pGlobal->flags.bCalibrationOrTrace ) {
-            bFound = (g_list_find_custom( pGlobal->pCalList, &projectAndName,
-                    (GCompareFunc)compareCalItemsForFind ) != NULL);
+            bFound = (catalogLookup( &pGlobal->calCatalog, projectAndName.sProject, projectAndName.sName ) != NULL);
         } else {
-            bFound = (g_list_find_custom( pGlobal->pTraceList, &projectAndName,
-                    (GCompareFunc)compareTraceItemsForFind ) != NULL);
+            bFound = (catalogLookup( &pGlobal->traceCatalog, projectAndName.sProject, projectAndName.sName ) != NULL);
         }
 
         // Warn before overwriting
@@ -1012,6 +1045,7 @@ CB_btn_Recall (GtkButton *wRecallBtn, gpointer udata)
                 // Restore the color of the title entry window
                 gtk_widget_remove_css_class( GTK_WIDGET( wEntryTitle ), "italicFont" );
                 gtk_widget_remove_css_class( GTK_WIDGET( wTraceNote ), "italicFont" );
+                populateTraceHistoryWidget( pGlobal );
             }
         }
         gtk_notebook_set_current_page ( GTK_NOTEBOOK( pGlobal->widgets[ eW_notebook ] ),
@@ -1152,7 +1186,7 @@ populateCalComboBoxWidget( tGlobal *pGlobal ) {
 
     gint nPos, nItems;
     gboolean bFound;
-    GList *l;
+    tHP8753cal *pCal;
 
     // Block signals while we populate the widgets programmatically
     g_signal_handlers_block_by_func(G_OBJECT(wComboBoxCalibration), CB_cbt_CalibrationProfileName, NULL);
@@ -1161,28 +1195,23 @@ populateCalComboBoxWidget( tGlobal *pGlobal ) {
     gtk_combo_box_text_remove_all( wComboBoxCalibration );
     gtk_editable_set_text( GTK_EDITABLE( gtk_combo_box_get_child(GTK_COMBO_BOX( wComboBoxCalibration )) ), "" );
 
-    for( l = pGlobal->pCalList, nPos=0, nItems=0, bFound=FALSE; l != NULL; l = l->next ){
-        tProjectAndName *pProjectAndName = &(((tHP8753cal *)l->data)->projectAndName);
-        if( g_strcmp0(  pProjectAndName->sProject, pGlobal->sProject ) == 0 ) {
-            nItems++;
-            gtk_combo_box_text_append_text( wComboBoxCalibration, pProjectAndName->sName );
-            if( !bFound ) {
-                if( pProjectAndName->bbFlags.bSelected )
-                    bFound = TRUE;
-                else
-                    nPos++;
-            }
+    // Only the profiles in this project are visited (the catalog holds them in order)
+    for( nPos=0, nItems=0, bFound=FALSE;
+            (pCal = catalogNthInProject( &pGlobal->calCatalog, pGlobal->sProject, nItems )) != NULL; nItems++ ){
+        gtk_combo_box_text_append_text( wComboBoxCalibration, pCal->projectAndName.sName );
+        if( !bFound ) {
+            if( pCal->projectAndName.bbFlags.bSelected )
+                bFound = TRUE;
+            else
+                nPos++;
         }
     }
 
-    if( !bFound && nItems > 0 ) {
-
-    }
     if( bFound ) {
         gtk_combo_box_set_active( GTK_COMBO_BOX(wComboBoxCalibration), nPos);
     } else if ( nItems > 0 ) {
         gtk_combo_box_set_active( GTK_COMBO_BOX(wComboBoxCalibration), 0);
-        ((tHP8753cal *)(pGlobal->pCalList->data))->projectAndName.bbFlags.bSelected = TRUE;
+        ((tHP8753cal *)catalogNthInProject( &pGlobal->calCatalog, pGlobal->sProject, 0 ))->projectAndName.bbFlags.bSelected = TRUE;
     } else {
         gtk_entry_buffer_set_text( gtk_entry_get_buffer( GTK_ENTRY( wComboBoxCalibration) ), "", -1 );
     }
@@ -1208,7 +1237,7 @@ populateTraceComboBoxWidget( tGlobal *pGlobal ) {
 
     gint nPos, nItems;
     gboolean bFound;
-    GList *l;
+    tHP8753traceAbstract *pTraceAbstract;
 
     // Block signals while we populate the widgets programatically
     g_signal_handlers_block_by_func( G_OBJECT(wComboBoxTrace), CB_cbt_TraceProfileName, NULL );
@@ -1218,24 +1247,21 @@ populateTraceComboBoxWidget( tGlobal *pGlobal ) {
     gtk_combo_box_text_remove_all( wComboBoxTrace );
     gtk_editable_set_text( GTK_EDITABLE( gtk_combo_box_get_child(GTK_COMBO_BOX( wComboBoxTrace )) ), "" );
 
-    for( l = pGlobal->pTraceList, nPos=0, nItems=0, bFound=FALSE; l != NULL; l = l->next ){
-        tProjectAndName *pProjectAndName = &(((tHP8753traceAbstract *)(l->data))->projectAndName);
-        if( g_strcmp0(  pProjectAndName->sProject, pGlobal->sProject ) == 0 ) {
-            nItems++;
-            gtk_combo_box_text_append_text( wComboBoxTrace, pProjectAndName->sName );
-            if( !bFound ) {
-                if( pProjectAndName->bbFlags.bSelected )
-                    bFound = TRUE;
-                else
-                    nPos++;
-            }
+    for( nPos=0, nItems=0, bFound=FALSE;
+            (pTraceAbstract = catalogNthInProject( &pGlobal->traceCatalog, pGlobal->sProject, nItems )) != NULL; nItems++ ){
+        gtk_combo_box_text_append_text( wComboBoxTrace, pTraceAbstract->projectAndName.sName );
+        if( !bFound ) {
+            if( pTraceAbstract->projectAndName.bbFlags.bSelected )
+                bFound = TRUE;
+            else
+                nPos++;
         }
     }
     if( bFound ) {
         gtk_combo_box_set_active( GTK_COMBO_BOX(wComboBoxTrace), nPos);
     } else if ( nItems > 0 ) {
         gtk_combo_box_set_active( GTK_COMBO_BOX(wComboBoxTrace), 0);
-        ((tHP8753traceAbstract *)(pGlobal->pTraceList->data))->projectAndName.bbFlags.bSelected = TRUE;
+        ((tHP8753traceAbstract *)catalogNthInProject( &pGlobal->traceCatalog, pGlobal->sProject, 0 ))->projectAndName.bbFlags.bSelected = TRUE;
     } else {
         gtk_entry_buffer_set_text( gtk_entry_get_buffer( GTK_ENTRY( wComboBoxTrace ) ), "", -1 );
     }
@@ -1248,6 +1274,28 @@ populateTraceComboBoxWidget( tGlobal *pGlobal ) {
 }
 
 
+/*!     \brief  Callback when the name typed in the project entry is entered
+ *
+ * \param  wEntry       the entry of the project GtkComboBoxText
+ * \param  gpGlobal     gpointer to the global data
+ */
+static void
+CB_entry_ProjectActivate( GtkEntry *wEntry, gpointer gpGlobal ) {
+    loadChosenProject( (tGlobal *)gpGlobal );
+}
+
+/*!     \brief  Callback when the project GtkComboBoxText looses focus
+ *
+ * The project named is read (if it has not been already)
+ *
+ * \param   controller  controller for the GtkComboBox
+ * \param   gpGlobal    gpointer to the global data
+ */
+static void
+CB_cbt_ProjectUnfocus( GtkEventControllerFocus *controller, gpointer gpGlobal  ) {
+    loadChosenProject( (tGlobal *)gpGlobal );
+}
+
 /*!     \brief  Callback when the connected GtkComboBoxText with GtkEntry looses focus
  *
  * We use this to deselect the text in the entry widget
@@ -1375,6 +1423,8 @@ initializeMainDialog( tGlobal *pGlobal, tInitFn purpose )
         // callback MD7 - change the entry widget of the 'Project' ComboBoxText
         g_signal_connect ( gtk_combo_box_get_child(pGlobal->widgets[ eW_cbt_Project ] ), "changed",
                 G_CALLBACK (CB_editable_ProjectName), NULL );
+        g_signal_connect ( gtk_combo_box_get_child(pGlobal->widgets[ eW_cbt_Project ] ), "activate",
+                G_CALLBACK (CB_entry_ProjectActivate), pGlobal );
 
         // callback MD8 - change 'Calibration Profile' ComboBoxText
         // This is called if either the Calibration Profile ComboBoxText is changed or the entry is changed
@@ -1473,6 +1523,7 @@ initializeMainDialog( tGlobal *pGlobal, tInitFn purpose )
         // Attach focus controller to entry1
         focus_controller = gtk_event_controller_focus_new();
         gtk_widget_add_controller( pGlobal->widgets[ eW_cbt_Project ], focus_controller);
+        g_signal_connect(focus_controller, "leave", G_CALLBACK( CB_cbt_ProjectUnfocus ), pGlobal );
         g_signal_connect(focus_controller, "leave", G_CALLBACK( CB_cbt_Unfocus ), pGlobal );
         focus_controller = gtk_event_controller_focus_new();
         gtk_widget_add_controller(  pGlobal->widgets[ eW_cbt_CalProfile ], focus_controller);
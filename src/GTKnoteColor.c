@@ -84,6 +84,7 @@ CB_nbColor_colbtn_element( GtkColorDialogButton *wColorBtn , gpointer udata)
     if( id < eMAX_COLORS ) {
         plotElementColors[ id ] = *gtk_color_dialog_button_get_rgba (GTK_COLOR_DIALOG_BUTTON( wColorBtn ) );
         if( !pGlobal->HP8753.flags.bShowHPGLplot || !pGlobal->HP8753.flags.bHPGLdataValid ) {
+            invalidatePlotCache();
             gtk_widget_queue_draw( GTK_WIDGET( pGlobal->widgets[ eW_drawingArea_Plot_A ] ));
             gtk_widget_queue_draw( GTK_WIDGET( pGlobal->widgets[ eW_drawingArea_Plot_B ] ));
         }
@@ -107,7 +108,9 @@ CB_nbColor_colbtn_HPGLpen( GtkColorDialogButton *wColorBtn , gpointer udata )
 
     if( id < NUM_HPGL_PENS ) {
         HPGLpens[ id ] = *gtk_color_dialog_button_get_rgba (GTK_COLOR_DIALOG_BUTTON( wColorBtn ) );
+        clearHPGLrecording();
         if( pGlobal->HP8753.flags.bHPGLdataValid && pGlobal->HP8753.flags.bShowHPGLplot ) {
+            invalidatePlotCache();
             gtk_widget_queue_draw( GTK_WIDGET( pGlobal->widgets[ eW_drawingArea_Plot_A ] ));
         }
     }
@@ -202,9 +205,11 @@ CB_nbColor_btn_ResetColors( GtkButton *wButton, gpointer udata )
     for( int i=0; i < NUM_HPGL_PENS; i++ ) {
         HPGLpens[ i ] = HPGLpensFactory[ i ];
     }
+    clearHPGLrecording();
     for( int i=0; i < eMAX_COLORS; i++ ) {
         plotElementColors[ i ] = plotElementColorsFactory[ i ];
     }
+    invalidatePlotCache();
     gtk_widget_queue_draw( GTK_WIDGET( pGlobal->widgets[ eW_drawingArea_Plot_A ] ) );
 
     gtk_widget_queue_draw( GTK_WIDGET( pGlobal->widgets[ eW_drawingArea_Plot_B ] ) );
@@ -246,6 +246,69 @@ writeCSVpoint( FILE *file, tFormat format, tComplex *point, gboolean bLF ) {
 		fprintf( file, "\n" );
 }
 
+/*!     \brief  Write the trace data to a CSV file
+ *
+ * The stimulus and response of each channel are written
+ * one point per line after a header line.
+ *
+ * \param  pGlobal    pointer to global data (with the trace data)
+ * \param  sFilename  name of the CSV file
+ * \return            OK or ERROR if the file could not be written
+ */
+gint
+writeCSVfile( tGlobal *pGlobal, const gchar *sFilename ) {
+    FILE *fCSV = NULL;
+    tFormat fmtCh1 = pGlobal->HP8753.channels[ eCH_ONE ].format,
+            fmtCh2 = pGlobal->HP8753.channels[ eCH_TWO ].format;
+    tSweepType sweepCh1 = pGlobal->HP8753.channels[ eCH_ONE ].sweepType,
+               sweepCh2 = pGlobal->HP8753.channels[ eCH_TWO ].sweepType;
+    tMeasurement measCh1 = pGlobal->HP8753.channels[ eCH_ONE ].measurementType,
+                 measCh2 = pGlobal->HP8753.channels[ eCH_TWO ].measurementType;
+
+    if( (fCSV = fopen( sFilename, "w" )) == NULL )
+        return ERROR;
+
+    writeCSVheader( fCSV,  sweepCh1, sweepCh2, fmtCh1, fmtCh2, measCh1, measCh2,
+            pGlobal->HP8753.flags.bSourceCoupled, pGlobal->HP8753.flags.bDualChannel );
+    if( pGlobal->HP8753.flags.bDualChannel ) {
+        if( pGlobal->HP8753.flags.bSourceCoupled ) {
+            for( int i=0; i < pGlobal->HP8753.channels[ eCH_ONE ].nPoints; i++ ) {
+                fprintf( fCSV, "%.0lf",
+                        getStimulusPoints( &pGlobal->HP8753.channels[ eCH_ONE ] )[i] );
+                writeCSVpoint( fCSV, fmtCh1, &pGlobal->HP8753.channels[ eCH_ONE ].responsePoints[i], FALSE );
+                writeCSVpoint( fCSV, fmtCh2, &pGlobal->HP8753.channels[ eCH_TWO ].responsePoints[i], TRUE );
+            }
+        } else {
+            for( int i=0; i < pGlobal->HP8753.channels[ eCH_ONE ].nPoints
+                            || i < pGlobal->HP8753.channels[ eCH_TWO ].nPoints; i++ ) {
+                if( i < pGlobal->HP8753.channels[ eCH_ONE ].nPoints ) {
+                    fprintf( fCSV, "%.0lf",
+                            getStimulusPoints( &pGlobal->HP8753.channels[ eCH_ONE ] )[i] );
+                    writeCSVpoint( fCSV, fmtCh1, &pGlobal->HP8753.channels[ eCH_ONE ].responsePoints[i], FALSE );
+                } else {
+                    fprintf( fCSV, ",,,");
+                }
+                if( i < pGlobal->HP8753.channels[ eCH_TWO ].nPoints ) {
+                    fprintf( fCSV, ",%.0lf",
+                            getStimulusPoints( &pGlobal->HP8753.channels[ eCH_TWO ] )[i] );
+                    writeCSVpoint( fCSV, fmtCh2, &pGlobal->HP8753.channels[ eCH_TWO ].responsePoints[i], TRUE );
+                } else {
+                    fprintf( fCSV, ",,\n");
+                }
+            }
+        }
+    } else {
+        for( int i=0; i < pGlobal->HP8753.channels[ eCH_ONE ].nPoints; i++ ) {
+            fprintf( fCSV, "%.0lf",
+                    getStimulusPoints( &pGlobal->HP8753.channels[ eCH_ONE ] )[i] );
+            writeCSVpoint( fCSV, fmtCh1, &pGlobal->HP8753.channels[ eCH_ONE ].responsePoints[i], TRUE );
+        }
+    }
+    fclose( fCSV );
+
+    return OK;
+}
+
 
 
 static gchar *sCSVfileName = NULL;
@@ -271,59 +334,14 @@ CB_dialog_CSV( GObject *source_object, GAsyncResult *res, gpointer gpGlobal ) {
         gchar *sChosenFilename = g_file_get_path( file );
         GString *sFilename = g_string_new( sChosenFilename );
 
-        FILE *fCSV = NULL;
-        tFormat fmtCh1 = pGlobal->HP8753.channels[ eCH_ONE ].format,
-                fmtCh2 = pGlobal->HP8753.channels[ eCH_TWO ].format;
-        tSweepType sweepCh1 = pGlobal->HP8753.channels[ eCH_ONE ].sweepType,
-                   sweepCh2 = pGlobal->HP8753.channels[ eCH_TWO ].sweepType;
-        tMeasurement measCh1 = pGlobal->HP8753.channels[ eCH_ONE ].measurementType,
-                     measCh2 = pGlobal->HP8753.channels[ eCH_TWO ].measurementType;
-
         g_free( sCSVfileName );
         sCSVfileName = g_strdup(sFilename->str);
 
-        if( (fCSV = fopen( sChosenFilename, "w" )) == NULL ) {
+        if( writeCSVfile( pGlobal, sChosenFilename ) != OK ) {
             gchar *sError = g_strdup_printf( "Cannot write: %s", sChosenFilename);
             postError( sError );
             g_free( sError );
         } else {
-            writeCSVheader( fCSV,  sweepCh1, sweepCh2, fmtCh1, fmtCh2, measCh1, measCh2,
-                    pGlobal->HP8753.flags.bSourceCoupled, pGlobal->HP8753.flags.bDualChannel );
-            if( pGlobal->HP8753.flags.bDualChannel ) {
-                if( pGlobal->HP8753.flags.bSourceCoupled ) {
-                    for( int i=0; i < pGlobal->HP8753.channels[ eCH_ONE ].nPoints; i++ ) {
-                        fprintf( fCSV, "%.0lf",
-                                pGlobal->HP8753.channels[ eCH_ONE ].stimulusPoints[i] );
-                        writeCSVpoint( fCSV, fmtCh1, &pGlobal->HP8753.channels[ eCH_ONE ].responsePoints[i], FALSE );
-                        writeCSVpoint( fCSV, fmtCh2, &pGlobal->HP8753.channels[ eCH_TWO ].responsePoints[i], TRUE );
-                    }
-                } else {
-                    for( int i=0; i < pGlobal->HP8753.channels[ eCH_ONE ].nPoints
-                                    || i < pGlobal->HP8753.channels[ eCH_TWO ].nPoints; i++ ) {
-                        if( i < pGlobal->HP8753.channels[ eCH_ONE ].nPoints ) {
-                            fprintf( fCSV, "%.0lf",
-                                    pGlobal->HP8753.channels[ eCH_ONE ].stimulusPoints[i] );
-                            writeCSVpoint( fCSV, fmtCh1, &pGlobal->HP8753.channels[ eCH_ONE ].responsePoints[i], FALSE );
-                        } else {
-                            fprintf( fCSV, ",,,");
-                        }
-                        if( i < pGlobal->HP8753.channels[ eCH_TWO ].nPoints ) {
-                            fprintf( fCSV, ",%.0lf",
-                                    pGlobal->HP8753.channels[ eCH_TWO ].stimulusPoints[i] );
-                            writeCSVpoint( fCSV, fmtCh2, &pGlobal->HP8753.channels[ eCH_TWO ].responsePoints[i], TRUE );
-                        } else {
-                            fprintf( fCSV, ",,\n");
-                        }
-                    }
-                }
-            } else {
-                for( int i=0; i < pGlobal->HP8753.channels[ eCH_ONE ].nPoints; i++ ) {
-                    fprintf( fCSV, "%.0lf",
-                            pGlobal->HP8753.channels[ eCH_ONE ].stimulusPoints[i] );
-                    writeCSVpoint( fCSV, fmtCh1, &pGlobal->HP8753.channels[ eCH_ONE ].responsePoints[i], TRUE );
-                }
-            }
-            fclose( fCSV );
             postInfo( "Traces saved to csv file" );
         }
 
@@ -40,6 +40,7 @@ CB_cbtn_BezierSpline (GtkCheckButton *wBtnSpline, gpointer udata)
     tGlobal *pGlobal = (tGlobal *)g_object_get_data(G_OBJECT( wBtnSpline ), "data");
 
     pGlobal->flags.bSmithSpline = gtk_check_button_get_active( GTK_CHECK_BUTTON( wBtnSpline ) );
+    invalidatePlotCache();
     gtk_widget_queue_draw(GTK_WIDGET( pGlobal->widgets[ eW_drawingArea_Plot_A ] ));
     gtk_widget_queue_draw(GTK_WIDGET( pGlobal->widgets[ eW_drawingArea_Plot_B ] ));
 }
@@ -58,6 +59,7 @@ CB_cbtn_ShowDateTime (GtkCheckButton *wCkButton, gpointer udata)
     tGlobal *pGlobal = (tGlobal *)g_object_get_data(G_OBJECT( wCkButton ), "data");
 
 	pGlobal->flags.bShowDateTime = gtk_check_button_get_active( GTK_CHECK_BUTTON( wCkButton ) );
+	invalidatePlotCache();
 	gtk_widget_queue_draw(GTK_WIDGET( pGlobal->widgets[ eW_drawingArea_Plot_A ] ));
 }
 
@@ -74,6 +76,7 @@ CB_cbtn_SmithGBnotRX (GtkCheckButton *wCheckBtn, gpointer udata)
     tGlobal *pGlobal = (tGlobal *)g_object_get_data(G_OBJECT( wCheckBtn ), "data");
 
     pGlobal->flags.bAdmitanceSmith = gtk_check_button_get_active( GTK_CHECK_BUTTON( wCheckBtn ) );
+    invalidatePlotCache();
     gtk_widget_queue_draw(GTK_WIDGET( pGlobal->widgets[ eW_drawingArea_Plot_A ] ));
     gtk_widget_queue_draw(GTK_WIDGET( pGlobal->widgets[ eW_drawingArea_Plot_B ] ));
 }
@@ -91,6 +94,7 @@ CB_cbtn_DeltaMarkerActual (GtkCheckButton *wCheckBtn, gpointer udata)
     tGlobal *pGlobal = (tGlobal *)g_object_get_data(G_OBJECT( wCheckBtn ), "data");
 
 	pGlobal->flags.bDeltaMarkerZero = !gtk_check_button_get_active( GTK_CHECK_BUTTON( wCheckBtn ) );
+    invalidatePlotCache();
     gtk_widget_queue_draw(GTK_WIDGET( pGlobal->widgets[ eW_drawingArea_Plot_A ] ));
     gtk_widget_queue_draw(GTK_WIDGET( pGlobal->widgets[ eW_drawingArea_Plot_B ] ));
 }
@@ -123,6 +127,7 @@ CB_cbtn_ShowHPlogo (GtkCheckButton *wBtnHPlogo, gpointer udata)
     tGlobal *pGlobal = (tGlobal *)g_object_get_data(G_OBJECT( wBtnHPlogo ), "data");
 
     pGlobal->flags.bHPlogo = gtk_check_button_get_active( GTK_CHECK_BUTTON( wBtnHPlogo ) );
+    invalidatePlotCache();
     gtk_widget_queue_draw(GTK_WIDGET( pGlobal->widgets[ eW_drawingArea_Plot_A ] ));
     gtk_widget_queue_draw(GTK_WIDGET( pGlobal->widgets[ eW_drawingArea_Plot_B ] ));
 }
@@ -162,6 +167,192 @@ CB_cbtn_PDFpageSize( GtkCheckButton *wBtnPageSize, gpointer gpSize)
         pGlobal->PDFpaperSize = (tPaperSize)GPOINTER_TO_INT(gpSize);
 }
 
+#define PROJECT_ARCHIVE_EXTENSION   ".hp8753"
+
+/*!     \brief  Callback when the project archive to write has been chosen
+ *
+ * \param  source_object     GtkFileDialog object
+ * \param  res               result of choosing the file
+ * \param  gpGlobal          pointer to global data
+ */
+static void
+CB_fdlg_ExportProject( GObject *source_object, GAsyncResult *res, gpointer gpGlobal )
+{
+    GtkFileDialog *dialog = GTK_FILE_DIALOG (source_object);
+    tGlobal *pGlobal = (tGlobal *)gpGlobal;
+    GError *err = NULL;
+    GFile *file;
+
+    if ( (file = gtk_file_dialog_save_finish (dialog, res, &err)) != NULL ) {
+        gchar *sChosenFilename = g_file_get_path( file );
+        GString *sFilename = g_string_new( sChosenFilename );
+
+        if( !g_str_has_suffix( sFilename->str, PROJECT_ARCHIVE_EXTENSION ) )
+            g_string_append( sFilename, PROJECT_ARCHIVE_EXTENSION );
+
+        // written in the background .. the result is shown by showProjectArchiveResult
+        if( startProjectArchive( FALSE, pGlobal->sProject, sFilename->str ) == OK )
+            postInfo( "Exporting project" );
+
+        GFile *dir = g_file_get_parent( file );
+        g_free( pGlobal->sLastDirectory );
+        pGlobal->sLastDirectory = g_file_get_path( dir );
+
+        g_object_unref( dir );
+        g_object_unref( file );
+        g_string_free( sFilename, TRUE );
+        g_free( sChosenFilename );
+    } else {
+        g_clear_error (&err);
+    }
+}
+
+/*!     \brief  Callback when the project archive to read has been chosen
+ *
+ * \param  source_object     GtkFileDialog object
+ * \param  res               result of choosing the file
+ * \param  gpGlobal          pointer to global data
+ */
+static void
+CB_fdlg_ImportProject( GObject *source_object, GAsyncResult *res, gpointer gpGlobal )
+{
+    GtkFileDialog *dialog = GTK_FILE_DIALOG (source_object);
+    tGlobal *pGlobal = (tGlobal *)gpGlobal;
+    GError *err = NULL;
+    GFile *file;
+
+    if ( (file = gtk_file_dialog_open_finish (dialog, res, &err)) != NULL ) {
+        gchar *sChosenFilename = g_file_get_path( file );
+
+        // read in the background .. the result is shown by showProjectArchiveResult
+        if( startProjectArchive( TRUE, NULL, sChosenFilename ) == OK )
+            postInfo( "Importing project archive" );
+
+        GFile *dir = g_file_get_parent( file );
+        g_free( pGlobal->sLastDirectory );
+        pGlobal->sLastDirectory = g_file_get_path( dir );
+
+        g_object_unref( dir );
+        g_object_unref( file );
+        g_free( sChosenFilename );
+    } else {
+        g_clear_error (&err);
+    }
+}
+
+/*!     \brief  Show the result of exporting or importing a project archive
+ *
+ * Called from projectArchiveComplete (main loop). After an import the lists
+ * have been re-read so the combo boxes are filled again.
+ *
+ * \param  pGlobal      pointer to global data
+ * \param  bImport      TRUE if imported, FALSE if exported
+ * \param  sProject     project exported
+ * \param  nProfiles    number of profiles exported or imported (or ERROR)
+ */
+void
+showProjectArchiveResult( tGlobal *pGlobal, gboolean bImport, const gchar *sProject, gint nProfiles )
+{
+    gchar *sStatus;
+
+    // the error has been shown
+    if( nProfiles == ERROR )
+        return;
+
+    if( bImport ) {
+        sStatus = g_strdup_printf( "Imported %d profile%s", nProfiles, nProfiles == 1 ? "" : "s" );
+        populateProjectComboBoxWidget( pGlobal );
+        populateCalComboBoxWidget( pGlobal );
+        populateTraceComboBoxWidget( pGlobal );
+    } else {
+        sStatus = g_strdup_printf( "Exported %d profile%s of %s", nProfiles,
+                nProfiles == 1 ? "" : "s", sProject );
+    }
+    gtk_label_set_text( GTK_LABEL( pGlobal->widgets[ eW_lbl_Status ] ), sStatus );
+    g_free( sStatus );
+}
+
+/*!     \brief  Create the file dialog for a project archive
+ *
+ * \param  sInitialName     suggested file name (or NULL)
+ * \param  pGlobal          pointer to global data
+ * \return                  file dialog
+ */
+static GtkFileDialog *
+projectArchiveFileDialog( gchar *sInitialName, tGlobal *pGlobal )
+{
+    GtkFileDialog *fileDialog = gtk_file_dialog_new ();
+    g_autoptr (GListModel) filters = (GListModel *)g_list_store_new (GTK_TYPE_FILE_FILTER);
+    g_autoptr (GtkFileFilter) filter = NULL;
+
+    filter = gtk_file_filter_new ();
+    gtk_file_filter_add_pattern (filter, "*" PROJECT_ARCHIVE_EXTENSION);
+    gtk_file_filter_set_name (filter, "Project archive");
+    g_list_store_append ( (GListStore*)filters, filter);
+
+    // All files
+    filter = gtk_file_filter_new ();
+    gtk_file_filter_add_pattern (filter, "*");
+    gtk_file_filter_set_name (filter, "All Files");
+    g_list_store_append ( (GListStore*) filters, filter);
+
+    gtk_file_dialog_set_filters (fileDialog, G_LIST_MODEL (filters));
+
+    if( sInitialName ) {
+        GFile *fPath = g_file_new_build_filename( pGlobal->sLastDirectory, sInitialName, NULL );
+        gtk_file_dialog_set_initial_file( fileDialog, fPath );
+        g_object_unref( fPath );
+    } else if( pGlobal->sLastDirectory ) {
+        GFile *fDir = g_file_new_for_path( pGlobal->sLastDirectory );
+        gtk_file_dialog_set_initial_folder( fileDialog, fDir );
+        g_object_unref( fDir );
+    }
+    return fileDialog;
+}
+
+/*!     \brief  Callback / Options page / "Export Project" GtkButton
+ *
+ * Callback (NOPT 9) when the "Export Project" GtkButton on the "Options" notebook page is pressed
+ *
+ * \param  wBtnExport   pointer to export button widget
+ * \param  udata        unused
+ */
+static void
+CB_btn_ExportProject( GtkButton *wBtnExport, gpointer udata )
+{
+    tGlobal *pGlobal = (tGlobal *)g_object_get_data(G_OBJECT( wBtnExport ), "data");
+    GtkWidget *win = gtk_widget_get_ancestor (GTK_WIDGET (wBtnExport), GTK_TYPE_WINDOW);
+
+    if( pGlobal->sProject == NULL )
+        return;
+
+    gchar *sName = g_strconcat( pGlobal->sProject, PROJECT_ARCHIVE_EXTENSION, NULL );
+    GtkFileDialog *fileDialogSave = projectArchiveFileDialog( sName, pGlobal );
+    gtk_file_dialog_save ( fileDialogSave, GTK_WINDOW (win), NULL, CB_fdlg_ExportProject, pGlobal);
+
+    g_object_unref( fileDialogSave );
+    g_free( sName );
+}
+
+/*!     \brief  Callback / Options page / "Import Project" GtkButton
+ *
+ * Callback (NOPT 10) when the "Import Project" GtkButton on the "Options" notebook page is pressed
+ *
+ * \param  wBtnImport   pointer to import button widget
+ * \param  udata        unused
+ */
+static void
+CB_btn_ImportProject( GtkButton *wBtnImport, gpointer udata )
+{
+    tGlobal *pGlobal = (tGlobal *)g_object_get_data(G_OBJECT( wBtnImport ), "data");
+    GtkWidget *win = gtk_widget_get_ancestor (GTK_WIDGET (wBtnImport), GTK_TYPE_WINDOW);
+
+    GtkFileDialog *fileDialogOpen = projectArchiveFileDialog( NULL, pGlobal );
+    gtk_file_dialog_open ( fileDialogOpen, GTK_WINDOW (win), NULL, CB_fdlg_ImportProject, pGlobal);
+
+    g_object_unref( fileDialogOpen );
+}
+
 /*!     \brief  Initialize the widgets and callbacks on the 'Options' page of the notebook
  *
  * Initialize the widgets and callbacks on the 'Options' page of the notebook
@@ -242,6 +433,11 @@ initializeNotebookPageOptions( tGlobal *pGlobal, tInitFn purpose )
         g_signal_connect ( pGlobal->widgets[ eW_nbOpts_rbtn_PDF_LTR ], "toggled", G_CALLBACK (CB_cbtn_PDFpageSize), GINT_TO_POINTER( eLetter ) );
         g_signal_connect ( pGlobal->widgets[ eW_nbOpts_rbtn_PDF_A3 ], "toggled", G_CALLBACK (CB_cbtn_PDFpageSize), GINT_TO_POINTER( eA3 ) );
         g_signal_connect ( pGlobal->widgets[ eW_nbOpts_rbtn_PDF_TBL ], "toggled", G_CALLBACK (CB_cbtn_PDFpageSize), GINT_TO_POINTER( eTabloid ) );
+
+        // NOPT 9 - Signal for callback of button to export the project to an archive file
+        g_signal_connect ( pGlobal->widgets[ eW_nbOpts_btn_ExportProject ], "clicked", G_CALLBACK (CB_btn_ExportProject), NULL );
+        // NOPT 10 - Signal for callback of button to import the profiles from an archive file
+        g_signal_connect ( pGlobal->widgets[ eW_nbOpts_btn_ImportProject ], "clicked", G_CALLBACK (CB_btn_ImportProject), NULL );
     }
 }
 
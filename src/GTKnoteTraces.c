@@ -42,6 +42,7 @@ CB_entry_Title_Changed (GtkEditable* wEditable, gpointer udata)
 
     g_free( pGlobal->HP8753.sTitle );
     pGlobal->HP8753.sTitle = sTitle;
+    invalidatePlotCache();
     gtk_widget_queue_draw(GTK_WIDGET(pGlobal->widgets[ eW_drawingArea_Plot_A ]));
     gtk_widget_queue_draw(GTK_WIDGET(pGlobal->widgets[ eW_drawingArea_Plot_B ]));
 }
@@ -62,6 +63,67 @@ CB_cbtn_PlotType ( GtkCheckButton* wCheckButtonHPGL, gpointer udata) {
     postDataToMainLoop(TM_REFRESH_TRACE, (void*) 1);
 }
 
+/*!     \brief  Callback when a capture is chosen from the history of the trace profile
+*
+* Callback (NTRA 3) when a capture is chosen from the history drop down.
+* The first (newest) entry is the profile as saved.
+*
+* \param  wDropDown    history GtkDropDown widget
+* \param  pSpec        "selected" property
+* \param  udata        unused
+*/
+static void
+CB_dd_History_Selected ( GtkDropDown *wDropDown, GParamSpec *pSpec, gpointer udata ) {
+    tGlobal *pGlobal = (tGlobal *)g_object_get_data(G_OBJECT( wDropDown ), "data");
+    GtkStringList *pTimes = GTK_STRING_LIST( gtk_drop_down_get_model( wDropDown ) );
+    guint selected = gtk_drop_down_get_selected( wDropDown );
+    tProjectAndName *pProjectAndName;
+    gint rtn;
+
+    if( pGlobal->pTraceAbstract == NULL || pTimes == NULL || selected == GTK_INVALID_LIST_POSITION )
+        return;
+    pProjectAndName = &pGlobal->pTraceAbstract->projectAndName;
+
+    if( selected == 0 )
+        rtn = recoverTraceData( pGlobal, pProjectAndName->sProject, pProjectAndName->sName );
+    else
+        rtn = recoverTraceHistory( pGlobal, pProjectAndName->sProject, pProjectAndName->sName,
+                gtk_string_list_get_string( pTimes, selected ) );
+
+    if( rtn == TRUE ) {
+        postDataToMainLoop(TM_REFRESH_TRACE, 0);
+        postDataToMainLoop(TM_REFRESH_TRACE, (void*) 1);
+    }
+}
+
+/*!     \brief  Show the captures in the history of the trace profile
+ *
+ * The history drop down is only shown if there is more than one capture.
+ *
+ * \param  pGlobal  pointer to global data
+ */
+void
+populateTraceHistoryWidget( tGlobal *pGlobal )
+{
+    GtkDropDown *wDropDown = GTK_DROP_DOWN( pGlobal->widgets[ eW_nbTrace_dd_History ] );
+    gchar **sTimes = NULL;
+    GtkStringList *pTimes;
+
+    if( pGlobal->pTraceAbstract )
+        sTimes = queryTraceHistory( pGlobal->pTraceAbstract->projectAndName.sProject,
+                pGlobal->pTraceAbstract->projectAndName.sName, NULL, NULL );
+
+    pTimes = gtk_string_list_new( (const gchar * const *)sTimes );
+    g_signal_handlers_block_by_func( wDropDown, CB_dd_History_Selected, NULL );
+    gtk_drop_down_set_model( wDropDown, G_LIST_MODEL( pTimes ) );
+    gtk_drop_down_set_selected( wDropDown, 0 );
+    g_signal_handlers_unblock_by_func( wDropDown, CB_dd_History_Selected, NULL );
+    gtk_widget_set_visible( GTK_WIDGET( wDropDown ), sTimes && g_strv_length( sTimes ) > 1 );
+
+    g_object_unref( pTimes );
+    g_strfreev( sTimes );
+}
+
 /*!     \brief  Callback when the connected GtkComboBoxText with GtkEntry looses focus
  *
  * We use this to deselect the text in the entry widget
@@ -124,6 +186,10 @@ initializeNotebookPageTraces( tGlobal *pGlobal, tInitFn purpose )
         g_signal_connect ( pGlobal->widgets[ eW_nbTrace_rbtn_PlotTypeHPGL ], "toggled",
                 G_CALLBACK ( CB_cbtn_PlotType ), NULL );
 
+        // callback NTRA 3 - choose a capture from the history of the trace profile
+        g_signal_connect ( pGlobal->widgets[ eW_nbTrace_dd_History ], "notify::selected",
+                G_CALLBACK ( CB_dd_History_Selected ), NULL );
+
         focus_controller = gtk_event_controller_focus_new();
         gtk_widget_add_controller(  pGlobal->widgets[ eW_nbTrace_entry_Title ], focus_controller);
         g_signal_connect(focus_controller, "leave", G_CALLBACK( CB_edit_Unfocus ), pGlobal );
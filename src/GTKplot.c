@@ -39,6 +39,19 @@ const	gchar *formatSymbols[] = { "dB", "°", "s", "U", "U", "U", "U", "", "U", "
 const	gchar *formatSmithOrPolarSymbols[][2] = { {"U", "°"}, {"dB", "°"}, {"U", "U"}, {"Ω", "Ω"}, {"S", "S"} };
 const	gchar *sweepSymbols[] = { "Hz", "Hz", "Hz", "s", "dBm" };
 
+// static layer of each drawing area (see drawCachedPlot)
+typedef struct {
+    cairo_surface_t *pSurface;
+    gint            width, height, scale;
+    gboolean        bValid;
+    gdouble         liveLeft, liveRight;    // x range of the live marker in the last draw
+    guint           tickId;                 // live marker redraw pending on the next frame
+    guint           nFrames, nStaticFrames; // frame time statistics for the debug output
+    gint64          drawTime, maxDrawTime;
+} tPlotCache;
+
+static tPlotCache plotCache[ eNUM_CH ] = { 0 };
+
 /*!     \brief  Turn off font metrics hinting
  *
  * Remove font metric hinting so that the font size remains the same
@@ -307,19 +320,20 @@ void multiLineText(
  * \ingroup drawing
  *
  * \param cr		pointer to cairo context
+ * \param pGlobal	pointer to global data (for the colors)
  * \param bOverlay	TRUE if overlaying both channels
  * \param channel	which channel we are drawing
  */
 void
-setTraceColor( cairo_t *cr,gboolean bOverlay, eChannel channel ) {
+setTraceColor( cairo_t *cr, tGlobal *pGlobal, gboolean bOverlay, eChannel channel ) {
 	if( bOverlay ) {
 		if ( channel == eCH_ONE ) {
-		    gdk_cairo_set_source_rgba (cr, &plotElementColors[ eColorTrace1   ] );
+		    gdk_cairo_set_source_rgba (cr, &pGlobal->plotElementColors[ eColorTrace1   ] );
 		} else {
-            gdk_cairo_set_source_rgba (cr, &plotElementColors[ eColorTrace2   ] );
+            gdk_cairo_set_source_rgba (cr, &pGlobal->plotElementColors[ eColorTrace2   ] );
 		}
 	} else {
-        gdk_cairo_set_source_rgba (cr, &plotElementColors[ eColorTraceSeparate  ] );
+        gdk_cairo_set_source_rgba (cr, &pGlobal->plotElementColors[ eColorTraceSeparate  ] );
 	}
 }
 
@@ -530,13 +544,13 @@ showStatusInformation (cairo_t *cr, tGridParameters *pGrid, eChannel channel, tG
 
 		if( pGrid->overlay.bAny ) {
 			if ( channel == 0 ) {
-			    gdk_cairo_set_source_rgba (cr, &plotElementColors[ eColorTrace1   ] );
+			    gdk_cairo_set_source_rgba (cr, &pGlobal->plotElementColors[ eColorTrace1   ] );
 			} else {
-			    gdk_cairo_set_source_rgba (cr, &plotElementColors[ eColorTrace2   ] );
+			    gdk_cairo_set_source_rgba (cr, &pGlobal->plotElementColors[ eColorTrace2   ] );
 				xOffset = 5.0 * pGrid->gridWidth / NHGRIDS;
 			}
 		} else {
-		    gdk_cairo_set_source_rgba (cr, &plotElementColors[ eColorTraceSeparate   ] );
+		    gdk_cairo_set_source_rgba (cr, &pGlobal->plotElementColors[ eColorTraceSeparate   ] );
 		}
 		multiLineText( cr, optMeasurementType[ pChannel->measurementType ].desc,
 				1, lineSpacing, pGrid->leftGridPosn + xOffset, pGrid->areaHeight, eTopLeft );
@@ -684,7 +698,7 @@ showStimulusInformation (cairo_t *cr, tGridParameters *pGrid, eChannel channel,
 	if( pGrid->overlay.bAny && pGrid->bSourceCoupled && channel != 0 )
 		return TRUE;
 
-	setTraceColor( cr, pGrid->overlay.bAny, channel );
+	setTraceColor( cr, pGlobal, pGrid->overlay.bAny, channel );
 
 	// x labels
 	switch ( pChannel->sweepType ) {
@@ -756,7 +770,7 @@ showStimulusInformation (cairo_t *cr, tGridParameters *pGrid, eChannel channel,
 		setCairoFontSize(cr, pGrid->fontSize * 0.8); // slighly smaller font
 		// if the sources are coupled or we do not have an overlay, use distinct color
 		if( !pGrid->overlay.bAny || pGrid->bSourceCoupled )
-		    gdk_cairo_set_source_rgba (cr, &plotElementColors[ eColorTextSpanPerDivCoupled   ] );
+		    gdk_cairo_set_source_rgba (cr, &pGlobal->plotElementColors[ eColorTextSpanPerDivCoupled   ] );
 
 		if( pChannel->sweepType == eSWP_LINFREQ &&
 				( pChannel->format != eFMT_SMITH && pChannel->format != eFMT_POLAR)) {
@@ -782,21 +796,22 @@ showStimulusInformation (cairo_t *cr, tGridParameters *pGrid, eChannel channel,
  *
  * \param cr	     pointer to cairo structure
  * \param pGrid      pointer to grid structure
+ * \param pGlobal    pointer to global data (for the colors and options)
  * \param sTitle	 pointer to title string
  * \param sTime   	 pointer to time string
  */
 void
-showTitleAndTime( cairo_t *cr, tGridParameters *pGrid, gchar *sTitle, gchar *sTime)
+showTitleAndTime( cairo_t *cr, tGridParameters *pGrid, tGlobal *pGlobal, gchar *sTitle, gchar *sTime)
 {
 	cairo_save( cr ); {
 		cairo_reset_clip( cr );
 		cairo_set_matrix (cr, &pGrid->initialMatrix);
-		gdk_cairo_set_source_rgba (cr, &plotElementColors[ eColorTextTitle ] );
+		gdk_cairo_set_source_rgba (cr, &pGlobal->plotElementColors[ eColorTextTitle ] );
 
 		cairo_select_font_face(cr, LABEL_FONT, CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_BOLD);
 		setCairoFontSize(cr, pGrid->fontSize * 1.3); // initially 10 pixels
 
-		if( globalData.flags.bHPlogo ) {
+		if( pGlobal->flags.bHPlogo ) {
             cairo_move_to( cr, pGrid->leftGridPosn - pGrid->gridHeight / NVGRIDS * 0.60,
                     pGrid->areaHeight-(pGrid->lineSpacing * 1.45));
             cairo_renderHewlettPackardLogo(cr, TRUE, FALSE, 1.0, pGrid->gridHeight / NVGRIDS * 0.30 );
@@ -829,11 +844,12 @@ calculateSegmentLinearlyInterpolatedResponse( gint nStart, gint nEnd, tChannel *
     gint nHead = nStart, nTail = nEnd;
     gint nMid = (nHead + nTail) / 2;
     gdouble xFract = 0.0;
+    gdouble *stimulusPoints = getStimulusPoints( pChannel );
 
     while ( nHead <= nTail )  {
-        if ( pChannel->stimulusPoints[nMid] < stimulus ) {
+        if ( stimulusPoints[nMid] < stimulus ) {
         	nHead = nMid + 1;
-        } else if ( pChannel->stimulusPoints[nMid] == stimulus ) {
+        } else if ( stimulusPoints[nMid] == stimulus ) {
         	return pChannel->responsePoints[nMid].r;
         } else {
         	nTail = nMid - 1;
@@ -842,8 +858,8 @@ calculateSegmentLinearlyInterpolatedResponse( gint nStart, gint nEnd, tChannel *
     }
 
     if( nHead > nTail ) {
-    	xFract = (stimulus - pChannel->stimulusPoints[nMid]) /
-    			(pChannel->stimulusPoints[nMid+1] - pChannel->stimulusPoints[nMid]);
+    	xFract = (stimulus - stimulusPoints[nMid]) /
+    			(stimulusPoints[nMid+1] - stimulusPoints[nMid]);
     	return LIN_INTERP( pChannel->responsePoints[nMid].r,
     				pChannel->responsePoints[nMid+1].r, xFract );
     }
@@ -851,19 +867,20 @@ calculateSegmentLinearlyInterpolatedResponse( gint nStart, gint nEnd, tChannel *
 }
 
 
-/*!     \brief  Plot the first channel
- *
- * Draw the plot for the first channel onto either the drawing area or to another
- * cairo device (printing, image etc)
+/*!     \brief  Plot layers of the first channel
  *
  * \param areaWidth	 width (in points) of the cairo drawing area
  * \param areaHeight height (in points) of the cairo drawing area
  * \param margin     margin (in points )
  * \param cr		 pointer to cairo structure
  * \param pGlobal	 pointer to the global data structure
+ * \param layers     PLOT_LAYER_ bits of the layers to draw
+ * \param pGridUsed  grid positions are returned here (or NULL)
  * \return			 FALSE
  */
-gboolean plotA (guint areaWidth, guint areaHeight, gdouble margin, cairo_t *cr, tGlobal *pGlobal)
+static gboolean
+plotLayersA (guint areaWidth, guint areaHeight, gdouble margin, cairo_t *cr, tGlobal *pGlobal,
+        guint layers, tGridParameters *pGridUsed)
 {
     // If we have dual display and it is not split, we show both traces on this DrawingArea
     gboolean bOverlay = !(pGlobal->HP8753.flags.bShowHPGLplot && pGlobal->HP8753.flags.bHPGLdataValid) &&
@@ -876,7 +893,7 @@ gboolean plotA (guint areaWidth, guint areaHeight, gdouble margin, cairo_t *cr,
     areaWidth  -= 2 * margin;
     areaHeight -= 2 * margin;
 
-    tGridParameters grid = {.areaWidth = areaWidth, .areaHeight = areaHeight, .margin = margin, 0};
+    tGridParameters grid = {.areaWidth = areaWidth, .areaHeight = areaHeight, .margin = margin, .layers = layers, 0};
 
 #if 0
     pGlobal->HP8753.channels[ 0 ].format = HP8753C_FMT_SMITH;
@@ -887,42 +904,29 @@ gboolean plotA (guint areaWidth, guint areaHeight, gdouble margin, cairo_t *cr,
 
 	if( pGlobal->HP8753.flags.bShowHPGLplot && pGlobal->HP8753.flags.bHPGLdataValid
 			&& pGlobal->HP8753.channels[ eCH_ONE ].chFlags.bValidData ) {
-		// Screenshot from HPGL
-		plotScreen ( cr, areaHeight, areaWidth, pGlobal);
+		// Screenshot from HPGL (there is no live marker)
+		if( layers & PLOT_LAYER_STATIC )
+			plotScreen ( cr, areaHeight, areaWidth, pGlobal);
+		if( pGridUsed )
+			pGridUsed->gridWidth = 0.0;
 	} else {
 		// Plot derived from data
 		determineGridPosition( cr, pGlobal, eCH_ONE, &grid );
+		if( pGridUsed )
+			*pGridUsed = grid;
 
 		if( !pGlobal->HP8753.channels[ eCH_ONE ].chFlags.bValidData ) {
 			// cairo_move_to( cr, stGrid.areaWidth * 0.2, stGrid.areaHeight * .50 );
-			drawHPlogo ( cr, pGlobal->HP8753.sProduct, grid.areaWidth / 2.0, grid.areaHeight * .20, grid.fontSize / 18.0 );
+			if( layers & PLOT_LAYER_STATIC )
+				drawHPlogo ( cr, pGlobal->HP8753.sProduct, grid.areaWidth / 2.0, grid.areaHeight * .20, grid.fontSize / 18.0 );
 			return TRUE;
 		}
 
-		showStatusInformation (cr, &grid, eCH_ONE, pGlobal);
-
-		switch ( pGlobal->HP8753.channels[ 0 ].format ) {
-		case eFMT_LOGM:
-		case eFMT_PHASE:
-		case eFMT_DELAY:
-		case eFMT_LINM:
-		case eFMT_REAL:
-		case eFMT_IMAG:
-		case eFMT_SWR:
-			plotCartesianGrid(cr, &grid, eCH_ONE, pGlobal);
-			break;
-		case eFMT_SMITH:
-			plotSmithGrid( cr, TRUE, &grid, eCH_ONE, pGlobal);
-			break;
-		case eFMT_POLAR:
-			plotPolarGrid (cr, TRUE, &grid, eCH_ONE, pGlobal);
-			break;
-		}
-
-		if ( bOverlay ) {
-			showStatusInformation (cr, &grid, eCH_TWO, pGlobal);
+		// grid and annotation (the traces set up their own transforms)
+		if( layers & PLOT_LAYER_STATIC ) {
+			showStatusInformation (cr, &grid, eCH_ONE, pGlobal);
 
-			switch ( pGlobal->HP8753.channels[ eCH_TWO ].format ) {
+			switch ( pGlobal->HP8753.channels[ 0 ].format ) {
 			case eFMT_LOGM:
 			case eFMT_PHASE:
 			case eFMT_DELAY:
@@ -930,15 +934,37 @@ gboolean plotA (guint areaWidth, guint areaHeight, gdouble margin, cairo_t *cr,
 			case eFMT_REAL:
 			case eFMT_IMAG:
 			case eFMT_SWR:
-				plotCartesianGrid(cr, &grid, eCH_TWO, pGlobal);
+				plotCartesianGrid(cr, &grid, eCH_ONE, pGlobal);
 				break;
 			case eFMT_SMITH:
-				plotSmithGrid(cr, TRUE, &grid, eCH_TWO, pGlobal);
+				plotSmithGrid( cr, TRUE, &grid, eCH_ONE, pGlobal);
 				break;
 			case eFMT_POLAR:
-				plotPolarGrid(cr, TRUE, &grid, 1, pGlobal);
+				plotPolarGrid (cr, TRUE, &grid, eCH_ONE, pGlobal);
 				break;
 			}
+
+			if ( bOverlay ) {
+				showStatusInformation (cr, &grid, eCH_TWO, pGlobal);
+
+				switch ( pGlobal->HP8753.channels[ eCH_TWO ].format ) {
+				case eFMT_LOGM:
+				case eFMT_PHASE:
+				case eFMT_DELAY:
+				case eFMT_LINM:
+				case eFMT_REAL:
+				case eFMT_IMAG:
+				case eFMT_SWR:
+					plotCartesianGrid(cr, &grid, eCH_TWO, pGlobal);
+					break;
+				case eFMT_SMITH:
+					plotSmithGrid(cr, TRUE, &grid, eCH_TWO, pGlobal);
+					break;
+				case eFMT_POLAR:
+					plotPolarGrid(cr, TRUE, &grid, 1, pGlobal);
+					break;
+				}
+			}
 		}
 
 		switch ( pGlobal->HP8753.channels[ eCH_ONE ].format ) {
@@ -978,6 +1004,157 @@ gboolean plotA (guint areaWidth, guint areaHeight, gdouble margin, cairo_t *cr,
     return FALSE;
 }
 
+/*!     \brief  Plot the first channel
+ *
+ * Draw the plot for the first channel onto either the drawing area or to another
+ * cairo device (printing, image etc)
+ *
+ * \param areaWidth	 width (in points) of the cairo drawing area
+ * \param areaHeight height (in points) of the cairo drawing area
+ * \param margin     margin (in points )
+ * \param cr		 pointer to cairo structure
+ * \param pGlobal	 pointer to the global data structure
+ * \return			 FALSE
+ */
+gboolean plotA (guint areaWidth, guint areaHeight, gdouble margin, cairo_t *cr, tGlobal *pGlobal)
+{
+    return plotLayersA( areaWidth, areaHeight, margin, cr, pGlobal, PLOT_LAYER_ALL, NULL );
+}
+
+/*!     \brief  Mark the cached static layers of the screen plots as out of date
+ *
+ * Called whenever anything but the live marker changes what is plotted
+ * (the trace data, options, colors etc.) before the drawing areas are queued for drawing.
+ */
+void
+invalidatePlotCache( void ) {
+    for( gint i = 0; i < eNUM_CH; i++ )
+        plotCache[ i ].bValid = FALSE;
+}
+
+/*!     \brief  Draw a drawing area from its cached static layer
+ *
+ * The static layer (grid, annotation, traces and markers) is rendered to an
+ * image surface when the cache is out of date or the size or scale of the area
+ * has changed. Then only the live marker is drawn over it.
+ *
+ * \param widget        pointer to GtkDrawingArea widget
+ * \param cr            pointer to cairo structure
+ * \param areaWidth     width
+ * \param areaHeight    height
+ * \param pCache        cache of the area
+ * \param plotLayers    function to plot the layers
+ * \param pGlobal       pointer to the global data structure
+ */
+static void
+drawCachedPlot( GtkDrawingArea *widget, cairo_t *cr, gint areaWidth, gint areaHeight, tPlotCache *pCache,
+        gboolean (*plotLayers)(guint, guint, gdouble, cairo_t *, tGlobal *, guint, tGridParameters *),
+        tGlobal *pGlobal )
+{
+    gint scale = gtk_widget_get_scale_factor( GTK_WIDGET( widget ) );
+    gint64 startTime = g_get_monotonic_time(), drawTime;
+    tGridParameters grid = { 0 };
+
+    if( !pCache->bValid || pCache->pSurface == NULL
+            || pCache->width != areaWidth || pCache->height != areaHeight || pCache->scale != scale ) {
+        cairo_t *crCache;
+
+        if( pCache->pSurface == NULL
+                || pCache->width != areaWidth || pCache->height != areaHeight || pCache->scale != scale ) {
+            g_clear_pointer( &pCache->pSurface, cairo_surface_destroy );
+            pCache->pSurface = cairo_surface_create_similar_image( cairo_get_target( cr ), CAIRO_FORMAT_RGB24,
+                    areaWidth * scale, areaHeight * scale );
+            cairo_surface_set_device_scale( pCache->pSurface, scale, scale );
+            pCache->width = areaWidth;
+            pCache->height = areaHeight;
+            pCache->scale = scale;
+        }
+
+        crCache = cairo_create( pCache->pSurface );
+        // clear the screen
+        cairo_set_source_rgba (crCache, 1.0, 1.0, 1.0, 1.0 );
+        cairo_paint( crCache );
+        plotLayers( areaWidth, areaHeight, 0.0, crCache, pGlobal, PLOT_LAYER_STATIC, NULL );
+        cairo_destroy( crCache );
+        pCache->bValid = TRUE;
+        pCache->nStaticFrames++;
+    }
+
+    cairo_set_source_surface( cr, pCache->pSurface, 0.0, 0.0 );
+    cairo_paint( cr );
+
+    plotLayers( areaWidth, areaHeight, 0.0, cr, pGlobal, PLOT_LAYER_LIVE, &grid );
+    // the live marker is only drawn when the mouse is over the grid
+    pCache->liveLeft = grid.leftGridPosn;
+    pCache->liveRight = grid.leftGridPosn + grid.gridWidth;
+
+    drawTime = g_get_monotonic_time() - startTime;
+    pCache->drawTime += drawTime;
+    pCache->maxDrawTime = MAX( pCache->maxDrawTime, drawTime );
+#define FRAME_STATISTICS_INTERVAL   100
+    if( ++pCache->nFrames == FRAME_STATISTICS_INTERVAL ) {
+        GdkFrameClock *frameClock = gtk_widget_get_frame_clock( GTK_WIDGET( widget ) );
+
+        DBG( eDEBUG_TESTING, "Plot %c: %u frames, draw %.2f ms average %.2f ms max, "
+                "static layer drawn %u times, %.1f fps",
+                pCache == &plotCache[ eCH_ONE ] ? 'A' : 'B', pCache->nFrames,
+                pCache->drawTime / 1000.0 / pCache->nFrames, pCache->maxDrawTime / 1000.0,
+                pCache->nStaticFrames, frameClock ? gdk_frame_clock_get_fps( frameClock ) : 0.0 );
+        pCache->nFrames = pCache->nStaticFrames = 0;
+        pCache->drawTime = pCache->maxDrawTime = 0;
+    }
+}
+
+/*!     \brief  Tick callback on the frame following a move of the live marker
+ *
+ * \param widget        drawing area
+ * \param frameClock    frame clock
+ * \param gpCache       cache of the area
+ * \return              G_SOURCE_REMOVE
+ */
+static gboolean
+CB_liveMarkerTick( GtkWidget *widget, GdkFrameClock *frameClock, gpointer gpCache )
+{
+    tPlotCache *pCache = (tPlotCache *)gpCache;
+
+    pCache->tickId = 0;
+    gtk_widget_queue_draw( widget );
+    return G_SOURCE_REMOVE;
+}
+
+/*!     \brief  Redraw the live marker on the areas where it has moved
+ *
+ * Mouse motion arrives faster than the display refreshes so the draw of each
+ * area is queued on the next tick of the frame clock (once per frame).
+ * An area is not redrawn if the live marker is held or the mouse was and is
+ * outside its grid (the live marker follows the x position only).
+ *
+ * \param pGlobal       pointer to the global data structure
+ * \param xOld          previous x position of the mouse
+ * \param xNew          new x position of the mouse
+ */
+void
+queueLiveMarkerDraw( tGlobal *pGlobal, gdouble xOld, gdouble xNew )
+{
+    GtkWidget *wDrawingAreas[ eNUM_CH ] = { pGlobal->widgets[ eW_drawingArea_Plot_A ],
+                                            pGlobal->widgets[ eW_drawingArea_Plot_B ] };
+
+    if( pGlobal->flags.bHoldLiveMarker || xOld == xNew )
+        return;
+
+    for( eChannel channel = eCH_ONE; channel < eNUM_CH; channel++ ) {
+        tPlotCache *pCache = &plotCache[ channel ];
+        gboolean bOldOnGrid = xOld >= pCache->liveLeft && xOld <= pCache->liveRight;
+        gboolean bNewOnGrid = xNew >= pCache->liveLeft && xNew <= pCache->liveRight;
+
+        if( !gtk_widget_is_drawable( wDrawingAreas[ channel ] ) || pCache->tickId != 0 )
+            continue;
+        if( pCache->bValid && !bOldOnGrid && !bNewOnGrid )
+            continue;
+        pCache->tickId = gtk_widget_add_tick_callback( wDrawingAreas[ channel ], CB_liveMarkerTick, pCache, NULL );
+    }
+}
+
 /*!     \brief  Signal received to draw the drawing area
  *
  * Draw the plot for area A
@@ -994,26 +1171,23 @@ CB_drawingArea_A_Draw ( GtkDrawingArea *widget, cairo_t *cr,
 {
     tGlobal *pGlobal = (tGlobal *)g_object_get_data(G_OBJECT( widget ), "data");
 
-    // clear the screen
-	cairo_set_source_rgba (cr, 1.0, 1.0, 1.0, 1.0 );
-	cairo_paint( cr );
-
-    plotA ( areaWidth,  areaHeight, 0, cr, pGlobal);
+    drawCachedPlot( widget, cr, areaWidth, areaHeight, &plotCache[ eCH_ONE ], plotLayersA, pGlobal );
 }
 
-/*!     \brief  Plot the second channel
- *
- * Draw the plot for the second channel onto either the drawing area or to another
- * cairo device (printing, image etc)
+/*!     \brief  Plot layers of the second channel
  *
  * \param areaWidth	 width (in points) of the cairo drawing area
  * \param areaHeight height (in points) of the cairo drawing area
  * \param margin     margin (used for PDF and print)
  * \param cr		 pointer to cairo structure
  * \param pGlobal	 pointer to the global data structure
+ * \param layers     PLOT_LAYER_ bits of the layers to draw
+ * \param pGridUsed  grid positions are returned here (or NULL)
  * \return			 FALSE
  */
-gboolean plotB (guint areaWidth, guint areaHeight, gdouble margin, cairo_t *cr, tGlobal *pGlobal)
+static gboolean
+plotLayersB (guint areaWidth, guint areaHeight, gdouble margin, cairo_t *cr, tGlobal *pGlobal,
+        guint layers, tGridParameters *pGridUsed)
 {
     cairo_translate( cr, margin, margin );
     removeFontHinting( cr );
@@ -1022,7 +1196,7 @@ gboolean plotB (guint areaWidth, guint areaHeight, gdouble margin, cairo_t *cr,
     areaWidth  -= 2 * margin;
     areaHeight -= 2 * margin;
 
-    tGridParameters grid = {.areaWidth = areaWidth, .areaHeight = areaHeight, .margin = margin, 0};
+    tGridParameters grid = {.areaWidth = areaWidth, .areaHeight = areaHeight, .margin = margin, .layers = layers, 0};
 
 //	if( !pGlobal->HP8753.channels[ eCH_TWO ].chFlags.bValidData )
 //		return FALSE;
@@ -1030,11 +1204,14 @@ gboolean plotB (guint areaWidth, guint areaHeight, gdouble margin, cairo_t *cr,
 	flipVertical( cr, &grid );
 
 	determineGridPosition( cr, pGlobal, eCH_TWO, &grid );
+	if( pGridUsed )
+		*pGridUsed = grid;
 	if( !pGlobal->HP8753.channels[ eCH_TWO ].chFlags.bValidData ) {
 		return TRUE;
 	}
 
-	showStatusInformation (cr, &grid, eCH_TWO, pGlobal);
+	if( layers & PLOT_LAYER_STATIC )
+		showStatusInformation (cr, &grid, eCH_TWO, pGlobal);
 
 	switch ( pGlobal->HP8753.channels[ eCH_TWO ].format ) {
 	case eFMT_LOGM:
@@ -1044,15 +1221,18 @@ gboolean plotB (guint areaWidth, guint areaHeight, gdouble margin, cairo_t *cr,
 	case eFMT_REAL:
 	case eFMT_IMAG:
 	case eFMT_SWR:
-		plotCartesianGrid(cr, &grid, eCH_TWO, pGlobal);
+		if( layers & PLOT_LAYER_STATIC )
+			plotCartesianGrid(cr, &grid, eCH_TWO, pGlobal);
 		plotCartesianTrace (cr, &grid, eCH_TWO, pGlobal);
 		break;
 	case eFMT_SMITH:
-        plotSmithGrid( cr, TRUE, &grid, eCH_TWO, pGlobal);
+		if( layers & PLOT_LAYER_STATIC )
+			plotSmithGrid( cr, TRUE, &grid, eCH_TWO, pGlobal);
         plotSmithAndPolarTrace (cr, &grid, eCH_TWO, pGlobal);
         break;
 	case eFMT_POLAR:
-		plotPolarGrid( cr, TRUE, &grid, eCH_TWO, pGlobal);
+		if( layers & PLOT_LAYER_STATIC )
+			plotPolarGrid( cr, TRUE, &grid, eCH_TWO, pGlobal);
 		plotSmithAndPolarTrace (cr, &grid, eCH_TWO, pGlobal);
  		break;
 	}
@@ -1060,6 +1240,23 @@ gboolean plotB (guint areaWidth, guint areaHeight, gdouble margin, cairo_t *cr,
     return FALSE;
 }
 
+/*!     \brief  Plot the second channel
+ *
+ * Draw the plot for the second channel onto either the drawing area or to another
+ * cairo device (printing, image etc)
+ *
+ * \param areaWidth	 width (in points) of the cairo drawing area
+ * \param areaHeight height (in points) of the cairo drawing area
+ * \param margin     margin (used for PDF and print)
+ * \param cr		 pointer to cairo structure
+ * \param pGlobal	 pointer to the global data structure
+ * \return			 FALSE
+ */
+gboolean plotB (guint areaWidth, guint areaHeight, gdouble margin, cairo_t *cr, tGlobal *pGlobal)
+{
+    return plotLayersB( areaWidth, areaHeight, margin, cr, pGlobal, PLOT_LAYER_ALL, NULL );
+}
+
 /*!     \brief  Signal received to draw the drawing area
  *
  * Draw the plot for area B
@@ -1076,11 +1273,7 @@ CB_drawingArea_B_Draw ( GtkDrawingArea *widget, cairo_t *cr,
 {
     tGlobal *pGlobal = (tGlobal *)g_object_get_data(G_OBJECT( widget ), "data");
 
-    // clear the screen
-	cairo_set_source_rgba (cr, 1.0, 1.0, 1.0, 1.0 );
-	cairo_paint( cr );
-
-    plotB ( areaWidth,  areaHeight, 0.0, cr, pGlobal);
+    drawCachedPlot( widget, cr, areaWidth, areaHeight, &plotCache[ eCH_TWO ], plotLayersB, pGlobal );
 }
 
 /*!     \brief  Show or hide plot b
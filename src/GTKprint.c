@@ -25,31 +25,79 @@
 #include "hp8753.h"
 #include "calibrationKit.h"
 #include "messageEvent.h"
+#include "exportWorker.h"
+
+#define HEADER_HEIGHT 10
+#define PRINT_MARGIN    (72.0 * 0.10)     // 0.10 inches
+
+/*!     \brief  Draw a printed page into a recording surface (export worker thread)
+ *
+ * \param  pJob       the page to print
+ * \return            OK or ERROR
+ */
+static gint
+renderPrintPage( tExportJob *pJob ) {
+	cairo_rectangle_t extents = { 0.0, 0.0, pJob->width, pJob->height };
+	cairo_t *cr;
+
+	pJob->pRecording = cairo_recording_surface_create( CAIRO_CONTENT_COLOR_ALPHA, &extents );
+	cr = cairo_create( pJob->pRecording );
+	if( pJob->page == 0)
+		plotA ( pJob->width, pJob->height, PRINT_MARGIN, cr, pJob->pExport->pSnapshot );
+	else
+		plotB ( pJob->width, pJob->height, PRINT_MARGIN, cr, pJob->pExport->pSnapshot );
+	cairo_destroy( cr );
+
+	return cairo_surface_status( pJob->pRecording ) == CAIRO_STATUS_SUCCESS ? OK : ERROR;
+}
+
+/*!     \brief  Hand a rendered page to GTK (main loop)
+ *
+ * The page must be finished even if it was not drawn (cancelled) or GTK waits for it.
+ *
+ * \param  pGlobal    pointer to data
+ * \param  pJob       the page printed
+ */
+static void
+completePrintPage( tGlobal *pGlobal, tExportJob *pJob ) {
+	if( pJob->status == OK ) {
+		cairo_t *cr = gtk_print_context_get_cairo_context( GTK_PRINT_CONTEXT( pJob->pPrintContext ) );
+		cairo_save( cr );
+		cairo_set_source_surface( cr, pJob->pRecording, 0.0, 0.0 );
+		cairo_paint( cr );
+		cairo_restore( cr );
+	}
+	if( pJob->pExport->pPrintOp )
+		gtk_print_operation_draw_page_finish( pJob->pExport->pPrintOp );
+}
+
 /*!     \brief  Callback to draw plots for printing
  *
+ * The page is drawn by an export worker from the snapshot taken when printing
+ * started. Drawing is deferred until it is complete (completePrintPage).
  *
  * \param  operation  pointer to GTK print operation structure
  * \param  context	  pointer to GTK print context structure
  * \param  pageNo	  page number
- * \param  pGlobal    pointer to data
+ * \param  pExport    the print export
  */
-#define HEADER_HEIGHT 10
 static void
 CB_PrintDrawPage (GtkPrintOperation *operation,
            GtkPrintContext   *context,
            gint               pageNo,
-		   tGlobal *          pGlobal)
+		   tExport *          pExport)
 {
-	  cairo_t *cr;
-	  gdouble height, width;
-#define PRINT_MARGIN    (72.0 * 0.10)     // 0.10 inches
-	  cr = gtk_print_context_get_cairo_context (context);
-	  height = gtk_print_context_get_height( context );
-	  width = gtk_print_context_get_width (context);
-	  if( pageNo == 0)
-		  plotA ( width, height, PRINT_MARGIN, cr, pGlobal);
-	  else
-		  plotB ( width, height, PRINT_MARGIN, cr, pGlobal);
+	  tExportJob *pJob = g_new0( tExportJob, 1 );
+
+	  gtk_print_operation_set_defer_drawing( operation );
+
+	  pJob->render = renderPrintPage;
+	  pJob->complete = completePrintPage;
+	  pJob->page = pageNo;
+	  pJob->height = gtk_print_context_get_height( context );
+	  pJob->width = gtk_print_context_get_width (context);
+	  pJob->pPrintContext = g_object_ref( context );
+	  queueExportJob( pExport, pJob );
 }
 
 /*!     \brief  Callback when printing commences
@@ -58,12 +106,13 @@ CB_PrintDrawPage (GtkPrintOperation *operation,
  *
  * \param  printOp  pointer to GTK print operation structure
  * \param  context	pointer to GTK print context structure
- * \param  pGlobal  pointer to data
+ * \param  pExport  the print export
  */
 static void
 CB_PrintBegin (GtkPrintOperation *printOp,
-           GtkPrintContext   *context, tGlobal *pGlobal)
+           GtkPrintContext   *context, tExport *pExport)
 {
+	tGlobal *pGlobal = pExport->pSnapshot;
 	gint pageNos = 1;
 	gboolean bHPGL = (pGlobal->HP8753.flags.bShowHPGLplot && pGlobal->HP8753.flags.bHPGLdataValid);
 	if( (pGlobal->HP8753.flags.bDualChannel && pGlobal->HP8753.flags.bSplitChannels)
@@ -114,10 +163,14 @@ CB_btn_Print (GtkButton *wButton, gpointer udata)
 {
 	  GtkPrintOperation *printOp;
 	  GtkPrintOperationResult res;
+	  tExport *pExport;
 
 	    tGlobal *pGlobal = (tGlobal *)g_object_get_data(G_OBJECT( wButton ), "data");
 
 	  printOp = gtk_print_operation_new ();
+	  // print what is shown now (the pages are drawn by the export workers)
+	  pExport = newExport( pGlobal, NULL );
+	  pExport->pPrintOp = printOp;
 
 	  if (pGlobal->printSettings != NULL)
 	    gtk_print_operation_set_print_settings (printOp, pGlobal->printSettings);
@@ -125,8 +178,8 @@ CB_btn_Print (GtkButton *wButton, gpointer udata)
 	  if (pGlobal->pageSetup != NULL)
 		  gtk_print_operation_set_default_page_setup (printOp, pGlobal->pageSetup);
 
-	  g_signal_connect(printOp, "begin_print", G_CALLBACK (CB_PrintBegin), pGlobal);
-	  g_signal_connect(printOp, "draw_page", G_CALLBACK (CB_PrintDrawPage), pGlobal);
+	  g_signal_connect(printOp, "begin_print", G_CALLBACK (CB_PrintBegin), pExport);
+	  g_signal_connect(printOp, "draw_page", G_CALLBACK (CB_PrintDrawPage), pExport);
 	  g_signal_connect(printOp, "request-page-setup", G_CALLBACK(CB_PrintRequestPageSetup), pGlobal);
 	  g_signal_connect(printOp, "done", G_CALLBACK(CB_PrintDone), pGlobal);
 
@@ -137,6 +190,7 @@ CB_btn_Print (GtkButton *wButton, gpointer udata)
 
 	  res = gtk_print_operation_run (printOp, GTK_PRINT_OPERATION_ACTION_PRINT_DIALOG,
 			  GTK_WINDOW( pGlobal->widgets[ eW_hp8753_main ] ), NULL);
+	  releaseExport( pExport );
 
 	  if (res == GTK_PRINT_OPERATION_RESULT_APPLY)
 	    {
@@ -0,0 +1,410 @@
+/*
+ * Copyright (c) 2026 Michael G. Katzmann
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/*! \file GTKprofileBrowser.c
+ * Searchable browser of the calibration and trace profiles (all projects).
+ *
+ * The browser is opened from the search icon in the calibration or trace profile
+ * entry. The model of the GtkColumnView holds only the row identifiers from the
+ * full text index (searchProfiles()). A row is fetched from the database when
+ * it is first bound, so only the rows scrolled into view are read.
+ *
+ * Hovering over a trace profile shows its thumbnail (drawn when the trace was
+ * saved, or in the background for older profiles) so the trace need not be recalled
+ * to see what it looks like.
+ */
+
+#include <gtk/gtk.h>
+#include <glib-2.0/glib.h>
+#include <string.h>
+
+#include "hp8753.h"
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+
+#define PB_ROW      "row"       // object data key of the tProfileSearchRow on a model item
+#define PB_KIND     "kind"      // object data key of the tDBtable being browsed
+#define PB_ITEM     "item"      // object data key of the model item shown by a cell
+#define PB_THUMBNAIL "thumbnail" // object data key of the GdkTexture thumbnail on a model item
+
+enum { ePB_COL_PROJECT, ePB_COL_NAME, ePB_COL_TITLE, ePB_COL_TIME, ePB_N_COLS };
+
+/*!     \brief  Get the profile data for an item of the browser model
+ *
+ * The row is fetched from the database the first time and kept with the item.
+ *
+ * \param  pItem    GtkStringObject holding the row identifier
+ * \return          pointer to the row data (or NULL if it no longer exists)
+ */
+static tProfileSearchRow *
+getBrowserRow( GtkStringObject *pItem ) {
+    tProfileSearchRow *pRow = g_object_get_data( G_OBJECT( pItem ), PB_ROW );
+
+    if( pRow == NULL ) {
+        pRow = fetchProfileSearchRow( g_ascii_strtoll( gtk_string_object_get_string( pItem ), NULL, 10 ) );
+        if( pRow )
+            g_object_set_data_full( G_OBJECT( pItem ), PB_ROW, pRow, freeProfileSearchRow );
+    }
+    return pRow;
+}
+
+/*!     \brief  Get the thumbnail of a trace profile item of the browser model
+ *
+ * The thumbnail is read from the database the first time it is shown and kept with the item.
+ *
+ * \param  pItem    GtkStringObject holding the row identifier
+ * \return          GdkTexture (owned by the item) or NULL if there is no thumbnail yet
+ */
+static GdkTexture *
+getBrowserThumbnail( GtkStringObject *pItem ) {
+    GdkTexture *pTexture = g_object_get_data( G_OBJECT( pItem ), PB_THUMBNAIL );
+    gint64 rowID;
+    guchar *thumbnail;
+    gsize thumbnailSize;
+
+    if( pTexture == NULL ) {
+        // the search index rowid of a trace profile is twice its row in HP8753C_TRACEDATA plus one
+        rowID = g_ascii_strtoll( gtk_string_object_get_string( pItem ), NULL, 10 );
+        if( (thumbnail = fetchTraceThumbnail( (rowID - 1) / 2, &thumbnailSize )) != NULL ) {
+            GBytes *pBytes = g_bytes_new_take( thumbnail, thumbnailSize );
+            pTexture = gdk_texture_new_from_bytes( pBytes, NULL );
+            g_bytes_unref( pBytes );
+            if( pTexture )
+                g_object_set_data_full( G_OBJECT( pItem ), PB_THUMBNAIL, pTexture, g_object_unref );
+        }
+    }
+    return pTexture;
+}
+
+/*!     \brief  Re-query the profiles matching the search text
+ *
+ * The model is replaced in one splice so the view gets a single "items-changed".
+ *
+ * \ingroup Profile browser
+ *
+ * \param  pGlobal  pointer to global data
+ */
+static void
+refreshProfileBrowser( tGlobal *pGlobal ) {
+    GtkColumnView *wColumnView = GTK_COLUMN_VIEW( pGlobal->widgets[ eW_PB_cv_Profiles ] );
+    GtkSingleSelection *pSelection = GTK_SINGLE_SELECTION( gtk_column_view_get_model( wColumnView ) );
+    GtkStringList *pRowIDs = GTK_STRING_LIST( gtk_single_selection_get_model( pSelection ) );
+    tDBtable kind = GPOINTER_TO_INT( g_object_get_data( G_OBJECT( pGlobal->widgets[ eW_dlg_Browse ] ), PB_KIND ) );
+    gboolean bThisProject = gtk_check_button_get_active( GTK_CHECK_BUTTON( pGlobal->widgets[ eW_PB_chk_ThisProject ] ) );
+    gboolean bByDate = gtk_check_button_get_active( GTK_CHECK_BUTTON( pGlobal->widgets[ eW_PB_chk_ByDate ] ) );
+    const gchar *sSearch = gtk_editable_get_text( GTK_EDITABLE( pGlobal->widgets[ eW_PB_search_Text ] ) );
+    gchar **sIDs, *sCount;
+    guint nFound;
+
+    sIDs = searchProfiles( kind, bThisProject ? pGlobal->sProject : NULL, sSearch, bByDate );
+    if( sIDs == NULL )
+        return;
+
+    gtk_string_list_splice( pRowIDs, 0, g_list_model_get_n_items( G_LIST_MODEL( pRowIDs ) ),
+            (const gchar * const *)sIDs );
+    nFound = g_strv_length( sIDs );
+    g_strfreev( sIDs );
+
+    sCount = g_strdup_printf( "%u %s profile%s", nFound,
+            kind == eDB_TRACE ? "trace" : "calibration", nFound == 1 ? "" : "s" );
+    gtk_label_set_text( GTK_LABEL( pGlobal->widgets[ eW_PB_lbl_Count ] ), sCount );
+    g_free( sCount );
+}
+
+/*!     \brief  Callback to show the thumbnail of a trace profile when hovering over a browser cell
+ *
+ * \ingroup Profile browser
+ *
+ * \param  wLabel       the GtkLabel of the cell
+ * \param  x            x position of the pointer
+ * \param  y            y position of the pointer
+ * \param  bKeyboard    tooltip triggered by the keyboard
+ * \param  tooltip      the GtkTooltip
+ * \param  udata        unused
+ * \return              TRUE if there is a thumbnail to show
+ */
+static gboolean
+CB_PB_QueryTooltip( GtkWidget *wLabel, gint x, gint y, gboolean bKeyboard,
+        GtkTooltip *tooltip, gpointer udata ) {
+    tGlobal *pGlobal = (tGlobal *)g_object_get_data(G_OBJECT( gtk_widget_get_root( wLabel ) ), "data");
+    GtkStringObject *pItem = g_object_get_data( G_OBJECT( wLabel ), PB_ITEM );
+    GdkTexture *pTexture;
+
+    if( pGlobal == NULL || pItem == NULL
+            || GPOINTER_TO_INT( g_object_get_data( G_OBJECT( pGlobal->widgets[ eW_dlg_Browse ] ), PB_KIND ) ) != eDB_TRACE )
+        return FALSE;
+
+    if( (pTexture = getBrowserThumbnail( pItem )) == NULL )
+        return FALSE;
+
+    gtk_tooltip_set_custom( tooltip, gtk_picture_new_for_paintable( GDK_PAINTABLE( pTexture ) ) );
+    return TRUE;
+}
+
+/*!     \brief  Callback to create the label widget of a browser cell
+ *
+ * \ingroup Profile browser
+ *
+ * \param  factory      the GtkSignalListItemFactory
+ * \param  listItem     the GtkListItem (or GtkColumnViewCell)
+ * \param  udata        unused
+ */
+static void
+CB_PB_SetupCell( GtkSignalListItemFactory *factory, GtkListItem *listItem, gpointer udata ) {
+    GtkWidget *wLabel = gtk_label_new( NULL );
+
+    gtk_label_set_xalign( GTK_LABEL( wLabel ), 0.0 );
+    gtk_label_set_ellipsize( GTK_LABEL( wLabel ), PANGO_ELLIPSIZE_END );
+    gtk_widget_set_has_tooltip( wLabel, TRUE );
+    g_signal_connect( wLabel, "query-tooltip", G_CALLBACK( CB_PB_QueryTooltip ), NULL );
+    gtk_list_item_set_child( listItem, wLabel );
+}
+
+/*!     \brief  Callback when a browser cell no longer shows an item
+ *
+ * \ingroup Profile browser
+ *
+ * \param  factory      the GtkSignalListItemFactory
+ * \param  listItem     the GtkListItem (or GtkColumnViewCell)
+ * \param  udata        unused
+ */
+static void
+CB_PB_UnbindCell( GtkSignalListItemFactory *factory, GtkListItem *listItem, gpointer udata ) {
+    g_object_set_data( G_OBJECT( gtk_list_item_get_child( listItem ) ), PB_ITEM, NULL );
+}
+
+/*!     \brief  Callback to show the profile data in a browser cell
+ *
+ * \ingroup Profile browser
+ *
+ * \param  factory      the GtkSignalListItemFactory
+ * \param  listItem     the GtkListItem (or GtkColumnViewCell)
+ * \param  gColumn      column number (ePB_COL_...)
+ */
+static void
+CB_PB_BindCell( GtkSignalListItemFactory *factory, GtkListItem *listItem, gpointer gColumn ) {
+    GtkLabel *wLabel = GTK_LABEL( gtk_list_item_get_child( listItem ) );
+    tProfileSearchRow *pRow = getBrowserRow( GTK_STRING_OBJECT( gtk_list_item_get_item( listItem ) ) );
+    const gchar *sText = NULL;
+    gchar *sFirstLine = NULL;
+
+    if( pRow ) {
+        switch( GPOINTER_TO_INT( gColumn ) ) {
+        case ePB_COL_PROJECT:
+            sText = pRow->sProject;
+            break;
+        case ePB_COL_NAME:
+            sText = pRow->sName;
+            break;
+        case ePB_COL_TITLE:
+            // calibration profiles have no title, so show the first line of the note
+            if( pRow->sTitle && *pRow->sTitle ) {
+                sText = pRow->sTitle;
+            } else if( pRow->sNote ) {
+                sFirstLine = g_strndup( pRow->sNote, strcspn( pRow->sNote, "\n" ) );
+                sText = sFirstLine;
+            }
+            break;
+        case ePB_COL_TIME:
+            sText = pRow->sDateTime;
+            break;
+        default:
+            break;
+        }
+    }
+    gtk_label_set_text( wLabel, sText ? sText : "" );
+    g_free( sFirstLine );
+    // for the thumbnail tooltip
+    g_object_set_data( G_OBJECT( wLabel ), PB_ITEM, gtk_list_item_get_item( listItem ) );
+}
+
+/*!     \brief  Callback when a profile is activated (double click or Enter) in the browser
+ *
+ * Select the project and then the profile in the main dialog combo boxes. This is
+ * what the user would do by hand and the usual callbacks show the profile information.
+ *
+ * \ingroup Profile browser
+ *
+ * \param  wColumnView  the GtkColumnView
+ * \param  position     row activated
+ * \param  udata        unused
+ */
+static void
+CB_PB_Activate( GtkColumnView *wColumnView, guint position, gpointer udata ) {
+    tGlobal *pGlobal = (tGlobal *)g_object_get_data(G_OBJECT( wColumnView ), "data");
+    GListModel *pModel = G_LIST_MODEL( gtk_column_view_get_model( wColumnView ) );
+    tDBtable kind = GPOINTER_TO_INT( g_object_get_data( G_OBJECT( pGlobal->widgets[ eW_dlg_Browse ] ), PB_KIND ) );
+    GtkStringObject *pItem;
+    tProfileSearchRow *pRow;
+
+    if( position >= g_list_model_get_n_items( pModel ) )
+        return;
+
+    pItem = g_list_model_get_item( pModel, position );
+    if( (pRow = getBrowserRow( pItem )) != NULL ) {
+        GtkComboBox *wProfileCombo = GTK_COMBO_BOX(
+                pGlobal->widgets[ kind == eDB_TRACE ? eW_cbt_TraceProfile : eW_cbt_CalProfile ] );
+
+        if( g_strcmp0( pRow->sProject, pGlobal->sProject ) != 0 )
+            setGtkComboBox( GTK_COMBO_BOX( pGlobal->widgets[ eW_cbt_Project ] ), pRow->sProject );
+        if( setGtkComboBox( wProfileCombo, pRow->sName ) )
+            gtk_widget_set_visible( GTK_WIDGET( pGlobal->widgets[ eW_dlg_Browse ] ), FALSE );
+    }
+    g_object_unref( pItem );
+}
+
+/*!     \brief  Callback when the search text or options change
+ *
+ * \ingroup Profile browser
+ *
+ * \param  wWidget      GtkSearchEntry or GtkCheckButton
+ * \param  udata        unused
+ */
+static void
+CB_PB_SearchChanged( GtkWidget *wWidget, gpointer udata ) {
+    tGlobal *pGlobal = (tGlobal *)g_object_get_data(G_OBJECT( wWidget ), "data");
+    refreshProfileBrowser( pGlobal );
+}
+
+/*!     \brief  Callback when Enter is pressed in the search entry
+ *
+ * Choose the first profile found
+ *
+ * \ingroup Profile browser
+ *
+ * \param  wSearchEntry the GtkSearchEntry
+ * \param  udata        unused
+ */
+static void
+CB_PB_SearchActivate( GtkSearchEntry *wSearchEntry, gpointer udata ) {
+    tGlobal *pGlobal = (tGlobal *)g_object_get_data(G_OBJECT( wSearchEntry ), "data");
+    CB_PB_Activate( GTK_COLUMN_VIEW( pGlobal->widgets[ eW_PB_cv_Profiles ] ), 0, NULL );
+}
+
+/*!     \brief  Callback when Escape is pressed in the search entry
+ *
+ * \ingroup Profile browser
+ *
+ * \param  wSearchEntry the GtkSearchEntry
+ * \param  udata        unused
+ */
+static void
+CB_PB_StopSearch( GtkSearchEntry *wSearchEntry, gpointer udata ) {
+    tGlobal *pGlobal = (tGlobal *)g_object_get_data(G_OBJECT( wSearchEntry ), "data");
+    gtk_widget_set_visible( GTK_WIDGET( pGlobal->widgets[ eW_dlg_Browse ] ), FALSE );
+}
+
+/*!     \brief  Callback when the search icon of the calibration or trace profile entry is pressed
+ *
+ * Show the profile browser for calibration or trace profiles
+ *
+ * \ingroup Profile browser
+ *
+ * \param  wEntry       the GtkEntry of the profile GtkComboBoxText
+ * \param  iconPosition which icon
+ * \param  gKind        eDB_CALandSETUP or eDB_TRACE
+ */
+static void
+CB_PB_Open( GtkEntry *wEntry, GtkEntryIconPosition iconPosition, gpointer gKind ) {
+    tGlobal *pGlobal = (tGlobal *)g_object_get_data(G_OBJECT(gtk_widget_get_root(GTK_WIDGET(wEntry))), "data");
+    GtkWindow *wBrowser = GTK_WINDOW( pGlobal->widgets[ eW_dlg_Browse ] );
+    GListModel *pColumns = gtk_column_view_get_columns( GTK_COLUMN_VIEW( pGlobal->widgets[ eW_PB_cv_Profiles ] ) );
+    gboolean bTrace = ( GPOINTER_TO_INT( gKind ) == eDB_TRACE );
+    GtkColumnViewColumn *pColumn;
+
+    g_object_set_data( G_OBJECT( wBrowser ), PB_KIND, gKind );
+    gtk_window_set_title( wBrowser, bTrace ? "Find Trace Profile" : "Find Calibration Profile" );
+
+    // calibration profiles have no title or time
+    pColumn = g_list_model_get_item( pColumns, ePB_COL_TITLE );
+    gtk_column_view_column_set_title( pColumn, bTrace ? "Title" : "Note" );
+    g_object_unref( pColumn );
+    pColumn = g_list_model_get_item( pColumns, ePB_COL_TIME );
+    gtk_column_view_column_set_visible( pColumn, bTrace );
+    g_object_unref( pColumn );
+    gtk_widget_set_sensitive( pGlobal->widgets[ eW_PB_chk_ByDate ], bTrace );
+
+    // draw the thumbnails of older trace profiles while the user is searching
+    if( bTrace )
+        startThumbnailGeneration();
+
+    refreshProfileBrowser( pGlobal );
+    gtk_window_present( wBrowser );
+    gtk_widget_grab_focus( pGlobal->widgets[ eW_PB_search_Text ] );
+}
+
+/*!     \brief  Initialize the profile browser widgets and callbacks
+ *
+ * \param  pGlobal  pointer to global data
+ * \param  purpose  initialize widgets or callbacks
+ */
+void
+initializeProfileBrowser( tGlobal *pGlobal, tInitFn purpose ) {
+    static const gchar *sColumnTitles[ ePB_N_COLS ] = { "Project", "Name", "Title", "Saved" };
+
+    if( purpose == eUpdateWidgets || purpose == eInitAll ) {
+        GtkColumnView *wColumnView = GTK_COLUMN_VIEW( pGlobal->widgets[ eW_PB_cv_Profiles ] );
+        GtkSingleSelection *pSelection = gtk_single_selection_new( G_LIST_MODEL( gtk_string_list_new( NULL ) ) );
+
+        gtk_single_selection_set_autoselect( pSelection, FALSE );
+        gtk_column_view_set_model( wColumnView, GTK_SELECTION_MODEL( pSelection ) );
+        g_object_unref( pSelection );
+
+        for( gint col = 0; col < ePB_N_COLS; col++ ) {
+            GtkListItemFactory *factory = gtk_signal_list_item_factory_new();
+            g_signal_connect( factory, "setup", G_CALLBACK( CB_PB_SetupCell ), NULL );
+            g_signal_connect( factory, "bind", G_CALLBACK( CB_PB_BindCell ), GINT_TO_POINTER( col ) );
+            g_signal_connect( factory, "unbind", G_CALLBACK( CB_PB_UnbindCell ), NULL );
+
+            GtkColumnViewColumn *pColumn = gtk_column_view_column_new( sColumnTitles[ col ], factory );
+            gtk_column_view_column_set_resizable( pColumn, TRUE );
+            gtk_column_view_column_set_expand( pColumn, col == ePB_COL_TITLE );
+            gtk_column_view_append_column( wColumnView, pColumn );
+            g_object_unref( pColumn );
+        }
+
+        // search icon in the calibration and trace profile entries
+        GtkEntry *wCalEntry = GTK_ENTRY( gtk_combo_box_get_child( GTK_COMBO_BOX( pGlobal->widgets[ eW_cbt_CalProfile ] ) ) );
+        GtkEntry *wTraceEntry = GTK_ENTRY( gtk_combo_box_get_child( GTK_COMBO_BOX( pGlobal->widgets[ eW_cbt_TraceProfile ] ) ) );
+        gtk_entry_set_icon_from_icon_name( wCalEntry, GTK_ENTRY_ICON_SECONDARY, "edit-find-symbolic" );
+        gtk_entry_set_icon_tooltip_text( wCalEntry, GTK_ENTRY_ICON_SECONDARY, "Find a calibration profile" );
+        gtk_entry_set_icon_from_icon_name( wTraceEntry, GTK_ENTRY_ICON_SECONDARY, "edit-find-symbolic" );
+        gtk_entry_set_icon_tooltip_text( wTraceEntry, GTK_ENTRY_ICON_SECONDARY, "Find a trace profile" );
+    }
+
+    if( purpose == eInitCallbacks || purpose == eInitAll ) {
+        g_signal_connect( gtk_combo_box_get_child( GTK_COMBO_BOX( pGlobal->widgets[ eW_cbt_CalProfile ] ) ),
+                "icon-press", G_CALLBACK( CB_PB_Open ), GINT_TO_POINTER( eDB_CALandSETUP ) );
+        g_signal_connect( gtk_combo_box_get_child( GTK_COMBO_BOX( pGlobal->widgets[ eW_cbt_TraceProfile ] ) ),
+                "icon-press", G_CALLBACK( CB_PB_Open ), GINT_TO_POINTER( eDB_TRACE ) );
+
+        // type-to-filter (the search entry delays "search-changed" until typing pauses)
+        g_signal_connect( pGlobal->widgets[ eW_PB_search_Text ], "search-changed",
+                G_CALLBACK( CB_PB_SearchChanged ), NULL );
+        g_signal_connect( pGlobal->widgets[ eW_PB_search_Text ], "activate",
+                G_CALLBACK( CB_PB_SearchActivate ), NULL );
+        g_signal_connect( pGlobal->widgets[ eW_PB_search_Text ], "stop-search",
+                G_CALLBACK( CB_PB_StopSearch ), NULL );
+        g_signal_connect( pGlobal->widgets[ eW_PB_chk_ThisProject ], "toggled",
+                G_CALLBACK( CB_PB_SearchChanged ), NULL );
+        g_signal_connect( pGlobal->widgets[ eW_PB_chk_ByDate ], "toggled",
+                G_CALLBACK( CB_PB_SearchChanged ), NULL );
+        g_signal_connect( pGlobal->widgets[ eW_PB_cv_Profiles ], "activate",
+                G_CALLBACK( CB_PB_Activate ), NULL );
+    }
+}
+#pragma GCC diagnostic pop
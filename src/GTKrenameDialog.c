@@ -21,6 +21,7 @@
 #include <glib-2.0/glib.h>
 
 #include "hp8753.h"
+#include "messageEvent.h"
 
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wdeprecated-declarations"
@@ -47,6 +48,8 @@ SensitizeDR_OKbtn( tGlobal *pGlobal ) {
     gboolean bSensitive = TRUE;
     tProjectAndName projectAndName = {pGlobal->sProject, 0};
 
+    // A clash with a profile of a project that has not been read yet is caught
+    // when OK is pressed (see CB_DR_RenameResponse) .. not on every keystroke
     switch( pGlobal->RMCdialogTarget ) {
     case eProjectName:
         // A project cannot be renamed to an existing project
@@ -59,14 +62,14 @@ SensitizeDR_OKbtn( tGlobal *pGlobal ) {
         if( pGlobal->RMCdialogPurpose == eRename ) {
             // Cannot rename to a cal profile that already exists
             projectAndName.sName = (gchar *)sTargetName;
-            if( g_list_find_custom( pGlobal->pCalList, &projectAndName, (GCompareFunc)compareCalItemsForFind ) != NULL
+            if( catalogLookup( &pGlobal->calCatalog, projectAndName.sProject, projectAndName.sName ) != NULL
                     || strlen(sTargetNameSanitized) == 0 )
                             bSensitive = FALSE;
         } else {
             // Cannot move or copy to a project where the cal profile exists
             projectAndName.sProject = sTargetProject;
             projectAndName.sName = pGlobal->pCalibrationAbstract->projectAndName.sName;
-            if( g_list_find_custom( pGlobal->pCalList, &projectAndName, (GCompareFunc)compareCalItemsForFind ) != NULL
+            if( catalogLookup( &pGlobal->calCatalog, projectAndName.sProject, projectAndName.sName ) != NULL
                     || strlen( sTargetProjectSanitized ) == 0 )
                 bSensitive = FALSE;
             else
@@ -77,14 +80,14 @@ SensitizeDR_OKbtn( tGlobal *pGlobal ) {
         if( pGlobal->RMCdialogPurpose == eRename ) {
             // Cannot rename to a trace profile that already exists
             projectAndName.sName = (gchar *)sTargetName;
-            if( g_list_find_custom( pGlobal->pTraceList, &projectAndName, (GCompareFunc)compareTraceItemsForFind ) != NULL
+            if( catalogLookup( &pGlobal->traceCatalog, projectAndName.sProject, projectAndName.sName ) != NULL
                     || strlen(sTargetNameSanitized) == 0 )
                             bSensitive = FALSE;
         } else {
             // Cannot move or copy to a project where the cal profile exists
             projectAndName.sProject = sTargetProject;
             projectAndName.sName = pGlobal->pTraceAbstract->projectAndName.sName;
-            if( g_list_find_custom( pGlobal->pTraceList, &projectAndName, (GCompareFunc)compareTraceItemsForFind ) != NULL
+            if( catalogLookup( &pGlobal->traceCatalog, projectAndName.sProject, projectAndName.sName ) != NULL
                     || strlen( sTargetProjectSanitized ) == 0 )
                 bSensitive = FALSE;
             else
@@ -172,6 +175,21 @@ CB_DR_RenameResponse( GtkDialog *wDialog, gint response, gpointer udata )
 
     switch ( response ) {
     case GTK_RESPONSE_OK:
+        // The profiles of the project to which a profile is moved or copied are read
+        // (once) so it is not listed twice and so a clash with one of them is caught
+        if( pGlobal->RMCdialogPurpose != eRename && pGlobal->RMCdialogTarget != eProjectName
+                && sProjectTo && *sProjectTo ) {
+            inventoryProject( pGlobal, sProjectTo );
+            if( (pGlobal->RMCdialogTarget == eCalibrationName
+                        && catalogLookup( &pGlobal->calCatalog, sProjectTo,
+                                pGlobal->pCalibrationAbstract->projectAndName.sName ) != NULL)
+                    || (pGlobal->RMCdialogTarget == eTraceName
+                        && catalogLookup( &pGlobal->traceCatalog, sProjectTo,
+                                pGlobal->pTraceAbstract->projectAndName.sName ) != NULL) ) {
+                postError( "A profile of that name is already in the project" );
+                break;
+            }
+        }
         switch( pGlobal->RMCdialogTarget ) {
         case eProjectName:
             if( pGlobal->RMCdialogPurpose  != eRename )
@@ -207,6 +225,11 @@ CB_DR_RenameResponse( GtkDialog *wDialog, gint response, gpointer udata )
                     pProjectAndName->sProject = g_strdup( sTo );
                 }
             }
+            // the keys have changed so re-index
+            pGlobal->pCalList = g_list_sort (pGlobal->pCalList, (GCompareFunc)compareCalItemsForSort);
+            pGlobal->pTraceList = g_list_sort (pGlobal->pTraceList, (GCompareFunc)compareTraceItemsForSort);
+            catalogRebuild( &pGlobal->calCatalog, pGlobal->pCalList );
+            catalogRebuild( &pGlobal->traceCatalog, pGlobal->pTraceList );
 
             // update the combobox widget
 
@@ -230,20 +253,11 @@ CB_DR_RenameResponse( GtkDialog *wDialog, gint response, gpointer udata )
                 if( renameMoveCopyDBitems(pGlobal, pGlobal->RMCdialogTarget, pGlobal->RMCdialogPurpose,
                         pGlobal->sProject, sFrom, (gchar *)sTo ) == ERROR )
                     break;
-                    // Update the name in the list of calibration/setup profiles
-                for( l = pGlobal->pCalList; l != NULL; l = l->next ){
-                    tProjectAndName *pProjectAndName = &(((tHP8753cal *)(l->data))->projectAndName);
-                    if( g_strcmp0( pGlobal->sProject, pProjectAndName->sProject  )  == 0
-                            && g_strcmp0( sFrom, pProjectAndName->sName  )  == 0  ){
-                        g_free( pProjectAndName->sName );
-                        pProjectAndName->sName = g_strdup( sTo );
-                    }
-                }
-
-                // Find the calibration in the list
-                tProjectAndName projectAndName = { pGlobal->sProject, (gchar *)sTo };
-                pGlobal->pCalibrationAbstract =
-                        g_list_find_custom( pGlobal->pCalList, &projectAndName, (GCompareFunc)compareCalItemsForFind )->data;
+                // Update the name in the list of calibration/setup profiles
+                catalogRemove( &pGlobal->calCatalog, pGlobal->pCalibrationAbstract );
+                pGlobal->pCalibrationAbstract->projectAndName.sName = g_strdup( sTo );
+                pGlobal->pCalList = g_list_sort (pGlobal->pCalList, (GCompareFunc)compareCalItemsForSort);
+                catalogAdd( &pGlobal->calCatalog, pGlobal->pCalibrationAbstract );
 
                 // update the combobox widget
                 populateCalComboBoxWidget( pGlobal );
@@ -262,10 +276,12 @@ CB_DR_RenameResponse( GtkDialog *wDialog, gint response, gpointer udata )
                 if( renameMoveCopyDBitems(pGlobal, pGlobal->RMCdialogTarget, pGlobal->RMCdialogPurpose,
                         pGlobal->pCalibrationAbstract->projectAndName.sName, sFrom, sProjectTo ) == ERROR )
                     break;
+                catalogRemove( &pGlobal->calCatalog, pGlobal->pCalibrationAbstract );
                 g_free(pGlobal->pCalibrationAbstract->projectAndName.sProject);
                 pGlobal->pCalibrationAbstract->projectAndName.sProject = g_strdup(sProjectTo);
                 // now resort because the project has changed
                 pGlobal->pCalList = g_list_sort (pGlobal->pCalList, (GCompareFunc)compareCalItemsForSort);
+                catalogAdd( &pGlobal->calCatalog, pGlobal->pCalibrationAbstract );
 
                 // also update the calibration pointer to the first profile in the list
                 // that matches the project
@@ -282,8 +298,8 @@ CB_DR_RenameResponse( GtkDialog *wDialog, gint response, gpointer udata )
                         pGlobal->pCalibrationAbstract->projectAndName.sName, sFrom, sProjectTo ) == ERROR )
                     break;
                 tHP8753cal *pCal = cloneCalibrationProfile( pGlobal->pCalibrationAbstract, sProjectTo );
-                pGlobal->pCalList = g_list_prepend(pGlobal->pCalList, pCal);
-                pGlobal->pCalList = g_list_sort (pGlobal->pCalList, (GCompareFunc)compareCalItemsForSort);
+                pGlobal->pCalList = g_list_insert_sorted( pGlobal->pCalList, pCal, (GCompareFunc)compareCalItemsForSort );
+                catalogAdd( &pGlobal->calCatalog, pCal );
                 break;
             }
         break;
@@ -301,20 +317,11 @@ CB_DR_RenameResponse( GtkDialog *wDialog, gint response, gpointer udata )
                     break;
 
                 // Update the name in the list of trace profiles
-                for( l = pGlobal->pTraceList; l != NULL; l = l->next ){
-                    tProjectAndName *pProjectAndName = &(((tHP8753traceAbstract *)(l->data))->projectAndName);
-                    if( g_strcmp0( pGlobal->sProject, pProjectAndName->sProject  )  == 0
-                            && g_strcmp0( sFrom, pProjectAndName->sName  )  == 0  ){
-                        g_free( pProjectAndName->sName ); // this is the same as sFrom
-                        pProjectAndName->sName = g_strdup( sTo );
-                    }
-                }
+                catalogRemove( &pGlobal->traceCatalog, pGlobal->pTraceAbstract );
+                g_free( pGlobal->pTraceAbstract->projectAndName.sName ); // this is the same as sFrom
+                pGlobal->pTraceAbstract->projectAndName.sName = g_strdup( sTo );
                 pGlobal->pTraceList = g_list_sort (pGlobal->pTraceList, (GCompareFunc)compareTraceItemsForSort);
-
-                // Find the trace in the list
-                tProjectAndName projectAndName = { pGlobal->sProject, (gchar *)sTo };
-                pGlobal->pTraceAbstract =
-                        g_list_find_custom( pGlobal->pTraceList, &projectAndName, (GCompareFunc)compareTraceItemsForFind )->data;
+                catalogAdd( &pGlobal->traceCatalog, pGlobal->pTraceAbstract );
                 // Update the widget
                 populateTraceComboBoxWidget( pGlobal );
 
@@ -334,10 +341,12 @@ CB_DR_RenameResponse( GtkDialog *wDialog, gint response, gpointer udata )
                         pGlobal->pTraceAbstract->projectAndName.sName, sFrom, sProjectTo ) == ERROR )
                     break;
 
+                catalogRemove( &pGlobal->traceCatalog, pGlobal->pTraceAbstract );
                 g_free(pGlobal->pTraceAbstract->projectAndName.sProject);
                 pGlobal->pTraceAbstract->projectAndName.sProject = g_strdup(sProjectTo);
                 // now resort because the project has changed
                 pGlobal->pTraceList = g_list_sort (pGlobal->pTraceList, (GCompareFunc)compareTraceItemsForSort);
+                catalogAdd( &pGlobal->traceCatalog, pGlobal->pTraceAbstract );
 
                 // Update the trace abstract pointer to the first profile in the list
                 // that matches the project
@@ -356,8 +365,8 @@ CB_DR_RenameResponse( GtkDialog *wDialog, gint response, gpointer udata )
                     break;
 
                 tHP8753traceAbstract *pCal = cloneTraceProfileAbstract( pGlobal->pTraceAbstract, sProjectTo );
-                pGlobal->pTraceList = g_list_prepend(pGlobal->pTraceList, pCal);
-                pGlobal->pTraceList = g_list_sort (pGlobal->pTraceList, (GCompareFunc)compareTraceItemsForSort);
+                pGlobal->pTraceList = g_list_insert_sorted( pGlobal->pTraceList, pCal, (GCompareFunc)compareTraceItemsForSort );
+                catalogAdd( &pGlobal->traceCatalog, pCal );
 
                 break;
             }
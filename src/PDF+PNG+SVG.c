@@ -20,6 +20,7 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <glib-2.0/glib.h>
+#include <glib/gstdio.h>
 #include <gio/gio.h>
 #include <cairo/cairo.h>
 #include <cairo/cairo-pdf.h>
@@ -27,10 +28,12 @@
 
 #include "hp8753.h"
 #include "messageEvent.h"
+#include "exportWorker.h"
 #include <math.h>
 
 
 #define PNG_WIDTH       3300
+#define THUMBNAIL_WIDTH  320
 
 tPaperDimensions paperDimensions[ eNumPaperSizes ] = {
         {595,  842,  7.2},  // A4
@@ -129,6 +132,276 @@ addFileNameSuffix( gchar *sChosenFilename, tFileType fileType, enum eWhichPlot p
     return( sModifiedFilename );
 }
 
+/*!     \brief  Number of pages (or files) for the plot(s)
+ *
+ * \param  pGlobal      pointer to data
+ * \return              2 if the channels are split (and not showing the HPGL plot) otherwise 1
+ */
+gint
+plotFilePageCount( tGlobal *pGlobal ) {
+    gboolean bHPGL = (pGlobal->HP8753.flags.bShowHPGLplot && pGlobal->HP8753.flags.bHPGLdataValid);
+
+    return (pGlobal->HP8753.flags.bDualChannel
+                && pGlobal->HP8753.flags.bSplitChannels && !bHPGL) ? 2 : 1;
+}
+
+/*!     \brief  Size of a page of a PDF, SVG or PNG file
+ *
+ * \param  pGlobal      pointer to data
+ * \param  fileType     ePDF, eSVG or ePNG
+ * \param  pWidth       pointer to the width returned (points or pixels)
+ * \param  pHeight      pointer to the height returned (points or pixels)
+ */
+void
+plotFilePageSize( tGlobal *pGlobal, tFileType fileType, gdouble *pWidth, gdouble *pHeight ) {
+    if( fileType == ePNG ) {
+        *pWidth  = PNG_WIDTH;
+        *pHeight = PNG_WIDTH / sqrt( 2.0 );
+    } else {
+        *pWidth  = paperDimensions[pGlobal->PDFpaperSize].width;
+        *pHeight = paperDimensions[pGlobal->PDFpaperSize].height;
+    }
+}
+
+/*!     \brief  Name of the file holding a page of the plot(s)
+ *
+ * \param  sFilename    chosen file name (with or without the suffix)
+ * \param  fileType     ePDF, eSVG or ePNG
+ * \param  nPages       number of files the plots are written to (see plotFilePageCount)
+ * \param  page         page (0 or 1)
+ * \return              file name (caller must free)
+ */
+gchar *
+plotFilePageName( const gchar *sFilename, tFileType fileType, gint nPages, gint page ) {
+    return addFileNameSuffix( (gchar *)sFilename, fileType,
+            nPages == 1 ? eOnlyPlot : (page == 0 ? ePlotA : ePlotB), NULL );
+}
+
+/*!     \brief  Draw a plot onto a page of a PDF, SVG or PNG file
+ *
+ * The page is the size given by plotFilePageSize.
+ *
+ * \param  cr           cairo context of the page
+ * \param  pGlobal      pointer to data
+ * \param  fileType     ePDF, eSVG or ePNG
+ * \param  page         page (0 for the first or only plot, 1 for the second)
+ */
+void
+drawPlotFilePage( cairo_t *cr, tGlobal *pGlobal, tFileType fileType, gint page ) {
+    gdouble width, height, margin = 0.0;
+
+    plotFilePageSize( pGlobal, fileType, &width, &height );
+
+    cairo_save( cr ); {
+        // Letter and Tabloid size are not in the ratio of our data ( height = width / sqrt( 2 ) )
+        // we need to adjust
+        if( fileType != ePNG )  {   // we know PNG is the right aspect ratio
+            margin = paperDimensions[pGlobal->PDFpaperSize].margin;
+            // aspect ratio is sqrt( 2 )
+            if( (height / width) / sqrt( 2.0 ) > 1.01 ) {// this should leave A4 and A3 untouched
+                cairo_translate( cr, width - (height * sqrt(2.0)) / 2.0, 0.0  );
+                width = height * sqrt( 2.0 );
+            } else if( (height / width) / sqrt( 2.0 ) < 0.99 ) {   // wider
+                cairo_translate( cr, 0.0, (height - width / sqrt( 2.0 )) / 2.0  );
+                height = width / sqrt( 2.0 );
+            }
+        }
+
+        if( page == 0 )
+            plotA( width, height, margin, cr, pGlobal );
+        else
+            plotB( width, height, margin, cr, pGlobal );
+    } cairo_restore( cr );
+}
+
+/*!     \brief  Draw the plot(s) into a PDF, SVG or PNG file
+ *
+ * The plot(s) are drawn with the already retrieved data. If the channels
+ * are split, PNG and SVG plots go into two files (.1 and .2) and PDF into two pages.
+ * This is called on an export worker thread with a snapshot of the data
+ * (see exportPlotFile) and by writePlotFile.
+ *
+ * \param  pGlobal      pointer to data
+ * \param  sFilename    chosen file name (with or without the suffix)
+ * \param  fileType     ePDF, eSVG or ePNG
+ * \param  pbCancel     pointer to a flag (set atomically) to stop before the next page or NULL
+ * \return              OK or ERROR if a file could not be created or the export was cancelled
+ */
+gint
+writePlotPages( tGlobal *pGlobal, const gchar *sFilename, tFileType fileType, gint *pbCancel ) {
+    gdouble width, height;
+    gchar *sAugmentedFilename = NULL;
+    gchar *sWrittenFilenames[ 2 ] = { NULL };
+    gint nPages = plotFilePageCount( pGlobal );
+    gint rtn = OK;
+
+    cairo_t *cr;
+    cairo_surface_t *cs = NULL;
+
+    plotFilePageSize( pGlobal, fileType, &width, &height );
+
+    for( gint page = 0; page < nPages; page++ ) {
+        if( pbCancel && g_atomic_int_get( pbCancel ) ) {
+            // the first page of a PDF is still open
+            if( fileType == ePDF && page > 0 )
+                cairo_surface_destroy ( cs );
+            // don't leave part of the export behind
+            for( gint i = 0; i < nPages; i++ )
+                if( sWrittenFilenames[ i ] )
+                    g_unlink( sWrittenFilenames[ i ] );
+            rtn = ERROR;
+            break;
+        }
+
+        // We place both plots into the one PDF (so only one file name needed)
+        sAugmentedFilename = plotFilePageName( sFilename, fileType, fileType == ePDF ? 1 : nPages, page );
+        switch( fileType ) {
+        case ePDF:
+        default:
+            // Only create the surface once
+            if( page == 0 ) {
+                cs = cairo_pdf_surface_create ( sAugmentedFilename, width, height );
+                cairo_pdf_surface_set_metadata (cs, CAIRO_PDF_METADATA_CREATOR, "HP8753 Network Analyzer");
+            }
+            break;
+        case eSVG:
+            cs = cairo_svg_surface_create ( sAugmentedFilename, width, height );
+            break;
+        case ePNG:
+            cs = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, width, height);
+            break;
+        }
+        if( cairo_surface_status( cs ) != CAIRO_STATUS_SUCCESS )
+            rtn = ERROR;
+
+        cr = cairo_create (cs);
+        drawPlotFilePage( cr, pGlobal, fileType, page );
+        cairo_show_page( cr );
+
+        if( fileType  == ePNG
+                && cairo_surface_write_to_png (cs, sAugmentedFilename ) != CAIRO_STATUS_SUCCESS )
+            rtn = ERROR;
+
+        // Don't destroy on the first page of a multi-page PDF
+        if( fileType != ePDF || page == nPages - 1 ) {
+            cairo_surface_destroy ( cs );
+        }
+        cairo_destroy( cr );
+
+        sWrittenFilenames[ page ] = sAugmentedFilename;
+    }
+
+    for( gint i = 0; i < nPages; i++ )
+        g_free( sWrittenFilenames[ i ] );
+
+    return rtn;
+}
+
+/*!     \brief  Write the high resolution Smith chart(s) of a PDF
+ *
+ * The Smith chart(s) are drawn by Ghostscript into a separate file (.HR.pdf)
+ * (or two if the channels are split and only one is a Smith chart).
+ *
+ * \param  pGlobal      pointer to data
+ * \param  sFilename    chosen file name (with or without the suffix)
+ * \return              OK or ERROR if Ghostscript failed (OK if there is no Smith chart)
+ */
+gint
+writeHighResSmithFile( tGlobal *pGlobal, const gchar *sFilename ) {
+    gchar *sAugmentedFilename = NULL;
+    gint rtn = 0;
+
+    gboolean bHPGL = (pGlobal->HP8753.flags.bShowHPGLplot && pGlobal->HP8753.flags.bHPGLdataValid);
+    gboolean bBoth = pGlobal->HP8753.flags.bDualChannel
+                && pGlobal->HP8753.flags.bSplitChannels && !bHPGL
+                && pGlobal->HP8753.channels[eCH_ONE].format == eFMT_SMITH
+                && pGlobal->HP8753.channels[eCH_TWO].format == eFMT_SMITH;
+
+    if( pGlobal->HP8753.channels[eCH_ONE].format == eFMT_SMITH ) {
+        if( pGlobal->HP8753.channels[eCH_TWO].format == eFMT_SMITH ) {
+            sAugmentedFilename = addFileNameSuffix( (gchar *)sFilename, ePDF, eOnlyPlot, ".HR" );
+            rtn = smithHighResPDF(pGlobal, sAugmentedFilename, eCH_BOTH );
+        } else {
+            sAugmentedFilename = addFileNameSuffix( (gchar *)sFilename, ePDF, bBoth ? ePlotA : eOnlyPlot, ".HR" );
+            rtn = smithHighResPDF(pGlobal, sAugmentedFilename, eCH_ONE );
+        }
+    } else if( pGlobal->HP8753.channels[eCH_TWO].format == eFMT_SMITH ) {
+            sAugmentedFilename = addFileNameSuffix( (gchar *)sFilename, ePDF, bBoth ? ePlotB : eOnlyPlot, ".HR" );
+            rtn = smithHighResPDF(pGlobal, sAugmentedFilename, eCH_TWO );
+    }
+    g_free( sAugmentedFilename );
+
+    return rtn == 0 ? OK : ERROR;
+}
+
+/*!     \brief  Write the image of the plot(s) to a PDF, SVG or PNG file
+ *
+ * The plot(s) are drawn with the already retrieved data (see writePlotPages).
+ * High resolution Smith charts are added (.HR.pdf) for a PDF.
+ *
+ * \param  pGlobal      pointer to data
+ * \param  sFilename    chosen file name (with or without the suffix)
+ * \param  fileType     ePDF, eSVG or ePNG
+ * \return              OK or ERROR if a file could not be created
+ */
+gint
+writePlotFile( tGlobal *pGlobal, const gchar *sFilename, tFileType fileType ) {
+    gint rtn = writePlotPages( pGlobal, sFilename, fileType, NULL );
+
+    // now do high resolution smith charts if we are doing PDF & smith
+    if( fileType == ePDF )
+        writeHighResSmithFile( pGlobal, sFilename );
+
+    return rtn;
+}
+
+static gint
+renderPlotPagesJob( tExportJob *pJob ) {
+    return writePlotPages( pJob->pExport->pSnapshot, pJob->sFilename, pJob->fileType, &pJob->pExport->bCancel );
+}
+
+static gint
+renderHighResSmithJob( tExportJob *pJob ) {
+    return writeHighResSmithFile( pJob->pExport->pSnapshot, pJob->sFilename );
+}
+
+/*!     \brief  Write the image of the plot(s) to a file on the export workers
+ *
+ * As writePlotFile but the file (and, in parallel, the high resolution Smith
+ * charts of a PDF) is written from a snapshot of the data by the export
+ * worker threads. Progress and errors are shown on the status line.
+ *
+ * \param  pGlobal      pointer to data
+ * \param  sFilename    chosen file name (with or without the suffix)
+ * \param  fileType     ePDF, eSVG or ePNG
+ */
+void
+exportPlotFile( tGlobal *pGlobal, const gchar *sFilename, tFileType fileType ) {
+    gchar *sBasename = g_path_get_basename( sFilename );
+    gchar *sMessage = g_strdup_printf( "Writing %s", sBasename );
+    tExport *pExport = newExport( pGlobal, sBasename );
+    tExportJob *pJob = g_new0( tExportJob, 1 );
+
+    pJob->render = renderPlotPagesJob;
+    pJob->sFilename = g_strdup( sFilename );
+    pJob->fileType = fileType;
+    queueExportJob( pExport, pJob );
+
+    if( fileType == ePDF && (pGlobal->HP8753.channels[eCH_ONE].format == eFMT_SMITH
+                || pGlobal->HP8753.channels[eCH_TWO].format == eFMT_SMITH) ) {
+        pJob = g_new0( tExportJob, 1 );
+        pJob->render = renderHighResSmithJob;
+        pJob->sFilename = g_strdup( sFilename );
+        pJob->fileType = ePDF;
+        queueExportJob( pExport, pJob );
+    }
+    releaseExport( pExport );
+
+    postInfo( sMessage );
+    g_free( sMessage );
+    g_free( sBasename );
+}
+
 /*!     \brief  Write the PDF image to a file
  *
  * Determine the filename to use for the PNG / PDF / SVG file and
@@ -148,19 +421,10 @@ plotAndSaveFile( GObject *source_object, GAsyncResult *res, gpointer gpGlobal, t
     GFile *file;
     GError *err = NULL;
     GtkAlertDialog *alert_dialog;
-    gdouble width, height, margin = 0.0;
-
-    gboolean bHPGL = (pGlobal->HP8753.flags.bShowHPGLplot && pGlobal->HP8753.flags.bHPGLdataValid);
-    gboolean bBoth = pGlobal->HP8753.flags.bDualChannel
-                && pGlobal->HP8753.flags.bSplitChannels && !bHPGL;
-
-    cairo_t *cr;
-    cairo_surface_t *cs;
 
     if (((file = gtk_file_dialog_save_finish (dialog, res, &err)) != NULL) ) {
 
         gchar *sChosenFilename = g_file_get_path( file );
-        gchar *sAugmentedFilename = NULL;
         gchar *selectedFileBasename = g_file_get_basename( file );
 
         // did we use the synthesized name or did we choose another
@@ -184,97 +448,8 @@ plotAndSaveFile( GObject *source_object, GAsyncResult *res, gpointer gpGlobal, t
             g_free( selectedFileBasename );
         }
 
-        for( gint page = (bBoth ? ePlotA : eOnlyPlot); page <= ePlotB; page++ ) {
-            // We place both plots into the one PDF (so only one file name needed)
-            sAugmentedFilename = addFileNameSuffix( sChosenFilename, fileType,
-                    fileType == ePDF ? eOnlyPlot : page, NULL );
-            switch( fileType ) {
-            case ePDF:
-            default:
-                width  = paperDimensions[pGlobal->PDFpaperSize].width;
-                height = paperDimensions[pGlobal->PDFpaperSize].height;
-                margin = paperDimensions[pGlobal->PDFpaperSize].margin;
-                // Only create the surface once
-                if( page != ePlotB ) {
-                    cs = cairo_pdf_surface_create ( sAugmentedFilename, width, height );
-                    cairo_pdf_surface_set_metadata (cs, CAIRO_PDF_METADATA_CREATOR, "HP8753 Network Analyzer");
-                }
-                break;
-            case eSVG:
-                width  = paperDimensions[pGlobal->PDFpaperSize].width;
-                height = paperDimensions[pGlobal->PDFpaperSize].height;
-                margin = paperDimensions[pGlobal->PDFpaperSize].margin;
-                cs = cairo_svg_surface_create ( sAugmentedFilename, width, height );
-                break;
-            case ePNG:
-                width  = PNG_WIDTH;
-                height = PNG_WIDTH / sqrt( 2.0 );
-                cs = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, width, height);
-                break;
-            }
-
-            cr = cairo_create (cs);
-
-            // Letter and Tabloid size are not in the ratio of our data ( height = width / sqrt( 2 ) )
-            // we need to adjust
-            if( fileType != ePNG )  {   // we know PNG is the right aspect ratio
-                // aspect ratio is sqrt( 2 )
-                if( (height / width) / sqrt( 2.0 ) > 1.01 ) {// this should leave A4 and A3 untouched
-                    cairo_translate( cr, width - (height * sqrt(2.0)) / 2.0, 0.0  );
-                    width = height * sqrt( 2.0 );
-                } else if( (height / width) / sqrt( 2.0 ) < 0.99 ) {   // wider
-                    cairo_translate( cr, 0.0, (height - width / sqrt( 2.0 )) / 2.0  );
-                    height = width / sqrt( 2.0 );
-                }
-            }
-
-            cairo_save( cr ); {
-                if( page < ePlotB)
-                    plotA( width, height, margin, cr, pGlobal );
-                else
-                    plotB( width, height, margin, cr, pGlobal );
-            } cairo_restore( cr );
-
-            cairo_show_page( cr );
-
-            if( fileType  == ePNG )
-                cairo_surface_write_to_png (cs, sAugmentedFilename );
-
-            // Don't destroy on the first page of a multi-page PDF
-            if( fileType != ePDF || page == ePlotB || page == eOnlyPlot ) {
-                cairo_surface_destroy ( cs );
-            }
-            cairo_destroy( cr );
-
-            g_free( sAugmentedFilename );
-
-            if( page == eOnlyPlot )
-                break;
-        }
-
-        // now do high resolution smith charts if we are doing PDF & smith
-        if( fileType == ePDF ) {
-            if( bBoth && pGlobal->HP8753.channels[eCH_ONE].format == eFMT_SMITH
-                    && pGlobal->HP8753.channels[eCH_TWO].format == eFMT_SMITH )
-                bBoth = TRUE;
-            else
-                bBoth = FALSE;
-
-            sAugmentedFilename = NULL;
-            if( pGlobal->HP8753.channels[eCH_ONE].format == eFMT_SMITH ) {
-                if( pGlobal->HP8753.channels[eCH_TWO].format == eFMT_SMITH ) {
-                    sAugmentedFilename = addFileNameSuffix( sChosenFilename, ePDF, eOnlyPlot, ".HR" );
-                    smithHighResPDF(pGlobal, sAugmentedFilename, eCH_BOTH );
-                } else {
-                    sAugmentedFilename = addFileNameSuffix( sChosenFilename, ePDF, bBoth ? ePlotA : eOnlyPlot, ".HR" );
-                    smithHighResPDF(pGlobal, sAugmentedFilename, eCH_ONE );
-                }
-            } else if( pGlobal->HP8753.channels[eCH_TWO].format == eFMT_SMITH ) {
-                    sAugmentedFilename = addFileNameSuffix( sChosenFilename, ePDF, bBoth ? ePlotB : eOnlyPlot, ".HR" );
-                    smithHighResPDF(pGlobal, sAugmentedFilename, eCH_TWO );
-            }
-            g_free( sAugmentedFilename );
-        }
+        // written by the export workers (errors are posted when they complete)
+        exportPlotFile( pGlobal, sChosenFilename, fileType );
 
         GFile *dir = g_file_get_parent( file );
         gchar *sChosenDirectory = g_file_get_path( dir );
@@ -295,6 +470,73 @@ plotAndSaveFile( GObject *source_object, GAsyncResult *res, gpointer gpGlobal, t
     g_free( sSuggestedFilename );
 }
 
+/*!     \brief  Write callback to collect the PNG image in memory
+ *
+ * \param  gpImage  GByteArray to append to
+ * \param  data     PNG data
+ * \param  length   number of bytes
+ * \return          CAIRO_STATUS_SUCCESS
+ */
+static cairo_status_t
+appendPNGdata( gpointer gpImage, const guchar *data, guint length ) {
+    g_byte_array_append( (GByteArray *)gpImage, data, length );
+    return CAIRO_STATUS_SUCCESS;
+}
+
+/*!     \brief  Render a small PNG image of the plot(s)
+ *
+ * The plot is drawn as for a PNG file but on a small image surface held in memory.
+ * If the channels are split, plot B is drawn below plot A.
+ * This is used for the thumbnails shown by the profile browser.
+ *
+ * \param  pGlobal  pointer to data (the HP8753 data and the plot flags are used)
+ * \param  pSize    pointer to the returned size of the image
+ * \return          allocated PNG image or NULL on failure
+ */
+guchar *
+renderTraceThumbnail( tGlobal *pGlobal, gsize *pSize ) {
+    gboolean bHPGL = (pGlobal->HP8753.flags.bShowHPGLplot && pGlobal->HP8753.flags.bHPGLdataValid);
+    gboolean bBoth = pGlobal->HP8753.flags.bDualChannel
+                && pGlobal->HP8753.flags.bSplitChannels && !bHPGL;
+    guint width = THUMBNAIL_WIDTH, height = THUMBNAIL_WIDTH / sqrt( 2.0 );
+    GByteArray *pImage;
+    cairo_surface_t *cs;
+    cairo_t *cr;
+
+    *pSize = 0;
+    cs = cairo_image_surface_create (CAIRO_FORMAT_RGB24, width, bBoth ? 2 * height : height);
+    if( cairo_surface_status( cs ) != CAIRO_STATUS_SUCCESS ) {
+        cairo_surface_destroy( cs );
+        return NULL;
+    }
+    cr = cairo_create (cs);
+
+    cairo_set_source_rgb (cr, 1.0, 1.0, 1.0 );
+    cairo_paint( cr );
+
+    cairo_save( cr ); {
+        plotA( width, height, 0.0, cr, pGlobal );
+    } cairo_restore( cr );
+    if( bBoth ) {
+        cairo_save( cr ); {
+            cairo_translate( cr, 0.0, height );
+            plotB( width, height, 0.0, cr, pGlobal );
+        } cairo_restore( cr );
+    }
+    cairo_destroy( cr );
+
+    pImage = g_byte_array_new();
+    if( cairo_surface_write_to_png_stream( cs, appendPNGdata, pImage ) != CAIRO_STATUS_SUCCESS ) {
+        g_byte_array_free( pImage, TRUE );
+        cairo_surface_destroy( cs );
+        return NULL;
+    }
+    cairo_surface_destroy( cs );
+
+    *pSize = pImage->len;
+    return g_byte_array_free( pImage, FALSE );
+}
+
 // Call back when file is selected
 static void
 CB_PDFsave( GObject *source_object, GAsyncResult *res, gpointer gpGlobal ) {
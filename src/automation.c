@@ -0,0 +1,534 @@
+/*
+ * Copyright (c) 2026 Michael G. Katzmann
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/*! \file automation.c
+ * D-Bus automation of a running instance.
+ *
+ * The acquisition commands are exported on the session bus in two ways, both
+ * at the application's object path (/us/heterodyne/HP8753):
+ *
+ *  - as actions of the application (org.gtk.Actions) .. fire and forget
+ *      e.g. gapplication action us.heterodyne.HP8753 get-trace
+ *  - as methods of the us.heterodyne.HP8753.Automation interface which reply,
+ *    when the request has been completed, with a dictionary (a{sv}) holding
+ *    'success' (b), 'message' (s), 'queued' & 'elapsed' (d seconds), 'files' (as),
+ *    'project' (s) and 'profile' (s) as appropriate.
+ *      e.g. gdbus call --session --dest us.heterodyne.HP8753 --object-path /us/heterodyne/HP8753 \
+ *                      --method us.heterodyne.HP8753.Automation.CaptureS2P /tmp/dut.s2p
+ *
+ * The information and error messages shown in the status line are also emitted
+ * as the Progress signal.
+ *
+ * Requests are queued and performed one at a time; the next is started when the
+ * GPIB thread has completed the previous one. The commands sent to the GPIB thread
+ * are numbered so that their completion is distinguished from that of a command
+ * from the GUI.
+ */
+
+#include <gtk/gtk.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <glib-2.0/glib.h>
+#include <gio/gio.h>
+
+#include "hp8753.h"
+#include "messageEvent.h"
+
+#define AUTOMATION_INTERFACE    "us.heterodyne.HP8753.Automation"
+#define MAX_AUTOMATION_QUEUE    32
+
+// D-Bus method and action names (in the order of tAutomationCommand)
+static const struct {
+    gchar *sMethod;
+    gchar *sAction;
+    gchar *sParameterType;
+} automationCommands[ eAUTO_NUM_COMMANDS ] = {
+    { "GetTrace",           "get-trace",              NULL },
+    { "GetSetupAndCal",     "get-setup-and-cal",      "s" },
+    { "RestoreSetupAndCal", "restore-setup-and-cal",  "s" },
+    { "CaptureS2P",         "capture-s2p",            "s" },
+    { "CaptureS1P",         "capture-s1p",            "s" },
+    { "SaveTrace",          "save-trace",             "s" },
+    { "Export",             "export",                 "(ss)" }
+};
+
+static const gchar automationIntrospectionXML[] =
+    "<node>"
+    "  <interface name='" AUTOMATION_INTERFACE "'>"
+    "    <method name='GetTrace'>"
+    "      <arg type='a{sv}' name='result' direction='out'/>"
+    "    </method>"
+    "    <method name='GetSetupAndCal'>"
+    "      <arg type='s' name='profile' direction='in'/>"
+    "      <arg type='a{sv}' name='result' direction='out'/>"
+    "    </method>"
+    "    <method name='RestoreSetupAndCal'>"
+    "      <arg type='s' name='profile' direction='in'/>"
+    "      <arg type='a{sv}' name='result' direction='out'/>"
+    "    </method>"
+    "    <method name='CaptureS2P'>"
+    "      <arg type='s' name='file' direction='in'/>"
+    "      <arg type='a{sv}' name='result' direction='out'/>"
+    "    </method>"
+    "    <method name='CaptureS1P'>"
+    "      <arg type='s' name='file' direction='in'/>"
+    "      <arg type='a{sv}' name='result' direction='out'/>"
+    "    </method>"
+    "    <method name='SaveTrace'>"
+    "      <arg type='s' name='profile' direction='in'/>"
+    "      <arg type='a{sv}' name='result' direction='out'/>"
+    "    </method>"
+    "    <method name='Export'>"
+    "      <arg type='s' name='file' direction='in'/>"
+    "      <arg type='s' name='format' direction='in'/>"
+    "      <arg type='a{sv}' name='result' direction='out'/>"
+    "    </method>"
+    "    <signal name='Progress'>"
+    "      <arg type='s' name='message'/>"
+    "      <arg type='b' name='error'/>"
+    "    </signal>"
+    "  </interface>"
+    "</node>";
+
+typedef struct {
+    tAutomationCommand      command;
+    GDBusMethodInvocation   *invocation;    // NULL if activated as an action
+    tAutomationDone         pDone;          // or called on completion (see queueAutomationCommand)
+    gpointer                pUserData;      // .. with this
+    gchar                   *sArgument;     // profile or file name
+    gchar                   *sFormat;       // export format
+    gint64                  queuedTime, startTime;
+    guint                   sequence;       // of the command to the GPIB thread (0 if none)
+    gboolean                bSaved;         // the S2P / S1P file or the setup & calibration was saved
+    gint                    nErrors;
+    gchar                   *sError;        // first error reported
+} tAutomationRequest;
+
+static const gchar * const noFiles[] = { NULL };
+
+static GQueue               automationQueue = G_QUEUE_INIT;
+static tAutomationRequest  *pActiveRequest = NULL;
+static GDBusConnection     *pAutomationConnection = NULL;
+static gchar               *sAutomationPath = NULL;
+static guint                automationRegistrationID = 0;
+
+/*!     \brief  Free an automation request
+ *
+ * \param  pRequest     request to free
+ */
+static void
+freeAutomationRequest( tAutomationRequest *pRequest ) {
+    g_free( pRequest->sArgument );
+    g_free( pRequest->sFormat );
+    g_free( pRequest->sError );
+    g_free( pRequest );
+}
+
+/*!     \brief  Complete an automation request
+ *
+ * Reply to the D-Bus method call (if there was one) with the result and free the request.
+ *
+ * \param  pGlobal      pointer to global data
+ * \param  pRequest     completed request
+ * \param  bSuccess     result
+ * \param  sMessage     message (or NULL to use the first error reported)
+ * \param  sFiles       NULL terminated list of files written (or NULL)
+ */
+static void
+completeAutomationRequest( tGlobal *pGlobal, tAutomationRequest *pRequest,
+        gboolean bSuccess, const gchar *sMessage, const gchar * const *sFiles ) {
+    gint64 now = g_get_monotonic_time();
+    GVariantBuilder result;
+
+    if( sMessage == NULL )
+        sMessage = pRequest->sError ? pRequest->sError : (bSuccess ? "OK" : "Failed");
+
+    if( pRequest->pDone ) {
+        pRequest->pDone( pGlobal, bSuccess, sMessage, pRequest->pUserData );
+    } else if( pRequest->invocation ) {
+        g_variant_builder_init( &result, G_VARIANT_TYPE_VARDICT );
+        g_variant_builder_add( &result, "{sv}", "success", g_variant_new_boolean( bSuccess ) );
+        g_variant_builder_add( &result, "{sv}", "message", g_variant_new_string( sMessage ) );
+        g_variant_builder_add( &result, "{sv}", "queued",
+                g_variant_new_double( (pRequest->startTime - pRequest->queuedTime) / 1.0e6 ) );
+        g_variant_builder_add( &result, "{sv}", "elapsed",
+                g_variant_new_double( (now - pRequest->startTime) / 1.0e6 ) );
+        g_variant_builder_add( &result, "{sv}", "files",
+                g_variant_new_strv( sFiles ? sFiles : noFiles, -1 ) );
+        if( pRequest->command == eAUTO_GET_SETUPandCAL || pRequest->command == eAUTO_RESTORE_SETUPandCAL
+                || pRequest->command == eAUTO_SAVE_TRACE ) {
+            g_variant_builder_add( &result, "{sv}", "project",
+                    g_variant_new_string( pGlobal->sProject ? pGlobal->sProject : "" ) );
+            g_variant_builder_add( &result, "{sv}", "profile", g_variant_new_string( pRequest->sArgument ) );
+        }
+        g_dbus_method_invocation_return_value( pRequest->invocation,
+                g_variant_new( "(a{sv})", &result ) );
+    } else if( !bSuccess ) {
+        LOG( G_LOG_LEVEL_WARNING, "%s failed: %s", automationCommands[ pRequest->command ].sAction, sMessage );
+    }
+
+    freeAutomationRequest( pRequest );
+}
+
+/*!     \brief  Start the next queued automation request
+ *
+ * Requests that do not use the HP8753 are completed immediately (and the next started).
+ * Those that do are sent to the GPIB thread and completed on TM_COMPLETE_GPIB.
+ *
+ * \param  pGlobal      pointer to global data
+ */
+static void
+startNextAutomationRequest( tGlobal *pGlobal ) {
+    tAutomationRequest *pRequest;
+    gint rtn;
+
+    while( pActiveRequest == NULL
+            && (pRequest = g_queue_pop_head( &automationQueue )) != NULL ) {
+        pRequest->startTime = g_get_monotonic_time();
+
+        switch( pRequest->command ) {
+        case eAUTO_GET_TRACE:
+            pRequest->sequence = postDataToGPIBThread( TG_RETRIEVE_TRACE_from_HP8753, NULL );
+            break;
+        case eAUTO_GET_SETUPandCAL:
+            pRequest->sequence = postDataToGPIBThread( TG_RETRIEVE_SETUPandCAL_from_HP8753,
+                    g_strdup( pRequest->sArgument ) );
+            break;
+        case eAUTO_RESTORE_SETUPandCAL:
+            if( recoverCalibrationAndSetup( pGlobal, pGlobal->sProject, pRequest->sArgument ) != TRUE ) {
+                completeAutomationRequest( pGlobal, pRequest, FALSE, "No such calibration profile", NULL );
+                continue;
+            }
+            pRequest->sequence = postDataToGPIBThread( TG_SEND_SETUPandCAL_to_HP8753, NULL );
+            break;
+        case eAUTO_CAPTURE_S2P:
+            pRequest->sequence = postDataToGPIBThread( TG_MEASURE_and_RETRIEVE_S2P_from_HP8753,
+                    g_strdup( pRequest->sArgument ) );
+            break;
+        case eAUTO_CAPTURE_S1P:
+            pRequest->sequence = postDataToGPIBThread( TG_MEASURE_and_RETRIEVE_S1P_from_HP8753,
+                    g_strdup( pRequest->sArgument ) );
+            break;
+        case eAUTO_SAVE_TRACE:
+            if( !pGlobal->HP8753.channels[ eCH_ONE ].chFlags.bValidData ) {
+                completeAutomationRequest( pGlobal, pRequest, FALSE, "No trace data to save", NULL );
+            } else {
+                rtn = saveTraceProfile( pGlobal, pRequest->sArgument );
+                completeAutomationRequest( pGlobal, pRequest, rtn == 0, NULL, NULL );
+            }
+            continue;
+        case eAUTO_EXPORT:
+        default:
+            {
+                const gchar *sFiles[] = { pRequest->sArgument, NULL };
+                tFileType fileType;
+
+                if( g_ascii_strcasecmp( pRequest->sFormat, "pdf" ) == 0 )
+                    fileType = ePDF;
+                else if( g_ascii_strcasecmp( pRequest->sFormat, "svg" ) == 0 )
+                    fileType = eSVG;
+                else if( g_ascii_strcasecmp( pRequest->sFormat, "png" ) == 0 )
+                    fileType = ePNG;
+                else if( g_ascii_strcasecmp( pRequest->sFormat, "csv" ) == 0 )
+                    fileType = eCSV;
+                else {
+                    completeAutomationRequest( pGlobal, pRequest, FALSE,
+                            "Format must be pdf, svg, png or csv", NULL );
+                    continue;
+                }
+
+                if( !pGlobal->HP8753.channels[ eCH_ONE ].chFlags.bValidData ) {
+                    completeAutomationRequest( pGlobal, pRequest, FALSE, "No trace data to export", NULL );
+                    continue;
+                }
+                if( fileType == eCSV )
+                    rtn = writeCSVfile( pGlobal, pRequest->sArgument );
+                else
+                    rtn = writePlotFile( pGlobal, pRequest->sArgument, fileType );
+                completeAutomationRequest( pGlobal, pRequest, rtn == OK,
+                        rtn == OK ? NULL : "Cannot write file", rtn == OK ? sFiles : NULL );
+            }
+            continue;
+        }
+
+        // The GUI controls that use the HP8753 are unavailable until completion
+        sensitiseControlsInUse( pGlobal, FALSE );
+        pActiveRequest = pRequest;
+    }
+}
+
+/*!     \brief  Queue an automation request
+ *
+ * \param  pGlobal      pointer to global data
+ * \param  command      the request
+ * \param  invocation   D-Bus method invocation (or NULL)
+ * \param  pDone        function to call on completion (or NULL)
+ * \param  pUserData    data for pDone
+ * \param  sArgument    profile or file name (or NULL)
+ * \param  sFormat      export format (or NULL)
+ */
+static void
+queueAutomationRequest( tGlobal *pGlobal, tAutomationCommand command,
+        GDBusMethodInvocation *invocation, tAutomationDone pDone, gpointer pUserData,
+        const gchar *sArgument, const gchar *sFormat ) {
+    tAutomationRequest *pRequest;
+
+    if( g_queue_get_length( &automationQueue ) >= MAX_AUTOMATION_QUEUE ) {
+        if( pDone )
+            pDone( pGlobal, FALSE, "Too many requests are queued", pUserData );
+        else if( invocation )
+            g_dbus_method_invocation_return_dbus_error( invocation,
+                    AUTOMATION_INTERFACE ".Error.Busy", "Too many requests are queued" );
+        return;
+    }
+
+    pRequest = g_new0( tAutomationRequest, 1 );
+    pRequest->command = command;
+    pRequest->invocation = invocation;
+    pRequest->pDone = pDone;
+    pRequest->pUserData = pUserData;
+    pRequest->sArgument = g_strdup( sArgument );
+    pRequest->sFormat = g_strdup( sFormat );
+    pRequest->queuedTime = g_get_monotonic_time();
+    g_queue_push_tail( &automationQueue, pRequest );
+
+    startNextAutomationRequest( pGlobal );
+}
+
+/*!     \brief  Queue a request from within the program
+ *
+ * The request is performed in turn with those from D-Bus. On completion
+ * pDone is called with the result.
+ *
+ * \param  pGlobal      pointer to global data
+ * \param  command      the request (eAUTO_EXPORT is not supported)
+ * \param  sArgument    profile or file name (or NULL)
+ * \param  pDone        function to call on completion
+ * \param  pUserData    data for pDone
+ */
+void
+queueAutomationCommand( tGlobal *pGlobal, tAutomationCommand command, const gchar *sArgument,
+        tAutomationDone pDone, gpointer pUserData ) {
+    queueAutomationRequest( pGlobal, command, NULL, pDone, pUserData, sArgument, NULL );
+}
+
+/*!     \brief  Callback for a call of a method of the automation interface
+ *
+ * \param  connection       D-Bus connection
+ * \param  sender           unique name of the caller
+ * \param  sObjectPath      object path
+ * \param  sInterfaceName   interface name
+ * \param  sMethodName      method name
+ * \param  parameters       method parameters
+ * \param  invocation       to reply to the call
+ * \param  gpGlobal         pointer to global data
+ */
+static void
+CB_automationMethodCall( GDBusConnection *connection, const gchar *sender,
+        const gchar *sObjectPath, const gchar *sInterfaceName, const gchar *sMethodName,
+        GVariant *parameters, GDBusMethodInvocation *invocation, gpointer gpGlobal ) {
+    tGlobal *pGlobal = (tGlobal *)gpGlobal;
+    const gchar *sArgument = NULL, *sFormat = NULL;
+
+    for( tAutomationCommand command = 0; command < eAUTO_NUM_COMMANDS; command++ ) {
+        if( g_strcmp0( sMethodName, automationCommands[ command ].sMethod ) != 0 )
+            continue;
+        if( command == eAUTO_EXPORT )
+            g_variant_get( parameters, "(&s&s)", &sArgument, &sFormat );
+        else if( automationCommands[ command ].sParameterType )
+            g_variant_get( parameters, "(&s)", &sArgument );
+        queueAutomationRequest( pGlobal, command, invocation, NULL, NULL, sArgument, sFormat );
+        return;
+    }
+    g_dbus_method_invocation_return_error( invocation, G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_METHOD,
+            "Unknown method %s", sMethodName );
+}
+
+static const GDBusInterfaceVTable automationVTable = { CB_automationMethodCall, NULL, NULL };
+
+/*!     \brief  Callback for the activation of an automation action
+ *
+ * \param  action       the action activated
+ * \param  parameter    parameter of the action (or NULL)
+ * \param  gpGlobal     pointer to global data
+ */
+static void
+CB_automationAction( GSimpleAction *action, GVariant *parameter, gpointer gpGlobal ) {
+    tGlobal *pGlobal = (tGlobal *)gpGlobal;
+    const gchar *sName = g_action_get_name( G_ACTION( action ) );
+    const gchar *sArgument = NULL, *sFormat = NULL;
+
+    for( tAutomationCommand command = 0; command < eAUTO_NUM_COMMANDS; command++ ) {
+        if( g_strcmp0( sName, automationCommands[ command ].sAction ) != 0 )
+            continue;
+        if( command == eAUTO_EXPORT )
+            g_variant_get( parameter, "(&s&s)", &sArgument, &sFormat );
+        else if( parameter )
+            sArgument = g_variant_get_string( parameter, NULL );
+        queueAutomationRequest( pGlobal, command, NULL, NULL, NULL, sArgument, sFormat );
+        return;
+    }
+}
+
+/*!     \brief  Note the result of saving the data received for the automation request
+ *
+ * Called from messageEventDispatch when the S2P / S1P file or the setup and calibration
+ * sent by the GPIB thread has been saved. The result is noted directly as an error posted
+ * now would only be dispatched after the GPIB thread's TM_COMPLETE_GPIB.
+ *
+ * \param  bSaved       TRUE if saved
+ * \param  sError       error message if not
+ */
+void
+automationSaveResult( gboolean bSaved, const gchar *sError ) {
+    if( pActiveRequest == NULL )
+        return;
+
+    if( bSaved ) {
+        pActiveRequest->bSaved = TRUE;
+    } else if( pActiveRequest->nErrors++ == 0 ) {
+        pActiveRequest->sError = g_strdup( sError );
+    }
+}
+
+/*!     \brief  Note a message from the GPIB thread for the automation requests
+ *
+ * Called from messageEventDispatch (after the message has been handled for the GUI).
+ * Information and errors are emitted as the Progress signal. Errors posted by the
+ * GPIB thread are attributed to the request in progress (those posted from the main
+ * loop or other threads may be dispatched after it is complete) and, when the GPIB
+ * thread completes its command, the request is completed and the next started.
+ *
+ * \param  pGlobal      pointer to global data
+ * \param  message      the message
+ */
+void
+automationMessage( tGlobal *pGlobal, messageEventData *message ) {
+    gboolean bSuccess;
+
+    switch( message->command ) {
+    case TM_INFO:
+    case TM_INFO_HIGHLIGHT:
+    case TM_ERROR:
+        if( automationRegistrationID )
+            g_dbus_connection_emit_signal( pAutomationConnection, NULL, sAutomationPath,
+                    AUTOMATION_INTERFACE, "Progress",
+                    g_variant_new( "(sb)", message->sMessage ? message->sMessage : "",
+                            message->command == TM_ERROR ), NULL );
+        if( message->command == TM_ERROR && message->bFromGPIBthread && pActiveRequest ) {
+            if( pActiveRequest->nErrors++ == 0 )
+                pActiveRequest->sError = g_strdup( message->sMessage );
+        }
+        break;
+    case TM_COMPLETE_GPIB:
+        if( pActiveRequest == NULL )
+            break;
+        if( pActiveRequest->sequence != GPOINTER_TO_UINT( message->data ) ) {
+            // a command from the GUI has completed .. ours is still to come
+            sensitiseControlsInUse( pGlobal, FALSE );
+            break;
+        }
+
+        bSuccess = (pActiveRequest->nErrors == 0);
+        switch( pActiveRequest->command ) {
+        case eAUTO_GET_TRACE:
+            bSuccess = bSuccess && pGlobal->HP8753.channels[ eCH_ONE ].chFlags.bValidData;
+            completeAutomationRequest( pGlobal, g_steal_pointer( &pActiveRequest ), bSuccess, NULL, NULL );
+            break;
+        case eAUTO_GET_SETUPandCAL:
+            bSuccess = bSuccess && pActiveRequest->bSaved;
+            completeAutomationRequest( pGlobal, g_steal_pointer( &pActiveRequest ), bSuccess, NULL, NULL );
+            break;
+        case eAUTO_CAPTURE_S2P:
+        case eAUTO_CAPTURE_S1P:
+            {
+                const gchar *sFiles[] = { pActiveRequest->sArgument, NULL };
+                bSuccess = bSuccess && pActiveRequest->bSaved;
+                completeAutomationRequest( pGlobal, g_steal_pointer( &pActiveRequest ), bSuccess, NULL,
+                        bSuccess ? sFiles : NULL );
+            }
+            break;
+        default:
+            completeAutomationRequest( pGlobal, g_steal_pointer( &pActiveRequest ), bSuccess, NULL, NULL );
+            break;
+        }
+        startNextAutomationRequest( pGlobal );
+        break;
+    default:
+        break;
+    }
+}
+
+/*!     \brief  Export the automation actions and interface on the session bus
+ *
+ * Called on startup (the application is registered on the bus by then).
+ *
+ * \param  pGlobal      pointer to global data
+ * \param  app          this application
+ */
+void
+initializeAutomation( tGlobal *pGlobal, GApplication *app ) {
+    GActionEntry actionEntries[ eAUTO_NUM_COMMANDS ] = {0};
+    GDBusNodeInfo *pIntrospection;
+    GError *err = NULL;
+
+    for( tAutomationCommand command = 0; command < eAUTO_NUM_COMMANDS; command++ ) {
+        actionEntries[ command ].name = automationCommands[ command ].sAction;
+        actionEntries[ command ].activate = CB_automationAction;
+        actionEntries[ command ].parameter_type = automationCommands[ command ].sParameterType;
+    }
+    g_action_map_add_action_entries( G_ACTION_MAP( app ), actionEntries, eAUTO_NUM_COMMANDS, pGlobal );
+
+    if( (pAutomationConnection = g_application_get_dbus_connection( app )) == NULL )
+        return;
+    sAutomationPath = g_strdup( g_application_get_dbus_object_path( app ) );
+
+    pIntrospection = g_dbus_node_info_new_for_xml( automationIntrospectionXML, NULL );
+    automationRegistrationID = g_dbus_connection_register_object( pAutomationConnection,
+            sAutomationPath, pIntrospection->interfaces[0], &automationVTable, pGlobal, NULL, &err );
+    if( automationRegistrationID == 0 ) {
+        LOG( G_LOG_LEVEL_WARNING, "Cannot export the automation interface: %s", err->message );
+        g_clear_error( &err );
+    }
+    g_dbus_node_info_unref( pIntrospection );
+}
+
+/*!     \brief  Withdraw the automation interface
+ *
+ * Queued requests are answered with an error.
+ *
+ * \param  pGlobal      pointer to global data
+ */
+void
+finalizeAutomation( tGlobal *pGlobal ) {
+    tAutomationRequest *pRequest;
+
+    if( pActiveRequest )
+        g_queue_push_head( &automationQueue, g_steal_pointer( &pActiveRequest ) );
+    while( (pRequest = g_queue_pop_head( &automationQueue )) != NULL ) {
+        if( pRequest->pDone )
+            pRequest->pDone( pGlobal, FALSE, "The application is ending", pRequest->pUserData );
+        else if( pRequest->invocation )
+            g_dbus_method_invocation_return_dbus_error( pRequest->invocation,
+                    AUTOMATION_INTERFACE ".Error.Shutdown", "The application is ending" );
+        freeAutomationRequest( pRequest );
+    }
+
+    if( automationRegistrationID )
+        g_dbus_connection_unregister_object( pAutomationConnection, automationRegistrationID );
+    automationRegistrationID = 0;
+    g_clear_pointer( &sAutomationPath, g_free );
+}
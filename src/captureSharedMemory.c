@@ -0,0 +1,163 @@
+/*
+ * Copyright (c) 2026 Michael G. Katzmann
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/*! \file captureSharedMemory.c
+ * Publish each completed capture to POSIX shared memory.
+ *
+ * With --shared-memory the traces and markers of each capture are copied (by the
+ * GPIB thread, as the capture completes) into a ring of slots in the shared memory
+ * object /hp8753-capture. Each slot is protected by a sequence lock so readers in
+ * other processes never block the writer and can detect a torn copy.
+ * The layout is in captureSharedMemory.h.
+ *
+ * e.g. in Python:
+ *      m = mmap.mmap( os.open( "/dev/shm/hp8753-capture", os.O_RDONLY ), 0, prot=mmap.PROT_READ )
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <glib-2.0/glib.h>
+
+#include "hp8753.h"
+#include "captureSharedMemory.h"
+
+static tCaptureShm  *pCaptureShm = NULL;
+static guint64      captureNumber = 0;
+
+/*!     \brief  Create the shared memory object for captures
+ *
+ * \return      OK or ERROR
+ */
+gint
+openCaptureSharedMemory( void ) {
+    gint fd;
+
+    if( pCaptureShm )
+        return OK;
+
+    if( (fd = shm_open( CAPTURE_SHM_NAME, O_CREAT | O_RDWR, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH )) < 0 ) {
+        LOG( G_LOG_LEVEL_WARNING, "Cannot create shared memory %s: %s", CAPTURE_SHM_NAME, g_strerror( errno ) );
+        return ERROR;
+    }
+    if( ftruncate( fd, sizeof( tCaptureShm ) ) != 0
+            || (pCaptureShm = mmap( NULL, sizeof( tCaptureShm ), PROT_READ | PROT_WRITE,
+                    MAP_SHARED, fd, 0 )) == MAP_FAILED ) {
+        LOG( G_LOG_LEVEL_WARNING, "Cannot map shared memory %s: %s", CAPTURE_SHM_NAME, g_strerror( errno ) );
+        pCaptureShm = NULL;
+        close( fd );
+        shm_unlink( CAPTURE_SHM_NAME );
+        return ERROR;
+    }
+    close( fd );
+
+    // a left over object from a previous run is reinitialized
+    memset( pCaptureShm, 0, sizeof( tCaptureShm ) );
+    pCaptureShm->version = CAPTURE_SHM_VERSION;
+    pCaptureShm->nSlots = CAPTURE_SHM_SLOTS;
+    pCaptureShm->slotSize = sizeof( tCaptureShmSlot );
+    __atomic_store_n( &pCaptureShm->magic, CAPTURE_SHM_MAGIC, __ATOMIC_RELEASE );
+
+    return OK;
+}
+
+/*!     \brief  Remove the shared memory object for captures
+ */
+void
+closeCaptureSharedMemory( void ) {
+    if( pCaptureShm == NULL )
+        return;
+
+    munmap( pCaptureShm, sizeof( tCaptureShm ) );
+    pCaptureShm = NULL;
+    // readers that have it mapped keep the last captures
+    shm_unlink( CAPTURE_SHM_NAME );
+}
+
+/*!     \brief  Copy a channel into a slot
+ *
+ * \param  pShmChannel  destination in the shared memory
+ * \param  pChannel     channel data
+ */
+static void
+copyChannel( tCaptureShmChannel *pShmChannel, tChannel *pChannel ) {
+    gint nPoints = MIN( pChannel->nPoints, CAPTURE_SHM_MAX_POINTS );
+    // filled by the GPIB thread before the capture is published (not here, as the
+    // main loop may be reading the channel)
+    gdouble *stimulus = pChannel->stimulusPoints;
+
+    if( !pChannel->chFlags.bValidData || pChannel->responsePoints == NULL || stimulus == NULL )
+        nPoints = 0;
+
+    pShmChannel->nPoints = nPoints;
+    pShmChannel->format = pChannel->format;
+    pShmChannel->sweepType = pChannel->sweepType;
+    pShmChannel->markersOn = pChannel->chFlags.bbMkrs;
+    for( gint i = 0; i < CAPTURE_SHM_MARKERS; i++ ) {
+        pShmChannel->markers[i][0] = pChannel->numberedMarkers[i].sourceValue;
+        pShmChannel->markers[i][1] = pChannel->numberedMarkers[i].point.r;
+        pShmChannel->markers[i][2] = pChannel->numberedMarkers[i].point.i;
+    }
+    if( nPoints > 0 ) {
+        // tComplex is two doubles, as is each response element
+        memcpy( pShmChannel->stimulus, stimulus, nPoints * sizeof( gdouble ) );
+        memcpy( pShmChannel->response, pChannel->responsePoints, nPoints * sizeof( tComplex ) );
+    }
+}
+
+/*!     \brief  Publish the capture just completed
+ *
+ * Called by the GPIB thread (the only writer). The slot after the latest is
+ * overwritten so a reader still copying the latest is not disturbed.
+ *
+ * \param  pGlobal      pointer to global data
+ * \param  sequence     sequence number of the GPIB command that made the capture
+ */
+void
+publishCaptureToSharedMemory( tGlobal *pGlobal, guint sequence ) {
+    tCaptureShmSlot *pSlot;
+    guint32 seqlock;
+
+    if( pCaptureShm == NULL )
+        return;
+
+    captureNumber++;
+    pSlot = &pCaptureShm->slots[ captureNumber % CAPTURE_SHM_SLOTS ];
+
+    // odd while writing
+    seqlock = __atomic_load_n( &pSlot->seqlock, __ATOMIC_RELAXED );
+    __atomic_store_n( &pSlot->seqlock, seqlock + 1, __ATOMIC_RELAXED );
+    __atomic_thread_fence( __ATOMIC_RELEASE );
+
+    pSlot->sequence = sequence;
+    pSlot->captureNumber = captureNumber;
+    pSlot->timeStamp = g_get_real_time();
+    g_strlcpy( pSlot->dateTime, pGlobal->HP8753.dateTime ? pGlobal->HP8753.dateTime : "",
+            sizeof( pSlot->dateTime ) );
+    pSlot->bDualChannel = pGlobal->HP8753.flags.bDualChannel;
+    copyChannel( &pSlot->channels[ eCH_ONE ], &pGlobal->HP8753.channels[ eCH_ONE ] );
+    if( pGlobal->HP8753.flags.bDualChannel )
+        copyChannel( &pSlot->channels[ eCH_TWO ], &pGlobal->HP8753.channels[ eCH_TWO ] );
+    else
+        pSlot->channels[ eCH_TWO ].nPoints = 0;
+
+    __atomic_store_n( &pSlot->seqlock, seqlock + 2, __ATOMIC_RELEASE );
+    __atomic_store_n( &pCaptureShm->latest, captureNumber, __ATOMIC_RELEASE );
+}
@@ -93,6 +93,7 @@ buildWidgetList( tGlobal *pGlobal,  GtkBuilder *builder ) {
             [ eW_nbTrace_buf_Title ]                = "WID_nbTrace_buf_Title",
             [ eW_nbTrace_box_PlotType ]             = "WID_nbTrace_box_PlotType",
             [ eW_nbTrace_lbl_Time ]                 = "WID_nbTrace_lbl_Time",
+            [ eW_nbTrace_dd_History ]               = "WID_nbTrace_dd_History",
 			[ eW_nbTrace_rbtn_PlotTypeHighRes ]     = "WID_nbTrace_rbtn_PlotTypeHighRes",
 			[ eW_nbTrace_rbtn_PlotTypeHPGL ]        = "WID_nbTrace_rbtn_PlotTypeHPGL",
 			[ eW_nbTrace_txtV_TraceNote ]           = "WID_nbTrace_txtV_TraceNote",
@@ -109,6 +110,8 @@ buildWidgetList( tGlobal *pGlobal,  GtkBuilder *builder ) {
 			[ eW_nbOpts_cbtn_ShowHPlogo ]           = "WID_nbOpts_cbtn_ShowHPlogo",
 			[ eW_nbOpts_btn_AnalyzeLS ]             = "WID_nbOpts_btn_AnalyzeLS",
 			[ eW_nbOpts_lbl_Firmware ]              = "WID_nbOpts_lbl_Firmware",
+			[ eW_nbOpts_btn_ExportProject ]         = "WID_nbOpts_btn_ExportProject",
+			[ eW_nbOpts_btn_ImportProject ]         = "WID_nbOpts_btn_ImportProject",
 			[ eW_nbOpts_rbtn_PDF_A4 ]               = "WID_nbOpts_rbtn_PDF_A4",
 			[ eW_nbOpts_rbtn_PDF_LTR ]              = "WID_nbOpts_rbtn_PDF_LTR",
 			[ eW_nbOpts_rbtn_PDF_A3 ]               = "WID_nbOpts_rbtn_PDF_A3",
@@ -174,6 +177,14 @@ buildWidgetList( tGlobal *pGlobal,  GtkBuilder *builder ) {
             [ eW_DR_lbl_From ]                      = "WID_DR_lbl_From",
             [ eW_DR_lbl_To ]                        = "WID_DR_lbl_To",
 
+			// Profile browser
+            [ eW_dlg_Browse ]                       = "WID_dlg_Browse",
+            [ eW_PB_search_Text ]                   = "WID_PB_search_Text",
+            [ eW_PB_chk_ThisProject ]               = "WID_PB_chk_ThisProject",
+            [ eW_PB_chk_ByDate ]                    = "WID_PB_chk_ByDate",
+            [ eW_PB_cv_Profiles ]                   = "WID_PB_cv_Profiles",
+            [ eW_PB_lbl_Count ]                     = "WID_PB_lbl_Count",
+
             [ eW_Splash ]                           = "WID_Splash",
             [ eW_lbl_Version ]                       = "WID_lbl_Version"
     };
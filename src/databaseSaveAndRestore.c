@@ -17,13 +17,18 @@
 #include <hp8753.h>
 #include <sqlite3.h>
 #include <sys/stat.h>
+#include <glib/gstdio.h>
 
 #include "widgetID.h"
 #include "messageEvent.h"
 #include "calibrationKit.h"
+#include "exportWorker.h"
 
 static sqlite3 *db = NULL;
 
+#define DB_BUSY_TIMEOUT     5000    // ms to wait for a lock held by another connection
+#define HISTORY_MAX_DEPTH   31      // XOR deltas of the trace history before a complete capture is stored
+
 static gint
 bind_string( sqlite3_stmt* statement, gint posn, const gchar * string )
 {
@@ -153,9 +158,557 @@ gchar *sqlCreateTables[] = {
 		    "product            TEXT,"
 			"PRIMARY KEY (ID)"
 		");",
-		"PRAGMA auto_vacuum = FULL;"
+		"CREATE TABLE IF NOT EXISTS BLOBS("
+			"hash            TEXT NOT NULL,"
+			"refcount        INTEGER NOT NULL DEFAULT 0,"
+			"data            BLOB,"
+			"PRIMARY KEY (hash)"
+		");",
+		"CREATE INDEX IF NOT EXISTS BLOBS_UNREFERENCED ON BLOBS (refcount) WHERE refcount <= 0;",
+		// Full text index of the calibration (kind 0) and trace (kind 1) profiles used by the profile browser.
+		// The rowid is that of the channel 0 row of the profile (x2 + kind) so the triggers can find it directly.
+		"CREATE VIRTUAL TABLE IF NOT EXISTS PROFILE_SEARCH USING fts5("
+			"project, name, title, notes, time,"
+			"kind UNINDEXED, sortTime UNINDEXED,"
+			"prefix = '2 3'"
+		");",
+		// Small PNG image of each trace profile shown by the profile browser.
+		// traceID is the rowid of the channel 0 row of the profile in HP8753C_TRACEDATA.
+		"CREATE TABLE IF NOT EXISTS TRACE_THUMBNAILS("
+			"traceID         INTEGER NOT NULL,"
+			"png             BLOB,"
+			"PRIMARY KEY (traceID)"
+		");",
+		// Every capture saved under a trace profile name. The points are an XOR delta of the
+		// previous capture with the same sweep setup (baseID) or complete if baseID is NULL.
+		// depth is the number of deltas to the complete capture.
+		"CREATE TABLE IF NOT EXISTS TRACE_HISTORY("
+			"captureID       INTEGER PRIMARY KEY,"
+			"project         TEXT,"
+			"name            TEXT NOT NULL,"
+			"channel         INTEGER NOT NULL,"
+			"time            TEXT,"
+			"isoTime         TEXT NOT NULL,"
+			"baseID          INTEGER,"
+			"depth           INTEGER NOT NULL DEFAULT 0,"
+			"sweepStart      REAL,"
+			"sweepStop       REAL,"
+			"IFbandwidth     REAL,"
+			"CWfrequency     REAL,"
+			"sweepType       INTEGER,"
+			"npoints         INTEGER,"
+			"format          INTEGER,"
+			"sParamOrInputPort INTEGER,"
+			"points          BLOB,"
+			"stimulusPoints  BLOB"
+		");",
+		"CREATE INDEX IF NOT EXISTS TRACE_HISTORY_TIME ON TRACE_HISTORY (project, name, isoTime);",
+		"PRAGMA auto_vacuum = FULL;",
+		// needed so that INSERT OR REPLACE fires the delete triggers on the replaced row
+		"PRAGMA recursive_triggers = ON;"
+};
+
+// The learn string and calibration arrays of HP8753C_CALIBRATION and the screenPlot
+// of HP8753C_TRACEDATA hold the SHA-256 key of the data in the BLOBS table.
+#define CAL_BLOB_COLUMNS( r ) \
+		r "learn, " r "cal01, " r "cal02, " r "cal03, " r "cal04, " r "cal05, " r "cal06, " \
+		r "cal07, " r "cal08, " r "cal09, " r "cal10, " r "cal11, " r "cal12"
+#define CAL_BLOB_REFS( r ) \
+		"((hash IS " r "learn) + (hash IS " r "cal01) + (hash IS " r "cal02) + (hash IS " r "cal03)" \
+		" + (hash IS " r "cal04) + (hash IS " r "cal05) + (hash IS " r "cal06) + (hash IS " r "cal07)" \
+		" + (hash IS " r "cal08) + (hash IS " r "cal09) + (hash IS " r "cal10) + (hash IS " r "cal11)" \
+		" + (hash IS " r "cal12))"
+#define BLOB_DATA( column ) "(SELECT data FROM BLOBS WHERE hash = " column ")"
+
+// Columns of the profile tables other than project, selected & name
+// (used where rows are copied between databases, see exportProjectArchive)
+#define CALIBRATION_DATA_COLUMNS \
+		"channel, learn, sweepStart, sweepStop, IFbandwidth, CWfrequency, sweepType, npoints, calType, " \
+		"cal01, cal02, cal03, cal04, cal05, cal06, cal07, cal08, cal09, cal10, cal11, cal12, " \
+		"notes, perChannelCalSettings, calSettings"
+#define TRACEDATA_DATA_COLUMNS \
+		"channel, sweepStart, sweepStop, IFbandwidth, CWfrequency, sweepType, npoints, points, " \
+		"stimulusPoints, format, scaleVal, scaleRefPos, scaleRefVal, sParamOrInputPort, markers, " \
+		"activeMkr, deltaMkr, mkrType, bandwidth, nSegments, segments, screenPlot, title, notes, " \
+		"perChannelFlags, generalFlags, time"
+#define TRACE_HISTORY_DATA_COLUMNS \
+		"channel, time, isoTime, depth, sweepStart, sweepStop, IFbandwidth, CWfrequency, " \
+		"sweepType, npoints, format, sParamOrInputPort, points, stimulusPoints"
+// Every blob key held by the calibration rows (c) and trace rows (t) of a project
+#define PROJECT_BLOB_KEYS( c, t ) \
+		"SELECT learn FROM " c " UNION SELECT cal01 FROM " c " UNION SELECT cal02 FROM " c \
+		" UNION SELECT cal03 FROM " c " UNION SELECT cal04 FROM " c " UNION SELECT cal05 FROM " c \
+		" UNION SELECT cal06 FROM " c " UNION SELECT cal07 FROM " c " UNION SELECT cal08 FROM " c \
+		" UNION SELECT cal09 FROM " c " UNION SELECT cal10 FROM " c " UNION SELECT cal11 FROM " c \
+		" UNION SELECT cal12 FROM " c " UNION SELECT screenPlot FROM " t
+
+// Reference counts of the BLOBS table are kept by triggers on the referencing tables
+// so that copies (INSERT ... SELECT) only touch metadata.
+// These are created after any schema update (see recoverProgramOptions).
+gchar *sqlBlobTriggers[] = {
+		"CREATE TRIGGER IF NOT EXISTS CALIBRATION_BLOBS_INSERT AFTER INSERT ON HP8753C_CALIBRATION BEGIN"
+		"  UPDATE BLOBS SET refcount = refcount + " CAL_BLOB_REFS( "NEW." )
+		"    WHERE hash IN (" CAL_BLOB_COLUMNS( "NEW." ) ");"
+		" END;",
+		"CREATE TRIGGER IF NOT EXISTS CALIBRATION_BLOBS_DELETE AFTER DELETE ON HP8753C_CALIBRATION BEGIN"
+		"  UPDATE BLOBS SET refcount = refcount - " CAL_BLOB_REFS( "OLD." )
+		"    WHERE hash IN (" CAL_BLOB_COLUMNS( "OLD." ) ");"
+		" END;",
+		"CREATE TRIGGER IF NOT EXISTS CALIBRATION_BLOBS_UPDATE AFTER UPDATE OF "
+		    CAL_BLOB_COLUMNS( "" ) " ON HP8753C_CALIBRATION BEGIN"
+		"  UPDATE BLOBS SET refcount = refcount - " CAL_BLOB_REFS( "OLD." )
+		"    WHERE hash IN (" CAL_BLOB_COLUMNS( "OLD." ) ");"
+		"  UPDATE BLOBS SET refcount = refcount + " CAL_BLOB_REFS( "NEW." )
+		"    WHERE hash IN (" CAL_BLOB_COLUMNS( "NEW." ) ");"
+		" END;",
+		"CREATE TRIGGER IF NOT EXISTS TRACEDATA_BLOBS_INSERT AFTER INSERT ON HP8753C_TRACEDATA BEGIN"
+		"  UPDATE BLOBS SET refcount = refcount + 1 WHERE hash = NEW.screenPlot;"
+		" END;",
+		"CREATE TRIGGER IF NOT EXISTS TRACEDATA_BLOBS_DELETE AFTER DELETE ON HP8753C_TRACEDATA BEGIN"
+		"  UPDATE BLOBS SET refcount = refcount - 1 WHERE hash = OLD.screenPlot;"
+		" END;",
+		"CREATE TRIGGER IF NOT EXISTS TRACEDATA_BLOBS_UPDATE AFTER UPDATE OF screenPlot ON HP8753C_TRACEDATA BEGIN"
+		"  UPDATE BLOBS SET refcount = refcount - 1 WHERE hash = OLD.screenPlot;"
+		"  UPDATE BLOBS SET refcount = refcount + 1 WHERE hash = NEW.screenPlot;"
+		" END;"
 };
 
+// The profile search index is kept up to date by triggers.
+// These are created after any schema update (see recoverProgramOptions).
+gchar *sqlSearchTriggers[] = {
+		"CREATE TRIGGER IF NOT EXISTS CALIBRATION_SEARCH_INSERT AFTER INSERT ON HP8753C_CALIBRATION"
+		"  WHEN NEW.channel = 0 BEGIN"
+		"  INSERT INTO PROFILE_SEARCH (rowid, project, name, notes, kind)"
+		"    VALUES (NEW.rowid * 2, NEW.project, NEW.name, NEW.notes, 0);"
+		" END;",
+		"CREATE TRIGGER IF NOT EXISTS CALIBRATION_SEARCH_DELETE AFTER DELETE ON HP8753C_CALIBRATION"
+		"  WHEN OLD.channel = 0 BEGIN"
+		"  DELETE FROM PROFILE_SEARCH WHERE rowid = OLD.rowid * 2;"
+		" END;",
+		"CREATE TRIGGER IF NOT EXISTS CALIBRATION_SEARCH_UPDATE AFTER UPDATE OF project, name, notes ON HP8753C_CALIBRATION"
+		"  WHEN NEW.channel = 0 BEGIN"
+		"  UPDATE PROFILE_SEARCH SET project = NEW.project, name = NEW.name, notes = NEW.notes"
+		"    WHERE rowid = OLD.rowid * 2;"
+		" END;",
+		"CREATE TRIGGER IF NOT EXISTS TRACEDATA_SEARCH_INSERT AFTER INSERT ON HP8753C_TRACEDATA"
+		"  WHEN NEW.channel = 0 BEGIN"
+		"  INSERT INTO PROFILE_SEARCH (rowid, project, name, title, notes, time, kind, sortTime)"
+		"    VALUES (NEW.rowid * 2 + 1, NEW.project, NEW.name, NEW.title, NEW.notes, NEW.time, 1, isoTime(NEW.time));"
+		" END;",
+		"CREATE TRIGGER IF NOT EXISTS TRACEDATA_SEARCH_DELETE AFTER DELETE ON HP8753C_TRACEDATA"
+		"  WHEN OLD.channel = 0 BEGIN"
+		"  DELETE FROM PROFILE_SEARCH WHERE rowid = OLD.rowid * 2 + 1;"
+		" END;",
+		"CREATE TRIGGER IF NOT EXISTS TRACEDATA_SEARCH_UPDATE AFTER UPDATE OF project, name, title, notes, time ON HP8753C_TRACEDATA"
+		"  WHEN NEW.channel = 0 BEGIN"
+		"  UPDATE PROFILE_SEARCH SET project = NEW.project, name = NEW.name, title = NEW.title,"
+		"      notes = NEW.notes, time = NEW.time, sortTime = isoTime(NEW.time)"
+		"    WHERE rowid = OLD.rowid * 2 + 1;"
+		" END;"
+};
+
+// The thumbnail goes with the trace profile row (a rename or move keeps the rowid,
+// a save over the profile replaces the row and so the thumbnail).
+// These are created after any schema update (see recoverProgramOptions).
+gchar *sqlThumbnailTriggers[] = {
+		"CREATE TRIGGER IF NOT EXISTS TRACEDATA_THUMBNAIL_DELETE AFTER DELETE ON HP8753C_TRACEDATA"
+		"  WHEN OLD.channel = 0 BEGIN"
+		"  DELETE FROM TRACE_THUMBNAILS WHERE traceID = OLD.rowid;"
+		" END;"
+};
+
+// The history follows the trace profile when it is renamed or moved to another project.
+// (It is deleted with the profile in deleteDBentry, not by a trigger, because saving
+//  over a profile replaces, and so deletes, its rows.)
+// These are created after any schema update (see recoverProgramOptions).
+gchar *sqlHistoryTriggers[] = {
+		"CREATE TRIGGER IF NOT EXISTS TRACEDATA_HISTORY_RENAME AFTER UPDATE OF project, name ON HP8753C_TRACEDATA"
+		"  WHEN NEW.channel = 0 BEGIN"
+		"  UPDATE TRACE_HISTORY SET project = NEW.project, name = NEW.name"
+		"    WHERE project IS OLD.project AND name = OLD.name;"
+		" END;"
+};
+
+/*!     \brief  SQL function converting the saved time of a trace to a sortable form
+ *
+ * Registered with sqlite as isoTime(x). The time is saved as formatted by getTimeStamp()
+ * ("%e %b %Y %H:%M:%S") which does not sort. This returns "YYYY-MM-DD HH:MM:SS" or NULL
+ * if the time cannot be interpreted. The month is matched against the abbreviations of the
+ * current locale (as used when formatted) and then against the English abbreviations.
+ * As the result depends on the locale, it is not registered as deterministic.
+ *
+ * \param context   sqlite function context
+ * \param argc      number of arguments (1)
+ * \param argv      arguments
+ */
+static void
+sqlFnIsoTime( sqlite3_context *context, gint argc, sqlite3_value **argv ) {
+	static gchar **sLocaleMonths = NULL;
+	static const gchar *sEnglishMonths[ 12 ] = { "Jan", "Feb", "Mar", "Apr", "May", "Jun",
+			"Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
+	const gchar *sTime = (const gchar *)sqlite3_value_text( argv[0] );
+	gint day, year, hour, minute, second, month;
+	gchar sMonth[ 32 ];
+
+	// filled once .. the function may be called on any connection (and thread)
+	if( g_once_init_enter( &sLocaleMonths ) ) {
+		gchar **sMonths = g_new0( gchar *, 12 + 1 );
+
+		for( month = 0; month < 12; month++ ) {
+			GDateTime *dt = g_date_time_new_utc( 2000, month + 1, 1, 0, 0, 0 );
+			gchar *sAbbreviation = g_date_time_format( dt, "%b" );
+			sMonths[ month ] = g_utf8_casefold( sAbbreviation, -1 );
+			g_free( sAbbreviation );
+			g_date_time_unref( dt );
+		}
+		g_once_init_leave( &sLocaleMonths, sMonths );
+	}
+
+	if( sTime == NULL
+			|| sscanf( sTime, "%d %31s %d %d:%d:%d", &day, sMonth, &year, &hour, &minute, &second ) != 6 ) {
+		sqlite3_result_null( context );
+		return;
+	}
+
+	gchar *sMonthFolded = g_utf8_casefold( sMonth, -1 );
+	for( month = 0; month < 12; month++ )
+		if( g_strcmp0( sMonthFolded, sLocaleMonths[ month ] ) == 0 )
+			break;
+	for( gint i = 0; month == 12 && i < 12; i++ )
+		if( g_ascii_strcasecmp( sMonth, sEnglishMonths[ i ] ) == 0 )
+			month = i;
+	g_free( sMonthFolded );
+
+	if( month < 12 )
+		sqlite3_result_text( context, g_strdup_printf( "%04d-%02d-%02d %02d:%02d:%02d",
+				year, month + 1, day, hour, minute, second ), -1, g_free );
+	else
+		sqlite3_result_null( context );
+}
+
+/*!     \brief  SQL function returning the SHA-256 digest of a blob
+ *
+ * Registered with sqlite as sha256(x). It is used to key the existing blobs
+ * when the database is updated to use the BLOBS table.
+ * NULL or empty values give NULL.
+ *
+ * \param context   sqlite function context
+ * \param argc      number of arguments (1)
+ * \param argv      arguments
+ */
+static void
+sqlFnSHA256( sqlite3_context *context, gint argc, sqlite3_value **argv ) {
+	const void *pData = sqlite3_value_blob( argv[0] );
+	gint length = sqlite3_value_bytes( argv[0] );
+
+	if( pData == NULL || length == 0 ) {
+		sqlite3_result_null( context );
+	} else {
+		gchar *sHash = g_compute_checksum_for_data( G_CHECKSUM_SHA256, pData, length );
+		sqlite3_result_text( context, sHash, -1, g_free );
+	}
+}
+
+// Stored blobs are preceded by this header. The data may be compressed and, for arrays of
+// doubles, each value may first be XORed with the value 'xorStride' doubles before it.
+// Since adjacent trace values are close, this leaves mostly zero bits to compress.
+#define BLOB_MAGIC     0x5A333538      // "853Z"
+
+enum eBlobCodec { eCODEC_NONE = 0, eCODEC_ZLIB = 1 };
+
+typedef struct {
+	guint32 magic;
+	guint8  codec;
+	guint8  xorStride;
+	guint16 spare;
+	guint32 length;         // length of the decoded data
+} __attribute__((packed)) tBlobHeader;
+
+/*!     \brief  Run data through a GZlibCompressor or GZlibDecompressor
+ *
+ * \param converter  the compressor or decompressor
+ * \param pIn        pointer to input data
+ * \param inLength   length of input data
+ * \param outHint    expected length of output data
+ * \param pOut       byte array to which the output is appended
+ * \return           TRUE on success
+ */
+static gboolean
+convertBlob( GConverter *converter, const guchar *pIn, gsize inLength, gsize outHint, GByteArray *pOut ) {
+	GConverterResult result;
+	gsize bytesRead, bytesWritten, outPosn = pOut->len;
+	GError *err = NULL;
+
+	g_byte_array_set_size( pOut, outPosn + outHint + 64 );
+	do {
+		if( pOut->len - outPosn < 64 )
+			g_byte_array_set_size( pOut, pOut->len * 2 );
+		result = g_converter_convert( converter, pIn, inLength, pOut->data + outPosn, pOut->len - outPosn,
+				G_CONVERTER_INPUT_AT_END, &bytesRead, &bytesWritten, &err );
+		if( result == G_CONVERTER_ERROR ) {
+			if( !g_error_matches( err, G_IO_ERROR, G_IO_ERROR_NO_SPACE ) ) {
+				LOG( G_LOG_LEVEL_WARNING, "blob codec: %s", err->message );
+				g_clear_error( &err );
+				return FALSE;
+			}
+			g_clear_error( &err );
+			g_byte_array_set_size( pOut, pOut->len * 2 );
+			continue;
+		}
+		pIn += bytesRead;
+		inLength -= bytesRead;
+		outPosn += bytesWritten;
+	} while( result != G_CONVERTER_FINISHED );
+
+	g_byte_array_set_size( pOut, outPosn );
+	return TRUE;
+}
+
+/*!     \brief  XOR each double with the one 'stride' positions before it (or undo this)
+ *
+ * \param pValues    array of doubles (as 64 bit words)
+ * \param nValues    number of doubles
+ * \param stride     distance to the value XORed with (e.g. 2 for tComplex arrays)
+ * \param bEncode    TRUE to encode, FALSE to decode
+ */
+static void
+xorDeltaDoubles( guint64 *pValues, gsize nValues, gsize stride, gboolean bEncode ) {
+	if( bEncode ) {
+		for( gsize i = nValues; i-- > stride; )
+			pValues[ i ] ^= pValues[ i - stride ];
+	} else {
+		for( gsize i = stride; i < nValues; i++ )
+			pValues[ i ] ^= pValues[ i - stride ];
+	}
+}
+
+/*!     \brief  Encode data for storage in the database
+ *
+ * Add the codec header and compress the data (if that makes it smaller).
+ *
+ * \param pData      pointer to data
+ * \param length     number of bytes of data
+ * \param xorStride  0 or the stride for the XOR-delta of an array of doubles
+ * \return           encoded data (caller must unref)
+ */
+static GBytes *
+encodeBlob( gconstpointer pData, gsize length, gint xorStride ) {
+	tBlobHeader header = { BLOB_MAGIC, eCODEC_ZLIB, 0, 0, length };
+	GByteArray *pEncoded = g_byte_array_sized_new( sizeof( tBlobHeader ) + length );
+	guchar *pTransformed = NULL;
+	GZlibCompressor *compressor = g_zlib_compressor_new( G_ZLIB_COMPRESSOR_FORMAT_RAW, 6 );
+
+	if( xorStride > 0 && length % sizeof( gdouble ) == 0 ) {
+		pTransformed = g_memdup2( pData, length );
+		xorDeltaDoubles( (guint64 *)pTransformed, length / sizeof( gdouble ), xorStride, TRUE );
+		pData = pTransformed;
+		header.xorStride = xorStride;
+	}
+
+	g_byte_array_append( pEncoded, (guint8 *)&header, sizeof( tBlobHeader ) );
+	if( !convertBlob( G_CONVERTER( compressor ), pData, length, length, pEncoded )
+			|| pEncoded->len >= sizeof( tBlobHeader ) + length ) {
+		// incompressible ... store it as is
+		header.codec = eCODEC_NONE;
+		g_byte_array_set_size( pEncoded, 0 );
+		g_byte_array_append( pEncoded, (guint8 *)&header, sizeof( tBlobHeader ) );
+		g_byte_array_append( pEncoded, pData, length );
+	}
+
+	g_object_unref( compressor );
+	g_free( pTransformed );
+	return g_byte_array_free_to_bytes( pEncoded );
+}
+
+/*!     \brief  Decode data stored in the database
+ *
+ * Blobs written before compression was introduced have no header and are returned as is.
+ *
+ * \param pBlob      pointer to stored data
+ * \param blobLength number of bytes of stored data
+ * \param pLength    pointer to the length of the decoded data
+ * \return           decoded data (caller must g_free) or NULL
+ */
+static guchar *
+decodeBlob( gconstpointer pBlob, gsize blobLength, gsize *pLength ) {
+	tBlobHeader header;
+	guchar *pDecoded = NULL;
+
+	*pLength = 0;
+	if( pBlob == NULL || blobLength == 0 )
+		return NULL;
+
+	memcpy( &header, pBlob, MIN( blobLength, sizeof( tBlobHeader ) ) );
+	if( blobLength < sizeof( tBlobHeader ) || header.magic != BLOB_MAGIC ) {
+		*pLength = blobLength;
+		return g_memdup2( pBlob, blobLength );
+	}
+
+	pBlob = (const guchar *)pBlob + sizeof( tBlobHeader );
+	blobLength -= sizeof( tBlobHeader );
+
+	switch( header.codec ) {
+	case eCODEC_NONE:
+		if( blobLength != header.length )
+			return NULL;
+		pDecoded = g_memdup2( pBlob, blobLength );
+		break;
+	case eCODEC_ZLIB: {
+		GZlibDecompressor *decompressor = g_zlib_decompressor_new( G_ZLIB_COMPRESSOR_FORMAT_RAW );
+		GByteArray *pOut = g_byte_array_sized_new( header.length );
+		gboolean bOK = convertBlob( G_CONVERTER( decompressor ), pBlob, blobLength, header.length, pOut )
+				&& pOut->len == header.length;
+		g_object_unref( decompressor );
+		if( !bOK ) {
+			g_byte_array_free( pOut, TRUE );
+			return NULL;
+		}
+		pDecoded = g_byte_array_free( pOut, FALSE );
+		}
+		break;
+	default:
+		return NULL;
+	}
+
+	if( header.xorStride > 0 )
+		xorDeltaDoubles( (guint64 *)pDecoded, header.length / sizeof( gdouble ), header.xorStride, FALSE );
+
+	*pLength = header.length;
+	return pDecoded;
+}
+
+/*!     \brief  Bind a blob encoded for storage
+ *
+ * \param statement  prepared statement
+ * \param posn       parameter index
+ * \param pData      pointer to data (or NULL)
+ * \param length     number of bytes of data
+ * \param xorStride  0 or the stride for the XOR-delta of an array of doubles
+ * \return           sqlite status
+ */
+static gint
+bind_encodedBlob( sqlite3_stmt* statement, gint posn, gconstpointer pData, gint length, gint xorStride )
+{
+	gsize size;
+	gint rc;
+
+	if( pData == NULL || length <= 0 )
+		return ( sqlite3_bind_null( statement, posn ) );
+
+	GBytes *encoded = encodeBlob( pData, length, xorStride );
+	gconstpointer pEncoded = g_bytes_get_data( encoded, &size );
+	rc = sqlite3_bind_blob( statement, posn, pEncoded, size, SQLITE_TRANSIENT );
+	g_bytes_unref( encoded );
+
+	return rc;
+}
+
+/*!     \brief  Get a stored blob from a column of a query result and decode it
+ *
+ * \param stmt       prepared statement
+ * \param column     column index
+ * \param pLength    pointer to the length of the decoded data
+ * \return           decoded data (caller must g_free) or NULL
+ */
+static guchar *
+column_decodedBlob( sqlite3_stmt *stmt, gint column, gsize *pLength ) {
+	const void *pBlob = sqlite3_column_blob( stmt, column );
+	return decodeBlob( pBlob, sqlite3_column_bytes( stmt, column ), pLength );
+}
+
+/*!     \brief  SQL function to encode a stored blob
+ *
+ * Registered with sqlite as encodeBlob(x, stride). Used when updating the database schema.
+ * NULL, empty or already encoded values are returned unchanged.
+ *
+ * \param context   sqlite function context
+ * \param argc      number of arguments (2)
+ * \param argv      arguments
+ */
+static void
+sqlFnEncodeBlob( sqlite3_context *context, gint argc, sqlite3_value **argv ) {
+	const void *pData = sqlite3_value_blob( argv[0] );
+	gint length = sqlite3_value_bytes( argv[0] );
+	gsize size;
+
+	if( pData == NULL || length == 0 || sqlite3_value_type( argv[0] ) != SQLITE_BLOB
+			|| ( length >= sizeof( tBlobHeader ) && ((tBlobHeader *)pData)->magic == BLOB_MAGIC ) ) {
+		sqlite3_result_value( context, argv[0] );
+	} else {
+		GBytes *encoded = encodeBlob( pData, length, sqlite3_value_int( argv[1] ) );
+		gconstpointer pEncoded = g_bytes_get_data( encoded, &size );
+		sqlite3_result_blob( context, pEncoded, size, SQLITE_TRANSIENT );
+		g_bytes_unref( encoded );
+	}
+}
+
+/*!     \brief  Bind a blob as a reference into the BLOBS table
+ *
+ * The data is keyed by its SHA-256 digest and added (encoded) to the BLOBS table if
+ * it is not already there. The key is bound in place of the data.
+ * The reference count is maintained by the triggers on the referencing table.
+ *
+ * \param statement  prepared statement
+ * \param posn       parameter index
+ * \param pData      pointer to data (or NULL)
+ * \param length     number of bytes of data
+ * \return           sqlite status
+ */
+static gint
+bind_hashedBlob( sqlite3_stmt* statement, gint posn, gconstpointer pData, gint length )
+{
+	sqlite3_stmt *stmt = NULL;
+	gchar *sHash;
+	gint rc;
+
+	if( pData == NULL || length <= 0 )
+		return ( sqlite3_bind_null( statement, posn ) );
+
+	// The key is the digest of the data (not the encoded data)
+	sHash = g_compute_checksum_for_data( G_CHECKSUM_SHA256, pData, length );
+	if( (rc = sqlite3_prepare_v2(db,
+			"INSERT OR IGNORE INTO BLOBS (hash, refcount, data) VALUES (?,0,?);", -1, &stmt, NULL)) == SQLITE_OK
+			&& (rc = sqlite3_bind_text( stmt, 1, sHash, -1, SQLITE_STATIC )) == SQLITE_OK
+			&& (rc = bind_encodedBlob( stmt, 2, pData, length, 0 )) == SQLITE_OK
+			&& (rc = sqlite3_step( stmt )) == SQLITE_DONE )
+		rc = sqlite3_bind_text( statement, posn, sHash, -1, SQLITE_TRANSIENT );
+	sqlite3_finalize( stmt );
+	g_free( sHash );
+
+	return rc;
+}
+
+/*!     \brief  Remove blobs that are no longer referenced
+ *
+ * Blobs are added with a zero reference count before the row that references them
+ * is written, so this is only done after a profile has been saved or deleted.
+ *
+ * \param pDB        database connection
+ * \return           completion status
+ */
+static gint
+purgeUnreferencedBlobs( sqlite3 *pDB ) {
+	if (sqlite3_exec(pDB, "DELETE FROM BLOBS WHERE refcount <= 0;", NULL, NULL, NULL) != SQLITE_OK) {
+		postMessageToMainLoop(TM_ERROR, (gchar*) sqlite3_errmsg(pDB));
+		return ERROR;
+	}
+	return OK;
+}
+
+/*!     \brief  Register the SQL functions used by the schema updates and triggers
+ *
+ * \param pDB        database connection
+ */
+static void
+registerSQLfunctions( sqlite3 *pDB ) {
+	sqlite3_create_function( pDB, "sha256", 1, SQLITE_UTF8 | SQLITE_DETERMINISTIC,
+			NULL, sqlFnSHA256, NULL, NULL );
+	sqlite3_create_function( pDB, "encodeBlob", 2, SQLITE_UTF8 | SQLITE_DETERMINISTIC,
+			NULL, sqlFnEncodeBlob, NULL, NULL );
+	sqlite3_create_function( pDB, "isoTime", 1, SQLITE_UTF8,
+			NULL, sqlFnIsoTime, NULL, NULL );
+}
+
 
 /*!     \brief  Open Sqlite database (or create tables)
  *
@@ -188,6 +741,12 @@ openOrCreateDB(void) {
 			break;
 		}
 
+		// the thumbnail generator and the project archive thread have their own connections
+		// (see startThumbnailGeneration and startProjectArchive)
+		sqlite3_busy_timeout( db, DB_BUSY_TIMEOUT );
+
+		registerSQLfunctions( db );
+
 		// if the table(s) do not exist, create them
 		for (i = 0; i < sizeof(sqlCreateTables) / sizeof(gchar*); i++) {
 			if ((rc = sqlite3_exec(db, sqlCreateTables[i], NULL, 0, &zErrMsg)) != SQLITE_OK) {
@@ -334,20 +893,16 @@ compareTraceItemsForSort( gpointer pTraceListItem1, gpointer pTraceListItem2 ) {
 
 }
 
-/*!     \brief  Get the skeleton data on setup and calibration profiles
+/*!     \brief  Read the skeleton data on the setup and calibration profiles of a project
  *
- * Populate a list of available setup and calibration profiles
- * including some basic data that is used to identify the profile.
+ * The profiles are prepended (unsorted) to the list.
  *
- * \param  pGlobal      pointer to tGlobal structure (containing the pointer to list)
+ * \param  sProject     project
+ * \param  ppList       pointer to the list to add the tHP8753cal items to
  * \return 				completion status
  */
-gint
-inventorySavedSetupsAndCal(tGlobal *pGlobal) {
-
-	g_list_free_full ( g_steal_pointer (&pGlobal->pCalList), (GDestroyNotify)freeCalListItem );
-	pGlobal->pCalList = NULL;
-
+static gint
+readCalibrationAbstracts( const gchar *sProject, GList **ppList ) {
 	tHP8753cal *pCal;
 	sqlite3_stmt *stmt = NULL;
 	gint queryIndex;
@@ -362,8 +917,10 @@ inventorySavedSetupsAndCal(tGlobal *pGlobal) {
 			"   b.CalType, a.perChannelCalSettings, b.perChannelCalSettings, a.calSettings "
 			" FROM HP8753C_CALIBRATION a LEFT JOIN HP8753C_CALIBRATION b "
 			" ON a.project=b.project AND a.name=b.name"
-			" WHERE a.channel=0 AND b.channel=1;", -1, &stmt, NULL) != SQLITE_OK) {
+			" WHERE a.project IS (?) AND a.channel=0 AND b.channel=1;", -1, &stmt, NULL) != SQLITE_OK
+			|| bind_string( stmt, 1, sProject ) != SQLITE_OK) {
 		postMessageToMainLoop(TM_ERROR, (gchar*) sqlite3_errmsg(db));
+		sqlite3_finalize(stmt);
 		return ERROR;
 	} else {
 		while (sqlite3_step(stmt) == SQLITE_ROW) {
@@ -409,21 +966,43 @@ inventorySavedSetupsAndCal(tGlobal *pGlobal) {
 			settings = sqlite3_column_int(stmt, queryIndex++);
 			memcpy( &pCal->settings, &settings, sizeof( gushort ) );
 
-			pGlobal->pCalList = g_list_prepend(pGlobal->pCalList, pCal);
+			*ppList = g_list_prepend(*ppList, pCal);
 		}
 		sqlite3_finalize(stmt);
 	}
 
+	return OK;
+}
+
+/*!     \brief  Get the skeleton data on setup and calibration profiles
+ *
+ * Populate a list of available setup and calibration profiles
+ * including some basic data that is used to identify the profile.
+ * Only the profiles of the current project are read; those of the other
+ * projects are read when the project is first selected (see inventoryProject).
+ *
+ * \param  pGlobal      pointer to tGlobal structure (containing the pointer to list)
+ * \return 				completion status
+ */
+gint
+inventorySavedSetupsAndCal(tGlobal *pGlobal) {
+
+	g_list_free_full ( g_steal_pointer (&pGlobal->pCalList), (GDestroyNotify)freeCalListItem );
+	pGlobal->pCalList = NULL;
+
+	if( readCalibrationAbstracts( pGlobal->sProject, &pGlobal->pCalList ) != OK )
+		return ERROR;
+
 	pGlobal->pCalList = g_list_sort (pGlobal->pCalList, (GCompareFunc)compareCalItemsForSort);
+	catalogRebuild( &pGlobal->calCatalog, pGlobal->pCalList );
+	catalogSetProjectLoaded( &pGlobal->calCatalog, pGlobal->sProject );
 
     // find the last selected setup & cal for the project that was last selected
     pGlobal->pCalibrationAbstract = NULL;
-    for( GList *l = pGlobal->pCalList; l != NULL; l = l->next ){
-        tHP8753cal *pCalibration = (tHP8753cal *)(l->data);
-            tProjectAndName *pProjectAndName = &pCalibration->projectAndName;
-            if( pProjectAndName->bbFlags.bSelected && g_strcmp0( pProjectAndName->sProject, pGlobal->sProject ) == 0) {
-                pGlobal->pCalibrationAbstract = pCalibration;
-            }
+    tHP8753cal *pCalibration;
+    for( guint i = 0; (pCalibration = catalogNthInProject( &pGlobal->calCatalog, pGlobal->sProject, i )) != NULL; i++ ){
+        if( pCalibration->projectAndName.bbFlags.bSelected )
+            pGlobal->pCalibrationAbstract = pCalibration;
     }
 
 	return OK;
@@ -484,40 +1063,291 @@ compareCalKitIdentifierItem( gpointer pCalKitIdentfierItem, gpointer sLabel ) {
 }
 
 
+/*!     \brief  Read the names of the saved trace profiles of a project
+ *
+ * The profiles are prepended (unsorted) to the list.
+ *
+ * \param  sProject     project
+ * \param  ppList       pointer to the list to add the tHP8753traceAbstract items to
+ * \return 				completion status
+ */
+static gint
+readTraceAbstracts( const gchar *sProject, GList **ppList ) {
+	gchar *zErrMsg = 0;
+	gchar *sSQL = sqlite3_mprintf(
+			"SELECT project,name,selected,title,notes,time FROM HP8753C_TRACEDATA"
+			" WHERE project IS %Q AND channel=0;", sProject );
+	gint rc = sqlite3_exec(db, sSQL, sqlCBtraceAbstract, ppList, &zErrMsg);
+
+	sqlite3_free(sSQL);
+	if (rc != SQLITE_OK) {
+		postMessageToMainLoop(TM_ERROR, zErrMsg);
+		sqlite3_free(zErrMsg);
+		return ERROR;
+	}
+	return OK;
+}
+
 /*!     \brief  Get the names of the saved trace profiles
  *
- * Populate a list of available trace profiles
+ * Populate a list of available trace profiles.
+ * Only the profiles of the current project are read; those of the other
+ * projects are read when the project is first selected (see inventoryProject).
  *
  * \param  pGlobal      pointer to tGlobal structure (containing the pointer to list)
  * \return 				completion status
  */
 guint
 inventorySavedTraceNames(tGlobal *pGlobal) {
-	gchar *zErrMsg = 0;
 	g_list_free_full ( g_steal_pointer (&pGlobal->pTraceList), (GDestroyNotify)freeTraceListItem );
 	pGlobal->pTraceList = NULL;
 
-	if (sqlite3_exec(db, "SELECT project,name,selected,title,notes,time FROM HP8753C_TRACEDATA WHERE channel=0;",
-			sqlCBtraceAbstract, &pGlobal->pTraceList, &zErrMsg) != SQLITE_OK) {
-		postMessageToMainLoop(TM_ERROR, zErrMsg);
-		sqlite3_free(zErrMsg);
+	if( readTraceAbstracts( pGlobal->sProject, &pGlobal->pTraceList ) != OK )
 		return ERROR;
-	}
+
 	pGlobal->pTraceList = g_list_sort (pGlobal->pTraceList, (GCompareFunc)compareTraceItemsForSort);
+	catalogRebuild( &pGlobal->traceCatalog, pGlobal->pTraceList );
+	catalogSetProjectLoaded( &pGlobal->traceCatalog, pGlobal->sProject );
 
 	// find the last selected trace for the project that was last selected
 	pGlobal->pTraceAbstract = NULL;
-	for( GList *l = pGlobal->pTraceList; l != NULL; l = l->next ){
-	    tHP8753traceAbstract *pTraceAbstract = (tHP8753traceAbstract *)(l->data);
-	        tProjectAndName *pProjectAndName = &pTraceAbstract->projectAndName;
-	        if( pProjectAndName->bbFlags.bSelected
-	                && g_strcmp0( pProjectAndName->sProject, pGlobal->sProject ) == 0) {
-	            pGlobal->pTraceAbstract = pTraceAbstract;
-	        }
+	tHP8753traceAbstract *pTraceAbstract;
+	for( guint i = 0; (pTraceAbstract = catalogNthInProject( &pGlobal->traceCatalog, pGlobal->sProject, i )) != NULL; i++ ){
+	    if( pTraceAbstract->projectAndName.bbFlags.bSelected )
+	        pGlobal->pTraceAbstract = pTraceAbstract;
+	}
+	return OK;
+}
+
+/*!     \brief  Read the profiles of a project if not already done
+ *
+ * Called when a project is selected. The calibration and trace profiles of the project
+ * are added to the lists (and catalogs). A profile already in the list (for example one
+ * moved or copied into the project before it was read) is not added again.
+ *
+ * \param  pGlobal      pointer to tGlobal structure
+ * \param  sProject     project
+ * \return 				completion status
+ */
+gint
+inventoryProject( tGlobal *pGlobal, const gchar *sProject ) {
+	GList *pNew = NULL, *l, *next;
+
+	if( !catalogIsProjectLoaded( &pGlobal->calCatalog, sProject ) ) {
+		if( readCalibrationAbstracts( sProject, &pNew ) != OK ) {
+			g_list_free_full( pNew, (GDestroyNotify)freeCalListItem );
+			return ERROR;
+		}
+		for( l = pNew; l != NULL; l = next ) {
+			tHP8753cal *pCal = l->data;
+			next = l->next;
+			if( catalogLookup( &pGlobal->calCatalog, sProject, pCal->projectAndName.sName ) != NULL ) {
+				freeCalListItem( pCal );
+				pNew = g_list_delete_link( pNew, l );
+			} else {
+				catalogAdd( &pGlobal->calCatalog, pCal );
+			}
+		}
+		pGlobal->pCalList = g_list_sort( g_list_concat( pNew, pGlobal->pCalList ),
+				(GCompareFunc)compareCalItemsForSort );
+		catalogSetProjectLoaded( &pGlobal->calCatalog, sProject );
+	}
+
+	if( !catalogIsProjectLoaded( &pGlobal->traceCatalog, sProject ) ) {
+		pNew = NULL;
+		if( readTraceAbstracts( sProject, &pNew ) != OK ) {
+			g_list_free_full( pNew, (GDestroyNotify)freeTraceListItem );
+			return ERROR;
+		}
+		for( l = pNew; l != NULL; l = next ) {
+			tHP8753traceAbstract *pTraceAbstract = l->data;
+			next = l->next;
+			if( catalogLookup( &pGlobal->traceCatalog, sProject, pTraceAbstract->projectAndName.sName ) != NULL ) {
+				freeTraceListItem( pTraceAbstract );
+				pNew = g_list_delete_link( pNew, l );
+			} else {
+				catalogAdd( &pGlobal->traceCatalog, pTraceAbstract );
+			}
+		}
+		pGlobal->pTraceList = g_list_sort( g_list_concat( pNew, pGlobal->pTraceList ),
+				(GCompareFunc)compareTraceItemsForSort );
+		catalogSetProjectLoaded( &pGlobal->traceCatalog, sProject );
 	}
+
 	return OK;
 }
 
+/*!     \brief  Reconstruct the points of a capture in the trace history
+ *
+ * The capture and the captures it is a delta of (back to a complete capture)
+ * are read with one query and XORed together.
+ *
+ * \param captureID  capture in TRACE_HISTORY
+ * \param pSize      pointer to the returned size of the points
+ * \return           allocated array of tComplex or NULL on error
+ */
+static guchar *
+reconstructCapture( gint64 captureID, gsize *pSize ) {
+	sqlite3_stmt *stmt = NULL;
+	guint64 *pPoints = NULL;
+	gsize size;
+
+	*pSize = 0;
+	if (sqlite3_prepare_v2(db,
+			"WITH RECURSIVE chain(captureID, baseID, points) AS ("
+			"    SELECT captureID, baseID, points FROM TRACE_HISTORY WHERE captureID = (?)"
+			"  UNION ALL"
+			"    SELECT H.captureID, H.baseID, H.points FROM TRACE_HISTORY H, chain"
+			"      WHERE H.captureID = chain.baseID"
+			") SELECT points, baseID FROM chain;", -1, &stmt, NULL) != SQLITE_OK) {
+		postMessageToMainLoop(TM_ERROR, (gchar*) sqlite3_errmsg(db));
+		return NULL;
+	}
+	sqlite3_bind_int64( stmt, 1, captureID );
+
+	while (sqlite3_step(stmt) == SQLITE_ROW) {
+		guint64 *pDelta = (guint64 *)column_decodedBlob( stmt, 0, &size );
+
+		if( pDelta == NULL || size == 0 || size % sizeof( guint64 ) != 0
+				|| ( pPoints && size != *pSize ) ) {
+			g_free( pDelta );
+			g_clear_pointer( &pPoints, g_free );
+			break;
+		}
+		if( pPoints == NULL ) {
+			pPoints = pDelta;
+			*pSize = size;
+		} else {
+			for( gsize i = 0; i < size / sizeof( guint64 ); i++ )
+				pPoints[ i ] ^= pDelta[ i ];
+			g_free( pDelta );
+		}
+		if( sqlite3_column_type( stmt, 1 ) == SQLITE_NULL ) {
+			// the complete capture ends the chain
+			sqlite3_finalize(stmt);
+			return (guchar *)pPoints;
+		}
+	}
+	// the chain is broken
+	sqlite3_finalize(stmt);
+	g_free( pPoints );
+	*pSize = 0;
+	return NULL;
+}
+
+/*!     \brief  Append the capture of a channel to the trace history
+ *
+ * The points are stored as an XOR delta of the previous capture of the profile with
+ * the same sweep setup. Successive captures differ little so most bits of the delta
+ * are zero and it compresses well. A complete capture is stored for the first of a
+ * sweep setup, for list frequency sweeps (the stimulus is saved with them) and after
+ * HISTORY_MAX_DEPTH deltas (to bound the cost of reconstruction).
+ * This is called as part of the saveTraceData transaction.
+ *
+ * \param pGlobal      pointer to tGlobal structure
+ * \param sProject     project of the trace profile
+ * \param sName        name of the trace profile
+ * \param channel      channel to save
+ * \return             completion status
+ */
+static gint
+appendTraceHistory( tGlobal *pGlobal, gchar *sProject, gchar *sName, eChannel channel ) {
+	tChannel *pChannel = &pGlobal->HP8753.channels[ channel ];
+	sqlite3_stmt *stmt = NULL;
+	gsize size = pChannel->nPoints * sizeof( tComplex ), baseSize = 0;
+	gint64 baseID = 0;
+	gint depth = 0, queryIndex = 0, rtn = ERROR;
+	guint64 *pDelta = NULL;
+	gboolean bListSweep = pChannel->stimulusPoints && pChannel->sweepType == eSWP_LSTFREQ
+			&& pChannel->chFlags.bAllSegments;
+
+	if( !pChannel->chFlags.bValidData || pChannel->responsePoints == NULL || pChannel->nPoints <= 0 )
+		return OK;
+
+	if( !bListSweep ) {
+		// the previous capture with the same sweep setup
+		if (sqlite3_prepare_v2(db,
+				"SELECT captureID, depth FROM TRACE_HISTORY"
+				"  WHERE project IS (?) AND name = (?) AND channel = (?)"
+				"    AND sweepStart = (?) AND sweepStop = (?) AND CWfrequency = (?) AND sweepType = (?)"
+				"    AND npoints = (?) AND format = (?) AND sParamOrInputPort = (?)"
+				"  ORDER BY captureID DESC LIMIT 1;", -1, &stmt, NULL) != SQLITE_OK)
+			goto err;
+		bind_string( stmt, ++queryIndex, sProject );
+		bind_string( stmt, ++queryIndex, sName );
+		sqlite3_bind_int( stmt, ++queryIndex, channel );
+		sqlite3_bind_double( stmt, ++queryIndex, pChannel->sweepStart );
+		sqlite3_bind_double( stmt, ++queryIndex, pChannel->sweepStop );
+		sqlite3_bind_double( stmt, ++queryIndex, pChannel->CWfrequency );
+		sqlite3_bind_int( stmt, ++queryIndex, pChannel->sweepType );
+		sqlite3_bind_int( stmt, ++queryIndex, pChannel->nPoints );
+		sqlite3_bind_int( stmt, ++queryIndex, pChannel->format );
+		sqlite3_bind_int( stmt, ++queryIndex, pChannel->measurementType );
+		if (sqlite3_step(stmt) == SQLITE_ROW
+				&& sqlite3_column_int(stmt, 1) < HISTORY_MAX_DEPTH) {
+			baseID = sqlite3_column_int64(stmt, 0);
+			depth = sqlite3_column_int(stmt, 1) + 1;
+		}
+		sqlite3_finalize(stmt);
+		stmt = NULL;
+
+		if( baseID != 0 ) {
+			pDelta = (guint64 *)reconstructCapture( baseID, &baseSize );
+			if( pDelta && baseSize == size ) {
+				for( gsize i = 0; i < size / sizeof( guint64 ); i++ )
+					pDelta[ i ] ^= ((guint64 *)pChannel->responsePoints)[ i ];
+			} else {
+				// cannot use it ... start again with a complete capture
+				g_clear_pointer( &pDelta, g_free );
+				baseID = 0;
+				depth = 0;
+			}
+		}
+	}
+
+	if (sqlite3_prepare_v2(db,
+			"INSERT INTO TRACE_HISTORY"
+			"  (project, name, channel, time, isoTime, baseID, depth,"
+			"   sweepStart, sweepStop, IFbandwidth, CWfrequency, sweepType, npoints,"
+			"   format, sParamOrInputPort, points, stimulusPoints)"
+			" VALUES (?,?,?,?, COALESCE(isoTime(?4), datetime('now', 'localtime')),?,?, ?,?,?,?,?,?, ?,?,?,?);",
+			-1, &stmt, NULL) != SQLITE_OK)
+		goto err;
+
+	queryIndex = 0;
+	if (bind_string(stmt, ++queryIndex, sProject) != SQLITE_OK
+			|| bind_string(stmt, ++queryIndex, sName) != SQLITE_OK
+			|| sqlite3_bind_int(stmt, ++queryIndex, channel) != SQLITE_OK
+			|| bind_string(stmt, ++queryIndex, pGlobal->HP8753.dateTime) != SQLITE_OK
+			|| (baseID ? sqlite3_bind_int64(stmt, ++queryIndex, baseID)
+					   : sqlite3_bind_null(stmt, ++queryIndex)) != SQLITE_OK
+			|| sqlite3_bind_int(stmt, ++queryIndex, depth) != SQLITE_OK
+			|| sqlite3_bind_double(stmt, ++queryIndex, pChannel->sweepStart) != SQLITE_OK
+			|| sqlite3_bind_double(stmt, ++queryIndex, pChannel->sweepStop) != SQLITE_OK
+			|| sqlite3_bind_double(stmt, ++queryIndex, pChannel->IFbandwidth) != SQLITE_OK
+			|| sqlite3_bind_double(stmt, ++queryIndex, pChannel->CWfrequency) != SQLITE_OK
+			|| sqlite3_bind_int(stmt, ++queryIndex, pChannel->sweepType) != SQLITE_OK
+			|| sqlite3_bind_int(stmt, ++queryIndex, pChannel->nPoints) != SQLITE_OK
+			|| sqlite3_bind_int(stmt, ++queryIndex, pChannel->format) != SQLITE_OK
+			|| sqlite3_bind_int(stmt, ++queryIndex, pChannel->measurementType) != SQLITE_OK
+			// a delta has no structure to exploit, a complete capture is XOR-delta encoded like the profile
+			|| bind_encodedBlob(stmt, ++queryIndex, pDelta ? (gpointer)pDelta : (gpointer)pChannel->responsePoints,
+					size, pDelta ? 0 : 2) != SQLITE_OK
+			|| ( bListSweep ? bind_encodedBlob(stmt, ++queryIndex, pChannel->stimulusPoints,
+					pChannel->nPoints * sizeof(gdouble), 1)
+					: sqlite3_bind_null(stmt, ++queryIndex) ) != SQLITE_OK
+			|| sqlite3_step(stmt) != SQLITE_DONE)
+		goto err;
+
+	rtn = OK;
+err:
+	if( rtn != OK )
+		postMessageToMainLoop(TM_ERROR, (gchar*) sqlite3_errmsg(db));
+	sqlite3_finalize(stmt);
+	g_free( pDelta );
+	return rtn;
+}
+
 #define EMPTYifNULL( x ) ((x)==NULL?"":(x))
 /*!     \brief  Save the trace profile
  *
@@ -534,6 +1364,9 @@ saveTraceData(tGlobal *pGlobal, gchar *sProject, gchar *sName) {
 	guint32 perChannelFlags=0;
 	guint16 generalFlags=0;
 	gint queryIndex;
+	gint64 traceID = 0;
+	gsize thumbnailSize = 0;
+	guchar *thumbnail = renderTraceThumbnail( pGlobal, &thumbnailSize );
 
 		// Source information
 	if (sqlite3_prepare_v2(db,
@@ -546,6 +1379,14 @@ saveTraceData(tGlobal *pGlobal, gchar *sProject, gchar *sName) {
 			"   perChannelFlags, generalFlags, time)"
 			" VALUES (?,?,?,?,?,?, ?,?,?,?,?, ?,?,?,?,?, ?,?,?,?,?, ?,?,?,?,?, ?,?,?)", -1, &stmt, NULL) != SQLITE_OK) {
 		postMessageToMainLoop(TM_ERROR, (gchar*) sqlite3_errmsg(db));
+		g_free( thumbnail );
+		return ERROR;
+	}
+	// the blobs, both channel rows and the thumbnail are written together
+	if (sqlite3_exec(db, "BEGIN TRANSACTION;", NULL, NULL, NULL) != SQLITE_OK) {
+		postMessageToMainLoop(TM_ERROR, (gchar*) sqlite3_errmsg(db));
+		sqlite3_finalize(stmt);
+		g_free( thumbnail );
 		return ERROR;
 	}
 
@@ -587,16 +1428,19 @@ saveTraceData(tGlobal *pGlobal, gchar *sProject, gchar *sName) {
 		if (sqlite3_bind_int(stmt, ++queryIndex,
 				pGlobal->HP8753.channels[channel].nPoints) != SQLITE_OK)
 			goto err;
-		// points
-		if (sqlite3_bind_blob(stmt, ++queryIndex,
+		// points (XOR-delta of the real and imaginary parts separately)
+		if (bind_encodedBlob(stmt, ++queryIndex,
 				pGlobal->HP8753.channels[channel].responsePoints,
-				pGlobal->HP8753.channels[channel].nPoints * sizeof(tComplex), SQLITE_STATIC) != SQLITE_OK)
+				pGlobal->HP8753.channels[channel].nPoints * sizeof(tComplex), 2) != SQLITE_OK)
 			goto err;
-		// stimulusPoints
-		if( pGlobal->HP8753.channels[channel].stimulusPoints ) {
-			if (sqlite3_bind_blob(stmt, ++queryIndex,
+		// stimulusPoints - only saved for list frequency sweeps of all segments,
+		// otherwise they are regenerated from the sweep settings (see getStimulusPoints)
+		if( pGlobal->HP8753.channels[channel].stimulusPoints
+				&& pGlobal->HP8753.channels[channel].sweepType == eSWP_LSTFREQ
+				&& pGlobal->HP8753.channels[channel].chFlags.bAllSegments ) {
+			if (bind_encodedBlob(stmt, ++queryIndex,
 					pGlobal->HP8753.channels[channel].stimulusPoints,
-					pGlobal->HP8753.channels[channel].nPoints * sizeof(tComplex), SQLITE_STATIC) != SQLITE_OK)
+					pGlobal->HP8753.channels[channel].nPoints * sizeof(gdouble), 1) != SQLITE_OK)
 				goto err;
 		} else {
 			++queryIndex;
@@ -656,11 +1500,11 @@ saveTraceData(tGlobal *pGlobal, gchar *sProject, gchar *sName) {
 				MAX_SEGMENTS * sizeof(tSegment), SQLITE_STATIC) != SQLITE_OK)
 			goto err;
 
-        // screenPlot
+        // screenPlot (the same plot is referenced by both channels)
 		if( pGlobal->HP8753.plotHPGL && pGlobal->HP8753.flags.bHPGLdataValid ) {
-            if (sqlite3_bind_blob(stmt, ++queryIndex,
+            if (bind_hashedBlob(stmt, ++queryIndex,
                     pGlobal->HP8753.plotHPGL,
-                    *(guint *)pGlobal->HP8753.plotHPGL, SQLITE_STATIC) != SQLITE_OK)
+                    *(guint *)pGlobal->HP8753.plotHPGL) != SQLITE_OK)
                 goto err;
 		} else {
 		    ++queryIndex;
@@ -686,32 +1530,91 @@ saveTraceData(tGlobal *pGlobal, gchar *sProject, gchar *sName) {
 
 		if (sqlite3_step(stmt) != SQLITE_DONE)
 			goto err;
+		if( channel == eCH_ONE )
+			traceID = sqlite3_last_insert_rowid( db );
 
 		sqlite3_reset( stmt );
 		sqlite3_clear_bindings( stmt );
 	}
 	sqlite3_finalize(stmt);
-	return 0;
+	stmt = NULL;
 
-err:
-	postMessageToMainLoop(TM_ERROR, (gchar*) sqlite3_errmsg(db));
+	// thumbnail (the replaced row, if any, took its thumbnail with it)
+	if( thumbnail ) {
+		if (sqlite3_prepare_v2(db,
+				"INSERT OR REPLACE INTO TRACE_THUMBNAILS (traceID, png) VALUES (?,?);",
+				-1, &stmt, NULL) != SQLITE_OK)
+			goto err;
+		if (sqlite3_bind_int64(stmt, 1, traceID) != SQLITE_OK
+				|| sqlite3_bind_blob(stmt, 2, thumbnail, thumbnailSize, SQLITE_STATIC) != SQLITE_OK
+				|| sqlite3_step(stmt) != SQLITE_DONE)
+			goto err;
+		sqlite3_finalize(stmt);
+		stmt = NULL;
+		g_clear_pointer( &thumbnail, g_free );
+	}
+
+	// and keep the capture in the history of the profile
+	for (eChannel channel = 0; channel < eNUM_CH; channel++) {
+		if( appendTraceHistory( pGlobal, sProject, sName, channel ) != OK ) {
+			sqlite3_exec(db, "ROLLBACK;", NULL, NULL, NULL);
+			return ERROR;
+		}
+	}
+
+	if (sqlite3_exec(db, "COMMIT;", NULL, NULL, NULL) != SQLITE_OK) {
+		postMessageToMainLoop(TM_ERROR, (gchar*) sqlite3_errmsg(db));
+		sqlite3_exec(db, "ROLLBACK;", NULL, NULL, NULL);
+		return ERROR;
+	}
+	purgeUnreferencedBlobs( db );
+	return 0;
+
+err:
+	postMessageToMainLoop(TM_ERROR, (gchar*) sqlite3_errmsg(db));
 	sqlite3_finalize(stmt);
+	sqlite3_exec(db, "ROLLBACK;", NULL, NULL, NULL);
+	g_free( thumbnail );
 	return ERROR;
 }
 
-/*!     \brief  Recover the saved trace profile
+/*!     \brief  Open another (read only) connection to the database
+ *
+ * For threads recovering trace profiles with recoverTraceDataFromDB.
+ * Called from the thread that opened the database.
+ *
+ * \return 			   connection (close with sqlite3_close) or NULL on error
+ */
+sqlite3 *
+openReadOnlyDBconnection( void ) {
+	sqlite3 *pDB = NULL;
+
+	if( db == NULL
+			|| sqlite3_open_v2( sqlite3_db_filename( db, "main" ), &pDB, SQLITE_OPEN_READONLY, NULL ) != SQLITE_OK ) {
+		sqlite3_close( pDB );
+		return NULL;
+	}
+	sqlite3_busy_timeout( pDB, DB_BUSY_TIMEOUT );
+	return pDB;
+}
+
+/*!     \brief  Recover the saved trace profile using a database connection
  *
  * Get the data of the named profile from the database
  *
- * \param pGlobal      pointer to tGlobal structure
+ * \param pDB          database connection
+ * \param pGlobal      pointer to tGlobal structure (only the HP8753 data is changed)
+ * \param sProject     project of the profile to recover
  * \param sName        name of the profile to recover
  * \return 			   completion status
  */
 gint
-recoverTraceData(tGlobal *pGlobal, gchar *sProject, gchar *sName) {
+recoverTraceDataFromDB(sqlite3 *pDB, tGlobal *pGlobal, const gchar *sProject, const gchar *sName) {
 	sqlite3_stmt *stmt = NULL;
-	gint nPoints, pointsSize, mkrSize, bandwidthSize, segmentsSize;
-	const guchar *points = NULL, *markers = NULL, *bandwidth = NULL, *segments=NULL, *screenPlot = NULL;
+	gint nPoints, mkrSize, bandwidthSize, segmentsSize;
+	gsize pointsSize, screenPlotSize;
+	const guchar *markers = NULL, *bandwidth = NULL, *segments=NULL;
+	guchar *points = NULL, *screenPlot = NULL;
 	eChannel channel = eCH_SINGLE;
 	const gchar *tText;
 
@@ -720,22 +1623,22 @@ recoverTraceData(tGlobal *pGlobal, gchar *sProject, gchar *sName) {
 	guint32 perChannelFlags;
 	guint16 generalFlags;
 
-	if (sqlite3_prepare_v2(db,
+	if (sqlite3_prepare_v2(pDB,
 			"SELECT "
 			"   channel, sweepStart, sweepStop, IFbandwidth, CWfrequency, "
 			"   sweepType, npoints, points, stimulusPoints, format, "
 			"   scaleVal, scaleRefPos, scaleRefVal, sParamOrInputPort, markers, "
 			"   activeMkr, deltaMkr, mkrType, bandwidth, nSegments, "
-			"   segments, screenPlot, title, notes, perChannelFlags, generalFlags, "
+			"   segments, " BLOB_DATA( "screenPlot" ) ", title, notes, perChannelFlags, generalFlags, "
 			"   time"
 			" FROM HP8753C_TRACEDATA WHERE project IS (?) AND name = (?);", -1, &stmt, NULL) != SQLITE_OK) {
-		postMessageToMainLoop(TM_ERROR, (gchar*) sqlite3_errmsg(db));
+		postMessageToMainLoop(TM_ERROR, (gchar*) sqlite3_errmsg(pDB));
 		return ERROR;
 	}
 
 	// bind project
 	bind_string(stmt, 1, sProject );
-	if( sqlite3_errcode( db ) != SQLITE_OK) {
+	if( sqlite3_errcode( pDB ) != SQLITE_OK) {
 		traceRetrieved = ERROR;
 		goto err;
 	}
@@ -759,23 +1662,24 @@ recoverTraceData(tGlobal *pGlobal, gchar *sProject, gchar *sName) {
 
 		nPoints = sqlite3_column_int(stmt, queryIndex++);
 		// points
-		pointsSize = sqlite3_column_bytes(stmt, queryIndex);
-		points = sqlite3_column_blob(stmt, queryIndex++);
+		points = column_decodedBlob(stmt, queryIndex++, &pointsSize);
 		g_free(pGlobal->HP8753.channels[channel].responsePoints);
+		clearDerivedTraceData( &pGlobal->HP8753.channels[channel] );
 		if (pointsSize > 0 && nPoints > 0) {
-			pGlobal->HP8753.channels[channel].responsePoints = g_memdup2(points, pointsSize);
+			pGlobal->HP8753.channels[channel].responsePoints = (tComplex *)points;
 			pGlobal->HP8753.channels[channel].nPoints = nPoints;
 		} else {
+			g_free( points );
 			pGlobal->HP8753.channels[channel].nPoints = 0;
 			pGlobal->HP8753.channels[channel].responsePoints = NULL;
 		}
-		// stimulus points
-		pointsSize = sqlite3_column_bytes(stmt, queryIndex);
-		points = sqlite3_column_blob(stmt, queryIndex++);
+		// stimulus points (if not saved, these are regenerated when needed)
+		points = column_decodedBlob(stmt, queryIndex++, &pointsSize);
 		g_free(pGlobal->HP8753.channels[channel].stimulusPoints);
-		if (pointsSize > 0 && nPoints > 0) {
-			pGlobal->HP8753.channels[channel].stimulusPoints = g_memdup2(points, pointsSize);
+		if (pointsSize >= nPoints * sizeof(gdouble) && nPoints > 0) {
+			pGlobal->HP8753.channels[channel].stimulusPoints = (gdouble *)points;
 		} else {
+			g_free( points );
 			pGlobal->HP8753.channels[channel].stimulusPoints = NULL;
 		}
 
@@ -811,14 +1715,17 @@ recoverTraceData(tGlobal *pGlobal, gchar *sProject, gchar *sName) {
 			memcpy( (guchar*)&pGlobal->HP8753.channels[channel].segments, segments, segmentsSize);
 		else
 			memset( pGlobal->HP8753.channels[channel].bandwidth, 0, sizeof( pGlobal->HP8753.channels[channel].bandwidth ));
+		indexSegments( &pGlobal->HP8753.channels[channel] );
 
 		// Screenplot
-		screenPlot = sqlite3_column_blob(stmt, queryIndex);
+		screenPlot = column_decodedBlob(stmt, queryIndex++, &screenPlotSize);
 		g_free( pGlobal->HP8753.plotHPGL );
 		pGlobal->HP8753.plotHPGL = NULL;
-		if( screenPlot != NULL && sqlite3_column_bytes( stmt, queryIndex ) == *(guint *)screenPlot )
-		        pGlobal->HP8753.plotHPGL = g_memdup2( screenPlot, *(guint *)screenPlot);
-		queryIndex++;
+		pGlobal->HP8753.HPGLgeneration++;
+		if( screenPlot != NULL && screenPlotSize == *(guint *)screenPlot )
+		        pGlobal->HP8753.plotHPGL = screenPlot;
+		else
+		        g_free( screenPlot );
 
 		if( channel == eCH_ONE ) {
 			tText = (const gchar *)sqlite3_column_text(stmt, queryIndex++);
@@ -837,14 +1744,175 @@ recoverTraceData(tGlobal *pGlobal, gchar *sProject, gchar *sName) {
 		if( channel == eCH_ONE ) {
 			generalFlags = sqlite3_column_int(stmt, queryIndex++);
 			memcpy(&pGlobal->HP8753.flags, &generalFlags, sizeof(guint16));
+			g_free( pGlobal->HP8753.dateTime );
 			pGlobal->HP8753.dateTime = g_strdup( (gchar *)sqlite3_column_text(stmt, queryIndex++) );
 		} else {
 			queryIndex +=2;
 		}
+
+		// calculated once here (now the format is known) rather than on every redraw
+		// of a Smith or polar chart; the other formats do not use them
+		if( pGlobal->HP8753.channels[channel].nPoints > 0
+				&& (pGlobal->HP8753.channels[channel].format == eFMT_SMITH
+					|| pGlobal->HP8753.channels[channel].format == eFMT_POLAR) )
+			getSplineControlPoints( &pGlobal->HP8753.channels[channel] );
 	}
 
 err:
-	if( sqlite3_errcode(db) != SQLITE_DONE) postMessageToMainLoop(TM_ERROR, (gchar*) sqlite3_errmsg(db));
+	if( sqlite3_errcode(pDB) != SQLITE_DONE) postMessageToMainLoop(TM_ERROR, (gchar*) sqlite3_errmsg(pDB));
+	sqlite3_finalize(stmt);
+	return traceRetrieved;
+}
+
+/*!     \brief  Recover the saved trace profile
+ *
+ * Get the data of the named profile from the database
+ *
+ * \param pGlobal      pointer to tGlobal structure
+ * \param sProject     project of the profile to recover
+ * \param sName        name of the profile to recover
+ * \return 			   completion status
+ */
+gint
+recoverTraceData(tGlobal *pGlobal, gchar *sProject, gchar *sName) {
+	return recoverTraceDataFromDB( db, pGlobal, sProject, sName );
+}
+
+/*!     \brief  List the captures in the history of a trace profile
+ *
+ * \param sProject     project of the trace profile
+ * \param sName        name of the trace profile
+ * \param sFrom        earliest time ("YYYY-MM-DD HH:MM:SS" or a prefix of it) or NULL
+ * \param sTo          latest time (as above) or NULL
+ * \return             NULL terminated array of the capture times, newest first
+ *                     (free with g_strfreev) or NULL on error
+ */
+gchar **
+queryTraceHistory( const gchar *sProject, const gchar *sName, const gchar *sFrom, const gchar *sTo ) {
+	sqlite3_stmt *stmt = NULL;
+	gint queryIndex = 0;
+	GPtrArray *pTimes;
+
+	// a prefix of the latest time (e.g. just the date) includes all of that period
+	gchar *sSQL = g_strdup_printf( "SELECT DISTINCT isoTime FROM TRACE_HISTORY"
+			" WHERE project IS (?) AND name = (?)%s%s ORDER BY isoTime DESC;",
+			sFrom ? " AND isoTime >= (?)" : "",
+			sTo ? " AND isoTime < ((?) || char(127))" : "" );
+
+	if (sqlite3_prepare_v2(db, sSQL, -1, &stmt, NULL) != SQLITE_OK) {
+		postMessageToMainLoop(TM_ERROR, (gchar*) sqlite3_errmsg(db));
+		g_free( sSQL );
+		return NULL;
+	}
+	g_free( sSQL );
+
+	bind_string( stmt, ++queryIndex, sProject );
+	bind_string( stmt, ++queryIndex, sName );
+	if( sFrom )
+		bind_string( stmt, ++queryIndex, sFrom );
+	if( sTo )
+		bind_string( stmt, ++queryIndex, sTo );
+
+	pTimes = g_ptr_array_new();
+	while (sqlite3_step(stmt) == SQLITE_ROW)
+		g_ptr_array_add( pTimes, g_strdup( (gchar *)sqlite3_column_text(stmt, 0) ) );
+	g_ptr_array_add( pTimes, NULL );
+
+	sqlite3_finalize(stmt);
+	return (gchar **)g_ptr_array_free( pTimes, FALSE );
+}
+
+/*!     \brief  Recover a capture from the history of a trace profile
+ *
+ * The sweep settings and points of the channel(s) captured at the time are
+ * replaced. The other settings (scale, markers etc.) are those of the profile.
+ * A channel that was not captured at the time is shown without data (rather
+ * than with the profile's points). The HPGL screen image is not kept in the
+ * history so it is discarded.
+ *
+ * \param pGlobal      pointer to tGlobal structure
+ * \param sProject     project of the trace profile
+ * \param sName        name of the trace profile
+ * \param sISOtime     capture time (as returned by queryTraceHistory)
+ * \return             TRUE if recovered, FALSE if not found or ERROR
+ */
+gint
+recoverTraceHistory( tGlobal *pGlobal, const gchar *sProject, const gchar *sName, const gchar *sISOtime ) {
+	sqlite3_stmt *stmt = NULL;
+	gboolean bRecovered[ eNUM_CH ] = { FALSE };
+	gint traceRetrieved = FALSE;
+	gint queryIndex;
+	gsize pointsSize;
+	guchar *points;
+
+	if (sqlite3_prepare_v2(db,
+			"SELECT captureID, channel, sweepStart, sweepStop, IFbandwidth, CWfrequency,"
+			"   sweepType, npoints, format, sParamOrInputPort, stimulusPoints, time"
+			" FROM TRACE_HISTORY WHERE project IS (?) AND name = (?) AND isoTime = (?)"
+			" ORDER BY captureID DESC;", -1, &stmt, NULL) != SQLITE_OK) {
+		postMessageToMainLoop(TM_ERROR, (gchar*) sqlite3_errmsg(db));
+		return ERROR;
+	}
+	bind_string( stmt, 1, sProject );
+	bind_string( stmt, 2, sName );
+	bind_string( stmt, 3, sISOtime );
+
+	// the latest capture of each channel at this time
+	while (sqlite3_step(stmt) == SQLITE_ROW) {
+		gint64 captureID;
+		eChannel channel;
+		tChannel *pChannel;
+		gint nPoints;
+
+		queryIndex = 0;
+		captureID = sqlite3_column_int64(stmt, queryIndex++);
+		channel = sqlite3_column_int(stmt, queryIndex++);
+		if( channel < 0 || channel >= eNUM_CH || bRecovered[ channel ] )
+			continue;
+		pChannel = &pGlobal->HP8753.channels[ channel ];
+
+		if( (points = reconstructCapture( captureID, &pointsSize )) == NULL ) {
+			traceRetrieved = ERROR;
+			break;
+		}
+		pChannel->sweepStart   = sqlite3_column_double(stmt, queryIndex++);
+		pChannel->sweepStop    = sqlite3_column_double(stmt, queryIndex++);
+		pChannel->IFbandwidth  = sqlite3_column_double(stmt, queryIndex++);
+		pChannel->CWfrequency  = sqlite3_column_double(stmt, queryIndex++);
+		pChannel->sweepType    = (tSweepType)sqlite3_column_int(stmt, queryIndex++);
+		nPoints = sqlite3_column_int(stmt, queryIndex++);
+		pChannel->format = (tFormat)sqlite3_column_int(stmt, queryIndex++);
+		pChannel->measurementType = (tMeasurement)sqlite3_column_int(stmt, queryIndex++);
+
+		g_free( pChannel->responsePoints );
+		clearDerivedTraceData( pChannel );
+		pChannel->responsePoints = (tComplex *)points;
+		pChannel->nPoints = MIN( nPoints, pointsSize / sizeof( tComplex ) );
+		pChannel->chFlags.bValidData = TRUE;
+
+		// stimulus points (if not saved, these are regenerated when needed)
+		g_free( pChannel->stimulusPoints );
+		pChannel->stimulusPoints = (gdouble *)column_decodedBlob(stmt, queryIndex++, &pointsSize);
+		if( pChannel->stimulusPoints && pointsSize < pChannel->nPoints * sizeof( gdouble ) )
+			g_clear_pointer( &pChannel->stimulusPoints, g_free );
+
+		g_free( pGlobal->HP8753.dateTime );
+		pGlobal->HP8753.dateTime = g_strdup( (gchar *)sqlite3_column_text(stmt, queryIndex++) );
+
+		bRecovered[ channel ] = TRUE;
+		traceRetrieved = TRUE;
+	}
+
+	if( traceRetrieved == TRUE ) {
+		for( eChannel channel = 0; channel < eNUM_CH; channel++ ) {
+			if( !bRecovered[ channel ] )
+				pGlobal->HP8753.channels[ channel ].chFlags.bValidData = FALSE;
+		}
+		g_clear_pointer( &pGlobal->HP8753.plotHPGL, g_free );
+		pGlobal->HP8753.flags.bHPGLdataValid = FALSE;
+		pGlobal->HP8753.HPGLgeneration++;
+	}
+
 	sqlite3_finalize(stmt);
 	return traceRetrieved;
 }
@@ -864,6 +1932,7 @@ deleteDBentry(tGlobal *pGlobal, gchar *sProject, gchar *sName, tDBtable whichTab
 	sqlite3_stmt *stmt = NULL;
 	gchar *sSQL = NULL;
 	GList *listElement = NULL;
+	gpointer pItem;
 	tProjectAndName projectAndName = {sProject, sName};
 
 	switch( whichTable ) {
@@ -882,6 +1951,12 @@ deleteDBentry(tGlobal *pGlobal, gchar *sProject, gchar *sName, tDBtable whichTab
 		break;
 	}
 
+	// the profile and its history are deleted together
+	if (sqlite3_exec(db, "BEGIN TRANSACTION;", NULL, NULL, NULL) != SQLITE_OK) {
+		postMessageToMainLoop(TM_ERROR, (gchar*) sqlite3_errmsg(db));
+		return ERROR;
+	}
+
 	if (sqlite3_prepare_v2(db, sSQL, -1, &stmt, NULL) != SQLITE_OK) {
 		postMessageToMainLoop(TM_ERROR, (gchar*) sqlite3_errmsg(db));
 		goto err;
@@ -904,22 +1979,43 @@ deleteDBentry(tGlobal *pGlobal, gchar *sProject, gchar *sName, tDBtable whichTab
 		goto err;
 
 	sqlite3_finalize(stmt);
+	stmt = NULL;
+
+	// the history goes with the trace profile
+	if( whichTable == eDB_TRACE ) {
+		if (sqlite3_prepare_v2(db, "DELETE FROM TRACE_HISTORY WHERE project IS (?) AND name = (?);",
+				-1, &stmt, NULL) != SQLITE_OK)
+			goto err;
+		if (bind_string( stmt, 1, sProject ) != SQLITE_OK
+				|| bind_string( stmt, 2, sName ) != SQLITE_OK
+				|| sqlite3_step(stmt) != SQLITE_DONE)
+			goto err;
+		sqlite3_finalize(stmt);
+		stmt = NULL;
+	}
+
+	if (sqlite3_exec(db, "COMMIT;", NULL, NULL, NULL) != SQLITE_OK)
+		goto err;
+	if( whichTable != eDB_CALKIT )
+		purgeUnreferencedBlobs( db );
 
 	// Must do this after the preparation of the SQL command because otherwise the name will be freed
 	// and the prep statement will fail
     switch( whichTable ) {
     case eDB_CALandSETUP:
-        listElement = g_list_find_custom( pGlobal->pCalList, &projectAndName, (GCompareFunc)compareCalItemsForFind );
-        if( listElement ) {
-            freeCalListItem(  listElement->data );
-            pGlobal->pCalList = g_list_remove( pGlobal->pCalList, listElement->data );
+        pItem = catalogLookup( &pGlobal->calCatalog, projectAndName.sProject, projectAndName.sName );
+        if( pItem ) {
+            catalogRemove( &pGlobal->calCatalog, pItem );
+            pGlobal->pCalList = g_list_remove( pGlobal->pCalList, pItem );
+            freeCalListItem( pItem );
         }
         break;
     case eDB_TRACE:
-        listElement = g_list_find_custom( pGlobal->pTraceList, &projectAndName, (GCompareFunc)compareTraceItemsForFind );
-        if( listElement ) {
-            freeTraceListItem( listElement->data );
-            pGlobal->pTraceList = g_list_remove( pGlobal->pTraceList, listElement->data );
+        pItem = catalogLookup( &pGlobal->traceCatalog, projectAndName.sProject, projectAndName.sName );
+        if( pItem ) {
+            catalogRemove( &pGlobal->traceCatalog, pItem );
+            pGlobal->pTraceList = g_list_remove( pGlobal->pTraceList, pItem );
+            freeTraceListItem( pItem );
         }
         break;
     case eDB_CALKIT:
@@ -938,6 +2034,7 @@ deleteDBentry(tGlobal *pGlobal, gchar *sProject, gchar *sName, tDBtable whichTab
 err:
 	postMessageToMainLoop(TM_ERROR, (gchar*) sqlite3_errmsg(db));
 	sqlite3_finalize(stmt);
+	sqlite3_exec(db, "ROLLBACK;", NULL, NULL, NULL);
 	return ERROR;
 }
 
@@ -968,6 +2065,12 @@ saveCalibrationAndSetup(tGlobal *pGlobal, gchar *sProject, gchar *sName) {
 		postMessageToMainLoop(TM_ERROR, (gchar*) sqlite3_errmsg(db));
 		return ERROR;
 	}
+	// the blobs and both channel rows are written together
+	if (sqlite3_exec(db, "BEGIN TRANSACTION;", NULL, NULL, NULL) != SQLITE_OK) {
+		postMessageToMainLoop(TM_ERROR, (gchar*) sqlite3_errmsg(db));
+		sqlite3_finalize(stmt);
+		return ERROR;
+	}
 
 	// project and name
 
@@ -987,8 +2090,8 @@ saveCalibrationAndSetup(tGlobal *pGlobal, gchar *sProject, gchar *sName) {
 			goto err;
 		//learn
 		if( channel == eCH_ONE ) {
-			if (sqlite3_bind_blob(stmt, ++queryIndex, pGlobal->HP8753cal.pHP8753_learn,
-					lengthFORM1data( pGlobal->HP8753cal.pHP8753_learn ), SQLITE_STATIC) != SQLITE_OK)
+			if (bind_hashedBlob(stmt, ++queryIndex, pGlobal->HP8753cal.pHP8753_learn,
+					lengthFORM1data( pGlobal->HP8753cal.pHP8753_learn )) != SQLITE_OK)
 				goto err;
 		} else {
 			++queryIndex;
@@ -1027,8 +2130,8 @@ saveCalibrationAndSetup(tGlobal *pGlobal, gchar *sProject, gchar *sName) {
 			if( i < numOfCalArrays[pGlobal->HP8753cal.perChannelCal[channel].iCalType] &&
 					pGlobal->HP8753cal.perChannelCal[channel].pCalArrays[i] != NULL )
 				length = lengthFORM1data( pGlobal->HP8753cal.perChannelCal[channel].pCalArrays[i] );
-			if (sqlite3_bind_blob(stmt, ++queryIndex, pGlobal->HP8753cal.perChannelCal[channel].pCalArrays[i], length,
-					SQLITE_STATIC) != SQLITE_OK)
+			if (bind_hashedBlob(stmt, ++queryIndex, pGlobal->HP8753cal.perChannelCal[channel].pCalArrays[i],
+					length) != SQLITE_OK)
 				goto err;
 		}
 		// notes
@@ -1060,12 +2163,18 @@ saveCalibrationAndSetup(tGlobal *pGlobal, gchar *sProject, gchar *sName) {
 		sqlite3_clear_bindings( stmt );
 	}
 	sqlite3_finalize(stmt);
+	if (sqlite3_exec(db, "COMMIT;", NULL, NULL, NULL) != SQLITE_OK) {
+		postMessageToMainLoop(TM_ERROR, (gchar*) sqlite3_errmsg(db));
+		sqlite3_exec(db, "ROLLBACK;", NULL, NULL, NULL);
+		return ERROR;
+	}
+	purgeUnreferencedBlobs( db );
 
-	tProjectAndName projectAndName = { sProject, sName, {FALSE, FALSE} };
-	GList *calPreviewElement = g_list_find_custom( pGlobal->pCalList, &projectAndName, (GCompareFunc)compareCalItemsForFind );
-	if( calPreviewElement ) {
-		freeCalListItem( calPreviewElement->data );
-		pGlobal->pCalList = g_list_remove( pGlobal->pCalList, calPreviewElement->data );
+	tHP8753cal *pCalPreview = catalogLookup( &pGlobal->calCatalog, sProject, sName );
+	if( pCalPreview ) {
+		catalogRemove( &pGlobal->calCatalog, pCalPreview );
+		pGlobal->pCalList = g_list_remove( pGlobal->pCalList, pCalPreview );
+		freeCalListItem( pCalPreview );
 	}
 	// Mark all other Calibration profiles as unselected
     for( GList *l = pGlobal->pCalList; l != NULL; l = l->next ){
@@ -1091,12 +2200,14 @@ saveCalibrationAndSetup(tGlobal *pGlobal, gchar *sProject, gchar *sName) {
 	memcpy( &pCal->settings, &pGlobal->HP8753cal.settings, sizeof( gushort ) );
 
 	pGlobal->pCalList = g_list_insert_sorted( pGlobal->pCalList, pCal, (GCompareFunc)compareCalItemsForSort );
+	catalogAdd( &pGlobal->calCatalog, pCal );
 	pGlobal->pCalibrationAbstract = pCal;
 	return 0;
 
 err:
 	postMessageToMainLoop(TM_ERROR, (gchar*) sqlite3_errmsg(db));
 	sqlite3_finalize(stmt);
+	sqlite3_exec(db, "ROLLBACK;", NULL, NULL, NULL);
 	return ERROR;
 }
 
@@ -1111,9 +2222,9 @@ err:
 gint
 recoverCalibrationAndSetup(tGlobal *pGlobal, gchar *sProject, gchar *sName) {
 	sqlite3_stmt *stmt = NULL;
-	gint length;
+	gsize length;
 	eChannel channel = eCH_SINGLE;
-	const guchar *tBlob;
+	guchar *tBlob;
 	const gchar *tText;
 	gint queryIndex;
 	gint calRetrieved = FALSE;
@@ -1121,11 +2232,12 @@ recoverCalibrationAndSetup(tGlobal *pGlobal, gchar *sProject, gchar *sName) {
 
 	if (sqlite3_prepare_v2(db,
 			"SELECT "
-			"  channel, learn, sweepStart, sweepStop, IFbandwidth,"
-			"  CWfrequency, sweepType, npoints, calType, cal01,"
-			"  cal02, cal03, cal04, cal05, cal06, "
-			"  cal07, cal08, cal09, cal10, cal11, "
-			"  cal12, notes, perChannelCalSettings, calSettings "
+			"  channel, " BLOB_DATA( "learn" ) ", sweepStart, sweepStop, IFbandwidth,"
+			"  CWfrequency, sweepType, npoints, calType, " BLOB_DATA( "cal01" ) ","
+			"  " BLOB_DATA( "cal02" ) ", " BLOB_DATA( "cal03" ) ", " BLOB_DATA( "cal04" ) ","
+			"  " BLOB_DATA( "cal05" ) ", " BLOB_DATA( "cal06" ) ", " BLOB_DATA( "cal07" ) ","
+			"  " BLOB_DATA( "cal08" ) ", " BLOB_DATA( "cal09" ) ", " BLOB_DATA( "cal10" ) ","
+			"  " BLOB_DATA( "cal11" ) ", " BLOB_DATA( "cal12" ) ", notes, perChannelCalSettings, calSettings "
 			"  FROM HP8753C_CALIBRATION"
 			" WHERE project IS (?) AND name = (?);", -1, &stmt, NULL) != SQLITE_OK) {
 		postMessageToMainLoop(TM_ERROR, (gchar*) sqlite3_errmsg(db));
@@ -1154,11 +2266,12 @@ recoverCalibrationAndSetup(tGlobal *pGlobal, gchar *sProject, gchar *sName) {
 		channel = sqlite3_column_int(stmt, queryIndex++);
 
 		// Learn string
-		length  = sqlite3_column_bytes(stmt, queryIndex);
-		tBlob   = sqlite3_column_blob(stmt, queryIndex++);
+		tBlob   = column_decodedBlob(stmt, queryIndex++, &length);
 		if( channel == eCH_ONE ) {
 			g_free(pGlobal->HP8753cal.pHP8753_learn);
-			pGlobal->HP8753cal.pHP8753_learn = g_memdup2(tBlob, (gsize) length);
+			pGlobal->HP8753cal.pHP8753_learn = tBlob;
+		} else {
+			g_free( tBlob );
 		}
 
 		pGlobal->HP8753cal.perChannelCal[channel].sweepStart   = sqlite3_column_double(stmt, queryIndex++);
@@ -1173,16 +2286,16 @@ recoverCalibrationAndSetup(tGlobal *pGlobal, gchar *sProject, gchar *sName) {
 
 		// calArrays
 		for (int i = 0; i < MAX_CAL_ARRAYS; i++) {
-			length = sqlite3_column_bytes(stmt, queryIndex);
 			g_free(pGlobal->HP8753cal.perChannelCal[channel].pCalArrays[i]);
-			tBlob = sqlite3_column_blob(stmt, queryIndex++);
+			tBlob = column_decodedBlob(stmt, queryIndex++, &length);
 			if (length > 0) {
-				pGlobal->HP8753cal.perChannelCal[channel].pCalArrays[i] = g_memdup2(tBlob, (gsize) length);
+				pGlobal->HP8753cal.perChannelCal[channel].pCalArrays[i] = tBlob;
 				// We infer size from cal string .. its only used for informational purposes
 				if( i==0 && length > 4 ) {
 					pGlobal->HP8753cal.perChannelCal[channel].nPoints = GUINT16_FROM_BE( (guint16 *)&tBlob[2] ) / BYTES_PER_CALPOINT;
 				}
 			} else {
+				g_free( tBlob );
 				pGlobal->HP8753cal.perChannelCal[channel].pCalArrays[i] = NULL;
 			}
 		}
@@ -1462,6 +2575,9 @@ recoverProgramOptions(tGlobal *pGlobal) {
 	gint queryIndex;
 	gint schemaVersion = 0;
 	gboolean bOptionsRecovered  = FALSE;
+	gboolean bSchemaFound = FALSE;
+	tChannel allSegments = { .chFlags.bAllSegments = TRUE };
+	guint32 allSegmentsFlag;
 
     union uOptions {
         struct stOptions {
@@ -1482,9 +2598,23 @@ recoverProgramOptions(tGlobal *pGlobal) {
 		while (sqlite3_step(stmt) == SQLITE_ROW) {
 			// check the database version and update if necessary
 			schemaVersion = sqlite3_column_int(stmt, 0);
+			bSchemaFound = TRUE;
 		}
 		sqlite3_finalize(stmt);
 
+		// A database with no options and no profiles has just been created with the current schema
+		if( !bSchemaFound ) {
+			if (sqlite3_prepare_v2(db,
+					"SELECT EXISTS (SELECT 1 FROM HP8753C_CALIBRATION)"
+					"    OR EXISTS (SELECT 1 FROM HP8753C_TRACEDATA);", -1, &stmt, NULL) != SQLITE_OK) {
+				postMessageToMainLoop(TM_ERROR, (gchar*) sqlite3_errmsg(db));
+				return ERROR;
+			}
+			if (sqlite3_step(stmt) == SQLITE_ROW && sqlite3_column_int(stmt, 0) == 0)
+				schemaVersion = CURRENT_DB_SCHEMA;
+			sqlite3_finalize(stmt);
+		}
+
 		// *************** Alert!
 		// if the stored database is older than the current schema ... update
 		// ***************
@@ -1557,7 +2687,75 @@ recoverProgramOptions(tGlobal *pGlobal) {
                     return ERROR;
                 }
 			    break;
-			case 2:
+			case 2: // from version 2 to version 3 - move the learn strings, calibration arrays and
+			        // HPGL screen plots to the content addressed BLOBS table.
+			        // The triggers are not yet in place, so the reference counts are set here.
+				if (sqlite3_exec(db,
+						"BEGIN TRANSACTION;"
+						"INSERT OR IGNORE INTO BLOBS (hash, refcount, data)"
+						"  SELECT sha256(item), count(*), item FROM ("
+						"    SELECT learn AS item FROM HP8753C_CALIBRATION"
+						"    UNION ALL SELECT cal01 FROM HP8753C_CALIBRATION UNION ALL SELECT cal02 FROM HP8753C_CALIBRATION"
+						"    UNION ALL SELECT cal03 FROM HP8753C_CALIBRATION UNION ALL SELECT cal04 FROM HP8753C_CALIBRATION"
+						"    UNION ALL SELECT cal05 FROM HP8753C_CALIBRATION UNION ALL SELECT cal06 FROM HP8753C_CALIBRATION"
+						"    UNION ALL SELECT cal07 FROM HP8753C_CALIBRATION UNION ALL SELECT cal08 FROM HP8753C_CALIBRATION"
+						"    UNION ALL SELECT cal09 FROM HP8753C_CALIBRATION UNION ALL SELECT cal10 FROM HP8753C_CALIBRATION"
+						"    UNION ALL SELECT cal11 FROM HP8753C_CALIBRATION UNION ALL SELECT cal12 FROM HP8753C_CALIBRATION"
+						"    UNION ALL SELECT screenPlot FROM HP8753C_TRACEDATA )"
+						"  WHERE typeof(item) = 'blob' AND length(item) > 0 GROUP BY sha256(item);"
+						"UPDATE HP8753C_CALIBRATION SET"
+						"  learn = sha256(learn), cal01 = sha256(cal01), cal02 = sha256(cal02), cal03 = sha256(cal03),"
+						"  cal04 = sha256(cal04), cal05 = sha256(cal05), cal06 = sha256(cal06), cal07 = sha256(cal07),"
+						"  cal08 = sha256(cal08), cal09 = sha256(cal09), cal10 = sha256(cal10), cal11 = sha256(cal11),"
+						"  cal12 = sha256(cal12);"
+						"UPDATE HP8753C_TRACEDATA SET screenPlot = sha256(screenPlot);"
+						"COMMIT;"
+						, NULL, NULL, NULL) != SQLITE_OK) {
+					postMessageToMainLoop(TM_ERROR, (gchar*) sqlite3_errmsg(db));
+					sqlite3_exec(db, "ROLLBACK;", NULL, NULL, NULL);
+					return ERROR;
+				}
+			    break;
+			case 3: // from version 3 to version 4 - compress the stored blobs and trace data
+				if (sqlite3_exec(db,
+						"BEGIN TRANSACTION;"
+						"UPDATE BLOBS SET data = encodeBlob(data, 0);"
+						"UPDATE HP8753C_TRACEDATA SET"
+						"  points = encodeBlob(points, 2), stimulusPoints = encodeBlob(stimulusPoints, 1);"
+						"COMMIT;"
+						, NULL, NULL, NULL) != SQLITE_OK) {
+					postMessageToMainLoop(TM_ERROR, (gchar*) sqlite3_errmsg(db));
+					sqlite3_exec(db, "ROLLBACK;", NULL, NULL, NULL);
+					return ERROR;
+				}
+			    break;
+			case 4: // from version 4 to version 5 - only list frequency sweeps of all segments keep the stimulus points
+				memcpy(&allSegmentsFlag, &allSegments.chFlags, sizeof(guint32));
+				gchar *sUpdate = g_strdup_printf(
+						"UPDATE HP8753C_TRACEDATA SET stimulusPoints = NULL"
+						"  WHERE sweepType != %d OR (perChannelFlags & %u) = 0;", eSWP_LSTFREQ, allSegmentsFlag );
+				if (sqlite3_exec(db, sUpdate, NULL, NULL, NULL) != SQLITE_OK) {
+					postMessageToMainLoop(TM_ERROR, (gchar*) sqlite3_errmsg(db));
+					g_free( sUpdate );
+					return ERROR;
+				}
+				g_free( sUpdate );
+			    break;
+			case 5: // from version 5 to version 6 - full text index of the profiles
+				if (sqlite3_exec(db,
+						"BEGIN TRANSACTION;"
+						"DELETE FROM PROFILE_SEARCH;"
+						"INSERT INTO PROFILE_SEARCH (rowid, project, name, notes, kind)"
+						"  SELECT rowid * 2, project, name, notes, 0 FROM HP8753C_CALIBRATION WHERE channel = 0;"
+						"INSERT INTO PROFILE_SEARCH (rowid, project, name, title, notes, time, kind, sortTime)"
+						"  SELECT rowid * 2 + 1, project, name, title, notes, time, 1, isoTime(time)"
+						"    FROM HP8753C_TRACEDATA WHERE channel = 0;"
+						"COMMIT;"
+						, NULL, NULL, NULL) != SQLITE_OK) {
+					postMessageToMainLoop(TM_ERROR, (gchar*) sqlite3_errmsg(db));
+					sqlite3_exec(db, "ROLLBACK;", NULL, NULL, NULL);
+					return ERROR;
+				}
 			    break;
 			default:
 				postMessageToMainLoop(TM_ERROR, (gchar*) "Database schema version error");
@@ -1575,6 +2773,35 @@ recoverProgramOptions(tGlobal *pGlobal) {
 		}
 	}
 
+	// reference counting of the BLOBS table
+	for (gint i = 0; i < sizeof(sqlBlobTriggers) / sizeof(gchar*); i++) {
+		if (sqlite3_exec(db, sqlBlobTriggers[i], NULL, NULL, NULL) != SQLITE_OK) {
+			postMessageToMainLoop(TM_ERROR, (gchar*) sqlite3_errmsg(db));
+			return ERROR;
+		}
+	}
+	// maintenance of the profile search index
+	for (gint i = 0; i < sizeof(sqlSearchTriggers) / sizeof(gchar*); i++) {
+		if (sqlite3_exec(db, sqlSearchTriggers[i], NULL, NULL, NULL) != SQLITE_OK) {
+			postMessageToMainLoop(TM_ERROR, (gchar*) sqlite3_errmsg(db));
+			return ERROR;
+		}
+	}
+	// removal of the thumbnails of deleted traces
+	for (gint i = 0; i < sizeof(sqlThumbnailTriggers) / sizeof(gchar*); i++) {
+		if (sqlite3_exec(db, sqlThumbnailTriggers[i], NULL, NULL, NULL) != SQLITE_OK) {
+			postMessageToMainLoop(TM_ERROR, (gchar*) sqlite3_errmsg(db));
+			return ERROR;
+		}
+	}
+	// renaming of the trace history
+	for (gint i = 0; i < sizeof(sqlHistoryTriggers) / sizeof(gchar*); i++) {
+		if (sqlite3_exec(db, sqlHistoryTriggers[i], NULL, NULL, NULL) != SQLITE_OK) {
+			postMessageToMainLoop(TM_ERROR, (gchar*) sqlite3_errmsg(db));
+			return ERROR;
+		}
+	}
+
 	if (sqlite3_prepare_v2(db,
 			"SELECT flags, GPIBcontrollerName, GPIBdeviceName, "
 			"  GPIBcontrollerCard, GPIBdevicePID, "
@@ -1650,8 +2877,10 @@ recoverProgramOptions(tGlobal *pGlobal) {
 			// HPGL plot colors
             size = sqlite3_column_bytes(stmt, queryIndex);
 			tBlob = sqlite3_column_blob(stmt, queryIndex++);
-            if( size == sizeof( HPGLpens ))
+            if( size == sizeof( HPGLpens )) {
                  memcpy( &HPGLpens, tBlob, sizeof( HPGLpens ));
+                 clearHPGLrecording();
+            }
 
 			size = sqlite3_column_bytes(stmt, queryIndex);
 			tBlob = sqlite3_column_blob(stmt, queryIndex++);
@@ -1725,9 +2954,20 @@ inventoryProjects(tGlobal *pGlobal) {
 	sqlite3_stmt *stmt = NULL;
 	gint queryIndex;
 
+	// Step from one project to the next through the (project, name, channel) primary key
+	// so the cost depends on the number of projects rather than the number of profiles
 	if (sqlite3_prepare_v2(db,
-			"SELECT DISTINCT project FROM  HP8753C_TRACEDATA"
-			" UNION SELECT DISTINCT project FROM HP8753C_CALIBRATION;", -1, &stmt, NULL) != SQLITE_OK) {
+			"WITH RECURSIVE"
+			" traceProjects(project) AS ("
+			"   SELECT MIN(project) FROM HP8753C_TRACEDATA"
+			"   UNION ALL SELECT (SELECT MIN(project) FROM HP8753C_TRACEDATA WHERE project > p.project)"
+			"     FROM traceProjects p WHERE p.project IS NOT NULL),"
+			" calProjects(project) AS ("
+			"   SELECT MIN(project) FROM HP8753C_CALIBRATION"
+			"   UNION ALL SELECT (SELECT MIN(project) FROM HP8753C_CALIBRATION WHERE project > p.project)"
+			"     FROM calProjects p WHERE p.project IS NOT NULL)"
+			" SELECT project FROM traceProjects WHERE project IS NOT NULL"
+			" UNION SELECT project FROM calProjects WHERE project IS NOT NULL;", -1, &stmt, NULL) != SQLITE_OK) {
 		postMessageToMainLoop(TM_ERROR, (gchar*) sqlite3_errmsg(db));
 		return ERROR;
 	} else {
@@ -2022,12 +3262,774 @@ err:
 }
 
 
+// Prepared once and reused as each visible row of the profile browser is bound
+static sqlite3_stmt *stmtFetchSearchRow = NULL;
+
+/*!     \brief  Form an FTS5 query from the text typed by the user
+ *
+ * Each word is quoted (so that punctuation is not interpreted as FTS5 syntax)
+ * and matched as a prefix. All words must match.
+ *
+ * \param sSearch  text to search for
+ * \return         allocated FTS5 query or NULL if there are no words
+ */
+static gchar *
+ftsQuery( const gchar *sSearch ) {
+	gchar **sWords;
+	GString *sQuery;
+
+	if( sSearch == NULL )
+		return NULL;
+
+	sWords = g_strsplit_set( sSearch, " \t\n", -1 );
+	sQuery = g_string_new( NULL );
+	for( gint i = 0; sWords[ i ] != NULL; i++ ) {
+		if( *sWords[ i ] == 0 )
+			continue;
+		gchar **sParts = g_strsplit( sWords[ i ], "\"", -1 );
+		gchar *sEscaped = g_strjoinv( "\"\"", sParts );
+		g_string_append_printf( sQuery, "%s\"%s\"*", sQuery->len ? " " : "", sEscaped );
+		g_free( sEscaped );
+		g_strfreev( sParts );
+	}
+	g_strfreev( sWords );
+
+	if( sQuery->len == 0 ) {
+		g_string_free( sQuery, TRUE );
+		return NULL;
+	}
+	return g_string_free( sQuery, FALSE );
+}
+
+/*!     \brief  Search the calibration or trace profiles
+ *
+ * Query the full text index of the profiles. Each word of the search text is
+ * matched as a prefix of a word in the project, name, title, notes or time.
+ * Only the row identifiers are returned, the rows themselves are fetched with
+ * fetchProfileSearchRow() when they are shown.
+ *
+ * \param whichTable   eDB_CALandSETUP or eDB_TRACE
+ * \param sProject     restrict to this project (or NULL for all projects)
+ * \param sSearch      text to search for (NULL or empty for all)
+ * \param bByDate      order newest first (otherwise by project and name)
+ * \return             NULL terminated array of row identifiers (free with g_strfreev) or NULL on error
+ */
+gchar **
+searchProfiles( tDBtable whichTable, const gchar *sProject, const gchar *sSearch, gboolean bByDate ) {
+	sqlite3_stmt *stmt = NULL;
+	gint queryIndex = 0;
+	gchar *sMatch = ftsQuery( sSearch );
+	GPtrArray *pRowIDs;
+
+	gchar *sSQL = g_strdup_printf( "SELECT rowid FROM PROFILE_SEARCH WHERE kind = %d%s%s ORDER BY %s;",
+			whichTable == eDB_TRACE ? 1 : 0,
+			sMatch ? " AND PROFILE_SEARCH MATCH (?)" : "",
+			sProject ? " AND project = (?)" : "",
+			bByDate ? "sortTime IS NULL, sortTime DESC, project, name" : "project, name" );
+
+	if (sqlite3_prepare_v2(db, sSQL, -1, &stmt, NULL) != SQLITE_OK) {
+		postMessageToMainLoop(TM_ERROR, (gchar*) sqlite3_errmsg(db));
+		g_free( sSQL );
+		g_free( sMatch );
+		return NULL;
+	}
+	g_free( sSQL );
+
+	if( sMatch )
+		bind_string( stmt, ++queryIndex, sMatch );
+	if( sProject )
+		bind_string( stmt, ++queryIndex, sProject );
+
+	pRowIDs = g_ptr_array_new();
+	while (sqlite3_step(stmt) == SQLITE_ROW)
+		g_ptr_array_add( pRowIDs, g_strdup_printf( "%" G_GINT64_FORMAT, (gint64)sqlite3_column_int64(stmt, 0) ) );
+	g_ptr_array_add( pRowIDs, NULL );
+
+	sqlite3_finalize(stmt);
+	g_free( sMatch );
+	return (gchar **)g_ptr_array_free( pRowIDs, FALSE );
+}
+
+/*!     \brief  Fetch a row of the profile search index
+ *
+ * \param rowID    row identifier returned by searchProfiles()
+ * \return         allocated tProfileSearchRow (free with freeProfileSearchRow) or NULL if not found
+ */
+tProfileSearchRow *
+fetchProfileSearchRow( gint64 rowID ) {
+	tProfileSearchRow *pRow = NULL;
+	gint queryIndex = 0;
+
+	if( stmtFetchSearchRow == NULL
+			&& sqlite3_prepare_v2(db, "SELECT project, name, title, notes, time FROM PROFILE_SEARCH WHERE rowid = (?);",
+					-1, &stmtFetchSearchRow, NULL) != SQLITE_OK) {
+		postMessageToMainLoop(TM_ERROR, (gchar*) sqlite3_errmsg(db));
+		return NULL;
+	}
+
+	sqlite3_bind_int64( stmtFetchSearchRow, 1, rowID );
+	if (sqlite3_step(stmtFetchSearchRow) == SQLITE_ROW) {
+		pRow = g_new0( tProfileSearchRow, 1 );
+		pRow->sProject = g_strdup( (gchar *)sqlite3_column_text(stmtFetchSearchRow, queryIndex++) );
+		pRow->sName = g_strdup( (gchar *)sqlite3_column_text(stmtFetchSearchRow, queryIndex++) );
+		pRow->sTitle = g_strdup( (gchar *)sqlite3_column_text(stmtFetchSearchRow, queryIndex++) );
+		pRow->sNote = g_strdup( (gchar *)sqlite3_column_text(stmtFetchSearchRow, queryIndex++) );
+		pRow->sDateTime = g_strdup( (gchar *)sqlite3_column_text(stmtFetchSearchRow, queryIndex++) );
+	}
+	sqlite3_reset( stmtFetchSearchRow );
+	return pRow;
+}
+
+/*!     \brief  Free a row fetched from the profile search index
+ *
+ * \param pRow     pointer to tProfileSearchRow
+ */
+void
+freeProfileSearchRow( gpointer pRow ) {
+	tProfileSearchRow *pSearchRow = (tProfileSearchRow *)pRow;
+
+	g_free( pSearchRow->sProject );
+	g_free( pSearchRow->sName );
+	g_free( pSearchRow->sTitle );
+	g_free( pSearchRow->sNote );
+	g_free( pSearchRow->sDateTime );
+	g_free( pSearchRow );
+}
+
+/*!     \brief  Get the thumbnail image of a trace profile
+ *
+ * \param traceID  rowid of the channel 0 row of the trace profile
+ * \param pSize    pointer to the returned size of the image
+ * \return         allocated PNG image or NULL if there is no thumbnail (yet)
+ */
+guchar *
+fetchTraceThumbnail( gint64 traceID, gsize *pSize ) {
+	sqlite3_stmt *stmt = NULL;
+	guchar *thumbnail = NULL;
+
+	*pSize = 0;
+	if (sqlite3_prepare_v2(db, "SELECT png FROM TRACE_THUMBNAILS WHERE traceID = (?);",
+			-1, &stmt, NULL) != SQLITE_OK) {
+		postMessageToMainLoop(TM_ERROR, (gchar*) sqlite3_errmsg(db));
+		return NULL;
+	}
+	sqlite3_bind_int64( stmt, 1, traceID );
+	if (sqlite3_step(stmt) == SQLITE_ROW && sqlite3_column_bytes(stmt, 0) > 0) {
+		*pSize = sqlite3_column_bytes(stmt, 0);
+		thumbnail = g_memdup2( sqlite3_column_blob(stmt, 0), *pSize );
+	}
+	sqlite3_finalize(stmt);
+	return thumbnail;
+}
+
+// A trace profile recovered by the thumbnail generator thread
+typedef struct {
+	gint64   traceID;
+	gchar   *sProject;
+	gchar   *sName;
+	tGlobal *pTrace;    // only the HP8753 data is used
+} tThumbnailJob;
+
+static GThread     *pThumbnailThread = NULL;
+static GAsyncQueue *thumbnailDoneQueue = NULL;
+static gint         bThumbnailGeneratorRunning = FALSE;
+static gint         bStopThumbnailGenerator = FALSE;
+
+/*!     \brief  Free a thumbnail generator job
+ *
+ * \param pJob     pointer to tThumbnailJob
+ */
+static void
+freeThumbnailJob( tThumbnailJob *pJob ) {
+	freeTraceSnapshot( pJob->pTrace );
+	g_free( pJob->sProject );
+	g_free( pJob->sName );
+	g_free( pJob );
+}
+
+/*!     \brief  Thread recovering the trace profiles that have no thumbnail
+ *
+ * Trace profiles saved before thumbnails were introduced (or copied) have no
+ * thumbnail. This thread reads and decodes them using its own (read only) database
+ * connection. The plot routines are not reentrant (and use the main loop's state)
+ * so each recovered trace is passed to the main loop to be drawn and saved
+ * (saveGeneratedThumbnail). Only one trace is in hand at a time.
+ *
+ * \param sDBfile  allocated path of the database file (freed here)
+ * \return         NULL
+ */
+static gpointer
+thumbnailGeneratorThread( gpointer sDBfile ) {
+	sqlite3 *pDB = NULL;
+	sqlite3_stmt *stmt = NULL;
+	GPtrArray *pJobs = g_ptr_array_new();
+
+	if (sqlite3_open_v2( sDBfile, &pDB, SQLITE_OPEN_READONLY, NULL ) == SQLITE_OK) {
+		sqlite3_busy_timeout( pDB, DB_BUSY_TIMEOUT );
+		// newest first, they are the most likely to be looked at
+		if (sqlite3_prepare_v2(pDB,
+				"SELECT rowid, project, name FROM HP8753C_TRACEDATA T WHERE channel = 0"
+				"  AND NOT EXISTS (SELECT 1 FROM TRACE_THUMBNAILS WHERE traceID = T.rowid)"
+				"  ORDER BY rowid DESC;", -1, &stmt, NULL) == SQLITE_OK) {
+			while (sqlite3_step(stmt) == SQLITE_ROW) {
+				tThumbnailJob *pJob = g_new0( tThumbnailJob, 1 );
+				pJob->traceID = sqlite3_column_int64(stmt, 0);
+				pJob->sProject = g_strdup( (gchar *)sqlite3_column_text(stmt, 1) );
+				pJob->sName = g_strdup( (gchar *)sqlite3_column_text(stmt, 2) );
+				g_ptr_array_add( pJobs, pJob );
+			}
+		}
+		sqlite3_finalize(stmt);
+	}
+
+	for( guint i = 0; i < pJobs->len; i++ ) {
+		tThumbnailJob *pJob = g_ptr_array_index( pJobs, i );
+
+		if( g_atomic_int_get( &bStopThumbnailGenerator ) ) {
+			freeThumbnailJob( pJob );
+			continue;
+		}
+		pJob->pTrace = g_new0( tGlobal, 1 );
+		if( recoverTraceDataFromDB( pDB, pJob->pTrace, pJob->sProject, pJob->sName ) == TRUE ) {
+			postDataToMainLoop( TM_SAVE_THUMBNAIL, pJob );
+			// wait until it is drawn (or we are told to stop)
+			g_async_queue_pop( thumbnailDoneQueue );
+		} else {
+			freeThumbnailJob( pJob );
+		}
+	}
+
+	g_ptr_array_free( pJobs, TRUE );
+	sqlite3_close( pDB );
+	g_free( sDBfile );
+	g_atomic_int_set( &bThumbnailGeneratorRunning, FALSE );
+	return NULL;
+}
+
+/*!     \brief  Draw and save the thumbnail of a trace recovered by the generator thread
+ *
+ * Called from the main loop (TM_SAVE_THUMBNAIL). The thumbnail is only saved if the
+ * trace profile still exists and does not have one already.
+ *
+ * \param pGlobal  pointer to tGlobal structure (for the plot options)
+ * \param pJobData pointer to the tThumbnailJob (freed here)
+ */
+void
+saveGeneratedThumbnail( tGlobal *pGlobal, gpointer pJobData ) {
+	tThumbnailJob *pJob = (tThumbnailJob *)pJobData;
+	sqlite3_stmt *stmt = NULL;
+	guchar *thumbnail;
+	gsize thumbnailSize = 0;
+
+	// the generator has been stopped (and the database closed)
+	if( thumbnailDoneQueue == NULL ) {
+		freeThumbnailJob( pJob );
+		return;
+	}
+
+	// plot as the user would see it
+	snapshotPlotOptions( pJob->pTrace, pGlobal );
+	pJob->pTrace->HP8753.sProduct = pGlobal->HP8753.sProduct;
+	thumbnail = renderTraceThumbnail( pJob->pTrace, &thumbnailSize );
+	pJob->pTrace->HP8753.sProduct = NULL;
+
+	if( thumbnail ) {
+		if (sqlite3_prepare_v2(db,
+				"INSERT OR IGNORE INTO TRACE_THUMBNAILS (traceID, png)"
+				"  SELECT ?1, ?2 WHERE EXISTS (SELECT 1 FROM HP8753C_TRACEDATA"
+				"    WHERE rowid = ?1 AND channel = 0 AND project IS ?3 AND name = ?4);",
+				-1, &stmt, NULL) != SQLITE_OK
+				|| sqlite3_bind_int64(stmt, 1, pJob->traceID) != SQLITE_OK
+				|| sqlite3_bind_blob(stmt, 2, thumbnail, thumbnailSize, SQLITE_STATIC) != SQLITE_OK
+				|| bind_string(stmt, 3, pJob->sProject) != SQLITE_OK
+				|| bind_string(stmt, 4, pJob->sName) != SQLITE_OK
+				|| sqlite3_step(stmt) != SQLITE_DONE) {
+			postMessageToMainLoop(TM_ERROR, (gchar*) sqlite3_errmsg(db));
+		}
+		sqlite3_finalize(stmt);
+		g_free( thumbnail );
+	}
+	freeThumbnailJob( pJob );
+
+	// let the generator recover the next trace
+	g_async_queue_push( thumbnailDoneQueue, GINT_TO_POINTER( TRUE ) );
+}
+
+/*!     \brief  Start generating the missing trace thumbnails in the background
+ *
+ * Does nothing if the generator is already running.
+ */
+void
+startThumbnailGeneration( void ) {
+	if( g_atomic_int_get( &bThumbnailGeneratorRunning ) )
+		return;
+
+	if( pThumbnailThread )
+		g_thread_join( g_steal_pointer( &pThumbnailThread ) );
+	if( thumbnailDoneQueue == NULL )
+		thumbnailDoneQueue = g_async_queue_new();
+	while( g_async_queue_try_pop( thumbnailDoneQueue ) )
+		;
+
+	g_atomic_int_set( &bStopThumbnailGenerator, FALSE );
+	g_atomic_int_set( &bThumbnailGeneratorRunning, TRUE );
+	pThumbnailThread = g_thread_new( "thumbnails", thumbnailGeneratorThread,
+			g_strdup( sqlite3_db_filename( db, "main" ) ) );
+}
+
+/*!     \brief  Stop the thumbnail generator thread
+ *
+ * Waits for the thread to end. A trace already passed to the main loop is not
+ * drawn (the main loop will not run again).
+ */
+static void
+stopThumbnailGeneration( void ) {
+	if( pThumbnailThread == NULL )
+		return;
+
+	g_atomic_int_set( &bStopThumbnailGenerator, TRUE );
+	g_async_queue_push( thumbnailDoneQueue, GINT_TO_POINTER( TRUE ) );
+	g_thread_join( g_steal_pointer( &pThumbnailThread ) );
+	g_clear_pointer( &thumbnailDoneQueue, g_async_queue_unref );
+}
+
+/*!     \brief  Execute an SQL statement binding strings to its parameters
+ *
+ * \param pDB       database connection
+ * \param sSQL      SQL statement
+ * \param nStrings  number of strings that follow (bound to parameters 1, 2 ...)
+ * \param ...       strings to bind (NULL binds NULL)
+ * \return          completion status
+ */
+static gint
+execBoundSQL( sqlite3 *pDB, const gchar *sSQL, gint nStrings, ... ) {
+	sqlite3_stmt *stmt = NULL;
+	gint queryIndex = 0;
+	va_list args;
+
+	if (sqlite3_prepare_v2(pDB, sSQL, -1, &stmt, NULL) != SQLITE_OK)
+		goto err;
+	va_start( args, nStrings );
+	while( queryIndex < nStrings ) {
+		if (bind_string( stmt, ++queryIndex, va_arg( args, const gchar * ) ) != SQLITE_OK) {
+			va_end( args );
+			goto err;
+		}
+	}
+	va_end( args );
+	if (sqlite3_step(stmt) != SQLITE_DONE)
+		goto err;
+	sqlite3_finalize(stmt);
+	return OK;
+
+err:
+	postMessageToMainLoop(TM_ERROR, (gchar*) sqlite3_errmsg(pDB));
+	sqlite3_finalize(stmt);
+	return ERROR;
+}
+
+/*!     \brief  Export a project to an archive file
+ *
+ * The archive is itself an hp8753 database holding only the profiles (with their
+ * thumbnails and history) of the project. It is attached to the open database and
+ * filled with INSERT ... SELECT so rows and blobs pass through the page cache one at
+ * a time (memory used does not depend on the size of the project). The calibration
+ * arrays are content addressed so an array shared by several profiles is written once.
+ * Run on the project archive thread (see startProjectArchive).
+ *
+ * \param pDB       database connection (of the thread)
+ * \param sProject  project to export
+ * \param sArchive  archive file name (replaced if it exists)
+ * \return          number of profiles exported or ERROR
+ */
+static gint
+exportProjectArchive( sqlite3 *pDB, const gchar *sProject, const gchar *sArchive ) {
+	sqlite3 *pArchiveDB = NULL;
+	sqlite3_stmt *stmt = NULL;
+	gint i, nProfiles = ERROR;
+	gchar *sSQL;
+
+	// Create the empty archive with the tables of the current schema. The blob triggers
+	// are included so that the reference counts in the archive are kept as rows are added.
+	g_unlink( sArchive );
+	if (sqlite3_open_v2(sArchive, &pArchiveDB, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, NULL) != SQLITE_OK) {
+		postMessageToMainLoop(TM_ERROR, (gchar*) sqlite3_errmsg(pArchiveDB));
+		sqlite3_close(pArchiveDB);
+		return ERROR;
+	}
+	for (i = 0; i < sizeof(sqlCreateTables) / sizeof(gchar*); i++) {
+		if (sqlite3_exec(pArchiveDB, sqlCreateTables[i], NULL, NULL, NULL) != SQLITE_OK)
+			break;
+	}
+	for (i = 0; i < sizeof(sqlBlobTriggers) / sizeof(gchar*) && sqlite3_errcode(pArchiveDB) == SQLITE_OK; i++) {
+		if (sqlite3_exec(pArchiveDB, sqlBlobTriggers[i], NULL, NULL, NULL) != SQLITE_OK)
+			break;
+	}
+	sSQL = g_strdup_printf( "PRAGMA user_version = %d;", CURRENT_DB_SCHEMA );
+	if (sqlite3_errcode(pArchiveDB) == SQLITE_OK)
+		sqlite3_exec(pArchiveDB, sSQL, NULL, NULL, NULL);
+	g_free( sSQL );
+	if (sqlite3_errcode(pArchiveDB) != SQLITE_OK) {
+		postMessageToMainLoop(TM_ERROR, (gchar*) sqlite3_errmsg(pArchiveDB));
+		sqlite3_close(pArchiveDB);
+		g_unlink( sArchive );
+		return ERROR;
+	}
+	sqlite3_close(pArchiveDB);
+
+	if (execBoundSQL( pDB, "ATTACH DATABASE (?) AS archive;", 1, sArchive ) != OK) {
+		g_unlink( sArchive );
+		return ERROR;
+	}
+	// the archive is discarded if anything fails so it needs no journal
+	if (sqlite3_exec(pDB, "PRAGMA archive.journal_mode = OFF;"
+			"PRAGMA archive.synchronous = OFF;"
+			"BEGIN;", NULL, NULL, NULL) != SQLITE_OK) {
+		postMessageToMainLoop(TM_ERROR, (gchar*) sqlite3_errmsg(pDB));
+		goto err;
+	}
+
+	// blobs first (with no references) so the triggers count the rows that refer to them
+	if (execBoundSQL( pDB,
+			"INSERT OR IGNORE INTO archive.BLOBS (hash, refcount, data)"
+			" SELECT hash, 0, data FROM main.BLOBS WHERE hash IN ("
+			"   WITH c AS (SELECT " CAL_BLOB_COLUMNS( "" ) " FROM main.HP8753C_CALIBRATION WHERE project IS ?1),"
+			"        t AS (SELECT screenPlot FROM main.HP8753C_TRACEDATA WHERE project IS ?1) "
+			    PROJECT_BLOB_KEYS( "c", "t" ) ");", 1, sProject ) != OK)
+		goto err;
+	if (execBoundSQL( pDB,
+			"INSERT INTO archive.HP8753C_CALIBRATION (project, selected, name, " CALIBRATION_DATA_COLUMNS ")"
+			" SELECT project, selected, name, " CALIBRATION_DATA_COLUMNS
+			" FROM main.HP8753C_CALIBRATION WHERE project IS (?);", 1, sProject ) != OK)
+		goto err;
+	if (execBoundSQL( pDB,
+			"INSERT INTO archive.HP8753C_TRACEDATA (project, selected, name, " TRACEDATA_DATA_COLUMNS ")"
+			" SELECT project, selected, name, " TRACEDATA_DATA_COLUMNS
+			" FROM main.HP8753C_TRACEDATA WHERE project IS (?);", 1, sProject ) != OK)
+		goto err;
+	// the thumbnails are keyed by the rowid of the trace which is different in the archive
+	if (execBoundSQL( pDB,
+			"INSERT INTO archive.TRACE_THUMBNAILS (traceID, png)"
+			" SELECT a.rowid, n.png FROM main.TRACE_THUMBNAILS n"
+			"   JOIN main.HP8753C_TRACEDATA m ON m.rowid = n.traceID"
+			"   JOIN archive.HP8753C_TRACEDATA a ON a.name = m.name AND a.channel = 0"
+			" WHERE m.project IS (?) AND m.channel = 0;", 1, sProject ) != OK)
+		goto err;
+	if (execBoundSQL( pDB,
+			"INSERT INTO archive.TRACE_HISTORY (captureID, project, name, baseID, " TRACE_HISTORY_DATA_COLUMNS ")"
+			" SELECT captureID, project, name, baseID, " TRACE_HISTORY_DATA_COLUMNS
+			" FROM main.TRACE_HISTORY WHERE project IS (?);", 1, sProject ) != OK)
+		goto err;
+
+	if (sqlite3_prepare_v2(pDB,
+			"SELECT (SELECT COUNT(*) FROM archive.HP8753C_CALIBRATION WHERE channel = 0)"
+			"     + (SELECT COUNT(*) FROM archive.HP8753C_TRACEDATA WHERE channel = 0);",
+			-1, &stmt, NULL) != SQLITE_OK
+			|| sqlite3_step(stmt) != SQLITE_ROW) {
+		postMessageToMainLoop(TM_ERROR, (gchar*) sqlite3_errmsg(pDB));
+		goto err;
+	}
+	nProfiles = sqlite3_column_int(stmt, 0);
+	sqlite3_finalize(stmt);
+	stmt = NULL;
+
+	if (sqlite3_exec(pDB, "COMMIT;", NULL, NULL, NULL) != SQLITE_OK) {
+		postMessageToMainLoop(TM_ERROR, (gchar*) sqlite3_errmsg(pDB));
+		nProfiles = ERROR;
+		goto err;
+	}
+	sqlite3_exec(pDB, "DETACH DATABASE archive;", NULL, NULL, NULL);
+	return nProfiles;
+
+err:
+	sqlite3_finalize(stmt);
+	if (!sqlite3_get_autocommit(pDB))
+		sqlite3_exec(pDB, "ROLLBACK;", NULL, NULL, NULL);
+	sqlite3_exec(pDB, "DETACH DATABASE archive;", NULL, NULL, NULL);
+	g_unlink( sArchive );
+	return ERROR;
+}
+
+/*!     \brief  Find a name for an imported profile that is not already used in the project
+ *
+ * Like the rename, move & copy dialog, an import never overwrites an existing profile.
+ * If the name is taken, " (2)", " (3)" ... is appended until it is unique.
+ *
+ * \param pDB       database connection
+ * \param sTable    profile table (HP8753C_CALIBRATION or HP8753C_TRACEDATA)
+ * \param sProject  project the profile is imported into
+ * \param sName     name of the profile in the archive
+ * \return          allocated name (or NULL on error)
+ */
+static gchar *
+uniqueImportName( sqlite3 *pDB, const gchar *sTable, const gchar *sProject, const gchar *sName ) {
+	sqlite3_stmt *stmt = NULL;
+	gchar *sSQL = g_strdup_printf(
+			"SELECT EXISTS (SELECT 1 FROM main.%s WHERE project IS (?) AND name = (?));", sTable );
+	gchar *sUnique = g_strdup( sName );
+	gint suffix = 1;
+
+	if (sqlite3_prepare_v2(pDB, sSQL, -1, &stmt, NULL) != SQLITE_OK) {
+		postMessageToMainLoop(TM_ERROR, (gchar*) sqlite3_errmsg(pDB));
+		g_clear_pointer( &sUnique, g_free );
+	} else {
+		while( TRUE ) {
+			if (bind_string( stmt, 1, sProject ) != SQLITE_OK
+					|| bind_string( stmt, 2, sUnique ) != SQLITE_OK
+					|| sqlite3_step(stmt) != SQLITE_ROW) {
+				postMessageToMainLoop(TM_ERROR, (gchar*) sqlite3_errmsg(pDB));
+				g_clear_pointer( &sUnique, g_free );
+				break;
+			}
+			if( sqlite3_column_int(stmt, 0) == 0 )
+				break;
+			sqlite3_reset(stmt);
+			sqlite3_clear_bindings(stmt);
+			g_free( sUnique );
+			sUnique = g_strdup_printf( "%s (%d)", sName, ++suffix );
+		}
+	}
+	sqlite3_finalize(stmt);
+	g_free( sSQL );
+	return sUnique;
+}
+
+/*!     \brief  Import the profiles from a project archive
+ *
+ * The archive (written by exportProjectArchive) is attached and its rows copied with
+ * INSERT ... SELECT. Blobs already in the database are not copied again. Profiles keep
+ * the project they were exported from; a profile with the same name as one already in
+ * that project is given a unique name (see uniqueImportName).
+ * Run on the project archive thread (see startProjectArchive). The lists of projects
+ * and profiles are re-read from the database afterwards (projectArchiveComplete).
+ *
+ * \param pDB       database connection (of the thread)
+ * \param sArchive  archive file name
+ * \return          number of profiles imported or ERROR
+ */
+static gint
+importProjectArchive( sqlite3 *pDB, const gchar *sArchive ) {
+	sqlite3_stmt *stmt = NULL;
+	gint nProfiles = 0;
+	gint64 captureOffset = 0;
+
+	if (execBoundSQL( pDB, "ATTACH DATABASE (?) AS archive;", 1, sArchive ) != OK)
+		return ERROR;
+
+	if (sqlite3_prepare_v2(pDB, "PRAGMA archive.user_version;", -1, &stmt, NULL) != SQLITE_OK
+			|| sqlite3_step(stmt) != SQLITE_ROW) {
+		postMessageToMainLoop(TM_ERROR, (gchar*) sqlite3_errmsg(pDB));
+		goto err;
+	}
+	if (sqlite3_column_int(stmt, 0) != CURRENT_DB_SCHEMA) {
+		postMessageToMainLoop(TM_ERROR, "Not an archive from this version of the program");
+		goto err;
+	}
+	sqlite3_finalize(stmt);
+	stmt = NULL;
+
+	if (sqlite3_exec(pDB, "BEGIN;"
+			"INSERT OR IGNORE INTO main.BLOBS (hash, refcount, data)"
+			" SELECT hash, 0, data FROM archive.BLOBS;", NULL, NULL, NULL) != SQLITE_OK) {
+		postMessageToMainLoop(TM_ERROR, (gchar*) sqlite3_errmsg(pDB));
+		goto err;
+	}
+
+	// the history captures are renumbered above those already in the database
+	if (sqlite3_prepare_v2(pDB, "SELECT IFNULL(MAX(captureID), 0) FROM main.TRACE_HISTORY;",
+			-1, &stmt, NULL) != SQLITE_OK
+			|| sqlite3_step(stmt) != SQLITE_ROW) {
+		postMessageToMainLoop(TM_ERROR, (gchar*) sqlite3_errmsg(pDB));
+		goto err;
+	}
+	captureOffset = sqlite3_column_int64(stmt, 0);
+	sqlite3_finalize(stmt);
+
+	if (sqlite3_prepare_v2(pDB,
+			"SELECT 0, project, name FROM archive.HP8753C_CALIBRATION WHERE channel = 0"
+			" UNION ALL SELECT 1, project, name FROM archive.HP8753C_TRACEDATA WHERE channel = 0;",
+			-1, &stmt, NULL) != SQLITE_OK) {
+		postMessageToMainLoop(TM_ERROR, (gchar*) sqlite3_errmsg(pDB));
+		goto err;
+	}
+	while (sqlite3_step(stmt) == SQLITE_ROW) {
+		gboolean bTrace = sqlite3_column_int(stmt, 0) == 1;
+		const gchar *sProject = (const gchar *)sqlite3_column_text(stmt, 1);
+		const gchar *sName = (const gchar *)sqlite3_column_text(stmt, 2);
+		gchar *sImportName = uniqueImportName( pDB,
+				bTrace ? "HP8753C_TRACEDATA" : "HP8753C_CALIBRATION", sProject, sName );
+		gint rc;
+
+		if( sImportName == NULL )
+			goto err;
+		if( !bTrace ) {
+			rc = execBoundSQL( pDB,
+					"INSERT INTO main.HP8753C_CALIBRATION (project, selected, name, " CALIBRATION_DATA_COLUMNS ")"
+					" SELECT project, 0, (?), " CALIBRATION_DATA_COLUMNS
+					" FROM archive.HP8753C_CALIBRATION WHERE project IS (?) AND name = (?);",
+					3, sImportName, sProject, sName );
+		} else {
+			gchar *sOffset = g_strdup_printf( "%" G_GINT64_FORMAT, captureOffset );
+			rc = execBoundSQL( pDB,
+					"INSERT INTO main.HP8753C_TRACEDATA (project, selected, name, " TRACEDATA_DATA_COLUMNS ")"
+					" SELECT project, 0, (?), " TRACEDATA_DATA_COLUMNS
+					" FROM archive.HP8753C_TRACEDATA WHERE project IS (?) AND name = (?);",
+					3, sImportName, sProject, sName );
+			if( rc == OK )
+				rc = execBoundSQL( pDB,
+					"INSERT INTO main.TRACE_THUMBNAILS (traceID, png)"
+					" SELECT m.rowid, n.png FROM archive.TRACE_THUMBNAILS n"
+					"   JOIN archive.HP8753C_TRACEDATA a ON a.rowid = n.traceID"
+					"   JOIN main.HP8753C_TRACEDATA m ON m.project IS a.project AND m.name = (?1) AND m.channel = 0"
+					" WHERE a.project IS (?2) AND a.name = (?3) AND a.channel = 0;",
+					3, sImportName, sProject, sName );
+			if( rc == OK )
+				rc = execBoundSQL( pDB,
+					"INSERT INTO main.TRACE_HISTORY (captureID, project, name, baseID, " TRACE_HISTORY_DATA_COLUMNS ")"
+					" SELECT captureID + (?4), project, (?1), baseID + (?4), " TRACE_HISTORY_DATA_COLUMNS
+					" FROM archive.TRACE_HISTORY WHERE project IS (?2) AND name = (?3);",
+					4, sImportName, sProject, sName, sOffset );
+			g_free( sOffset );
+		}
+		g_free( sImportName );
+		if( rc != OK )
+			goto err;
+		nProfiles++;
+	}
+	sqlite3_finalize(stmt);
+	stmt = NULL;
+
+	if (purgeUnreferencedBlobs( pDB ) != OK)
+		goto err;
+	if (sqlite3_exec(pDB, "COMMIT;", NULL, NULL, NULL) != SQLITE_OK) {
+		postMessageToMainLoop(TM_ERROR, (gchar*) sqlite3_errmsg(pDB));
+		goto err;
+	}
+	sqlite3_exec(pDB, "DETACH DATABASE archive;", NULL, NULL, NULL);
+
+	return nProfiles;
+
+err:
+	sqlite3_finalize(stmt);
+	if (!sqlite3_get_autocommit(pDB))
+		sqlite3_exec(pDB, "ROLLBACK;", NULL, NULL, NULL);
+	sqlite3_exec(pDB, "DETACH DATABASE archive;", NULL, NULL, NULL);
+	return ERROR;
+}
+
+// An export or import of a project archive (see startProjectArchive)
+typedef struct {
+	sqlite3  *pDB;          // connection of the thread
+	gboolean  bImport;
+	gchar    *sProject;     // project exported
+	gchar    *sArchive;
+	gint      nProfiles;    // profiles exported or imported (or ERROR)
+} tProjectArchiveJob;
+
+static GThread     *pArchiveThread = NULL;
+static gint         bArchiveThreadRunning = FALSE;
+
+/*!     \brief  Thread exporting or importing a project archive
+ *
+ * The copy can take minutes for a large project so it is made on its own connection
+ * and the result is passed back to the main loop (TM_PROJECT_ARCHIVE_COMPLETE).
+ *
+ * \param pJobData  pointer to the tProjectArchiveJob
+ * \return          NULL
+ */
+static gpointer
+projectArchiveThread( gpointer pJobData ) {
+	tProjectArchiveJob *pJob = (tProjectArchiveJob *)pJobData;
+
+	if( pJob->bImport )
+		pJob->nProfiles = importProjectArchive( pJob->pDB, pJob->sArchive );
+	else
+		pJob->nProfiles = exportProjectArchive( pJob->pDB, pJob->sProject, pJob->sArchive );
+	sqlite3_close( g_steal_pointer( &pJob->pDB ) );
+
+	g_atomic_int_set( &bArchiveThreadRunning, FALSE );
+	postDataToMainLoop( TM_PROJECT_ARCHIVE_COMPLETE, pJob );
+	return NULL;
+}
+
+/*!     \brief  Export a project to, or import the profiles from, an archive in the background
+ *
+ * Only one archive is written or read at a time.
+ * Called from the main loop.
+ *
+ * \param bImport   TRUE to import, FALSE to export
+ * \param sProject  project to export (unused for an import)
+ * \param sArchive  archive file name
+ * \return          completion status (OK if started)
+ */
+gint
+startProjectArchive( gboolean bImport, const gchar *sProject, const gchar *sArchive ) {
+	tProjectArchiveJob *pJob;
+	sqlite3 *pDB = NULL;
+
+	if( g_atomic_int_get( &bArchiveThreadRunning ) ) {
+		postError( "A project archive is already being written or read" );
+		return ERROR;
+	}
+	if( pArchiveThread )
+		g_thread_join( g_steal_pointer( &pArchiveThread ) );
+
+	if (sqlite3_open_v2( sqlite3_db_filename( db, "main" ), &pDB, SQLITE_OPEN_READWRITE, NULL ) != SQLITE_OK) {
+		postMessageToMainLoop(TM_ERROR, (gchar*) sqlite3_errmsg(pDB));
+		sqlite3_close( pDB );
+		return ERROR;
+	}
+	// the main loop waits for the locks of this connection when it saves
+	sqlite3_busy_timeout( pDB, DB_BUSY_TIMEOUT );
+	registerSQLfunctions( pDB );
+
+	pJob = g_new0( tProjectArchiveJob, 1 );
+	pJob->pDB = pDB;
+	pJob->bImport = bImport;
+	pJob->sProject = g_strdup( sProject );
+	pJob->sArchive = g_strdup( sArchive );
+
+	g_atomic_int_set( &bArchiveThreadRunning, TRUE );
+	pArchiveThread = g_thread_new( "archive", projectArchiveThread, pJob );
+	return OK;
+}
+
+/*!     \brief  The export or import of a project archive is complete
+ *
+ * Called from the main loop (TM_PROJECT_ARCHIVE_COMPLETE). After an import the lists of
+ * projects and profiles are re-read from the database (keeping the selections made in
+ * this session) before the result is shown.
+ *
+ * \param pGlobal   pointer to tGlobal structure
+ * \param pJobData  pointer to the tProjectArchiveJob (freed here)
+ */
+void
+projectArchiveComplete( tGlobal *pGlobal, gpointer pJobData ) {
+	tProjectArchiveJob *pJob = (tProjectArchiveJob *)pJobData;
+
+	if( pJob->bImport && pJob->nProfiles != ERROR && saveProgramOptions( pGlobal ) == OK ) {
+		inventoryProjects( pGlobal );
+		inventorySavedSetupsAndCal( pGlobal );
+		inventorySavedTraceNames( pGlobal );
+	}
+	showProjectArchiveResult( pGlobal, pJob->bImport, pJob->sProject, pJob->nProfiles );
+
+	g_free( pJob->sProject );
+	g_free( pJob->sArchive );
+	g_free( pJob );
+}
+
 /*!     \brief  Close the Sqlite3 database
  *
  * Close the Sqlite3 database prior to ending program
  *
  */
 void closeDB(void) {
+	stopThumbnailGeneration();
+	// an archive being written or read is completed (the result is not shown)
+	if( pArchiveThread )
+		g_thread_join( g_steal_pointer( &pArchiveThread ) );
+	sqlite3_finalize( stmtFetchSearchRow );
 	sqlite3_close(db);
 	sqlite3_shutdown();
 }
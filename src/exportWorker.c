@@ -0,0 +1,320 @@
+/*
+ * Copyright (c) 2026 Michael G. Katzmann
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/*! \file exportWorker.c
+ * Render PDF, SVG & PNG exports and printed pages on worker threads.
+ *
+ * When an export is started the traces, plot options and colors are copied (snapshotTraces)
+ * so the worker threads draw what was on the screen at the time, even if a new
+ * capture arrives or another trace is recalled while they run. Each file (or printed
+ * page) is a job on a small pool of threads. When a job is done it is passed back to
+ * the main loop (TM_EXPORT_COMPLETE) to report progress and errors on the status line
+ * and, for printing, to hand the page to GTK.
+ *
+ * Escape cancels the exports in progress (cancelExports); jobs not yet started
+ * are skipped and a multi-page file is abandoned between pages.
+ */
+
+#include <gtk/gtk.h>
+#include <string.h>
+#include <glib-2.0/glib.h>
+
+#include "hp8753.h"
+#include "messageEvent.h"
+#include "exportWorker.h"
+
+#define EXPORT_MAX_THREADS  4
+
+static GThreadPool  *exportPool = NULL;
+static GList        *activeExports = NULL;     // (main loop only) exports with jobs outstanding
+
+/*!     \brief  Copy the plot options and colors to a snapshot
+ *
+ * The snapshot is then drawn as it would be on the screen, but the screen's
+ * caches are not used. Called from the main loop (or while pGlobal cannot change).
+ *
+ * \param  pSnapshot    snapshot (freed with freeTraceSnapshot)
+ * \param  pGlobal      pointer to global data
+ */
+void
+snapshotPlotOptions( tGlobal *pSnapshot, tGlobal *pGlobal ) {
+    pSnapshot->bSnapshot = TRUE;
+    pSnapshot->flags = pGlobal->flags;
+    pSnapshot->PDFpaperSize = pGlobal->PDFpaperSize;
+
+    g_free( pSnapshot->plotElementColors );
+    pSnapshot->plotElementColors = g_memdup2( pGlobal->plotElementColors, eMAX_COLORS * sizeof( GdkRGBA ) );
+    g_free( pSnapshot->HPGLpens );
+    pSnapshot->HPGLpens = g_memdup2( pGlobal->HPGLpens, NUM_HPGL_PENS * sizeof( GdkRGBA ) );
+}
+
+/*!     \brief  Copy the traces and plot options for rendering on another thread
+ *
+ * The data derived from the traces when first drawn (stimulus values, list
+ * segment index and spline control points) is calculated before the copy so
+ * the snapshot is never changed by the plot routines.
+ * Called from the main loop.
+ *
+ * \param  pGlobal  pointer to global data
+ * \return          snapshot (free with freeTraceSnapshot)
+ */
+tGlobal *
+snapshotTraces( tGlobal *pGlobal ) {
+    tGlobal *pSnapshot = g_new0( tGlobal, 1 );
+
+    pSnapshot->HP8753 = pGlobal->HP8753;
+    for( eChannel channel = 0; channel < eNUM_CH; channel++ ) {
+        tChannel *pSource = &pGlobal->HP8753.channels[ channel ];
+        tChannel *pChannel = &pSnapshot->HP8753.channels[ channel ];
+
+        pChannel->responsePoints = NULL;
+        pChannel->stimulusPoints = NULL;
+        pChannel->splineControlPoints = NULL;
+        pChannel->decimated = (tDecimatedTrace){ 0 };
+        if( pSource->responsePoints == NULL || pSource->nPoints == 0 )
+            continue;
+
+        getStimulusPoints( pSource );
+        getSegmentIndex( pSource );
+        if( pSource->format == eFMT_SMITH || pSource->format == eFMT_POLAR )
+            getSplineControlPoints( pSource );
+        pChannel->segmentIndex = pSource->segmentIndex;
+
+        pChannel->responsePoints = g_memdup2( pSource->responsePoints, pSource->nPoints * sizeof( tComplex ) );
+        if( pSource->stimulusPoints )
+            pChannel->stimulusPoints = g_memdup2( pSource->stimulusPoints, pSource->nPoints * sizeof( gdouble ) );
+        if( pSource->splineControlPoints )
+            pChannel->splineControlPoints =
+                    g_memdup2( pSource->splineControlPoints, 2 * pSource->nPoints * sizeof( tComplex ) );
+    }
+    // the compiled HPGL starts with its length
+    if( pGlobal->HP8753.plotHPGL )
+        pSnapshot->HP8753.plotHPGL = g_memdup2( pGlobal->HP8753.plotHPGL, *(guint *)pGlobal->HP8753.plotHPGL );
+    pSnapshot->HP8753.sTitle = g_strdup( pGlobal->HP8753.sTitle );
+    pSnapshot->HP8753.sNote = g_strdup( pGlobal->HP8753.sNote );
+    pSnapshot->HP8753.dateTime = g_strdup( pGlobal->HP8753.dateTime );
+    pSnapshot->HP8753.sProduct = g_strdup( pGlobal->HP8753.sProduct );
+    // not used to plot
+    memset( &pSnapshot->HP8753.S2P, 0, sizeof( tS2P ) );
+    pSnapshot->HP8753.pLSindexes = NULL;
+
+    snapshotPlotOptions( pSnapshot, pGlobal );
+    pSnapshot->liveMarkerPosnRatio = pGlobal->liveMarkerPosnRatio;
+    memcpy( pSnapshot->mousePosition, pGlobal->mousePosition, sizeof( pSnapshot->mousePosition ) );
+    pSnapshot->mouseXpercentHeld = pGlobal->mouseXpercentHeld;
+
+    return pSnapshot;
+}
+
+/*!     \brief  Free a copy of the traces
+ *
+ * \param  pSnapshot    snapshot from snapshotTraces (or a trace recovered into an empty tGlobal)
+ */
+void
+freeTraceSnapshot( tGlobal *pSnapshot ) {
+    if( pSnapshot == NULL )
+        return;
+
+    for( eChannel channel = 0; channel < eNUM_CH; channel++ ) {
+        g_free( pSnapshot->HP8753.channels[ channel ].responsePoints );
+        g_free( pSnapshot->HP8753.channels[ channel ].stimulusPoints );
+        clearDerivedTraceData( &pSnapshot->HP8753.channels[ channel ] );
+    }
+    g_free( pSnapshot->HP8753.plotHPGL );
+    g_free( pSnapshot->HP8753.sTitle );
+    g_free( pSnapshot->HP8753.sNote );
+    g_free( pSnapshot->HP8753.dateTime );
+    g_free( pSnapshot->HP8753.sProduct );
+    g_free( pSnapshot->plotElementColors );
+    g_free( pSnapshot->HPGLpens );
+    g_free( pSnapshot );
+}
+
+/*!     \brief  Start an export of the current traces
+ *
+ * Jobs are added with queueExportJob. The export is freed once the owner has
+ * called releaseExport and all of its jobs are complete.
+ * Called from the main loop.
+ *
+ * \param  pGlobal  pointer to global data
+ * \param  sName    name shown in the progress messages (or NULL)
+ * \return          the export
+ */
+tExport *
+newExport( tGlobal *pGlobal, const gchar *sName ) {
+    tExport *pExport = g_new0( tExport, 1 );
+
+    pExport->pSnapshot = snapshotTraces( pGlobal );
+    pExport->sName = g_strdup( sName );
+    activeExports = g_list_prepend( activeExports, pExport );
+
+    return pExport;
+}
+
+static void
+freeExport( tExport *pExport ) {
+    activeExports = g_list_remove( activeExports, pExport );
+    freeTraceSnapshot( pExport->pSnapshot );
+    g_free( pExport->sName );
+    g_free( pExport );
+}
+
+static void
+freeExportJob( tExportJob *pJob ) {
+    g_free( pJob->sFilename );
+    if( pJob->pRecording )
+        cairo_surface_destroy( pJob->pRecording );
+    if( pJob->pPrintContext )
+        g_object_unref( pJob->pPrintContext );
+    g_free( pJob );
+}
+
+/*!     \brief  Render one job (export pool thread)
+ *
+ * \param  data     the job
+ * \param  udata    unused
+ */
+static void
+exportWorker( gpointer data, gpointer udata ) {
+    tExportJob *pJob = (tExportJob *)data;
+
+    if( isExportCancelled( pJob->pExport ) )
+        pJob->status = ERROR;
+    else
+        pJob->status = pJob->render( pJob );
+
+    postDataToMainLoop( TM_EXPORT_COMPLETE, pJob );
+}
+
+/*!     \brief  Add a job to an export
+ *
+ * Called from the main loop.
+ *
+ * \param  pExport  the export
+ * \param  pJob     the job (freed when complete)
+ */
+void
+queueExportJob( tExport *pExport, tExportJob *pJob ) {
+    if( exportPool == NULL )
+        exportPool = g_thread_pool_new( exportWorker, NULL,
+                CLAMP( g_get_num_processors(), 2, EXPORT_MAX_THREADS ), FALSE, NULL );
+
+    pJob->pExport = pExport;
+    pExport->nJobs++;
+    g_thread_pool_push( exportPool, pJob, NULL );
+}
+
+/*!     \brief  Report a completed job and free it (main loop - TM_EXPORT_COMPLETE)
+ *
+ * \param  pGlobal  pointer to global data
+ * \param  pJob     the job
+ */
+void
+exportJobComplete( tGlobal *pGlobal, tExportJob *pJob ) {
+    tExport *pExport = pJob->pExport;
+    gboolean bCancelled = isExportCancelled( pExport );
+    const gchar *sName = pExport->sName ? pExport->sName : "print";
+    gchar *sMessage;
+
+    pExport->nComplete++;
+    if( pJob->status != OK && !bCancelled ) {
+        pExport->nFailed++;
+        if( pJob->sFilename ) {
+            sMessage = g_strdup_printf( "Cannot write: %s", pJob->sFilename );
+            postError( sMessage );
+            g_free( sMessage );
+        }
+    }
+    if( pJob->complete )
+        pJob->complete( pGlobal, pJob );
+
+    if( pExport->nComplete < pExport->nJobs ) {
+        sMessage = g_strdup_printf( "Writing %s (%d of %d)", sName, pExport->nComplete, pExport->nJobs );
+        postInfo( sMessage );
+        g_free( sMessage );
+    } else if( bCancelled ) {
+        sMessage = g_strdup_printf( "Cancelled: %s", sName );
+        postInfo( sMessage );
+        g_free( sMessage );
+    } else if( pExport->nFailed == 0 && pExport->bReleased && pExport->sName ) {
+        sMessage = g_strdup_printf( "Saved %s", sName );
+        postInfo( sMessage );
+        g_free( sMessage );
+    }
+
+    freeExportJob( pJob );
+    if( pExport->bReleased && pExport->nComplete == pExport->nJobs )
+        freeExport( pExport );
+}
+
+/*!     \brief  No more jobs will be added to the export
+ *
+ * The export is freed when its jobs are complete.
+ * Called from the main loop.
+ *
+ * \param  pExport  the export
+ */
+void
+releaseExport( tExport *pExport ) {
+    pExport->bReleased = TRUE;
+    pExport->pPrintOp = NULL;
+    if( pExport->nComplete == pExport->nJobs )
+        freeExport( pExport );
+}
+
+/*!     \brief  Has the export been cancelled
+ *
+ * \param  pExport  the export
+ * \return          TRUE if cancelled
+ */
+gboolean
+isExportCancelled( tExport *pExport ) {
+    return g_atomic_int_get( &pExport->bCancel );
+}
+
+/*!     \brief  Cancel the exports in progress
+ *
+ * Called from the main loop.
+ *
+ * \return          number of exports cancelled
+ */
+gint
+cancelExports( void ) {
+    gint nCancelled = 0;
+
+    for( GList *l = activeExports; l != NULL; l = l->next ) {
+        tExport *pExport = (tExport *)l->data;
+
+        if( isExportCancelled( pExport ) )
+            continue;
+        g_atomic_int_set( &pExport->bCancel, TRUE );
+        if( pExport->pPrintOp )
+            gtk_print_operation_cancel( pExport->pPrintOp );
+        nCancelled++;
+    }
+    return nCancelled;
+}
+
+/*!     \brief  Cancel the exports and wait for the workers to finish
+ *
+ * Called on shutdown.
+ */
+void
+stopExportWorkers( void ) {
+    cancelExports();
+    if( exportPool )
+        g_thread_pool_free( g_steal_pointer( &exportPool ), FALSE, TRUE );
+}
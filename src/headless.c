@@ -0,0 +1,432 @@
+/*
+ * Copyright (c) 2026 Michael G. Katzmann
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/*! \file headless.c
+ * Batch (headless) operation for automated test stations.
+ *
+ * With --batch=<job file> the program does not create the application window
+ * (GTK is not initialized). The jobs in the file are run in order and the
+ * program exits with a status indicating success or failure.
+ *
+ * Each line of the job file is a command and (for most) an argument:
+ *
+ *      # comment
+ *      project     <project>       select the project for the following jobs
+ *      recall-cal  <profile>       send a saved setup & calibration to the HP8753
+ *      save-cal    <profile>       save the HP8753 setup & calibration
+ *      capture                     retrieve the trace(s) from the HP8753
+ *      recall-trace <profile>      recover a saved trace profile
+ *      title       <text>          title of the trace(s)
+ *      note        <text>          note saved with the trace profile
+ *      save-trace  <profile>       save the trace(s) as a trace profile
+ *      s2p         <file>          measure all S-parameters and write a Touchstone file
+ *      s1p         <file>          measure S11 or S22 and write a Touchstone file
+ *      csv         <file>          write the trace(s) as comma separated values
+ *      pdf | svg | png <file>      write the plot(s)
+ *      render-project pdf <file> [<search>]
+ *      render-project svg | png <directory> [<search>]
+ *                                  render every trace profile of the project (or those
+ *                                  matching the search text) to a PDF report or to files
+ *
+ * The HP8753 is addressed using the same commands to the GPIB thread as the
+ * GUI. Replies are taken directly from the message queue rather than by the
+ * main loop's event source (which updates the widgets).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib-2.0/glib.h>
+#include <gtk/gtk.h>
+
+#include "hp8753.h"
+#include "messageEvent.h"
+
+#define BATCH_JOB_FAILED    1   // exit status if a job fails
+#define BATCH_FILE_INVALID  2   // exit status if the job file cannot be read or is in error
+
+static gboolean bBatchQuiet = FALSE;
+
+/*!     \brief  Handle the messages posted to the main loop
+ *
+ * Information is printed on stdout (unless quiet) and errors on stderr.
+ * Data posted by the GPIB thread (calibration, S2P & S1P) is saved.
+ * If waiting for the GPIB thread, this returns when it has completed the command
+ * otherwise the messages already queued are handled.
+ *
+ * \param  pGlobal      pointer to global data
+ * \param  bWaitForGPIB wait for TM_COMPLETE_GPIB
+ * \return              number of errors reported
+ */
+static gint
+batchMessages( tGlobal *pGlobal, gboolean bWaitForGPIB ) {
+    messageEventData *message;
+    gboolean bComplete = !bWaitForGPIB;
+    gint nErrors = 0;
+
+    while( (message = bComplete ? g_async_queue_try_pop( pGlobal->messageQueueToMain )
+                                : g_async_queue_pop( pGlobal->messageQueueToMain )) ) {
+        switch( message->command ) {
+        case TM_INFO:
+        case TM_INFO_HIGHLIGHT:
+            if( !bBatchQuiet )
+                g_print( "    %s\n", message->sMessage );
+            break;
+        case TM_ERROR:
+            g_printerr( "    error: %s\n", message->sMessage );
+            nErrors++;
+            break;
+        case TM_SAVE_SETUPandCAL:
+            if( saveCalibrationAndSetup( pGlobal, pGlobal->sProject, (gchar *)message->data ) == ERROR )
+                nErrors++;
+            g_free( message->data );
+            break;
+        case TM_SAVE_LEARN_STRING_ANALYSIS:
+            saveLearnStringAnalysis( pGlobal, (tLearnStringIndexes *)message->data );
+            break;
+        case TM_SAVE_S2P:
+        case TM_SAVE_S1P:
+            if( (message->command == TM_SAVE_S2P ? writeS2Pfile : writeS1Pfile)( pGlobal, message->data ) != OK ) {
+                g_printerr( "    error: cannot write: %s\n", (gchar *)message->data );
+                nErrors++;
+            }
+            g_free( message->data );
+            break;
+        case TM_COMPLETE_GPIB:
+            bComplete = TRUE;
+            break;
+        case TM_REFRESH_TRACE:
+        default:
+            break;
+        }
+        g_free( message->sMessage );
+        g_free( message );
+    }
+
+    return nErrors;
+}
+
+/*!     \brief  Have the GPIB thread perform a command and wait for it to complete
+ *
+ * \param  pGlobal      pointer to global data
+ * \param  command      TG_ command
+ * \param  data         allocated data for the command (freed by the GPIB thread) or NULL
+ * \return              OK or ERROR if any error was reported
+ */
+static gint
+batchGPIBcommand( tGlobal *pGlobal, enum _threadmessage command, gpointer data ) {
+    postDataToGPIBThread( command, data );
+    return batchMessages( pGlobal, TRUE ) == 0 ? OK : ERROR;
+}
+
+static gint
+jobProject( tGlobal *pGlobal, gchar *sArgument ) {
+    g_free( pGlobal->sProject );
+    pGlobal->sProject = g_strdup( sArgument );
+    return OK;
+}
+
+static gint
+jobRecallCal( tGlobal *pGlobal, gchar *sArgument ) {
+    if( recoverCalibrationAndSetup( pGlobal, pGlobal->sProject, sArgument ) != TRUE ) {
+        g_printerr( "    error: no calibration profile '%s' in project '%s'\n", sArgument, pGlobal->sProject );
+        return ERROR;
+    }
+    return batchGPIBcommand( pGlobal, TG_SEND_SETUPandCAL_to_HP8753, NULL );
+}
+
+static gint
+jobSaveCal( tGlobal *pGlobal, gchar *sArgument ) {
+    return batchGPIBcommand( pGlobal, TG_RETRIEVE_SETUPandCAL_from_HP8753, g_strdup( sArgument ) );
+}
+
+static gint
+jobCapture( tGlobal *pGlobal, gchar *sArgument ) {
+    if( batchGPIBcommand( pGlobal, TG_RETRIEVE_TRACE_from_HP8753, NULL ) != OK )
+        return ERROR;
+    return pGlobal->HP8753.channels[ eCH_ONE ].chFlags.bValidData ? OK : ERROR;
+}
+
+static gint
+jobRecallTrace( tGlobal *pGlobal, gchar *sArgument ) {
+    if( recoverTraceData( pGlobal, pGlobal->sProject, sArgument ) != TRUE ) {
+        g_printerr( "    error: no trace profile '%s' in project '%s'\n", sArgument, pGlobal->sProject );
+        return ERROR;
+    }
+    return OK;
+}
+
+static gint
+jobTitle( tGlobal *pGlobal, gchar *sArgument ) {
+    g_free( pGlobal->HP8753.sTitle );
+    pGlobal->HP8753.sTitle = g_strdup( sArgument );
+    return OK;
+}
+
+static gint
+jobNote( tGlobal *pGlobal, gchar *sArgument ) {
+    g_free( pGlobal->HP8753.sNote );
+    pGlobal->HP8753.sNote = g_strdup( sArgument );
+    return OK;
+}
+
+static gint
+jobSaveTrace( tGlobal *pGlobal, gchar *sArgument ) {
+    if( !pGlobal->HP8753.channels[ eCH_ONE ].chFlags.bValidData ) {
+        g_printerr( "    error: no trace data to save\n" );
+        return ERROR;
+    }
+    return saveTraceData( pGlobal, pGlobal->sProject, sArgument ) == ERROR ? ERROR : OK;
+}
+
+static gint
+jobS2P( tGlobal *pGlobal, gchar *sArgument ) {
+    return batchGPIBcommand( pGlobal, TG_MEASURE_and_RETRIEVE_S2P_from_HP8753, g_strdup( sArgument ) );
+}
+
+static gint
+jobS1P( tGlobal *pGlobal, gchar *sArgument ) {
+    return batchGPIBcommand( pGlobal, TG_MEASURE_and_RETRIEVE_S1P_from_HP8753, g_strdup( sArgument ) );
+}
+
+static gint
+jobTraceFile( tGlobal *pGlobal, gchar *sArgument, tFileType fileType ) {
+    gint rtn;
+
+    if( !pGlobal->HP8753.channels[ eCH_ONE ].chFlags.bValidData ) {
+        g_printerr( "    error: no trace data to export\n" );
+        return ERROR;
+    }
+    if( fileType == eCSV )
+        rtn = writeCSVfile( pGlobal, sArgument );
+    else
+        rtn = writePlotFile( pGlobal, sArgument, fileType );
+    if( rtn != OK )
+        g_printerr( "    error: cannot write: %s\n", sArgument );
+    return rtn;
+}
+
+static gint jobCSV( tGlobal *pGlobal, gchar *sArgument ) { return jobTraceFile( pGlobal, sArgument, eCSV ); }
+static gint jobPDF( tGlobal *pGlobal, gchar *sArgument ) { return jobTraceFile( pGlobal, sArgument, ePDF ); }
+static gint jobSVG( tGlobal *pGlobal, gchar *sArgument ) { return jobTraceFile( pGlobal, sArgument, eSVG ); }
+static gint jobPNG( tGlobal *pGlobal, gchar *sArgument ) { return jobTraceFile( pGlobal, sArgument, ePNG ); }
+
+static gint
+jobRenderProject( tGlobal *pGlobal, gchar *sArgument ) {
+    static const gchar *sFileTypes[] = { "pdf", "svg", "png" };
+    gchar **sArgs = NULL, *sSearch = NULL;
+    GError *err = NULL;
+    gint argc, rtn = ERROR;
+    tFileType fileType;
+
+    // the file or directory may be quoted
+    if( !g_shell_parse_argv( sArgument, &argc, &sArgs, &err ) ) {
+        g_printerr( "    error: %s\n", err->message );
+        g_clear_error( &err );
+        return ERROR;
+    }
+    for( fileType = ePDF; fileType <= ePNG; fileType++ )
+        if( g_ascii_strcasecmp( sArgs[ 0 ], sFileTypes[ fileType ] ) == 0 )
+            break;
+    if( fileType > ePNG || argc < 2 ) {
+        g_printerr( "    error: expected pdf <file>, svg <directory> or png <directory>\n" );
+    } else {
+        if( argc > 2 )
+            sSearch = g_strjoinv( " ", &sArgs[ 2 ] );
+        rtn = renderProject( pGlobal, pGlobal->sProject, fileType, sArgs[ 1 ], sSearch );
+        g_free( sSearch );
+    }
+    g_strfreev( sArgs );
+    return rtn;
+}
+
+static const struct {
+    gchar    *sCommand;
+    gboolean bArgument;     // an argument is required
+    gboolean bGPIB;         // the HP8753 is addressed
+    gint     (*job)( tGlobal *, gchar * );
+} batchJobs[] = {
+    { "project",      TRUE,  FALSE, jobProject },
+    { "recall-cal",   TRUE,  TRUE,  jobRecallCal },
+    { "save-cal",     TRUE,  TRUE,  jobSaveCal },
+    { "capture",      FALSE, TRUE,  jobCapture },
+    { "recall-trace", TRUE,  FALSE, jobRecallTrace },
+    { "title",        FALSE, FALSE, jobTitle },
+    { "note",         FALSE, FALSE, jobNote },
+    { "save-trace",   TRUE,  FALSE, jobSaveTrace },
+    { "s2p",          TRUE,  TRUE,  jobS2P },
+    { "s1p",          TRUE,  TRUE,  jobS1P },
+    { "csv",          TRUE,  FALSE, jobCSV },
+    { "pdf",          TRUE,  FALSE, jobPDF },
+    { "svg",          TRUE,  FALSE, jobSVG },
+    { "png",          TRUE,  FALSE, jobPNG },
+    { "render-project", TRUE, FALSE, jobRenderProject }
+};
+
+typedef struct {
+    gint    lineNo;
+    gint    jobIndex;
+    gchar   *sArgument;
+} tBatchStep;
+
+/*!     \brief  Read and check the job file
+ *
+ * All of the file is checked before any job is run.
+ *
+ * \param  sJobFile     name of the job file
+ * \param  pbGPIB       pointer to return whether any job addresses the HP8753
+ * \return              array of tBatchStep or NULL if the file is in error
+ */
+static GArray *
+readBatchJobs( const gchar *sJobFile, gboolean *pbGPIB ) {
+    gchar *sContents = NULL, **sLines;
+    GError *err = NULL;
+    GArray *pSteps;
+    gboolean bValid = TRUE;
+
+    if( !g_file_get_contents( sJobFile, &sContents, NULL, &err ) ) {
+        g_printerr( "%s\n", err->message );
+        g_clear_error( &err );
+        return NULL;
+    }
+
+    *pbGPIB = FALSE;
+    pSteps = g_array_new( FALSE, TRUE, sizeof( tBatchStep ) );
+    sLines = g_strsplit( sContents, "\n", -1 );
+    for( gint line = 0; sLines[ line ] != NULL; line++ ) {
+        gchar *sLine = g_strstrip( sLines[ line ] ), *sArgument;
+        guint i;
+
+        if( *sLine == 0 || *sLine == '#' )
+            continue;
+        sArgument = sLine + strcspn( sLine, " \t" );
+        if( *sArgument ) {
+            *sArgument++ = 0;
+            sArgument = g_strchug( sArgument );
+        }
+
+        for( i = 0; i < G_N_ELEMENTS( batchJobs ); i++ )
+            if( g_strcmp0( sLine, batchJobs[ i ].sCommand ) == 0 )
+                break;
+        if( i == G_N_ELEMENTS( batchJobs ) ) {
+            g_printerr( "%s:%d: unknown command '%s'\n", sJobFile, line + 1, sLine );
+            bValid = FALSE;
+        } else if( batchJobs[ i ].bArgument && *sArgument == 0 ) {
+            g_printerr( "%s:%d: '%s' requires an argument\n", sJobFile, line + 1, sLine );
+            bValid = FALSE;
+        } else {
+            tBatchStep step = { .lineNo = line + 1, .jobIndex = i, .sArgument = g_strdup( sArgument ) };
+            g_array_append_val( pSteps, step );
+            *pbGPIB |= batchJobs[ i ].bGPIB;
+        }
+    }
+    g_strfreev( sLines );
+    g_free( sContents );
+
+    if( !bValid ) {
+        for( guint i = 0; i < pSteps->len; i++ )
+            g_free( g_array_index( pSteps, tBatchStep, i ).sArgument );
+        g_array_free( pSteps, TRUE );
+        return NULL;
+    }
+    return pSteps;
+}
+
+/*!     \brief  Run the jobs in a job file without the GUI
+ *
+ * The database and program options are those of the GUI (the GPIB interface,
+ * plot options and colors). The options are not saved on completion.
+ * The jobs are run in order until one fails.
+ *
+ * \param  pGlobal      pointer to global data
+ * \param  sJobFile     name of the job file
+ * \param  bQuiet       do not print progress
+ * \return              exit status: EXIT_SUCCESS, BATCH_JOB_FAILED or BATCH_FILE_INVALID
+ */
+gint
+runBatchJobs( tGlobal *pGlobal, const gchar *sJobFile, gboolean bQuiet ) {
+    GArray *pSteps;
+    gboolean bGPIB = FALSE;
+    gint status = EXIT_SUCCESS;
+
+    bBatchQuiet = bQuiet;
+    if( (pSteps = readBatchJobs( sJobFile, &bGPIB )) == NULL )
+        return BATCH_FILE_INVALID;
+
+    LOG(G_LOG_LEVEL_INFO, "Starting batch");
+    setenv ("IB_NO_ERROR", "1", 0);	// no noise
+    logVersion ();
+
+    pGlobal->messageQueueToMain = g_async_queue_new();
+    pGlobal->messageQueueToGPIB = g_async_queue_new();
+    clearHP8753traces( &pGlobal->HP8753 );
+
+    for( int i=0; i < NUM_HPGL_PENS; i++ ) {
+        HPGLpens[ i ] = HPGLpensFactory[ i ];
+    }
+    for( int i=0; i < eMAX_COLORS; i++ ) {
+        plotElementColors[ i ] = plotElementColorsFactory[ i ];
+    }
+    pGlobal->PDFpaperSize = eLetter;
+    pGlobal->flags.bSmithSpline = TRUE;
+    pGlobal->flags.bShowDateTime = TRUE;
+    pGlobal->flags.bHPlogo = TRUE;
+
+    if( openOrCreateDB() != 0 ) {
+        g_printerr( "Cannot open the database\n" );
+        status = BATCH_JOB_FAILED;
+        goto cleanup;
+    }
+    if( recoverProgramOptions( pGlobal ) != TRUE && bGPIB )
+        g_printerr( "No saved GPIB settings (configure the interface using the GUI)\n" );
+    batchMessages( pGlobal, FALSE );
+
+    if( bGPIB )
+        pGlobal->pGThread = g_thread_new( "GPIBthread", threadGPIB, (gpointer)pGlobal );
+
+    for( guint i = 0; i < pSteps->len; i++ ) {
+        tBatchStep *pStep = &g_array_index( pSteps, tBatchStep, i );
+
+        if( !bBatchQuiet )
+            g_print( "%s:%d: %s %s\n", sJobFile, pStep->lineNo,
+                    batchJobs[ pStep->jobIndex ].sCommand, pStep->sArgument );
+        if( batchJobs[ pStep->jobIndex ].job( pGlobal, pStep->sArgument ) != OK
+                || batchMessages( pGlobal, FALSE ) != 0 ) {
+            g_printerr( "%s:%d: '%s' failed\n", sJobFile, pStep->lineNo,
+                    batchJobs[ pStep->jobIndex ].sCommand );
+            status = BATCH_JOB_FAILED;
+            break;
+        }
+    }
+
+    if( pGlobal->pGThread ) {
+        postDataToGPIBThread( TG_END, NULL );
+        g_thread_join( g_steal_pointer( &pGlobal->pGThread ) );
+    }
+    closeDB();
+
+cleanup:
+    batchMessages( pGlobal, FALSE );
+    for( guint i = 0; i < pSteps->len; i++ )
+        g_free( g_array_index( pSteps, tBatchStep, i ).sArgument );
+    g_array_free( pSteps, TRUE );
+
+    g_async_queue_unref( pGlobal->messageQueueToMain );
+    g_async_queue_unref( pGlobal->messageQueueToGPIB );
+
+    LOG(G_LOG_LEVEL_INFO, "Ending batch (status %d)", status);
+    return status;
+}
@@ -16,6 +16,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <unistd.h>
 #include <glib-2.0/glib.h>
 #include <gtk/gtk.h>
@@ -30,11 +31,17 @@
 #include "hp8753.h"
 #include "widgetID.h"
 #include "messageEvent.h"
+#include "HPGLplot.h"
+#include "exportWorker.h"
 
 tGlobal globalData = {
 		.HP8753 = {.flags = {.bSourceCoupled = 1, .bMarkersCoupled = 1}},
 		.HP8753cal = {{0}},
 		.HP8753calibrationKit = {{0}},
+		.calCatalog = { .projectAndNameOffset = offsetof( tHP8753cal, projectAndName ) },
+		.traceCatalog = { .projectAndNameOffset = offsetof( tHP8753traceAbstract, projectAndName ) },
+		.plotElementColors = plotElementColors,
+		.HPGLpens = HPGLpens,
 		.flags ={0},
 		0 };
 
@@ -44,6 +51,14 @@ static gint     optDebug = INVALID;
 static gboolean bOptStandardLogging = FALSE;
 static gboolean bOptQuiet = 0;
 static gboolean bOptNoGPIBtimeout = 0;
+static gboolean bOptProfileStartup = FALSE;
+static gchar    *sOptBatchFile = NULL;
+static gboolean bOptServer = FALSE;
+static gint     optServerPort = 0;
+static gboolean bOptSharedMemory = FALSE;
+static gint     optLiveViewPort = 0;
+static gchar    **sOptBenchmarkHPGL = NULL;
+static gchar    *sOptBenchmarkRender = NULL;
 
 static gchar    **argsRemainder = NULL;
 
@@ -54,13 +69,123 @@ static const GOptionEntry optionEntries[] =
   { "stderrLogging",            's', G_OPTION_FLAG_NONE, G_OPTION_ARG_NONE,
 			&bOptStandardLogging, "Send log data to the default device (usually stdout/stderr) rather than the journal", NULL },
   { "quiet",           'q', 0, G_OPTION_ARG_NONE,
-          &bOptQuiet, "No GUI sounds", NULL },
+          &bOptQuiet, "No GUI sounds (no progress messages with --batch)", NULL },
   { "noGPIBtimeout",   't', 0, G_OPTION_ARG_NONE,
 		  &bOptNoGPIBtimeout, "no GPIB timeout (for debug with HP59401A)", NULL },
+  { "profile-startup", 0, 0, G_OPTION_ARG_NONE,
+          &bOptProfileStartup, "Print the time taken by each phase of startup", NULL },
+  { "batch",           'b', 0, G_OPTION_ARG_FILENAME,
+          &sOptBatchFile, "Run the jobs in the file without the GUI (exit status 0 on success, 1 if a job fails, 2 if the file is in error)", "JOBFILE" },
+  { "server",          0, 0, G_OPTION_ARG_NONE,
+          &bOptServer, "Share the HP8753 with local clients through the socket $XDG_RUNTIME_DIR/hp8753.socket", NULL },
+  { "server-port",     0, 0, G_OPTION_ARG_INT,
+          &optServerPort, "Also share the HP8753 through this TCP port on the loopback interface", "PORT" },
+  { "shared-memory",   0, 0, G_OPTION_ARG_NONE,
+          &bOptSharedMemory, "Publish each capture to the shared memory object /hp8753-capture", NULL },
+  { "live-view-port",  0, 0, G_OPTION_ARG_INT,
+          &optLiveViewPort, "Serve a web page showing the captures on this TCP port", "PORT" },
+  { "benchmark-hpgl",  0, 0, G_OPTION_ARG_FILENAME_ARRAY,
+          &sOptBenchmarkHPGL, "Time the parse of a captured OUTPPLOT stream (as echoed with --debug 6), check it compiles the same when split, and exit", "FILE" },
+  { "benchmark-render", 0, 0, G_OPTION_ARG_FILENAME,
+          &sOptBenchmarkRender, "Time the rendering of each type of plot offscreen, write the results as JSON ('-' for stdout) and exit", "FILE" },
   { G_OPTION_REMAINING, 0, 0, G_OPTION_ARG_STRING_ARRAY, &argsRemainder, "", NULL },
   { NULL }
 };
 
+static gint64   startupEpoch = 0;       // monotonic time (us) at the start of main()
+static gboolean bOpenGPIBatStartup = FALSE; // GPIB interface options were recovered
+
+/*!     \brief  Note the completion of a phase of startup
+ *
+ * With --profile-startup the time since the program started and since the
+ * previous phase is printed.
+ *
+ * \param  sPhase       description of the phase just completed
+ */
+static void
+startupPhase( const gchar *sPhase ) {
+    static gint64 previous = 0;
+    gint64 now;
+
+    if( !bOptProfileStartup )
+        return;
+    now = g_get_monotonic_time();
+    if( previous == 0 )
+        previous = startupEpoch;
+    g_print( "startup: %-40s %8.1f ms  (+%.1f ms)\n", sPhase,
+            (now - startupEpoch) / 1000.0, (now - previous) / 1000.0 );
+    previous = now;
+}
+
+/*!     \brief  Tick callback on the first frame of the main window
+ *
+ * \param  wWindow      main window
+ * \param  frameClock   frame clock
+ * \param  udata        unused
+ * \return              G_SOURCE_REMOVE (only the first frame is of interest)
+ */
+static gboolean
+CB_firstFrame( GtkWidget *wWindow, GdkFrameClock *frameClock, gpointer udata ) {
+    startupPhase( "first frame of main window" );
+    return G_SOURCE_REMOVE;
+}
+
+/*!     \brief  Read the profiles of the other projects in the background
+ *
+ * Idle callback. The profiles of one project are read on each call so the
+ * user interface remains responsive. (A project not yet read when it is selected
+ * is read then, see inventoryProject.)
+ *
+ * \param  pGlobal      pointer to global data
+ * \return              G_SOURCE_CONTINUE until all projects are read
+ */
+static gboolean
+idleInventoryOtherProjects( tGlobal *pGlobal ) {
+    static gint nProjects = 0;
+
+    for( GList *l = pGlobal->pProjectList; l != NULL; l = l->next ) {
+        if( !catalogIsProjectLoaded( &pGlobal->calCatalog, l->data )
+                || !catalogIsProjectLoaded( &pGlobal->traceCatalog, l->data ) ) {
+            if( inventoryProject( pGlobal, l->data ) != OK )
+                break;
+            nProjects++;
+            return G_SOURCE_CONTINUE;
+        }
+    }
+
+    if( bOptProfileStartup ) {
+        gchar *sPhase = g_strdup_printf( "profiles of %d other project%s read", nProjects, nProjects == 1 ? "" : "s" );
+        startupPhase( sPhase );
+        g_free( sPhase );
+    }
+    return G_SOURCE_REMOVE;
+}
+
+/*!     \brief  Complete startup once the main window is showing
+ *
+ * Idle callback (run once). Reads what is not needed to show the current
+ * project, starts the GPIB thread and, if an interface has been configured,
+ * has the thread open it.
+ *
+ * \param  pGlobal      pointer to global data
+ * \return              G_SOURCE_REMOVE
+ */
+static gboolean
+idleDeferredStartup( tGlobal *pGlobal ) {
+    inventorySavedCalibrationKits( pGlobal );
+    initializeNotebookPageCalKit( pGlobal, eUpdateWidgets );
+    startupPhase( "calibration kits read" );
+
+    // Start the GPIB communication thread (messages posted before this are queued)
+    pGlobal->pGThread = g_thread_new( "GPIBthread", threadGPIB, (gpointer)pGlobal );
+    if( bOpenGPIBatStartup )
+        postDataToGPIBThread( TG_SETUP_GPIB, NULL );
+    startupPhase( "GPIB thread started" );
+
+    g_idle_add_full( G_PRIORITY_LOW, (GSourceFunc)idleInventoryOtherProjects, pGlobal, NULL );
+    return G_SOURCE_REMOVE;
+}
+
 /*!     \brief  Initialize widgets
  *
  * Initialize GTK Widgets from data
@@ -92,6 +217,9 @@ initializeWidgets (tGlobal *pGlobal) {
 
     initializeRenameDialog( pGlobal, eInitCallbacks );
     initializeRenameDialog( pGlobal, eUpdateWidgets );
+
+    initializeProfileBrowser( pGlobal, eUpdateWidgets );
+    initializeProfileBrowser( pGlobal, eInitCallbacks );
 }
 
 
@@ -173,6 +301,9 @@ on_activate (GApplication *app, gpointer udata)
     gtk_widget_set_visible (wApplicationWindow, TRUE);
     gtk_application_add_window (GTK_APPLICATION(app), GTK_WINDOW(wApplicationWindow));
     gtk_window_set_icon_name (GTK_WINDOW(wApplicationWindow), "hp8753");
+    if( bOptProfileStartup )
+        gtk_widget_add_tick_callback( wApplicationWindow, CB_firstFrame, NULL, NULL );
+    startupPhase( "main window built" );
 
     pGlobal->flags.bSmithSpline = TRUE;
     pGlobal->flags.bShowDateTime = TRUE;
@@ -183,6 +314,8 @@ on_activate (GApplication *app, gpointer udata)
         // ... but I don't know what that might be!
         bShowGPIBtab = TRUE;
     }
+    bOpenGPIBatStartup = !bShowGPIBtab;
+    startupPhase( "program options recovered" );
 
     gtk_window_set_title( GTK_WINDOW( wApplicationWindow ), "HP8753 Companion");
     gtk_label_set_text( GTK_LABEL( pGlobal->widgets[ ew_label_Title ] ), "HP8753 Companion" );
@@ -197,11 +330,12 @@ on_activate (GApplication *app, gpointer udata)
     gtk_label_set_text( GTK_LABEL( pGlobal->widgets[ ew_label_Title ] ), sWindowTitle );
     g_free( sWindowTitle );
 
-    // Get cal and trace profiles from sqlite3 database
+    // Get the cal and trace profiles of the current project from sqlite3 database
+    // (the calibration kits and the other projects are read once the window is showing)
     inventoryProjects( pGlobal );
     inventorySavedSetupsAndCal( pGlobal );
     inventorySavedTraceNames( pGlobal );
-    inventorySavedCalibrationKits( pGlobal );
+    startupPhase( "current project read" );
 
     // set the title initially to that of the last trace saved
     if( pGlobal->pTraceAbstract != NULL )
@@ -212,6 +346,7 @@ on_activate (GApplication *app, gpointer udata)
     populateTraceComboBoxWidget( pGlobal );
 
     initializeWidgets (pGlobal);
+    startupPhase( "widgets initialized" );
 
     if( bShowGPIBtab )
         gtk_notebook_set_current_page ( GTK_NOTEBOOK( pGlobal->widgets[ eW_notebook ] ), NPAGE_GPIB );
@@ -219,8 +354,8 @@ on_activate (GApplication *app, gpointer udata)
         gtk_notebook_set_current_page ( GTK_NOTEBOOK( pGlobal->widgets[ eW_notebook ] ),
                     pGlobal->flags.bCalibrationOrTrace ? NPAGE_CALIBRATION : NPAGE_TRACE );
 
-    // Start the GPIB communication thread
-    pGlobal->pGThread = g_thread_new( "GPIBthread", threadGPIB, (gpointer)pGlobal );
+    // Finish off once the window has been drawn
+    g_idle_add_full( G_PRIORITY_DEFAULT_IDLE, (GSourceFunc)idleDeferredStartup, pGlobal, NULL );
 
     // Somehow we loose focus in something we've done.
     // We regain focus so that the keyboard will be active (F1 etc).
@@ -268,6 +403,16 @@ on_startup (GApplication *app, gpointer udata)
     clearHP8753traces( &pGlobal->HP8753 );
 
     openOrCreateDB();
+    startupPhase( "database opened" );
+
+    // Export the acquisition commands on the session bus
+    initializeAutomation( pGlobal, app );
+    // Share the analyzer with local clients (line protocol on a socket)
+    startSocketServer( pGlobal, bOptServer, optServerPort );
+    if( bOptSharedMemory )
+        openCaptureSharedMemory();
+    // Stream the captures to web browsers
+    startLiveViewServer( pGlobal, optLiveViewPort );
 
     for( int i=0; i < NUM_HPGL_PENS; i++ ) {
         HPGLpens[ i ] = HPGLpensFactory[ i ];
@@ -292,6 +437,10 @@ on_shutdown (GApplication *app, gpointer userData)
 {
 	tGlobal *pGlobal = (tGlobal *)userData;
 
+	finalizeAutomation( pGlobal );
+	stopExportWorkers();
+	stopSocketServer();
+	stopLiveViewServer();
 	saveProgramOptions( pGlobal );
 	closeDB();
 
@@ -304,11 +453,14 @@ on_shutdown (GApplication *app, gpointer userData)
         g_thread_join (pGlobal->pGThread);
         g_thread_unref (pGlobal->pGThread);
     }
+    closeCaptureSharedMemory();
 
     g_list_free_full ( g_steal_pointer (&pGlobal->pProjectList), (GDestroyNotify)g_free );
     g_list_free_full ( g_steal_pointer (&pGlobal->pTraceList), (GDestroyNotify)freeTraceListItem );
     g_list_free_full ( g_steal_pointer (&pGlobal->pCalList), (GDestroyNotify)freeCalListItem );
     g_list_free_full ( g_steal_pointer (&pGlobal->pCalKitList), (GDestroyNotify)freeCalKitIdentifierItem );
+    catalogFree( &pGlobal->calCatalog );
+    catalogFree( &pGlobal->traceCatalog );
 
     g_free( pGlobal->HP8753cal.pHP8753_learn );
     g_free( pGlobal->sLastDirectory );
@@ -319,6 +471,7 @@ on_shutdown (GApplication *app, gpointer userData)
             g_free( pGlobal->HP8753cal.perChannelCal[channel].pCalArrays[i] );
         g_free( pGlobal->HP8753.channels[ channel ].responsePoints );
         g_free( pGlobal->HP8753.channels[ channel ].stimulusPoints );
+        clearDerivedTraceData( &pGlobal->HP8753.channels[ channel ] );
     }
 
     g_free( pGlobal->HP8753.S2P.freq );
@@ -396,6 +549,7 @@ main(int argc, char *argv[]) {
 
     GMainLoop __attribute__((unused)) *loop;
 
+    startupEpoch = g_get_monotonic_time();
     setlocale(LC_ALL, "en_US");
     setenv("IB_NO_ERROR", "1", 0);	// no noise for GPIB library
     g_log_set_writer_func (filtered_log_writer_journald, (gpointer)&globalData, NULL);
@@ -403,6 +557,36 @@ main(int argc, char *argv[]) {
     // g_log_set_handler(G_LOG_DOMAIN, G_LOG_LEVEL_INFO, g_log_default_handler, NULL);
     // gtk_set_debug_flags( 0 );
 
+    // A batch run does not create the application (GTK is not initialized)
+    // so the options are checked before the application parses them
+    {
+        GOptionContext *context = g_option_context_new( NULL );
+        gchar **args = g_strdupv( argv );
+
+        g_option_context_add_main_entries( context, optionEntries, NULL );
+        g_option_context_set_help_enabled( context, FALSE );
+        g_option_context_set_ignore_unknown_options( context, TRUE );
+        g_option_context_parse_strv( context, &args, NULL );
+        g_option_context_free( context );
+        g_strfreev( args );
+    }
+#define HPGL_BENCHMARK_REPEAT   200
+    if( sOptBenchmarkHPGL )
+        return benchmarkHPGLparser( sOptBenchmarkHPGL, HPGL_BENCHMARK_REPEAT );
+    if( sOptBenchmarkRender )
+        return runRenderBenchmark( &globalData, sOptBenchmarkRender );
+    if( sOptBatchFile ) {
+        gint exitStatus;
+
+        globalData.flags.bNoGPIBtimeout = bOptNoGPIBtimeout;
+        globalData.flags.bbDebug = optDebug < 8 ? optDebug : 7;
+        if( bOptSharedMemory )
+            openCaptureSharedMemory();
+        exitStatus = runBatchJobs( &globalData, sOptBatchFile, bOptQuiet );
+        closeCaptureSharedMemory();
+        return exitStatus;
+    }
+
     // ensure only one instance of program runs ..
     app = gtk_application_new ("us.heterodyne.HP8753", G_APPLICATION_HANDLES_OPEN);
     g_application_add_main_option_entries (G_APPLICATION ( app ), optionEntries);
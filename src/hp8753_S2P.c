@@ -244,3 +244,71 @@ getHP3753_S1P( tGPIBinterface *pGPIBinterface, tGlobal *pGlobal )
 err:
     return ERROR;
 }
+
+/*!     \brief  Write the retrieved S-paramaters to a Touchstone S2P file
+ *
+ * \param  pGlobal          Gloabl data (holding the S2P data from getHP3753_S2P)
+ * \param  sFilename        name of the file to write
+ * \return OK on success or ERROR if the file cannot be written
+ */
+gint
+writeS2Pfile( tGlobal *pGlobal, const gchar *sFilename )
+{
+    FILE *fSXP;
+
+    if( (fSXP = fopen( sFilename, "w" )) == NULL )
+        return ERROR;
+
+    fprintf( fSXP, "! 2-port S-paramater data, multiple frequency points\n"
+            "! from HP8753 Network analyzer\n"
+            "# MHz S RI R 50.0\n"
+            "! freq\tReS11\tImS11\tReS21\tImS21\tReS12\tImS12\tReS22\tImS22\n" );
+    for( gint i=0; i < pGlobal->HP8753.S2P.nPoints; i++ ) {
+        fprintf( fSXP, "%.16lg\t%.16lg\t%.16lg\t%.16lg\t%.16lg\t%.16lg\t%.16lg\t%.16lg\t%.16lg\n",
+                pGlobal->HP8753.S2P.freq[i]/1.0e6,
+                pGlobal->HP8753.S2P.S11[i].r, pGlobal->HP8753.S2P.S11[i].i,
+                pGlobal->HP8753.S2P.S21[i].r, pGlobal->HP8753.S2P.S21[i].i,
+                pGlobal->HP8753.S2P.S12[i].r, pGlobal->HP8753.S2P.S12[i].i,
+                pGlobal->HP8753.S2P.S22[i].r, pGlobal->HP8753.S2P.S22[i].i );
+    }
+    fclose( fSXP );
+
+    return OK;
+}
+
+/*!     \brief  Write the retrieved S-paramater to a Touchstone S1P file
+ *
+ * \param  pGlobal          Gloabl data (holding the S11 or S22 data from getHP3753_S1P)
+ * \param  sFilename        name of the file to write
+ * \return OK on success or ERROR if the file cannot be written
+ */
+gint
+writeS1Pfile( tGlobal *pGlobal, const gchar *sFilename )
+{
+    FILE *fSXP;
+
+    if( (fSXP = fopen( sFilename, "w" )) == NULL )
+        return ERROR;
+
+    fprintf( fSXP, "! 1-port S-paramater data, multiple frequency points\n"
+            "! from HP8753 Network analyzer\n"
+            "# MHz S RI R 50.0\n" );
+    if( pGlobal->HP8753.S2P.SnPtype == S1P_S11 ) {
+        fprintf( fSXP, "! freq\tReS11\tImS11\n"         );
+        for( gint i=0; i < pGlobal->HP8753.S2P.nPoints; i++ ) {
+            fprintf( fSXP, "%.16lg\t%.16lg\t%.16lg\n",
+                    pGlobal->HP8753.S2P.freq[i]/1.0e6,
+                    pGlobal->HP8753.S2P.S11[i].r, pGlobal->HP8753.S2P.S11[i].i );
+        }
+    } else {
+        fprintf( fSXP, "! freq\tReS22\tImS22\n" );
+        for( int i=0; i < pGlobal->HP8753.S2P.nPoints; i++ ) {
+            fprintf( fSXP, "%.16g\t%.16lg\t%.16lg\n",
+                    pGlobal->HP8753.S2P.freq[i]/1.0e6,
+                    pGlobal->HP8753.S2P.S22[i].r, pGlobal->HP8753.S2P.S22[i].i );
+        }
+    }
+    fclose( fSXP );
+
+    return OK;
+}
@@ -564,6 +564,7 @@ getHP8753markersAndSegments( tGPIBinterface *pGPIB_HP8753, tGlobal *pGlobal  ) {
                 pChannel->segments[ seg ].stopFreq =
                         pGlobal->HP8753.channels[ otherChannel ].segments[ seg ].stopFreq;
             }
+            indexSegments( pChannel );
 //            g_free( pChannel->stimulusPoints );
 //            pChannel->stimulusPoints = g_memdup2( pGlobal->HP8753.channels[ otherChannel ].stimulusPoints,
 //                    pGlobal->HP8753.channels[ otherChannel ].nPoints * sizeof( gdouble ) );
@@ -737,44 +738,31 @@ getHP8753channelTrace( tGPIBinterface *pGPIB_HP8753, tGlobal *pGlobal, eChannel
 
     pChannel->nPoints = sizeF2 / (sizeof(gint32) * 2);
     pChannel->responsePoints = g_realloc( pChannel->responsePoints, sizeof(tComplex) * sizeF2 );
-    pChannel->stimulusPoints = g_realloc( pChannel->stimulusPoints, sizeof(gdouble) * sizeF2 );
+    // The stimulus values are regenerated from the sweep settings when needed (see getStimulusPoints).
+    // This will be wrong for list sweep if we sweep all segments; therefore, they are set
+    //      in getHP8753channelListFreqSegments in that case.
+    //      The logial place to do it is here but to do so we must change the sweep to each of the segments
+    //      and this destroys the traces (both channels). We get the trace data for both channels first
+    //      and then get the segments in order to calculate the stimulus value for each point;
+    g_free( pChannel->stimulusPoints );
+    pChannel->stimulusPoints = NULL;
+    clearDerivedTraceData( pChannel );
 
-    gdouble logSweepStart = log10( pChannel->sweepStart );
-    gdouble logStimulusStop = log10( pChannel->sweepStop );
     for ( i = 0; i < pChannel->nPoints; i++) {
-        gdouble stimulusSample, stimulusFraction;
-
         rBits.bytes = GUINT32_FROM_BE( *(guint32* )(pFORM2 + i * sizeof(gint32) * 2));
         iBits.bytes = GUINT32_FROM_BE( *(guint32* )(pFORM2 + i * sizeof(gint32) * 2 + sizeof(gint32)));
         pChannel->responsePoints[i].r = rBits.IEEE754;
         pChannel->responsePoints[i].i = iBits.IEEE754;
         // g_print( "%3d : %15e + j %15e\n", i, trace->points[i].r, trace->points[i].i);
-
-        stimulusFraction = (gdouble) i / (pChannel->nPoints-1);
-
-        switch( pChannel->sweepType ) {
-        case eSWP_LSTFREQ:
-        case eSWP_LINFREQ:
-        case eSWP_CWTIME:
-        case eSWP_PWR:
-        default:
-            // n.b: 3 is the minimum number of points so this will not blow up
-            // This calculation will be wrong for list sweep if we sweep all segments; therefore, we redo this in
-            //      getHP8753markersAndSegments in that case.
-            //      The logial place to do it is here but to do so we must change the sweep to each of the segments
-            //      and this destroys the traces (both channels). We get the trace data for both channels first
-            //      and then get the segments in order to calculate the stimulus value for each point;
-            stimulusSample = pChannel->sweepStart + (pChannel->sweepStop - pChannel->sweepStart) * stimulusFraction;
-            break;
-        case eSWP_LOGFREQ:
-            stimulusSample = pow( 10.0,  logSweepStart + ( logStimulusStop - logSweepStart) * logStimulusStop );
-            break;
-        }
-        pChannel->stimulusPoints[i] = stimulusSample;
     }
 
-    if (pChannel->nPoints != 0 && !GPIBfailed( pGPIB_HP8753->status ))
+    if (pChannel->nPoints != 0 && !GPIBfailed( pGPIB_HP8753->status )) {
         pChannel->chFlags.bValidData = TRUE;
+        // calculated once here rather than on every redraw of a Smith or polar chart
+        // (the other formats do not use them)
+        if( pChannel->format == eFMT_SMITH || pChannel->format == eFMT_POLAR )
+            getSplineControlPoints( pChannel );
+    }
     g_free(pFORM2);
 
     return (GPIBfailed( pGPIB_HP8753->status ));
@@ -799,11 +787,11 @@ const HP8753_option optPlotQuadrant[] = {
 #define MAX_HPGL_PLOT_CHUNK    1000
 gint
 acquireHPGLplot( tGPIBinterface *pGPIB_HP8753, tGlobal *pGlobal ) {
-    gchar sHPGL[ MAX_HPGL_PLOT_CHUNK + 1 ];
-    gint nTokens = 0;
+    gchar sHPGL[ MAX_HPGL_PLOT_CHUNK ];
     gboolean bFullPagePlot = TRUE;
     gint plotQuadrant = 0;
     gboolean bPresumedEnd = FALSE;
+    tHPGLparser parser;
 
     pGlobal->HP8753.flags.bHPGLdataValid = FALSE;
 
@@ -818,46 +806,34 @@ acquireHPGLplot( tGPIBinterface *pGPIB_HP8753, tGlobal *pGlobal ) {
     GPIBasyncWrite( pGPIB_HP8753, "SCAPFULL;FULP;PTEXT ON;OUTPPLOT;", 10 * TIMEOUT_RW_1SEC);
     // The number of characters is dependent on the number of points and number of traces (including memory traces)
     // that are enabled. The GPIB END is asserted at the end of a line and ibcnt will indicate the actual count.
-    sHPGL[0] = 0;    // we start with no remainder from a previous call
-    parseHPGL( NULL, pGlobal );
+    initHPGLparser( &parser, pGlobal );
     // We do a number of reads to obtain the HPGL...
     // The number of reads is different on the c and the d models so we cannot
     // assume to know what this is. We could just read until a timeout but then we always have
     // an delay on the last read. The HPGL selects pen 0 (white) as the anti-penultimate command.
-    // we can use this to indicate that no more reads are needed. When parsedd, this give us our 'presumed end'
+    // we can use this to indicate that no more reads are needed. When parsed, this give us our 'presumed end'
     do {
-        gint offset = strlen(sHPGL);
-        int n;
-        if( GPIBasyncRead( pGPIB_HP8753, sHPGL+offset, MAX_HPGL_PLOT_CHUNK-offset,
-                1 * TIMEOUT_RW_1SEC) != eRDWT_OK )
+        if( GPIBasyncRead( pGPIB_HP8753, sHPGL, MAX_HPGL_PLOT_CHUNK, 1 * TIMEOUT_RW_1SEC) != eRDWT_OK )
             break;
-        sHPGL[ pGPIB_HP8753->nChars+offset ] = 0;
         if( GPIBsucceeded( pGPIB_HP8753->status ) ) {
             if( pGlobal->flags.bbDebug == 6 )
-                g_printerr( "%.*s", pGPIB_HP8753->nChars, sHPGL+offset );
-            gchar **tokens =  g_strsplit ( sHPGL, ";", -1 );
-            gint max=g_strv_length(tokens);
-            // the last string may be partial, so stuff it into
-            // the beginning of the next buffer
-            for( n=0 ; n < max-1; n++ ) {
-                bPresumedEnd = parseHPGL( tokens[n], pGlobal );
-                nTokens++;
-            }
-            // copy remainder (possibly only a partial) to the buffer to be
-            // added to on the next read
-            if( max > 0 )
-                strcpy( sHPGL, tokens[max-1] );
-            g_strfreev(tokens);
+                g_printerr( "%.*s", pGPIB_HP8753->nChars, sHPGL );
+            // commands split between reads are completed on the next
+            bPresumedEnd = parseHPGLstream( &parser, sHPGL, pGPIB_HP8753->nChars );
         }
-        postInfoWithCount( "Received %d HPGL instructions", nTokens, 0 );
+        postInfoWithCount( "Received %d HPGL instructions", parser.nCommands, 0 );
     } while ( (( pGPIB_HP8753->status & END) != END || !bPresumedEnd)  && GPIBsucceeded( pGPIB_HP8753->status )  );
-    // the last command must be parsed
+
+    g_free( pGlobal->HP8753.plotHPGL );
+    pGlobal->HP8753.HPGLgeneration++;
     if( GPIBsucceeded( pGPIB_HP8753->status ) ) {
-        parseHPGL( sHPGL, pGlobal );
+        // the last command must be parsed
+        pGlobal->HP8753.plotHPGL = finishHPGLparser( &parser );
         pGlobal->HP8753.flags.bHPGLdataValid = TRUE;
     } else {
         // Abandon partial HPGL
-        parseHPGL( NULL, pGlobal );
+        freeHPGLparser( &parser );
+        pGlobal->HP8753.plotHPGL = NULL;
         // make sure we do not attempt to show the HPGL plot
         pGlobal->HP8753.flags.bHPGLdataValid = FALSE;
     }
@@ -1200,6 +1176,7 @@ getHP8753channelListFreqSegments( tGPIBinterface *pGPIB_HP8753, tGlobal *pGlobal
                 }
             totalPoints += nPoints;
         }
+        indexSegments( pChannel );
         pChannel->chFlags.bValidSegments = TRUE;
         GPIBasyncWrite( pGPIB_HP8753, "ASEG;MENUON;MENUSTIM;MENUOFF;", 10 * TIMEOUT_RW_1SEC);
     } else {
@@ -0,0 +1,463 @@
+/*
+ * Copyright (c) 2026 Michael G. Katzmann
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/*! \file liveViewServer.c
+ * HTTP / WebSocket server for viewing the captures in a web browser.
+ *
+ * With --live-view-port=<port> the page at http://<host>:<port>/ plots the traces.
+ * Each capture is sent to every viewer (on /ws) as one binary frame per channel.
+ * All values are little endian:
+ *
+ *   offset  type        content
+ *   0       u8          'V'
+ *   1       u8          version (1)
+ *   2       u8          flags: 0x01 points are absolute (otherwise deltas)
+ *                              0x02 stimulus values follow the markers (list sweep)
+ *   3       u8          channel (0 or 1)
+ *   4       u32         frame number
+ *   8       u16         number of points (0 if the channel has no data)
+ *   10      u8          format (tFormat)
+ *   11      u8          sweep type (tSweepType)
+ *   12      f64         sweep start
+ *   20      f64         sweep stop
+ *   28      f32 x 3     scale per division, reference position, reference value
+ *   40      u8          markers on (bit n for marker n+1)
+ *   41      u8          active marker
+ *   42      u16         unused
+ *   44      5 x         marker: f64 stimulus, f32 real, f32 imaginary
+ *   124     f32 x n     stimulus (only with flag 0x02)
+ *           f32 x 2n    real, imaginary of each point
+ *
+ * The points are float32 differences from those of the previous frame of the
+ * channel, so that successive sweeps (which differ little) compress well with
+ * the permessage-deflate extension that libsoup negotiates.
+ * The server keeps the values as the viewers reconstruct them (in float32) so
+ * rounding does not accumulate. All viewers receive the same frames; a new viewer
+ * is first sent a frame with the absolute values.
+ *
+ * The viewer acknowledges each frame with a message (its content is ignored).
+ * A viewer that has not acknowledged LIVE_VIEW_MAX_BACKLOG frames is not sent any
+ * more (so a slow or stalled viewer cannot make the server queue without limit);
+ * once it catches up it is sent the absolute frame of each channel it missed.
+ *
+ * tools/liveViewClient.py decodes the frames and checks them against the captures.
+ */
+
+#include <gtk/gtk.h>
+#include <string.h>
+#include <glib-2.0/glib.h>
+#include <libsoup/soup.h>
+
+#include "hp8753.h"
+
+#define LIVE_VIEW_VERSION       1
+#define LIVE_VIEW_ABSOLUTE      0x01
+#define LIVE_VIEW_STIMULUS      0x02
+#define LIVE_VIEW_HEADER_SIZE   124
+#define MAX_LIVE_VIEWERS        64
+#define LIVE_VIEW_MAX_BACKLOG   8               // frames sent but not acknowledged
+
+typedef struct {
+    guint32     frameNumber;
+    guint       nPoints;
+    tFormat     format;
+    tSweepType  sweepType;
+    gfloat      *points;                        // as reconstructed by the viewers
+    GBytes      *pAbsoluteFrame;                // sent to a new viewer
+} tLiveChannel;
+
+typedef struct {
+    SoupWebsocketConnection *pConnection;
+    guint       nUnacknowledged;                // frames sent that the viewer has not acknowledged
+    gboolean    bResync[ eNUM_CH ];             // frames were skipped, send the absolute frame next
+} tLiveViewer;
+
+static SoupServer   *pLiveViewServer = NULL;
+static GList        *pViewers = NULL;          // tLiveViewer
+static tLiveChannel liveChannel[ eNUM_CH ] = { 0 };
+
+static const gchar liveViewPage[] =
+"<!DOCTYPE html>\n"
+"<html><head><meta charset=\"utf-8\"><title>HP8753 live view</title>\n"
+"<style>body{background:#111;color:#ccc;font:14px sans-serif;margin:0}"
+"canvas{display:block;width:100vw;height:46vh}#s{padding:4px}</style></head>\n"
+"<body><div id=\"s\">connecting</div><canvas id=\"c0\"></canvas><canvas id=\"c1\"></canvas>\n"
+"<script>\n"
+"const FMT=['LOG MAG','PHASE','DELAY','SMITH','POLAR','LIN MAG','SWR','REAL','IMAG'],ch=[{n:0},{n:0}];\n"
+"function frame(b){const v=new DataView(b);if(v.getUint8(0)!=86)return;\n"
+" const f=v.getUint8(2),c=v.getUint8(3)&1,n=v.getUint16(8,true),k=ch[c];let o=124;\n"
+" k.frame=v.getUint32(4,true);k.n=n;k.fmt=v.getUint8(10);k.swp=v.getUint8(11);\n"
+" k.start=v.getFloat64(12,true);k.stop=v.getFloat64(20,true);\n"
+" k.per=v.getFloat32(28,true);k.refPos=v.getFloat32(32,true);k.refVal=v.getFloat32(36,true);\n"
+" k.mOn=v.getUint8(40);k.mkr=[];\n"
+" for(let i=0;i<5;i++){const m=44+16*i;k.mkr.push([v.getFloat64(m,true),v.getFloat32(m+8,true),v.getFloat32(m+12,true)]);}\n"
+" k.stim=null;if(f&2){k.stim=new Float32Array(b.slice(o,o+4*n));o+=4*n;}\n"
+" const d=new Float32Array(b.slice(o,o+8*n));\n"
+" if((f&1)||!k.pts||k.pts.length!=2*n)k.pts=d;else for(let i=0;i<2*n;i++)k.pts[i]+=d[i];\n"
+" draw(c);}\n"
+"function draw(c){const k=ch[c],cv=document.getElementById('c'+c),w=cv.width=cv.clientWidth,h=cv.height=cv.clientHeight,\n"
+" g=cv.getContext('2d');g.clearRect(0,0,w,h);g.strokeStyle='#444';g.fillStyle='#ccc';\n"
+" if(!k.n){g.fillText('channel '+(c+1)+': no data',10,20);return;}\n"
+" g.fillText('channel '+(c+1)+'  '+FMT[k.fmt]+'  frame '+k.frame,10,14);\n"
+" let X,Y;\n"
+" if(k.fmt==3||k.fmt==4){const r=Math.min(w,h)/2-20,s=k.fmt==3||!k.per?1:k.per;\n"
+"  g.beginPath();g.arc(w/2,h/2,r,0,2*Math.PI);g.stroke();\n"
+"  X=(i,re,im)=>w/2+re/s*r;Y=(re,im)=>h/2-im/s*r;\n"
+" }else{const lo=k.refVal-k.refPos*k.per,hi=lo+10*k.per,l=50,t=20,gw=w-70,gh=h-40;\n"
+"  for(let i=0;i<=10;i++){g.beginPath();g.moveTo(l+gw*i/10,t);g.lineTo(l+gw*i/10,t+gh);\n"
+"   g.moveTo(l,t+gh*i/10);g.lineTo(l+gw,t+gh*i/10);g.stroke();\n"
+"   g.fillText((hi-i*k.per).toPrecision(4),4,t+gh*i/10+4);}\n"
+"  const fx=s=>k.swp==1?Math.log(s/k.start)/Math.log(k.stop/k.start):(s-k.start)/(k.stop-k.start);\n"
+"  X=(i,re,im,s)=>l+gw*(s!==undefined?fx(s):k.stim?fx(k.stim[i]):i/(k.n-1));\n"
+"  Y=(re,im)=>t+gh*(hi-re)/(hi-lo);}\n"
+" g.strokeStyle=c?'#4cf':'#fc4';g.beginPath();\n"
+" for(let i=0;i<k.n;i++){const re=k.pts[2*i],im=k.pts[2*i+1];i?g.lineTo(X(i,re,im),Y(re,im)):g.moveTo(X(i,re,im),Y(re,im));}\n"
+" g.stroke();\n"
+" for(let m=0;m<5;m++)if(k.mOn&(1<<m)){const[s,re,im]=k.mkr[m],x=X(0,re,im,s),y=Y(re,im);\n"
+"  g.fillRect(x-3,y-3,6,6);g.fillText(m<4?m+1:'\\u25b3',x+5,y-5);}}\n"
+"function connect(){const ws=new WebSocket((location.protocol=='https:'?'wss://':'ws://')+location.host+'/ws');\n"
+" ws.binaryType='arraybuffer';ws.onopen=()=>document.getElementById('s').textContent='connected';\n"
+" ws.onmessage=e=>{frame(e.data);ws.send('ack');document.getElementById('s').textContent='updated '+new Date().toLocaleTimeString();};\n"
+" ws.onclose=()=>{document.getElementById('s').textContent='disconnected';setTimeout(connect,2000);};}\n"
+"window.onresize=()=>{draw(0);draw(1);};connect();\n"
+"</script></body></html>\n";
+
+/*
+ * Append values to a frame (little endian)
+ */
+static void
+appendU8( GByteArray *pFrame, guint8 value ) {
+    g_byte_array_append( pFrame, &value, sizeof( value ) );
+}
+
+static void
+appendU16( GByteArray *pFrame, guint16 value ) {
+    value = GUINT16_TO_LE( value );
+    g_byte_array_append( pFrame, (guint8 *)&value, sizeof( value ) );
+}
+
+static void
+appendU32( GByteArray *pFrame, guint32 value ) {
+    value = GUINT32_TO_LE( value );
+    g_byte_array_append( pFrame, (guint8 *)&value, sizeof( value ) );
+}
+
+static void
+appendF32( GByteArray *pFrame, gfloat value ) {
+    union { gfloat f; guint32 u; } v = { .f = value };
+    appendU32( pFrame, v.u );
+}
+
+static void
+appendF64( GByteArray *pFrame, gdouble value ) {
+    union { gdouble d; guint64 u; } v = { .d = value };
+    v.u = GUINT64_TO_LE( v.u );
+    g_byte_array_append( pFrame, (guint8 *)&v.u, sizeof( v.u ) );
+}
+
+/*!     \brief  Make the header of a frame (all but the points)
+ *
+ * \param  pChannel     channel data
+ * \param  channel      channel number
+ * \param  nPoints      number of points in the frame
+ * \param  flags        LIVE_VIEW_ABSOLUTE and/or LIVE_VIEW_STIMULUS
+ * \return              frame to which the points are to be appended
+ */
+static GByteArray *
+liveViewFrameHeader( tChannel *pChannel, eChannel channel, guint nPoints, guint8 flags ) {
+    GByteArray *pFrame = g_byte_array_sized_new( LIVE_VIEW_HEADER_SIZE + nPoints * 3 * sizeof( gfloat ) );
+
+    appendU8( pFrame, 'V' );
+    appendU8( pFrame, LIVE_VIEW_VERSION );
+    appendU8( pFrame, flags );
+    appendU8( pFrame, channel );
+    appendU32( pFrame, liveChannel[ channel ].frameNumber );
+    appendU16( pFrame, nPoints );
+    appendU8( pFrame, pChannel->format );
+    appendU8( pFrame, pChannel->sweepType );
+    appendF64( pFrame, pChannel->sweepStart );
+    appendF64( pFrame, pChannel->sweepStop );
+    appendF32( pFrame, pChannel->scaleVal );
+    appendF32( pFrame, pChannel->scaleRefPos );
+    appendF32( pFrame, pChannel->scaleRefVal );
+    appendU8( pFrame, pChannel->chFlags.bbMkrs );
+    appendU8( pFrame, pChannel->activeMarker );
+    appendU16( pFrame, 0 );
+    for( gint i = 0; i < MAX_MKRS; i++ ) {
+        appendF64( pFrame, pChannel->numberedMarkers[i].sourceValue );
+        appendF32( pFrame, pChannel->numberedMarkers[i].point.r );
+        appendF32( pFrame, pChannel->numberedMarkers[i].point.i );
+    }
+    if( flags & LIVE_VIEW_STIMULUS ) {
+        // already filled by the GPIB thread for a capture (main loop only otherwise)
+        gdouble *stimulus = getStimulusPoints( pChannel );
+        for( gint i = 0; i < nPoints; i++ )
+            appendF32( pFrame, stimulus[i] );
+    }
+
+    return pFrame;
+}
+
+/*!     \brief  Encode the frame of a channel for the latest capture
+ *
+ * Also updates the frame sent to new viewers.
+ *
+ * \param  pGlobal      pointer to global data
+ * \param  channel      channel
+ * \return              frame to send to the viewers
+ */
+static GBytes *
+encodeLiveViewFrame( tGlobal *pGlobal, eChannel channel ) {
+    tChannel *pChannel = &pGlobal->HP8753.channels[ channel ];
+    tLiveChannel *pLive = &liveChannel[ channel ];
+    guint nPoints = pChannel->chFlags.bValidData && pChannel->responsePoints
+            && (channel == eCH_ONE || pGlobal->HP8753.flags.bDualChannel) ? pChannel->nPoints : 0;
+    guint8 flags = pChannel->sweepType == eSWP_LSTFREQ ? LIVE_VIEW_STIMULUS : 0;
+    GByteArray *pFrame, *pAbsolute;
+
+    // a change in the number of points or format makes differences meaningless
+    if( pLive->points == NULL || nPoints != pLive->nPoints
+            || pChannel->format != pLive->format || pChannel->sweepType != pLive->sweepType ) {
+        g_free( pLive->points );
+        pLive->points = g_new0( gfloat, 2 * nPoints );
+        pLive->nPoints = nPoints;
+        pLive->format = pChannel->format;
+        pLive->sweepType = pChannel->sweepType;
+        flags |= LIVE_VIEW_ABSOLUTE;
+    }
+    pLive->frameNumber++;
+
+    pFrame = liveViewFrameHeader( pChannel, channel, nPoints, flags );
+    pAbsolute = liveViewFrameHeader( pChannel, channel, nPoints, flags | LIVE_VIEW_ABSOLUTE );
+    for( gint i = 0; i < nPoints; i++ ) {
+        gfloat *point = &pLive->points[ 2 * i ];
+        gfloat re = pChannel->responsePoints[i].r, im = pChannel->responsePoints[i].i;
+
+        if( flags & LIVE_VIEW_ABSOLUTE ) {
+            point[0] = re;
+            point[1] = im;
+            appendF32( pFrame, re );
+            appendF32( pFrame, im );
+        } else {
+            // the viewer adds the (float32) difference to its (float32) value
+            gfloat dRe = re - point[0], dIm = im - point[1];
+            point[0] += dRe;
+            point[1] += dIm;
+            appendF32( pFrame, dRe );
+            appendF32( pFrame, dIm );
+        }
+        appendF32( pAbsolute, point[0] );
+        appendF32( pAbsolute, point[1] );
+    }
+
+    if( pLive->pAbsoluteFrame )
+        g_bytes_unref( pLive->pAbsoluteFrame );
+    pLive->pAbsoluteFrame = g_byte_array_free_to_bytes( pAbsolute );
+
+    return g_byte_array_free_to_bytes( pFrame );
+}
+
+/*!     \brief  Send a frame to a viewer
+ *
+ * \param  pViewer      the viewer
+ * \param  pFrame       the frame
+ */
+static void
+sendLiveViewFrame( tLiveViewer *pViewer, GBytes *pFrame ) {
+    gsize length;
+    gconstpointer data = g_bytes_get_data( pFrame, &length );
+
+    soup_websocket_connection_send_binary( pViewer->pConnection, data, length );
+    pViewer->nUnacknowledged++;
+}
+
+/*!     \brief  Send the latest capture to the viewers
+ *
+ * A viewer with too many frames not acknowledged skips this capture.
+ *
+ * \param  pGlobal      pointer to global data
+ */
+void
+broadcastLiveView( tGlobal *pGlobal ) {
+    if( pLiveViewServer == NULL )
+        return;
+
+    for( eChannel channel = eCH_ONE; channel < eNUM_CH; channel++ ) {
+        GBytes *pFrame = encodeLiveViewFrame( pGlobal, channel );
+
+        for( GList *l = pViewers; l != NULL; l = l->next ) {
+            tLiveViewer *pViewer = l->data;
+
+            if( soup_websocket_connection_get_state( pViewer->pConnection ) != SOUP_WEBSOCKET_STATE_OPEN )
+                continue;
+            if( pViewer->nUnacknowledged >= LIVE_VIEW_MAX_BACKLOG ) {
+                // the differences that follow would be from values it does not have
+                pViewer->bResync[ channel ] = TRUE;
+            } else if( pViewer->bResync[ channel ] ) {
+                sendLiveViewFrame( pViewer, liveChannel[ channel ].pAbsoluteFrame );
+                pViewer->bResync[ channel ] = FALSE;
+            } else {
+                sendLiveViewFrame( pViewer, pFrame );
+            }
+        }
+        g_bytes_unref( pFrame );
+    }
+}
+
+/*!     \brief  Free a viewer
+ *
+ * \param  pViewer      the viewer
+ */
+static void
+freeLiveViewer( tLiveViewer *pViewer ) {
+    g_object_unref( pViewer->pConnection );
+    g_free( pViewer );
+}
+
+/*!     \brief  Callback when a viewer acknowledges a frame
+ *
+ * \param  pConnection  websocket connection
+ * \param  type         message type
+ * \param  pMessage     message (ignored)
+ * \param  gpViewer     the viewer
+ */
+static void
+CB_viewerMessage( SoupWebsocketConnection *pConnection, gint type, GBytes *pMessage, gpointer gpViewer ) {
+    tLiveViewer *pViewer = (tLiveViewer *)gpViewer;
+
+    if( pViewer->nUnacknowledged > 0 )
+        pViewer->nUnacknowledged--;
+}
+
+/*!     \brief  Callback when a viewer has gone
+ *
+ * \param  pConnection  websocket connection
+ * \param  gpViewer     the viewer
+ */
+static void
+CB_viewerClosed( SoupWebsocketConnection *pConnection, gpointer gpViewer ) {
+    pViewers = g_list_remove( pViewers, gpViewer );
+    freeLiveViewer( (tLiveViewer *)gpViewer );
+}
+
+/*!     \brief  Callback for a new viewer on /ws
+ *
+ * \param  server       the server
+ * \param  msg          the upgrade request
+ * \param  path         path (/ws)
+ * \param  pViewer      websocket connection
+ * \param  gpGlobal     pointer to global data
+ */
+static void
+CB_liveViewWebsocket( SoupServer *server, SoupServerMessage *msg, const gchar *path,
+        SoupWebsocketConnection *pConnection, gpointer gpGlobal ) {
+    tLiveViewer *pViewer;
+
+    if( g_list_length( pViewers ) >= MAX_LIVE_VIEWERS ) {
+        soup_websocket_connection_close( pConnection, SOUP_WEBSOCKET_CLOSE_TRY_AGAIN_LATER, "Too many viewers" );
+        return;
+    }
+
+    pViewer = g_new0( tLiveViewer, 1 );
+    pViewer->pConnection = g_object_ref( pConnection );
+    pViewers = g_list_prepend( pViewers, pViewer );
+    g_signal_connect( pConnection, "message", G_CALLBACK( CB_viewerMessage ), pViewer );
+    g_signal_connect( pConnection, "closed", G_CALLBACK( CB_viewerClosed ), pViewer );
+
+    // start the viewer with the current values
+    for( eChannel channel = eCH_ONE; channel < eNUM_CH; channel++ ) {
+        if( liveChannel[ channel ].pAbsoluteFrame )
+            sendLiveViewFrame( pViewer, liveChannel[ channel ].pAbsoluteFrame );
+    }
+}
+
+/*!     \brief  Callback for a request for the page
+ *
+ * \param  server       the server
+ * \param  msg          the request
+ * \param  path         path
+ * \param  query        query parameters (unused)
+ * \param  gpGlobal     pointer to global data
+ */
+static void
+CB_liveViewPage( SoupServer *server, SoupServerMessage *msg, const gchar *path,
+        GHashTable *query, gpointer gpGlobal ) {
+    const gchar *sMethod = soup_server_message_get_method( msg );
+
+    if( g_strcmp0( path, "/" ) != 0 ) {
+        soup_server_message_set_status( msg, SOUP_STATUS_NOT_FOUND, NULL );
+    } else if( sMethod != SOUP_METHOD_GET && sMethod != SOUP_METHOD_HEAD ) {
+        soup_server_message_set_status( msg, SOUP_STATUS_NOT_IMPLEMENTED, NULL );
+    } else {
+        soup_server_message_set_status( msg, SOUP_STATUS_OK, NULL );
+        soup_server_message_set_response( msg, "text/html; charset=utf-8", SOUP_MEMORY_STATIC,
+                liveViewPage, sizeof( liveViewPage ) - 1 );
+    }
+}
+
+/*!     \brief  Start the live view server
+ *
+ * \param  pGlobal      pointer to global data
+ * \param  port         TCP port (or 0 for no server)
+ * \return              OK or ERROR
+ */
+gint
+startLiveViewServer( tGlobal *pGlobal, gint port ) {
+    GError *err = NULL;
+
+    if( port == 0 )
+        return OK;
+
+    pLiveViewServer = soup_server_new( "server-header", "HP8753 live view ", NULL );
+    soup_server_add_handler( pLiveViewServer, "/", CB_liveViewPage, pGlobal, NULL );
+    soup_server_add_websocket_handler( pLiveViewServer, "/ws", NULL, NULL,
+            CB_liveViewWebsocket, pGlobal, NULL );
+
+    // for viewing from other rooms, listen on all interfaces
+    if( !soup_server_listen_all( pLiveViewServer, port, 0, &err ) ) {
+        LOG( G_LOG_LEVEL_WARNING, "Cannot start live view on port %d: %s", port, err->message );
+        g_clear_error( &err );
+        g_clear_object( &pLiveViewServer );
+        return ERROR;
+    }
+
+    return OK;
+}
+
+/*!     \brief  Stop the live view server
+ */
+void
+stopLiveViewServer( void ) {
+    if( pLiveViewServer == NULL )
+        return;
+
+    for( GList *l = pViewers; l != NULL; l = l->next ) {
+        tLiveViewer *pViewer = l->data;
+
+        g_signal_handlers_disconnect_by_data( pViewer->pConnection, pViewer );
+        soup_websocket_connection_close( pViewer->pConnection, SOUP_WEBSOCKET_CLOSE_GOING_AWAY, NULL );
+    }
+    g_list_free_full( g_steal_pointer( &pViewers ), (GDestroyNotify)freeLiveViewer );
+
+    soup_server_disconnect( pLiveViewServer );
+    g_clear_object( &pLiveViewServer );
+
+    for( eChannel channel = eCH_ONE; channel < eNUM_CH; channel++ ) {
+        g_clear_pointer( &liveChannel[ channel ].points, g_free );
+        g_clear_pointer( &liveChannel[ channel ].pAbsoluteFrame, g_bytes_unref );
+        liveChannel[ channel ].nPoints = 0;
+    }
+}
@@ -16,6 +16,7 @@
 
 #include "hp8753.h"
 #include "messageEvent.h"
+#include "exportWorker.h"
 
 static gint clearTimerID = 0;
 gboolean
@@ -48,7 +49,6 @@ messageEventDispatch(GSource *source, GSourceFunc callback, gpointer udata) {
     GtkLabel *wLblStatus = GTK_LABEL( pGlobal->widgets[ eW_lbl_Status ]);
     GtkWidget *wBoxPlotType;
     gchar *sMarkup;
-    FILE *fSXP;
 
 	while ((message = g_async_queue_try_pop(pGlobal->messageQueueToMain))) {
 		switch (message->command) {
@@ -80,7 +80,10 @@ messageEventDispatch(GSource *source, GSourceFunc callback, gpointer udata) {
 			break;
 
 		case TM_SAVE_SETUPandCAL:
-		    if( saveCalibrationAndSetup( pGlobal, pGlobal->sProject, (gchar *)message->data ) != ERROR ) {
+		    if( saveCalibrationAndSetup( pGlobal, pGlobal->sProject, (gchar *)message->data ) == ERROR ) {
+		        automationSaveResult( FALSE, "Cannot save the setup and calibration" );
+		    } else {
+		        automationSaveResult( TRUE, NULL );
 		        populateCalComboBoxWidget( pGlobal );
                 // If this is a new project, also update the project combobox list
 		        if( !g_list_find_custom (pGlobal->pProjectList, pGlobal->sProject, (GCompareFunc) strcmp ) ) {
@@ -108,66 +111,43 @@ messageEventDispatch(GSource *source, GSourceFunc callback, gpointer udata) {
 			break;
 
 		case TM_SAVE_S2P:
+		case TM_SAVE_S1P:
 		    sensitiseControlsInUse( pGlobal, TRUE );
-		    if( (fSXP = fopen( message->data, "w" )) == NULL ) {
+		    if( (message->command == TM_SAVE_S2P ? writeS2Pfile : writeS1Pfile)( pGlobal, message->data ) != OK ) {
 		        gchar *sError = g_strdup_printf( "Cannot write: %s", (gchar *)message->data);
+		        automationSaveResult( FALSE, sError );
 		        postError( sError );
 		        g_free( sError );
 		    } else {
-		        fprintf( fSXP, "! 2-port S-paramater data, multiple frequency points\n"
-		                "! from HP8753 Network analyzer\n"
-		                "# MHz S RI R 50.0\n"
-		                "! freq\tReS11\tImS11\tReS21\tImS21\tReS12\tImS12\tReS22\tImS22\n" );
-		        for( gint i=0; i < pGlobal->HP8753.S2P.nPoints; i++ ) {
-		            fprintf( fSXP, "%.16lg\t%.16lg\t%.16lg\t%.16lg\t%.16lg\t%.16lg\t%.16lg\t%.16lg\t%.16lg\n",
-		                    pGlobal->HP8753.S2P.freq[i]/1.0e6,
-		                    pGlobal->HP8753.S2P.S11[i].r, pGlobal->HP8753.S2P.S11[i].i,
-		                    pGlobal->HP8753.S2P.S21[i].r, pGlobal->HP8753.S2P.S21[i].i,
-		                    pGlobal->HP8753.S2P.S12[i].r, pGlobal->HP8753.S2P.S12[i].i,
-		                    pGlobal->HP8753.S2P.S22[i].r, pGlobal->HP8753.S2P.S22[i].i );
-		        }
-		        fclose( fSXP );
-		        postInfo( "S2P saved" );
+		        automationSaveResult( TRUE, NULL );
+		        postInfo( message->command == TM_SAVE_S2P ? "S2P saved" : "S1P saved" );
 		    }
 		    g_free( message->data );
 
 			break;
-		case TM_SAVE_S1P:
-		    sensitiseControlsInUse( pGlobal, TRUE );
-		    if( (fSXP = fopen( message->data, "w" )) == NULL ) {
-		        gchar *sError = g_strdup_printf( "Cannot write: %s", (gchar *)message->data);
-		        postError( sError );
-		        g_free( sError );
-		    } else {
-		        fprintf( fSXP, "! 1-port S-paramater data, multiple frequency points\n"
-		                "! from HP8753 Network analyzer\n"
-		                "# MHz S RI R 50.0\n" );
-		        if( pGlobal->HP8753.S2P.SnPtype == S1P_S11 ) {
-		            fprintf( fSXP, "! freq\tReS11\tImS11\n"         );
-		            for( gint i=0; i < pGlobal->HP8753.S2P.nPoints; i++ ) {
-		                fprintf( fSXP, "%.16lg\t%.16lg\t%.16lg\n",
-		                        pGlobal->HP8753.S2P.freq[i]/1.0e6,
-		                        pGlobal->HP8753.S2P.S11[i].r, pGlobal->HP8753.S2P.S11[i].i );
-		            }
-		        } else {
-		            fprintf( fSXP, "! freq\tReS22\tImS22\n" );
-		            for( int i=0; i < pGlobal->HP8753.S2P.nPoints; i++ ) {
-		                fprintf( fSXP, "%.16g\t%.16lg\t%.16lg\n",
-		                        pGlobal->HP8753.S2P.freq[i]/1.0e6,
-		                        pGlobal->HP8753.S2P.S22[i].r, pGlobal->HP8753.S2P.S22[i].i );
-		                }
-		        }
-		        fclose( fSXP );
-		        postInfo( "S2P saved" );
-		    }
-            g_free( message->data );
 
-			break;
+		case TM_SAVE_THUMBNAIL:
+		    saveGeneratedThumbnail( pGlobal, message->data );
+		    break;
+
+		case TM_EXPORT_COMPLETE:
+		    exportJobComplete( pGlobal, message->data );
+		    break;
+
+		case TM_PROJECT_ARCHIVE_COMPLETE:
+		    projectArchiveComplete( pGlobal, message->data );
+		    break;
 
 		case TM_COMPLETE_GPIB:
             sensitiseControlsInUse( pGlobal, TRUE );
 			break;
+		case TM_NEW_CAPTURE:
+		    // stream to the web viewers (if enabled)
+		    broadcastLiveView( pGlobal );
+		    break;
 		case TM_REFRESH_TRACE:
+		    // the trace data has changed
+		    invalidatePlotCache();
             wBoxPlotType = GTK_WIDGET( pGlobal->widgets[ eW_nbTrace_box_PlotType ]);
             if( pGlobal->HP8753.plotHPGL == NULL )
                 gtk_widget_set_visible (GTK_WIDGET( wBoxPlotType ), FALSE);
@@ -206,6 +186,8 @@ messageEventDispatch(GSource *source, GSourceFunc callback, gpointer udata) {
 		default:
 			break;
 		}
+		// D-Bus automation requests
+		automationMessage( pGlobal, message );
 
 		g_free(message->sMessage);
 		g_free(message);
@@ -259,6 +241,7 @@ postMessageToMainLoop(enum _threadmessage Command, gchar *sMessage) {
 
 	messageData->sMessage = g_strdup(sMessage); // g_free() in threadEventsDispatch
 	messageData->command = Command;
+	messageData->bFromGPIBthread = (globalData.pGThread != NULL && g_thread_self() == globalData.pGThread);
 
 	g_async_queue_push(globalData.messageQueueToMain, messageData);
 	g_main_context_wakeup( NULL);
@@ -301,21 +284,27 @@ void postDataToMainLoop(enum _threadmessage Command, void *data) {
 	g_main_context_wakeup( NULL);
 }
 
-/*!     \brief  Send status state from thread to the main loop
+/*!     \brief  Send a command to the GPIB thread
  *
- * Send error information to the main loop
+ * Send a command (and data) to the GPIB thread.
+ * Each command is numbered. The number is returned with TM_COMPLETE_GPIB
+ * once the command has been performed.
  *
  * \param Command       : enumerated state to indicate action
- * \param sMessage      : message or signal
+ * \param data          : data for the command (freed by the GPIB thread)
+ * \return              : sequence number of the command
  */
-void postDataToGPIBThread(enum _threadmessage Command, void *data) {
-	// sMesaage can be a pointer to a string or a small gint up to PM_MAX (notification message)
+guint postDataToGPIBThread(enum _threadmessage Command, void *data) {
+	static gint lastSequence = 0;
+	guint sequence = (guint)g_atomic_int_add( &lastSequence, 1 ) + 1;
 
-	messageEventData *messageData;   // g_free() in threadEventsDispatch
+	messageEventData *messageData;   // g_free() in threadGPIB
 	messageData = g_new0( messageEventData, 1 );
 
 	messageData->data = data;
 	messageData->command = Command;
+	messageData->sequence = sequence;
 
 	g_async_queue_push(globalData.messageQueueToGPIB, messageData);
+	return sequence;
 }
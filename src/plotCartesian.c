@@ -31,6 +31,57 @@ gdouble logGrids[ NUM_LOG_GRIDS ] = {
 		 0.0,            0.0,            0.301029995664, 0.477121254720, 0.602059991328,
 		 0.698970004336, 0.778151250384, 0.845098040014, 0.903089986992, 0.954242509439
 		};
+
+/*!     \brief  Reduce a trace to the min/max envelope of each pixel column
+ *
+ * Of the samples falling in each pixel column, the first, the minimum, the
+ * maximum and the last are kept (in sample order) so that peaks are exact and
+ * the columns join as they would have. The result is kept with the channel
+ * until the width changes or the trace data changes (see clearDerivedTraceData).
+ *
+ * \param pDecimated	decimated trace (of the channel or for this draw only)
+ * \param pPoints	trace samples
+ * \param nPoints	number of samples
+ * \param nColumns	number of pixel columns spanned by the trace
+ * \return			array of indexes (guint) of the samples to draw
+ */
+static GArray *
+decimateTrace( tDecimatedTrace *pDecimated, const tComplex *pPoints, gint nPoints, gint nColumns ) {
+	gdouble columnsPerPoint = (gdouble)nColumns / (nPoints - 1);
+
+	if( pDecimated->indexes != NULL && pDecimated->nColumns == nColumns )
+		return pDecimated->indexes;
+
+	if( pDecimated->indexes == NULL )
+		pDecimated->indexes = g_array_sized_new( FALSE, FALSE, sizeof( guint ), 4 * nColumns );
+	g_array_set_size( pDecimated->indexes, 0 );
+
+#define PIXEL_COLUMN(i)	MIN( (gint)((i) * columnsPerPoint), nColumns - 1 )
+	for( guint i = 0; i < nPoints; ) {
+		gint column = PIXEL_COLUMN( i );
+		guint kept[4], nKept = 0, first = i, iMin = i, iMax = i;
+
+		for( i++; i < nPoints && PIXEL_COLUMN( i ) == column; i++ ) {
+			if( pPoints[ i ].r < pPoints[ iMin ].r )
+				iMin = i;
+			if( pPoints[ i ].r > pPoints[ iMax ].r )
+				iMax = i;
+		}
+		kept[ nKept++ ] = first;
+		kept[ nKept++ ] = MIN( iMin, iMax );
+		kept[ nKept++ ] = MAX( iMin, iMax );
+		kept[ nKept++ ] = i - 1;
+		// in sample order .. without repeats
+		for( gint k = 0; k < nKept; k++ )
+			if( k == 0 || kept[ k ] != kept[ k - 1 ] )
+				g_array_append_val( pDecimated->indexes, kept[ k ] );
+	}
+
+	pDecimated->nColumns = nColumns;
+
+	return pDecimated->indexes;
+}
+
 /*!     \brief  Display the cartesian grid
  *
  * If the plot is cartesian, draw the grid and legends.
@@ -56,13 +107,12 @@ plotCartesianGrid (cairo_t *cr, tGridParameters *pGrid, eChannel channel, tGloba
 	gint i;
 	gchar *sYlabels[ NVGRIDS+1 ];
 	cairo_text_extents_t YlabelExtents[ NVGRIDS+1 ];
-	static gdouble maxYlabelWidth = 0.0;
 	double yLabelScale = 1.0;
 
 	// In calculating the maximum Y label we need to see both sides
 	// So don't reset if we are overlaying and this is ch 2
 	if( channel == eCH_ONE || !pGrid->overlay.bCartesian ) {
-		maxYlabelWidth = 0.0;
+		pGrid->maxYlabelWidth = 0.0;
 	}
 
     cairo_save(cr);
@@ -93,12 +143,12 @@ plotCartesianGrid (cairo_t *cr, tGridParameters *pGrid, eChannel channel, tGloba
 				yTicValue = 0.0;
 			sYlabels[i] = engNotation( yTicValue, 2, eENG_NORMAL, NULL);
 			cairo_text_extents (cr, sYlabels[i], &YlabelExtents[i]);
-			if( YlabelExtents[i].width + YlabelExtents[i].x_bearing > maxYlabelWidth )
-				maxYlabelWidth = YlabelExtents[i].width + YlabelExtents[i].x_bearing;
+			if( YlabelExtents[i].width + YlabelExtents[i].x_bearing > pGrid->maxYlabelWidth )
+				pGrid->maxYlabelWidth = YlabelExtents[i].width + YlabelExtents[i].x_bearing;
 		}
 		// If we have a larger than usual response (Y) label, then make room by expanding the margins to accomodate
-		if( maxYlabelWidth + pGrid->textMargin  > pGrid->leftGridPosn   ) {
-			yLabelScale = (pGrid->leftGridPosn - pGrid->textMargin) / maxYlabelWidth;
+		if( pGrid->maxYlabelWidth + pGrid->textMargin  > pGrid->leftGridPosn   ) {
+			yLabelScale = (pGrid->leftGridPosn - pGrid->textMargin) / pGrid->maxYlabelWidth;
 		}
 
 		// Draw grid pattern
@@ -148,13 +198,13 @@ plotCartesianGrid (cairo_t *cr, tGridParameters *pGrid, eChannel channel, tGloba
 			//    gtk_style_context_get_color (context, gtk_style_context_get_state (context), &color);
 			//    gdk_cairo_set_source_rgba (cr, &color);
 
-			gdk_cairo_set_source_rgba (cr, &plotElementColors[ eColorGrid   ] );
+			gdk_cairo_set_source_rgba (cr, &pGlobal->plotElementColors[ eColorGrid   ] );
 			cairo_set_line_width (cr, pGrid->areaWidth / 1000.0 * 0.5);
 			cairo_stroke (cr);
 		}
 
 		showStimulusInformation (cr, pGrid, channel, pGlobal);
-		setTraceColor( cr, pGrid->overlay.bAny, channel );
+		setTraceColor( cr, pGlobal, pGrid->overlay.bAny, channel );
 
 		// y-axis labels
 		// put bottom left of the grid at 0.0
@@ -170,7 +220,7 @@ plotCartesianGrid (cairo_t *cr, tGridParameters *pGrid, eChannel channel, tGloba
 						(i * pGrid->gridHeight / NVGRIDS) - (YlabelExtents[i].height/2 + YlabelExtents[i].y_bearing));
 			} else {
 				cairo_move_to(cr, pGrid->gridWidth
-						+ maxYlabelWidth * yLabelScale
+						+ pGrid->maxYlabelWidth * yLabelScale
 						- (YlabelExtents[i].width + YlabelExtents[i].x_bearing) * yLabelScale + pGrid->textMargin,
 						(i * pGrid->gridHeight / NVGRIDS) - (YlabelExtents[i].height/2 + YlabelExtents[i].y_bearing));
 			}
@@ -179,7 +229,7 @@ plotCartesianGrid (cairo_t *cr, tGridParameters *pGrid, eChannel channel, tGloba
 		}
 
 		if( channel == eCH_ONE || !pGlobal->HP8753.flags.bDualChannel )
-			showTitleAndTime( cr, pGrid, pGlobal->HP8753.sTitle,
+			showTitleAndTime( cr, pGrid, pGlobal, pGlobal->HP8753.sTitle,
 					pGlobal->flags.bShowDateTime ? pGlobal->HP8753.dateTime : "" );
 
     }
@@ -213,7 +263,8 @@ plotCartesianTrace (cairo_t *cr, tGridParameters *pGrid, eChannel channel, tGlob
 	gint xl, xu, npoints, seg;
 	gchar *sLabel = 0, sNote[ BUFFER_SIZE_100 ], *sPrefix="";
 	tChannel *pChannel = &pGlobal->HP8753.channels[channel];
-    GdkRGBA solidCursorRGBA = plotElementColors[ eColorLiveMkrCursor ];
+	gdouble *stimulusPoints = getStimulusPoints( pChannel );
+    GdkRGBA solidCursorRGBA = pGlobal->plotElementColors[ eColorLiveMkrCursor ];
     solidCursorRGBA.alpha = 1.0;
 
 	npoints = pChannel->nPoints;
@@ -232,13 +283,13 @@ plotCartesianTrace (cairo_t *cr, tGridParameters *pGrid, eChannel channel, tGlob
 
 	cairo_save( cr ); {
 		// Draw reference line
-
-	    gdk_cairo_set_source_rgba (cr, &plotElementColors[ eColorRefLine1   ] );
-		cairo_set_line_width (cr, pGrid->areaWidth / 1000.0 * 1.5);
-		cairo_move_to(cr, pGrid->leftGridPosn, pGrid->bottomGridPosn + refPos * pGrid->gridHeight / NVGRIDS);
-		cairo_rel_line_to(cr, pGrid->gridWidth, 0.0);
-		cairo_stroke( cr );
-
+		if( pGrid->layers & PLOT_LAYER_STATIC ) {
+		    gdk_cairo_set_source_rgba (cr, &pGlobal->plotElementColors[ eColorRefLine1   ] );
+			cairo_set_line_width (cr, pGrid->areaWidth / 1000.0 * 1.5);
+			cairo_move_to(cr, pGrid->leftGridPosn, pGrid->bottomGridPosn + refPos * pGrid->gridHeight / NVGRIDS);
+			cairo_rel_line_to(cr, pGrid->gridWidth, 0.0);
+			cairo_stroke( cr );
+		}
 
 		if ( npoints ) {
 			// put bottom left of the grid at 0.0
@@ -257,44 +308,76 @@ plotCartesianTrace (cairo_t *cr, tGridParameters *pGrid, eChannel channel, tGlob
 			// translate to zero
 			cairo_translate( cr, 0.0,  refPos * perDiv * levelScale);
 
-			setTraceColor( cr, pGrid->overlay.bAny, channel );
-			cairo_set_line_width (cr, pGrid->areaWidth / 1000.0);
-
-			for ( i=0, seg=0; i < npoints; i++) {
-				x = i * sweepScale;
-				y = pChannel->responsePoints[i].r - refVal;
+			if( pGrid->layers & PLOT_LAYER_STATIC ) {
+				setTraceColor( cr, pGlobal, pGrid->overlay.bAny, channel );
+				cairo_set_line_width (cr, pGrid->areaWidth / 1000.0);
 
 				// the stimulus sample points are non linear when all segments are displayed in list freq sweep mode
 				if( (pChannel->sweepType == eSWP_LSTFREQ && pChannel->chFlags.bAllSegments)
 						&& (pChannel->sweepStart != pChannel->sweepStop) ) {
-					x = (gdouble)pGrid->gridWidth * (pChannel->stimulusPoints[ i ] - pChannel->sweepStart)
-							/ (pChannel->sweepStop - pChannel->sweepStart);
-
-					if( pChannel->stimulusPoints[ i ] == pChannel->segments[seg].startFreq ) {
-						cairo_move_to(cr, x, y * levelScale);
-						if( pChannel->segments[seg].nPoints == 1 ) {
-							cairo_arc(cr, x, y * levelScale, 1.0, 0, 2*G_PI );
-							cairo_stroke( cr );
-							seg++;
+					tSegmentIndex *pIndex = getSegmentIndex( pChannel );
+					// each segment is drawn separately (the segment boundaries are from the index)
+					for ( seg=0; seg < pIndex->nSegments; seg++ ) {
+						gint first = pIndex->firstPoint[ seg ];
+						gint last = MIN( pIndex->firstPoint[ seg+1 ], npoints ) - 1;
+
+						for ( i=first; i <= last; i++ ) {
+							y = pChannel->responsePoints[i].r - refVal;
+							x = (gdouble)pGrid->gridWidth * (stimulusPoints[ i ] - pChannel->sweepStart)
+									/ (pChannel->sweepStop - pChannel->sweepStart);
+							if( i == first )
+								cairo_move_to(cr, x, y * levelScale);
+							else
+								cairo_line_to(cr, x, y * levelScale);
 						}
-					} else if( pChannel->stimulusPoints[ i ] == pChannel->segments[seg].stopFreq ) {
-						cairo_line_to(cr, x, y * levelScale);
+						if( first == last )
+							cairo_arc(cr, x, y * levelScale, 1.0, 0, 2*G_PI );
 						cairo_stroke( cr );
-						seg++;
-					} else  {
-						cairo_line_to(cr, x, y * levelScale);
 					}
 				} else {
-					if ( i == 0 )
-						cairo_move_to(cr, x, y * levelScale);
-					else
-						cairo_line_to(cr, x, y * levelScale);
+					// On the screen (or a bitmap) there is no point drawing more than
+					// the envelope of each pixel column. PDF, SVG and print are drawn
+					// at full resolution.
+					gdouble nColumns = pGrid->gridWidth, dy = 0.0;
+					cairo_user_to_device_distance( cr, &nColumns, &dy );
+					nColumns = ceil( fabs( nColumns ) );
+
+					if( cairo_surface_get_type( cairo_get_target( cr ) ) == CAIRO_SURFACE_TYPE_IMAGE
+							&& npoints > 2 * nColumns && nColumns > 0 ) {
+						// exports draw a snapshot of the traces on another thread (perhaps
+						// more than one at a time) so it is not changed
+						tDecimatedTrace uncached = { 0 };
+						GArray *indexes = decimateTrace( pGlobal->bSnapshot ? &uncached : &pChannel->decimated,
+								pChannel->responsePoints, npoints, (gint)nColumns );
+
+						for ( gint k=0; k < indexes->len; k++ ) {
+							i = g_array_index( indexes, guint, k );
+							x = i * sweepScale;
+							y = pChannel->responsePoints[i].r - refVal;
+							if ( k == 0 )
+								cairo_move_to(cr, x, y * levelScale);
+							else
+								cairo_line_to(cr, x, y * levelScale);
+						}
+						if( uncached.indexes )
+							g_array_free( uncached.indexes, TRUE );
+					} else {
+						for ( i=0; i < npoints; i++) {
+							x = i * sweepScale;
+							y = pChannel->responsePoints[i].r - refVal;
+							if ( i == 0 )
+								cairo_move_to(cr, x, y * levelScale);
+							else
+								cairo_line_to(cr, x, y * levelScale);
+						}
+					}
 				}
+				cairo_stroke (cr);
 			}
-			cairo_stroke (cr);
 
 			cairo_reset_clip( cr );
-	        drawMarkers( cr, pGlobal, pGrid, channel, refVal, levelScale );
+			if( pGrid->layers & PLOT_LAYER_STATIC )
+				drawMarkers( cr, pGlobal, pGrid, channel, refVal, levelScale );
 
 			// translate actual mouse positions to translated ones
 			// if we overlay then this is always on the first GtkDrawingArea
@@ -306,7 +389,9 @@ plotCartesianTrace (cairo_t *cr, tGridParameters *pGrid, eChannel channel, tGlob
 			if( pGlobal->flags.bHoldLiveMarker )
 			    xMouse = pGlobal->mouseXpercentHeld * pGrid->areaWidth;
 
-			if ( xMouse >= pGrid->leftGridPosn && xMouse <= pGrid->gridWidth+pGrid->leftGridPosn ) {
+			// the live marker is drawn over the (cached) grid and trace
+			if ( (pGrid->layers & PLOT_LAYER_LIVE)
+					&& xMouse >= pGrid->leftGridPosn && xMouse <= pGrid->gridWidth+pGrid->leftGridPosn ) {
 				gboolean bValidSample = FALSE;
 				xFract = (xMouse-pGrid->leftGridPosn) / pGrid->gridWidth;
 				x = (npoints-1) * xFract; y=0.0;
@@ -314,16 +399,12 @@ plotCartesianTrace (cairo_t *cr, tGridParameters *pGrid, eChannel channel, tGlob
 
 				if( pChannel->sweepType == eSWP_LSTFREQ && pChannel->chFlags.bAllSegments ) {
 					sweepValue = LIN_INTERP(pChannel->sweepStart, pChannel->sweepStop, xFract);
-					for( int seg=0, nSample=0; seg < pChannel->nSegments; seg++ ) {
-						// see if we even have this sample frequency
-						if( sweepValue >= pChannel->segments[seg].startFreq &&
-								sweepValue <= pChannel->segments[seg].stopFreq ) {
-							y = calculateSegmentLinearlyInterpolatedResponse( nSample, nSample+pChannel->segments[seg].nPoints,
-									pChannel, sweepValue );
-							bValidSample = TRUE;
-							break;
-						}
-						nSample += pChannel->segments[seg].nPoints;
+					// see if we even have this sample frequency
+					if( (seg = findSegment( pChannel, sweepValue )) >= 0 ) {
+						tSegmentIndex *pIndex = getSegmentIndex( pChannel );
+						y = calculateSegmentLinearlyInterpolatedResponse( pIndex->firstPoint[ seg ],
+								MIN( pIndex->firstPoint[ seg+1 ], npoints ) - 1, pChannel, sweepValue );
+						bValidSample = TRUE;
 					}
 				} else {
 					yl = pChannel->responsePoints[xl].r - refVal;
@@ -343,7 +424,7 @@ plotCartesianTrace (cairo_t *cr, tGridParameters *pGrid, eChannel channel, tGlob
                     cairo_arc( cr, x * sweepScale, y * levelScale, pGrid->areaWidth / 1000.0 * 1.5, 0.0, 2 * G_PI );
                     cairo_fill(cr);
                     // circle around live market
-	                gdk_cairo_set_source_rgba (cr, &plotElementColors[ eColorLiveMkrCursor ] );
+	                gdk_cairo_set_source_rgba (cr, &pGlobal->plotElementColors[ eColorLiveMkrCursor ] );
                     cairo_arc( cr, x * sweepScale, y * levelScale, pGrid->areaWidth / 1000.0 * 6.4, 0.0, 2 * G_PI );
                     cairo_stroke(cr);
 				}
@@ -372,7 +453,7 @@ plotCartesianTrace (cairo_t *cr, tGridParameters *pGrid, eChannel channel, tGlob
 					sLabel = engNotation( sweepValue, 2, eENG_SEPARATE, &sPrefix );
 					g_snprintf( sNote, BUFFER_SIZE_100, "  %s%s", sPrefix,
 							sweepSymbols[pGlobal->HP8753.channels[channel].sweepType]);
-					setTraceColor( cr, pGrid->overlay.bAny, channel );
+					setTraceColor( cr, pGlobal, pGrid->overlay.bAny, channel );
 					// Where to place the text indicating the freq / value
 					if( pGrid->overlay.bAny && channel == eCH_TWO )
 						ylabel= pGrid->bottomGridPosn + pGrid->gridHeight * 0.09;
@@ -83,9 +83,9 @@ plotPolarGrid (cairo_t *cr, gboolean bAnnotate, tGridParameters *pGrid, eChannel
 		cairo_set_line_width (cr, LINE_THICKNESS/pGrid->scale);
 
 		if( pGrid->overlay.bAny && channel == eCH_TWO ) {
-		    gdk_cairo_set_source_rgba (cr, &plotElementColors[ eColorGridPolarOverlay   ] );
+		    gdk_cairo_set_source_rgba (cr, &pGlobal->plotElementColors[ eColorGridPolarOverlay   ] );
 		} else {
-		    gdk_cairo_set_source_rgba (cr, &plotElementColors[ eColorGrid   ] );
+		    gdk_cairo_set_source_rgba (cr, &pGlobal->plotElementColors[ eColorGrid   ] );
 		}
 	#define ONEonSQRT2 0.70710678118
 
@@ -133,7 +133,7 @@ plotPolarGrid (cairo_t *cr, gboolean bAnnotate, tGridParameters *pGrid, eChannel
 
 		// if we overlay polar & polar (but with different scales) or
 		// Smith & polar, display legend in colors matching the trace
-		setTraceColor( cr, pGrid->overlay.bPolarWithDiferentScaling
+		setTraceColor( cr, pGlobal, pGrid->overlay.bPolarWithDiferentScaling
 				|| pGrid->overlay.bPolarSmith, channel );
 
 		setCairoFontSize(cr, pGrid->fontSize / pGrid->scale); // initially 10 pixels
@@ -208,7 +208,7 @@ showPolarCursorInfo(
 		}
 	}
 
-	setTraceColor( cr, pGrid->overlay.bAny, channel );
+	setTraceColor( cr, pGlobal, pGrid->overlay.bAny, channel );
 
 	label = g_strdup_printf(" %4.3f U ∠ %5.3f°", mag, angle);
 	filmCreditsCairoText( cr, "", label, 0,  xTextPos,  yTextPos, eBottomLeft );
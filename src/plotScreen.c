@@ -17,6 +17,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 #include <math.h>
 #include <glib-2.0/glib.h>
@@ -27,49 +28,102 @@
 
 #include "HPGLplot.h"
 
-/*!     \brief  Parse an HPGL command
+/*!     \brief  Add bytes to the compiled HPGL
  *
- * Parse an HPGL command and prepare data for plotting.
- * We create a compiled serial data set for plotting....
- * NNNNNNNN - byte count (total count of bytes for the data)
- * Line         - CHPGL_LINE2PT - identifier byte
- *                NN          - 16 bit count of bytes in line (n)
- *                NN          - 16 bit x1 position
- *                NN          - 16 bit y1 position
- *                x & y repeated for coordinate 2 to n (min of three points)
- * 2 point Line - CHPGL_LINE2PT - identifier byte
- *                NN          - 16 bit x1 position
- *                NN          - 16 bit y1 position
- *                NN          - 16 bit x2 position
- *                NN          - 16 bit y2 position
- * label        - CHPGL_LABEL or CHPGL_LABEL_REL - identifier byte
- *                NN          - 16 bit x position
- *                NN          - 16 bit y position
- *                NN          - 16 bit byte count of string (including trailling null)
- *                SSSSSSS.... - variable length string (including terminating by NULL)
- * lable size   - HPGL_CHAR_SIZE_REL - identifier byte
- *                NNNN        - float character size scaling in x (percentage of P2-P1 x)
- *                NNNN        - float character size scaling in y (percentahge of P2-P1 y)
- * pen select   - HPGL_SELECT_PEN - identifier byte
- *                N           - 8 bits identifying the pen (colour)
- * line type    - HPGL_LINE_TYPE - identifier byte
- *                N           - 8 bits identifying the line type (AFAICT this does not change)
+ * \param  pArena	compiled HPGL chunks
+ * \param  pData	bytes to add
+ * \param  length	number of bytes
+ */
+static void
+arenaAppend( tHPGLarena *pArena, const void *pData, gsize length ) {
+	const guchar *pBytes = pData;
+
+	if( pArena->chunks == NULL )
+		pArena->chunks = g_ptr_array_new_with_free_func( g_free );
+
+	while( length > 0 ) {
+		gsize nCopy;
+
+		if( pArena->chunks->len == 0 || pArena->nUsedInLast == HPGL_ARENA_CHUNK_SIZE ) {
+			g_ptr_array_add( pArena->chunks, g_malloc( HPGL_ARENA_CHUNK_SIZE ) );
+			pArena->nUsedInLast = 0;
+		}
+		nCopy = MIN( length, HPGL_ARENA_CHUNK_SIZE - pArena->nUsedInLast );
+		memcpy( (guchar *)g_ptr_array_index( pArena->chunks, pArena->chunks->len - 1 ) + pArena->nUsedInLast,
+				pBytes, nCopy );
+		pArena->nUsedInLast += nCopy;
+		pArena->nTotal += nCopy;
+		pBytes += nCopy;
+		length -= nCopy;
+	}
+}
+
+/*!     \brief  Add a compiled HPGL command identifier
  *
+ * \param  pParser	parser context
+ * \param  code		compiled HPGL command
+ */
+static void
+emitCHPGL( tHPGLparser *pParser, eHPGL code ) {
+	arenaAppend( &pParser->arena, &code, sizeof( eHPGL ) );
+}
+
+/*!     \brief  Conclude the line being drawn (the pen is lifted)
  *
- * \param  sHPGL	pointer to HPGL snippet
- * \return 0 (OK) or -1 (ERROR)
+ * \param  pParser	parser context
  */
-gboolean
-parseHPGL( gchar *sHPGL, tGlobal *pGlobal ) {
-	static gboolean bPenDown = FALSE;
-	static tCoord posn = {0};
-	static gfloat charSizeX = 0.0, charSizeY = 0.0;
-	static gint colour = 0, lineType = 0;
-	guchar *secondHPGLcmd = NULL;
-	// If a line is started .. we add to it
-	static tCoord *currentLine = 0;
-	static gint	nPointsInLine = 0;
-	static gboolean	bNewPosition = FALSE;
+static void
+penUp( tHPGLparser *pParser ) {
+	if( pParser->bPenDown ) {
+		guint16 nPointsInLine = pParser->currentLine->len;
+
+		// if it just a two point line, we don't save the number of points .. its implicit
+		if( nPointsInLine == 2 ) {
+			emitCHPGL( pParser, CHPGL_LINE2PT );
+		} else {
+			emitCHPGL( pParser, CHPGL_LINE );
+			arenaAppend( &pParser->arena, &nPointsInLine, sizeof( guint16 ) );
+		}
+		arenaAppend( &pParser->arena, pParser->currentLine->data, nPointsInLine * sizeof( tCoord ) );
+	}
+	g_array_set_size( pParser->currentLine, 0 );
+	pParser->bPenDown = FALSE;
+}
+
+/*!     \brief  Start a line at the current position (the pen is lowered)
+ *
+ * \param  pParser	parser context
+ */
+static void
+penDown( tHPGLparser *pParser ) {
+	if( !pParser->bPenDown ) {
+		g_array_set_size( pParser->currentLine, 0 );
+		g_array_append_val( pParser->currentLine, pParser->posn );
+		pParser->bPenDown = TRUE;
+	}
+}
+
+/*!     \brief  Move the pen (drawing if it is down)
+ *
+ * \param  pParser	parser context
+ * \param  x		plotter x coordinate
+ * \param  y		plotter y coordinate
+ */
+static void
+movePen( tHPGLparser *pParser, gdouble x, gdouble y ) {
+	pParser->posn.x = (guint16)(gint)x;
+	pParser->posn.y = (guint16)(gint)y;
+	if( pParser->bPenDown )
+		g_array_append_val( pParser->currentLine, pParser->posn );
+	pParser->bNewPosition = TRUE;
+}
+
+/*!     \brief  Compile the label just parsed
+ *
+ * \param  pParser	parser context
+ */
+static void
+compileLabel( tHPGLparser *pParser ) {
 	struct scanArrow {
 		eHPGL code1;     // code CHPGL_LINE2PT
 	    tCoord vert1, vert2;
@@ -84,255 +138,446 @@ parseHPGL( gchar *sHPGL, tGlobal *pGlobal ) {
 	        CHPGL_LINE2PT, {77, 384}, {77, 444 },
             CHPGL_LINE, 3, {65, 426}, {77, 444}, {88, 426}
 	};
+	guchar length;
 
-	static gint scaleX = HPGL_MAX_X;
-	static gint scaleY = HPGL_MAX_Y;
-    static gint scalePtX = HPGL_P1P2_X;
-    static gint scalePtY = HPGL_P1P2_Y;
-
-	gint temp1=0, temp2=0;
-
-	// selecting pen 0 (white) indicates end of plot
-	static gboolean bPresumedEnd = FALSE;
-
-	// number of bytes used in the malloced memory
-	guint HPGLserialCount;
-	gint nArgs;
-	gint strLength;
+	pParser->label[ pParser->labelLength ] = pParser->label[ pParser->labelLength + 1 ] = 0;
+	// don't bother adding null labels ("LB;")
+	if( pParser->labelLength == 0 && !pParser->bLabelTerminated )
+		return;
 
-	// Initialize the serialized & compiled HPGL plot
-	if( sHPGL == NULL ) {
-		// free any previously malloced data
-		g_free( pGlobal->HP8753.plotHPGL );
-		pGlobal->HP8753.plotHPGL = NULL;
-
-		// abandon any open line
-		g_free( currentLine );
-		nPointsInLine = 0;
-		currentLine = NULL;
-
-		bPresumedEnd = FALSE;
-		// assume the pen is up
-		bPenDown = FALSE;
-		return 0;
+#define HLD_LBL_YPOS_CH2	384
+#define HLD_LBL_YPOS_CH1	2432
+	// Dont show the Hld if we are not in hold
+	if( pParser->bLabelTerminated && strcmp( pParser->label, "Hld" ) == 0 && pParser->posn.x == 0 ) {
+		if( pParser->posn.y == HLD_LBL_YPOS_CH1 ) {
+			if( pParser->bScanArrowUpper ) {
+				// show the scan arrow instead of 'Hld'
+				arenaAppend( &pParser->arena, &upperScanArrow, sizeof( struct scanArrow ) );
+				return;
+			}
+		} else if( pParser->bScanArrowLower ) {
+			arenaAppend( &pParser->arena, &lowerScanArrow, sizeof( struct scanArrow ) );
+			return;
+		}
 	}
 
-	// all our HPGL commands are two ACSII caharcters
-	if( strlen(sHPGL) < 2 )
-		return 0;
-
-	if( pGlobal->HP8753.plotHPGL )
-		HPGLserialCount = *(guint *)(pGlobal->HP8753.plotHPGL);
-	else
-		HPGLserialCount = sizeof( guint );	// byte count at the beginning of malloced string
+	// insert the label identifier and location
+	emitCHPGL( pParser, pParser->bNewPosition ? CHPGL_LABEL : CHPGL_LABEL_REL );
+	arenaAppend( &pParser->arena, &pParser->posn, sizeof( tCoord ) );
+	// next the string length .. the terminator (003) is replaced with a null and
+	// a further null follows
+	length = pParser->labelLength + (pParser->bLabelTerminated ? 1 : 0);
+	arenaAppend( &pParser->arena, &length, sizeof( guchar ) );
+	arenaAppend( &pParser->arena, pParser->label, length + 1 );
+	pParser->bNewPosition = FALSE;
+}
 
-	switch( ((guchar)sHPGL[0] << 8) + (guchar)sHPGL[1] ) {	// concatenate the two bytes
-	case HPGL_POSN_ABS:
-		// some PA lines also contain other commands so malloc memory
-		// to use in such a case to hold the second command
-		// e.g.: PA3084 ,2414 SR 1.472 , 2.279 ;
-		//       PA3444 ,736 SP1;
-		secondHPGLcmd = g_malloc0( strlen( sHPGL ) );
-		// so this will work to capture all of the trailing string.
-		// Normally %s will stop at a whitespace in sscanf so we use "not 0200" (everything)
-		nArgs = sscanf(sHPGL+2, "%hd , %hd %[^\0200]", &posn.x, &posn.y, secondHPGLcmd);
-
-		if( bPenDown ) {
-			// make sure we have enough space .. quantized by 100 points
-			currentLine = g_realloc_n( currentLine, QUANTIZE(nPointsInLine + 1, 100) + sizeof(guint16), sizeof( tCoord ) );
-			currentLine[ nPointsInLine ] = posn;
-			nPointsInLine++;
-		}
-		// we have more than just x and y .. i.e another command on the same lineHLD_LBL_YPOS_CH1
-		// I don't think this should occur with HPGL ... but there you have it
-		if( nArgs == 3 ) {
-			*(guint *)(pGlobal->HP8753.plotHPGL) = HPGLserialCount;
-			bPresumedEnd |= parseHPGL( (gchar *)secondHPGLcmd, pGlobal );
-			HPGLserialCount = *(guint *)(pGlobal->HP8753.plotHPGL);
-		}
-		g_free( secondHPGLcmd );
-		bNewPosition = TRUE;
-		break;
-	case HPGL_LABEL:
-		strLength = strlen( sHPGL+2 );
-		if( strLength == 0 )
-			break;	// don't bother adding null labels ("LB;")
+/*!     \brief  Compile the HPGL command just parsed
+ *
+ * \param  pParser	parser context
+ */
+static void
+compileHPGLcommand( tHPGLparser *pParser ) {
+	gdouble *param = pParser->parameters;
+	gint nParams = pParser->nParameters;
+	guchar byte;
 
-#define HLD_LBL_YPOS_CH2	384
-#define HLD_LBL_YPOS_CH1	2432
-		// Dont show the Hld if we are not in hold
-		if( g_str_has_prefix( sHPGL, "LBHld\003" )  && posn.x == 0 ) {
-		    if( posn.y == HLD_LBL_YPOS_CH1 ) {
-		        if( ( pGlobal->HP8753.flags.bDualChannel && !pGlobal->HP8753.channels[ eCH_ONE ].chFlags.bSweepHold )
-		                || ( !pGlobal->HP8753.flags.bDualChannel &&
-		                        !pGlobal->HP8753.channels[ pGlobal->HP8753.activeChannel ].chFlags.bSweepHold ) ) {
-		            // show the scan arrow instead of 'Hld'
-		            // allocate more space if needed
-		            pGlobal->HP8753.plotHPGL = g_realloc( pGlobal->HP8753.plotHPGL,
-		                    QUANTIZE( HPGLserialCount + sizeof( struct scanArrow ), 1000 ) );
-		            memcpy( pGlobal->HP8753.plotHPGL + HPGLserialCount, &upperScanArrow, sizeof (struct scanArrow ));
-		            HPGLserialCount += sizeof (struct scanArrow );
-		            break;
-		        }
-		    } else if( !pGlobal->HP8753.channels[ eCH_TWO ].chFlags.bSweepHold ) {
-                // show the scan arrow instead of 'Hld'
-                // allocate more space if needed
-                pGlobal->HP8753.plotHPGL = g_realloc( pGlobal->HP8753.plotHPGL,
-                        QUANTIZE( HPGLserialCount + sizeof( struct scanArrow ), 1000 ) );
-                memcpy( pGlobal->HP8753.plotHPGL + HPGLserialCount, &lowerScanArrow, sizeof (struct scanArrow ));
-                HPGLserialCount += sizeof (struct scanArrow );
-                break;
-            }
-		}
+	pParser->nCommands++;
 
-		// labels from the 8753 have 003 characters .. remove them
-		if( sHPGL[ 2 + strLength - 1 ] == HPGL_LINE_TERMINATOR_CHARACTER )
-			sHPGL[ 2 + strLength - 1 ] = 0;
-		// allocate more space if needed
-		pGlobal->HP8753.plotHPGL = g_realloc( pGlobal->HP8753.plotHPGL,
-				QUANTIZE( HPGLserialCount + sizeof(eHPGL) + sizeof(tCoord) + sizeof( guchar ) + strLength, 1000 ) );
-		// insert the label identifier
-		*(eHPGL *)(pGlobal->HP8753.plotHPGL + HPGLserialCount) = bNewPosition ? CHPGL_LABEL:CHPGL_LABEL_REL;
-		HPGLserialCount += sizeof(eHPGL);
-		// insert the location
-		*(tCoord *)(pGlobal->HP8753.plotHPGL + HPGLserialCount) = posn;
-		HPGLserialCount += sizeof(tCoord);
-		// next the string length (max 255 characters)
-		*(guchar *)(pGlobal->HP8753.plotHPGL + HPGLserialCount) = (guchar) strLength;
-		HPGLserialCount += sizeof(guchar);
-		// copy the string (and the null)
-		memcpy( pGlobal->HP8753.plotHPGL + HPGLserialCount, sHPGL + 2, strLength+1);
-		HPGLserialCount += strLength+1;
-		bNewPosition = FALSE;
+	switch( pParser->mnemonic ) {
+	case HPGL_POSN_ABS:
+		for( gint i = 0; i + 1 < nParams; i += 2 )
+			movePen( pParser, param[ i ], param[ i+1 ] );
 		break;
 	case HPGL_PEN_UP:
-		if( bPenDown ) {
-			// End of a line ...
-			// this concludes the line..  Add the accumulated line points to the compiled HPGL serial store
-			// enlarge the buffer .. g_realloc will only do this if necessary
-			pGlobal->HP8753.plotHPGL = g_realloc( pGlobal->HP8753.plotHPGL,
-					QUANTIZE( HPGLserialCount + sizeof(eHPGL) + sizeof( guint16 ) + (nPointsInLine * sizeof(tCoord)), 1000 ) );
-			// insert the compiled HPGL command (either CHPGL_LINE2PT or CHPGL_LINE)
-			if( nPointsInLine == 2 ) {
-				// if it just a two point line, we don't save the number of points .. its implicit
-				*(eHPGL *)(pGlobal->HP8753.plotHPGL + HPGLserialCount) = CHPGL_LINE2PT;
-				HPGLserialCount += sizeof(eHPGL);
-			} else {
-				*(eHPGL *)(pGlobal->HP8753.plotHPGL + HPGLserialCount) = CHPGL_LINE;
-				HPGLserialCount +=sizeof(eHPGL);
-				// next save the number of points in the line
-				*(guint16 *)(pGlobal->HP8753.plotHPGL + HPGLserialCount) = nPointsInLine;
-				HPGLserialCount += sizeof( guint16 );
-			}
-			memcpy( pGlobal->HP8753.plotHPGL + HPGLserialCount, currentLine, nPointsInLine * sizeof(tCoord) );
-			HPGLserialCount += (nPointsInLine * sizeof(tCoord));
-		}
-
-		// We have completed the line, so dispose of the malloced memory
-		g_free( currentLine );
-		nPointsInLine = 0;
-		currentLine = NULL;
-		// Remember that the pen is up
-		bPenDown = FALSE;
+		penUp( pParser );
+		for( gint i = 0; i + 1 < nParams; i += 2 )
+			movePen( pParser, param[ i ], param[ i+1 ] );
 		break;
 	case HPGL_PEN_DOWN:
 		// assume we are starting a new line and save the start point
-		if( !bPenDown ) {
-			currentLine = g_realloc_n( currentLine, QUANTIZE(1, 100), sizeof( tCoord ) );
-			currentLine[0] = posn;
-			nPointsInLine = 1;
-			bPenDown = TRUE;
-		}
+		penDown( pParser );
+		for( gint i = 0; i + 1 < nParams; i += 2 )
+			movePen( pParser, param[ i ], param[ i+1 ] );
+		break;
+	case HPGL_LABEL:
+		compileLabel( pParser );
 		break;
 	case HPGL_CHAR_SIZE_REL:
-		sscanf(sHPGL+2, "%f , %f", &charSizeX, &charSizeY);
-		pGlobal->HP8753.plotHPGL = g_realloc( pGlobal->HP8753.plotHPGL,
-				QUANTIZE( HPGLserialCount + sizeof(eHPGL) + (2 * sizeof(gfloat)), 1000 ) );
-		// add the text size change to the compiled HPGL serialized string
-		*(eHPGL *)(pGlobal->HP8753.plotHPGL + HPGLserialCount) = CHPGL_TEXT_SIZE;
-		HPGLserialCount += sizeof(eHPGL);
-		*(gfloat *)(pGlobal->HP8753.plotHPGL + HPGLserialCount) = charSizeX;
-		HPGLserialCount += sizeof( gfloat );
-		*(gfloat *)(pGlobal->HP8753.plotHPGL + HPGLserialCount) = charSizeY;
-		HPGLserialCount += sizeof( gfloat );
+		if( nParams >= 1 )
+			pParser->charSizeX = param[0];
+		if( nParams >= 2 )
+			pParser->charSizeY = param[1];
+		// add the text size change to the compiled HPGL
+		emitCHPGL( pParser, CHPGL_TEXT_SIZE );
+		arenaAppend( &pParser->arena, &pParser->charSizeX, sizeof( gfloat ) );
+		arenaAppend( &pParser->arena, &pParser->charSizeY, sizeof( gfloat ) );
 		break;
 	case HPGL_LINE_TYPE:
-		sscanf(sHPGL+2, "%d", &lineType);
-		pGlobal->HP8753.plotHPGL = g_realloc( pGlobal->HP8753.plotHPGL,
-				QUANTIZE( HPGLserialCount + sizeof(eHPGL) + sizeof(guchar), 1000 ) );
-		*(eHPGL *)(pGlobal->HP8753.plotHPGL + HPGLserialCount) = CHPGL_LINETYPE;
-		HPGLserialCount += sizeof(eHPGL);
-		*(guchar *)(pGlobal->HP8753.plotHPGL + HPGLserialCount) = (guchar)lineType;
-		HPGLserialCount += sizeof( gchar );
+		if( nParams >= 1 )
+			pParser->lineType = (gint)param[0];
+		emitCHPGL( pParser, CHPGL_LINETYPE );
+		byte = (guchar)pParser->lineType;
+		arenaAppend( &pParser->arena, &byte, sizeof( guchar ) );
 		break;
 	case HPGL_SELECT_PEN:
-		sscanf(sHPGL+2, "%d", &colour);
+		if( nParams >= 1 )
+			pParser->colour = (gint)param[0];
 		// bizarrely there is, occasionally, a pen change while the pen is down..
 		// so close the current line (so the old color will be used when it is stroked)
 		// and start a new line from the current point
-		if( bPenDown ) {
-            bPresumedEnd |= parseHPGL( "PU", pGlobal );
-            HPGLserialCount = *(guint *)(pGlobal->HP8753.plotHPGL);
-            bPresumedEnd |= parseHPGL( "PD", pGlobal );
+		if( pParser->bPenDown ) {
+			penUp( pParser );
+			penDown( pParser );
 		}
-		pGlobal->HP8753.plotHPGL = g_realloc( pGlobal->HP8753.plotHPGL,
-				QUANTIZE( HPGLserialCount + sizeof(eHPGL) + sizeof(gchar), 1000 ) );
-		*(eHPGL *)(pGlobal->HP8753.plotHPGL + HPGLserialCount) = CHPGL_PEN;
-		HPGLserialCount += sizeof(eHPGL);
-		*(gchar *)(pGlobal->HP8753.plotHPGL + HPGLserialCount) = (gchar)colour;
-		HPGLserialCount += sizeof( gchar );
-		if( colour == 0 && posn.x == 0 )
-		    bPresumedEnd = TRUE;
+		emitCHPGL( pParser, CHPGL_PEN );
+		byte = (guchar)pParser->colour;
+		arenaAppend( &pParser->arena, &byte, sizeof( guchar ) );
+		// selecting pen 0 (white) indicates end of plot
+		if( pParser->colour == 0 && pParser->posn.x == 0 )
+			pParser->bPresumedEnd = TRUE;
 		break;
 	case HPGL_SCALING_PTS:
-        sscanf(sHPGL+2, "%d,%d,%d,%d", &temp1, &scalePtX, &temp2, &scalePtY);
-        scalePtX -= temp1;
-        scalePtY -= temp2;
-        break;
-	    break;
+		if( nParams == 4 ) {
+			pParser->scalePtX = (gint)(param[2] - param[0]);
+			pParser->scalePtY = (gint)(param[3] - param[1]);
+		}
+		break;
 	case HPGL_SCALING:
-	    sscanf(sHPGL+2, "%d,%d,%d,%d", &temp1, &scaleX, &temp2, &scaleY);
-	    scaleX -= temp1;
-	    scaleY -= temp2;
-	    break;
-    case HPGL_VELOCITY:
-    case HPGL_INPUT_MASK:
+		if( nParams == 4 ) {
+			pParser->scaleX = (gint)(param[1] - param[0]);
+			pParser->scaleY = (gint)(param[3] - param[2]);
+		}
+		break;
+	case HPGL_VELOCITY:
+	case HPGL_INPUT_MASK:
 	case HPGL_DEFAULT:
 	case HPGL_PAGE_FEED:
 	default:
 		break;
 	}
+}
 
-	// update the count
-	if( pGlobal->HP8753.plotHPGL )
-		*(guint *)(pGlobal->HP8753.plotHPGL) = HPGLserialCount;
+/*!     \brief  Complete the number being parsed
+ *
+ * \param  pParser	parser context
+ */
+static void
+endNumber( tHPGLparser *pParser ) {
+	if( pParser->bInNumber && pParser->nParameters < HPGL_MAX_PARAMETERS )
+		pParser->parameters[ pParser->nParameters++ ] = pParser->bNegative ? -pParser->number : pParser->number;
+	pParser->bInNumber = FALSE;
+}
 
-	return bPresumedEnd;
+/*!     \brief  Initialize the parse of an HPGL plot
+ *
+ * The 'Hld' annotation is replaced by a scan arrow for channels that are sweeping.
+ * The hold state is taken from the global data now so the parse itself does not
+ * refer to it.
+ *
+ * \param  pParser	parser context
+ * \param  pGlobal	pointer to global data (or NULL if no channel is sweeping)
+ */
+void
+initHPGLparser( tHPGLparser *pParser, tGlobal *pGlobal ) {
+	memset( pParser, 0, sizeof( tHPGLparser ) );
+	pParser->state = eHPGL_MNEMONIC1;
+	pParser->currentLine = g_array_sized_new( FALSE, FALSE, sizeof( tCoord ), 100 );
+	pParser->scaleX = HPGL_MAX_X;
+	pParser->scaleY = HPGL_MAX_Y;
+	pParser->scalePtX = HPGL_P1P2_X;
+	pParser->scalePtY = HPGL_P1P2_Y;
+
+	if( pGlobal ) {
+		tHP8753 *pHP8753 = &pGlobal->HP8753;
+
+		pParser->bScanArrowUpper = pHP8753->flags.bDualChannel ?
+				!pHP8753->channels[ eCH_ONE ].chFlags.bSweepHold
+				: !pHP8753->channels[ pHP8753->activeChannel ].chFlags.bSweepHold;
+		pParser->bScanArrowLower = !pHP8753->channels[ eCH_TWO ].chFlags.bSweepHold;
+	}
 }
 
-/*!     \brief  Display the 8753 screen image
+/*!     \brief  Parse (and compile) part of an HPGL stream
+ *
+ * The HPGL from the 8753 is parsed, a byte at a time, as it arrives. A command
+ * may be split between calls. The compiled serial data (for plotScreen) is....
+ * NNNNNNNN - byte count (total count of bytes for the data)
+ * Line         - CHPGL_LINE - identifier
+ *                NN          - 16 bit count of points in line (n)
+ *                NN          - 16 bit x1 position
+ *                NN          - 16 bit y1 position
+ *                x & y repeated for coordinate 2 to n
+ * 2 point Line - CHPGL_LINE2PT - identifier
+ *                NN          - 16 bit x1 position
+ *                NN          - 16 bit y1 position
+ *                NN          - 16 bit x2 position
+ *                NN          - 16 bit y2 position
+ * label        - CHPGL_LABEL or CHPGL_LABEL_REL - identifier
+ *                NN          - 16 bit x position
+ *                NN          - 16 bit y position
+ *                N           - 8 bit byte count of string (n)
+ *                SSSSSSS.... - string followed by a null (n+1 bytes)
+ * lable size   - CHPGL_TEXT_SIZE - identifier
+ *                NNNN        - float character size scaling in x (percentage of P2-P1 x)
+ *                NNNN        - float character size scaling in y (percentahge of P2-P1 y)
+ * pen select   - CHPGL_PEN - identifier
+ *                N           - 8 bits identifying the pen (colour)
+ * line type    - CHPGL_LINETYPE - identifier
+ *                N           - 8 bits identifying the line type (AFAICT this does not change)
  *
- * If the plot is polar, draw the grid and legends.
- * If there is an overlay of two polar grids of the same scale show both,
- * otherwise actual grid is only drawn once.
+ * \param  pParser	parser context
+ * \param  pHPGL	HPGL bytes
+ * \param  length	number of bytes
+ * \return TRUE if the end of the plot is presumed (pen 0 was selected)
+ */
+gboolean
+parseHPGLstream( tHPGLparser *pParser, const gchar *pHPGL, gsize length ) {
+	for( const gchar *pCursor = pHPGL, *pEnd = pHPGL + length; pCursor < pEnd; pCursor++ ) {
+		gchar c = *pCursor;
+
+		switch( pParser->state ) {
+		case eHPGL_LABEL:
+			// labels are terminated by 003 (and the 8753 follows that with ';')
+			if( c == HPGL_LINE_TERMINATOR_CHARACTER || c == ';' ) {
+				pParser->bLabelTerminated = (c == HPGL_LINE_TERMINATOR_CHARACTER);
+				compileHPGLcommand( pParser );
+				pParser->state = eHPGL_MNEMONIC1;
+			} else if( pParser->labelLength < HPGL_MAX_LABEL ) {
+				pParser->label[ pParser->labelLength++ ] = c;
+			}
+			break;
+
+		case eHPGL_PARAMETERS:
+			if( g_ascii_isdigit( c ) ) {
+				if( !pParser->bInNumber ) {
+					pParser->bInNumber = TRUE;
+					pParser->bNegative = FALSE;
+					pParser->number = 0.0;
+					pParser->fractionScale = 0.0;
+				}
+				if( pParser->fractionScale == 0.0 ) {
+					pParser->number = pParser->number * 10.0 + (c - '0');
+				} else {
+					pParser->number += (c - '0') * pParser->fractionScale;
+					pParser->fractionScale /= 10.0;
+				}
+				break;
+			} else if( c == '.' || c == '-' || c == '+' ) {
+				if( !pParser->bInNumber || c == '.' ) {
+					if( !pParser->bInNumber ) {
+						pParser->bInNumber = TRUE;
+						pParser->number = 0.0;
+						pParser->bNegative = (c == '-');
+						pParser->fractionScale = 0.0;
+					}
+					if( c == '.' )
+						pParser->fractionScale = 0.1;
+				}
+				break;
+			}
+			endNumber( pParser );
+			if( c == ';' ) {
+				compileHPGLcommand( pParser );
+				pParser->state = eHPGL_MNEMONIC1;
+			} else if( g_ascii_isalpha( c ) ) {
+				// another command follows without a ';' (e.g. PA3444 ,736 SP1;)
+				compileHPGLcommand( pParser );
+				pParser->mnemonic = (guchar)g_ascii_toupper( c ) << 8;
+				pParser->state = eHPGL_MNEMONIC2;
+			}
+			// otherwise a separator (',' or white space)
+			break;
+
+		case eHPGL_MNEMONIC2:
+			if( g_ascii_isalpha( c ) ) {
+				pParser->mnemonic |= (guchar)g_ascii_toupper( c );
+				pParser->nParameters = 0;
+				pParser->bInNumber = FALSE;
+				if( pParser->mnemonic == HPGL_LABEL ) {
+					pParser->labelLength = 0;
+					pParser->state = eHPGL_LABEL;
+				} else {
+					pParser->state = eHPGL_PARAMETERS;
+				}
+				break;
+			}
+			// all our HPGL commands are two ASCII characters
+			pParser->state = eHPGL_MNEMONIC1;
+			break;
+
+		case eHPGL_MNEMONIC1:
+		default:
+			if( g_ascii_isalpha( c ) ) {
+				pParser->mnemonic = (guchar)g_ascii_toupper( c ) << 8;
+				pParser->state = eHPGL_MNEMONIC2;
+			}
+			// ';' and white space between commands are ignored
+			break;
+		}
+	}
+	return pParser->bPresumedEnd;
+}
+
+/*!     \brief  Complete the parse of an HPGL plot
  *
- * \ingroup drawing
+ * A final command without a terminator is compiled. A line still being drawn
+ * is abandoned.
  *
- * \param cr		pointer to cairo context
- * \param pGrid		pointer to grid parameters
- * \param pGlobal	pointer to global data
- * \return			TRUE
+ * \param  pParser	parser context (freed)
+ * \return compiled HPGL (g_free when done) in one block with the byte count at its head
+ */
+void *
+finishHPGLparser( tHPGLparser *pParser ) {
+	tHPGLarena *pArena = &pParser->arena;
+	guchar *plotHPGL, *pDest;
+	guint length;
+
+	if( pParser->state == eHPGL_PARAMETERS ) {
+		endNumber( pParser );
+		compileHPGLcommand( pParser );
+	} else if( pParser->state == eHPGL_LABEL ) {
+		pParser->bLabelTerminated = FALSE;
+		compileHPGLcommand( pParser );
+	}
+	pParser->state = eHPGL_MNEMONIC1;
+
+	// join the chunks
+	length = sizeof( guint ) + pArena->nTotal;
+	plotHPGL = g_malloc( length );
+	*(guint *)plotHPGL = length;
+	pDest = plotHPGL + sizeof( guint );
+	for( guint i = 0; pArena->chunks && i < pArena->chunks->len; i++ ) {
+		gsize nChunk = (i == pArena->chunks->len - 1) ? pArena->nUsedInLast : HPGL_ARENA_CHUNK_SIZE;
+		memcpy( pDest, g_ptr_array_index( pArena->chunks, i ), nChunk );
+		pDest += nChunk;
+	}
+
+	freeHPGLparser( pParser );
+	return plotHPGL;
+}
+
+/*!     \brief  Free the parser context (abandoning the plot)
+ *
+ * \param  pParser	parser context
+ */
+void
+freeHPGLparser( tHPGLparser *pParser ) {
+	g_clear_pointer( &pParser->arena.chunks, g_ptr_array_unref );
+	pParser->arena.nTotal = pParser->arena.nUsedInLast = 0;
+	g_clear_pointer( &pParser->currentLine, g_array_unref );
+}
+
+/*!     \brief  Compile an HPGL stream fed to the parser in chunks
  *
+ * \param  sHPGL		the HPGL stream
+ * \param  length		its length
+ * \param  chunkSize	bytes passed to each call of parseHPGLstream
+ * \param  pnCommands	number of commands parsed (or NULL)
+ * \return compiled HPGL (g_free when done)
+ */
+static void *
+compileHPGLinChunks( const gchar *sHPGL, gsize length, gsize chunkSize, guint *pnCommands ) {
+	tHPGLparser parser;
+
+	initHPGLparser( &parser, NULL );
+	for( gsize offset = 0; offset < length; offset += chunkSize )
+		parseHPGLstream( &parser, sHPGL + offset, MIN( chunkSize, length - offset ) );
+	if( pnCommands )
+		*pnCommands = parser.nCommands;
+	return finishHPGLparser( &parser );
+}
+
+/*!     \brief  Time the HPGL parser on captured plots
+ *
+ * Each file holds an OUTPPLOT stream captured from an 8753 (e.g. with --debug 6
+ * the HPGL is echoed to stderr as it is received). The stream is fed to the parser
+ * in the chunks received over GPIB, repeatedly, and the time taken is printed.
+ * The plot compiled from the whole stream must be the same, byte for byte, as that
+ * compiled when the stream is split into small pieces (so a command, number or label
+ * is split across calls), otherwise the file is reported as failed.
+ * See tools/hpgl and 'make check'.
+ *
+ * \param  sFiles	NULL terminated list of file names
+ * \param  nRepeat	number of times to parse each file
+ * \return 0 if all files were read and compiled the same when split, 1 otherwise
+ */
+#define MAX_HPGL_PLOT_CHUNK    1000
+gint
+benchmarkHPGLparser( gchar **sFiles, gint nRepeat ) {
+	static const gsize splitChunkSizes[] = { 1, 2, 3, 7, 64, MAX_HPGL_PLOT_CHUNK };
+	gint status = 0;
+
+	nRepeat = MAX( nRepeat, 1 );
+	g_print( "%-40s %8s %9s %9s %10s %10s %6s\n", "file", "bytes", "commands", "compiled", "us/parse", "MB/s", "split" );
+	for( gint f = 0; sFiles && sFiles[ f ]; f++ ) {
+		gchar *sHPGL = NULL;
+		gsize length = 0, compiledLength = 0;
+		guint nCommands = 0;
+		GError *pError = NULL;
+		gint64 start, elapsed;
+		void *plotWhole;
+		gboolean bSame = TRUE;
+
+		if( !g_file_get_contents( sFiles[ f ], &sHPGL, &length, &pError ) ) {
+			g_printerr( "%s\n", pError->message );
+			g_clear_error( &pError );
+			status = 1;
+			continue;
+		}
+
+		start = g_get_monotonic_time();
+		for( gint n = 0; n < nRepeat; n++ ) {
+			void *plotHPGL = compileHPGLinChunks( sHPGL, length, MAX_HPGL_PLOT_CHUNK, &nCommands );
+			compiledLength = *(guint *)plotHPGL;
+			g_free( plotHPGL );
+		}
+		elapsed = MAX( g_get_monotonic_time() - start, 1 );
+
+		// the compiled plot must not depend on how the stream was received
+		plotWhole = compileHPGLinChunks( sHPGL, length, MAX( length, 1 ), NULL );
+		for( gint i = 0; i < G_N_ELEMENTS( splitChunkSizes ); i++ ) {
+			void *plotSplit = compileHPGLinChunks( sHPGL, length, splitChunkSizes[ i ], NULL );
+			if( *(guint *)plotSplit != *(guint *)plotWhole
+					|| memcmp( plotSplit, plotWhole, *(guint *)plotWhole ) != 0 ) {
+				g_printerr( "%s: compiled differently when parsed %zu bytes at a time\n",
+						sFiles[ f ], splitChunkSizes[ i ] );
+				bSame = FALSE;
+			}
+			g_free( plotSplit );
+		}
+		g_free( plotWhole );
+		if( !bSame )
+			status = 1;
+
+		g_print( "%-40s %8zu %9u %9zu %10.1f %10.1f %6s\n", sFiles[ f ], length, nCommands, compiledLength,
+				(gdouble)elapsed / nRepeat, (gdouble)length * nRepeat / elapsed, bSame ? "same" : "DIFFER" );
+		g_free( sHPGL );
+	}
+	return status;
+}
+
+/*!     \brief  Draw the compiled HPGL screen plot
+ *
+ * Walk the compiled HPGL (see parseHPGL) and draw each line and label.
+ *
+ * \ingroup drawing
+ *
+ * \param cr			pointer to cairo context
+ * \param areaHeight	height of the plot area
+ * \param areaWidth		width of the plot area
+ * \param plotHPGL		compiled HPGL data
+ * \param pPens		colors of the HPGL pens
  */
 #define ASPECT_CORRECTION 1.070
-gboolean
-plotScreen (cairo_t *cr, guint areaHeight, guint areaWidth, tGlobal *pGlobal)
+static void
+drawCompiledHPGL (cairo_t *cr, guint areaHeight, guint areaWidth, void *plotHPGL, GdkRGBA *pPens)
 {
 
-	if( pGlobal->HP8753.plotHPGL ) {
+	if( plotHPGL ) {
 		guint HPGLserialCount = 0;
-		static gfloat charSizeX = 1.0, charSizeY = 1.0;
-		guint length = *((guint *)pGlobal->HP8753.plotHPGL);
+		gfloat charSizeX = 1.0, charSizeY = 1.0;
+		guint length = *((guint *)plotHPGL);
 		gint HPGLpen = 0;
 		gint ptsInLine;
 		cairo_matrix_t matrix;
@@ -363,20 +608,20 @@ plotScreen (cairo_t *cr, guint areaHeight, guint areaWidth, tGlobal *pGlobal)
 	        cairo_select_font_face(cr, HPGL_FONT, CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
 
 			// If we don't set the color its black ... but the HP8753 does
-			gdk_cairo_set_source_rgba (cr, &HPGLpens[1] );      // black pen by default
+			gdk_cairo_set_source_rgba (cr, &pPens[1] );      // black pen by default
 			cairo_set_line_width (cr, areaWidth / 1000.0 * 0.75);
 
 			do {
 				// get compiled HPGL command byte
-				eHPGL cmd = *((guchar *)(pGlobal->HP8753.plotHPGL+HPGLserialCount)) ;
+				eHPGL cmd = *((guchar *)(plotHPGL+HPGLserialCount)) ;
 				HPGLserialCount += sizeof( eHPGL );
 
 				switch ( cmd ) {
 				case CHPGL_LINE:
 					// the points in the line are preceded by the point count
-					ptsInLine = *((guint16 *)(pGlobal->HP8753.plotHPGL+HPGLserialCount));
+					ptsInLine = *((guint16 *)(plotHPGL+HPGLserialCount));
 					HPGLserialCount += sizeof( guint16 );
-					pPoint = (tCoord *)(pGlobal->HP8753.plotHPGL+HPGLserialCount);
+					pPoint = (tCoord *)(plotHPGL+HPGLserialCount);
 					cairo_new_path( cr );
 					// move to first point
 					cairo_move_to(cr, leftOffset + pPoint->x * scaleX, bottomOffset + pPoint->y * scaleY );
@@ -389,7 +634,7 @@ plotScreen (cairo_t *cr, guint areaHeight, guint areaWidth, tGlobal *pGlobal)
 					HPGLserialCount += (ptsInLine * sizeof( tCoord ));
 					break;
 				case CHPGL_LINE2PT:
-					pPoint = (tCoord *)(pGlobal->HP8753.plotHPGL+HPGLserialCount);
+					pPoint = (tCoord *)(plotHPGL+HPGLserialCount);
 					cairo_new_path( cr );
 					// move to first point
 					cairo_move_to(cr, leftOffset + pPoint->x * scaleX, bottomOffset + pPoint->y * scaleY );
@@ -400,24 +645,24 @@ plotScreen (cairo_t *cr, guint areaHeight, guint areaWidth, tGlobal *pGlobal)
 					HPGLserialCount += (2 * sizeof( tCoord ));
 					break;
 				case CHPGL_PEN:
-					HPGLpen = *(guchar *)(pGlobal->HP8753.plotHPGL + HPGLserialCount);
+					HPGLpen = *(guchar *)(plotHPGL + HPGLserialCount);
 					HPGLserialCount += sizeof( guchar );
-					gdk_cairo_set_source_rgba (cr, &HPGLpens[ HPGLpen < NUM_HPGL_PENS ? HPGLpen : 1 ] );
+					gdk_cairo_set_source_rgba (cr, &pPens[ HPGLpen < NUM_HPGL_PENS ? HPGLpen : 1 ] );
 					break;
 				case CHPGL_LINETYPE:
-					HPGLlineType = *(guchar *)(pGlobal->HP8753.plotHPGL + HPGLserialCount);
+					HPGLlineType = *(guchar *)(plotHPGL + HPGLserialCount);
 					HPGLserialCount += sizeof( guchar );
 					break;
 				case CHPGL_LABEL:
 				case CHPGL_LABEL_REL:
-					pPoint = (tCoord *)(pGlobal->HP8753.plotHPGL + HPGLserialCount);
+					pPoint = (tCoord *)(plotHPGL + HPGLserialCount);
 					HPGLserialCount += sizeof( tCoord );
 					if( cmd == CHPGL_LABEL )
 						cairo_move_to(cr, leftOffset + pPoint->x * scaleX, bottomOffset + pPoint->y * scaleY );
-					guint labelLength = *(guchar *)(pGlobal->HP8753.plotHPGL + HPGLserialCount);
+					guint labelLength = *(guchar *)(plotHPGL + HPGLserialCount);
 					HPGLserialCount += sizeof( guchar );
 					// label is null terminated
-					gchar *pLabel = (gchar *)(pGlobal->HP8753.plotHPGL + HPGLserialCount);
+					gchar *pLabel = (gchar *)(plotHPGL + HPGLserialCount);
 					gchar *ptr = strchr( pLabel, '\b' );
 					// If we have a backspace, then there is an underscore (number of marker)
 					if( !ptr) {
@@ -443,9 +688,9 @@ plotScreen (cairo_t *cr, guint areaHeight, guint areaWidth, tGlobal *pGlobal)
 					break;
 				case CHPGL_TEXT_SIZE:
 				    cairo_matrix_init_identity( &matrix );
-					charSizeX = *(gfloat *)(pGlobal->HP8753.plotHPGL + HPGLserialCount);
+					charSizeX = *(gfloat *)(plotHPGL + HPGLserialCount);
 					HPGLserialCount += sizeof( gfloat );
-					charSizeY = *(gfloat *)(pGlobal->HP8753.plotHPGL + HPGLserialCount);
+					charSizeY = *(gfloat *)(plotHPGL + HPGLserialCount);
 					HPGLserialCount += sizeof( gfloat );
 					matrix.xx = charSizeX  * HPGL_P1P2_X * scaleX / 100.0;
 					matrix.yy = -charSizeY * HPGL_P1P2_Y * scaleY / 112.0;  // Slighly reduce height compared with width
@@ -457,6 +702,83 @@ plotScreen (cairo_t *cr, guint areaHeight, guint areaWidth, tGlobal *pGlobal)
 			} while (HPGLserialCount < length);
 		}
 	} cairo_restore( cr );
+}
+
+// The compiled HPGL drawn to a recording surface, replayed on each redraw
+static struct {
+	cairo_surface_t *pRecording;
+	guint	HPGLgeneration;		// of the compiled HPGL recorded
+	guint	areaWidth, areaHeight;
+} HPGLrecording = { 0 };
+
+/*!     \brief  Discard the recording of the HPGL screen plot
+ *
+ * Called when the HPGL pen colors are changed. A new plot is noticed
+ * by its HPGLgeneration.
+ */
+void
+clearHPGLrecording( void )
+{
+	g_clear_pointer( &HPGLrecording.pRecording, cairo_surface_destroy );
+}
+
+/*!     \brief  Display the 8753 screen image
+ *
+ * The compiled HPGL is drawn once (for each capture and plot size) to a cairo
+ * recording surface which is then replayed. The replay is vector to vector
+ * so PDF, SVG and print output are unchanged.
+ * Exports draw a snapshot of the data on another thread; they draw directly.
+ *
+ * \ingroup drawing
+ *
+ * \param cr			pointer to cairo context
+ * \param areaHeight	height of the plot area
+ * \param areaWidth		width of the plot area
+ * \param pGlobal		pointer to global data
+ * \return				TRUE
+ */
+gboolean
+plotScreen (cairo_t *cr, guint areaHeight, guint areaWidth, tGlobal *pGlobal)
+{
+	void *plotHPGL = pGlobal->HP8753.plotHPGL;
+
+	if( plotHPGL == NULL )
+		return TRUE;
+
+	if( pGlobal->bSnapshot ) {
+		drawCompiledHPGL( cr, areaHeight, areaWidth, plotHPGL, pGlobal->HPGLpens );
+		return TRUE;
+	}
+
+	// the recording is of the same HPGL data (see HPGLgeneration) at the same size
+	if( HPGLrecording.pRecording == NULL
+			|| HPGLrecording.areaWidth != areaWidth || HPGLrecording.areaHeight != areaHeight
+			|| HPGLrecording.HPGLgeneration != pGlobal->HP8753.HPGLgeneration ) {
+		cairo_font_options_t *pFontOptions = cairo_font_options_create();
+		cairo_t *crRecording;
+
+		clearHPGLrecording();
+		HPGLrecording.pRecording = cairo_recording_surface_create( CAIRO_CONTENT_COLOR_ALPHA, NULL );
+		crRecording = cairo_create( HPGLrecording.pRecording );
+		// labels are rendered as they would be directly
+		cairo_get_font_options( cr, pFontOptions );
+		cairo_set_font_options( crRecording, pFontOptions );
+		cairo_font_options_destroy( pFontOptions );
+
+		drawCompiledHPGL( crRecording, areaHeight, areaWidth, plotHPGL, pGlobal->HPGLpens );
+		cairo_destroy( crRecording );
+
+		HPGLrecording.HPGLgeneration = pGlobal->HP8753.HPGLgeneration;
+		HPGLrecording.areaWidth = areaWidth;
+		HPGLrecording.areaHeight = areaHeight;
+	}
+
+	// the recording is in user space (after the flip and translation of the caller)
+	cairo_save( cr );
+	cairo_set_source_surface( cr, HPGLrecording.pRecording, 0.0, 0.0 );
+	cairo_paint( cr );
+	cairo_restore( cr );
+
 	return TRUE;
 }
 
@@ -492,6 +814,7 @@ clearHP8753traces( tHP8753 *pHP8753 ) {
         g_free( pHP8753->channels[channel].stimulusPoints );
         pHP8753->channels[channel].responsePoints = NULL;
         pHP8753->channels[channel].stimulusPoints = NULL;
+        clearDerivedTraceData( &pHP8753->channels[channel] );
         pHP8753->channels[channel].nPoints = 0;
         pHP8753->channels[channel].nSegments = 0;
         for( gint seg=0; seg < MAX_SEGMENTS; seg++ ) {
@@ -499,6 +822,7 @@ clearHP8753traces( tHP8753 *pHP8753 ) {
             pHP8753->channels[channel].segments[ seg ].startFreq = 0.0;
             pHP8753->channels[channel].segments[ seg ].stopFreq = 0.0;
         }
+        indexSegments( &pHP8753->channels[channel] );
 
         pHP8753->channels[channel].chFlags.bValidData = FALSE;
     }
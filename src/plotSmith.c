@@ -46,11 +46,12 @@ searchForStimulusValueInSegment( gint nSegmentStart, gint nSegmentEnd, tChannel
 		                gdouble stimulusTarget, gdouble *pSamplePoint ) {
     gint nHead = nSegmentStart, nTail = nSegmentEnd;
     gint nMid = (nHead + nTail) / 2;
+    gdouble *stimulusPoints = getStimulusPoints( pChannel );
 
     while ( nHead <= nTail )  {
-        if ( pChannel->stimulusPoints[nMid] < stimulusTarget ) {
+        if ( stimulusPoints[nMid] < stimulusTarget ) {
         	nHead = nMid + 1;
-        } else if ( pChannel->stimulusPoints[nMid] == stimulusTarget ) {
+        } else if ( stimulusPoints[nMid] == stimulusTarget ) {
         	*pSamplePoint = (double)nMid;
         	return TRUE;
         } else {
@@ -60,8 +61,8 @@ searchForStimulusValueInSegment( gint nSegmentStart, gint nSegmentEnd, tChannel
     }
 
     if( nHead > nTail ) {
-		*pSamplePoint = (gdouble)nMid + (stimulusTarget - pChannel->stimulusPoints[nMid]) /
-    			(pChannel->stimulusPoints[nMid+1] - pChannel->stimulusPoints[nMid]);
+		*pSamplePoint = (gdouble)nMid + (stimulusTarget - stimulusPoints[nMid]) /
+    			(stimulusPoints[nMid+1] - stimulusPoints[nMid]);
     	return TRUE;
     } else {
     	return FALSE;
@@ -177,9 +178,9 @@ plotSmithGrid (cairo_t *cr, gboolean bAnnotate, tGridParameters *pGrid, eChannel
 		cairo_arc (cr, 0,0, 1.0, 0, 2 * G_PI);
 
         if( pGrid->overlay.bSmithWithDiferentScaling && channel == eCH_TWO ) {
-            gdk_cairo_set_source_rgba (cr, &plotElementColors[ eColorGridPolarOverlay   ] );
+            gdk_cairo_set_source_rgba (cr, &pGlobal->plotElementColors[ eColorGridPolarOverlay   ] );
         } else {
-            gdk_cairo_set_source_rgba (cr, &plotElementColors[ eColorGrid   ] );
+            gdk_cairo_set_source_rgba (cr, &pGlobal->plotElementColors[ eColorGrid   ] );
         }
 
 		cairo_new_path(cr);
@@ -242,7 +243,7 @@ plotSmithGrid (cairo_t *cr, gboolean bAnnotate, tGridParameters *pGrid, eChannel
 			// labels
 			// resistance first
 			cairo_reset_clip( cr );
-			gdk_cairo_set_source_rgba (cr, &plotElementColors[ eColorSmithGridAnnotations ] );
+			gdk_cairo_set_source_rgba (cr, &pGlobal->plotElementColors[ eColorSmithGridAnnotations ] );
 			setCairoFontSize(cr, pGrid->fontSize * 0.75 / pGrid->scale);
 
 			double lastRad = 1000.0;
@@ -378,7 +379,7 @@ showSmithCursorInfo(
 			xTextPos -= pGrid->areaWidth * 0.04;
 	}
 
-	setTraceColor( cr, pGrid->overlay.bAny, channel );
+	setTraceColor( cr, pGlobal, pGrid->overlay.bAny, channel );
 
 	if( x < 0 ) {
 		if( !pGlobal->flags.bAdmitanceSmith )
@@ -472,7 +473,7 @@ plotSmithAndPolarTrace (cairo_t *cr, tGridParameters *pGrid, eChannel channel, t
 	gboolean bValidSample = FALSE;
 
 	tChannel *pChannel = &pGlobal->HP8753.channels[channel];
-    GdkRGBA solidCursorRGBA = plotElementColors[ eColorLiveMkrCursor ];
+    GdkRGBA solidCursorRGBA = pGlobal->plotElementColors[ eColorLiveMkrCursor ];
     solidCursorRGBA.alpha = 1.0;
 
 	// gamma for full scale
@@ -499,35 +500,52 @@ plotSmithAndPolarTrace (cairo_t *cr, tGridParameters *pGrid, eChannel channel, t
 		gint npoints = pChannel->nPoints;
 		if( npoints ) {
 
-			setTraceColor( cr, pGrid->overlay.bAny, channel );
+			setTraceColor( cr, pGlobal, pGrid->overlay.bAny, channel );
 			cairo_set_line_width (cr, SMITH_LINE_THICKNESS * 1.25 * gammaScale);	// we have already scaled (1 is the size of the outer circle)
 
-			// Draw markers (if there are any)
-			drawMarkers( cr, pGlobal, pGrid, channel, 0.0, 1.0 );
-
-			// Draw trace
-			// Use Bezier splines to give better interpolation
-			if( pGlobal->flags.bSmithSpline ) {
-				// If we are using list sweep with all segments, then plot each segment
-				// separately, otherwise plot one one curve
-				if( pChannel->sweepType == eSWP_LSTFREQ && pChannel->chFlags.bAllSegments ) {
-					// Draw trace for sweep type list frequency (all segments)
-					for ( int seg=0, startPoint=0; seg < pChannel->nSegments; seg++ ) {
-						drawBezierSpline(cr, &pChannel->responsePoints[ startPoint ],
-								pChannel->segments[ seg ].nPoints);
-						startPoint += pChannel->segments[ seg ].nPoints;
+			if( pGrid->layers & PLOT_LAYER_STATIC ) {
+				// Draw markers (if there are any)
+				drawMarkers( cr, pGlobal, pGrid, channel, 0.0, 1.0 );
+
+				// Draw trace
+				// Use Bezier splines to give better interpolation
+				if( pGlobal->flags.bSmithSpline ) {
+					tComplex *controlPoints = getSplineControlPoints( pChannel );
+					// If we are using list sweep with all segments, then plot each segment
+					// separately, otherwise plot one one curve
+					if( pChannel->sweepType == eSWP_LSTFREQ && pChannel->chFlags.bAllSegments ) {
+						// Draw trace for sweep type list frequency (all segments)
+						tSegmentIndex *pIndex = getSegmentIndex( pChannel );
+						for ( int seg=0; seg < pIndex->nSegments; seg++ ) {
+							gint startPoint = pIndex->firstPoint[ seg ];
+							drawBezierSpline(cr, &pChannel->responsePoints[ startPoint ], &controlPoints[ 2 * startPoint ],
+									MIN( pIndex->firstPoint[ seg+1 ], npoints ) - startPoint);
+						}
+					} else {
+						// Draw trace for all sweep types except list frequency (all segments)
+						drawBezierSpline(cr, pChannel->responsePoints, controlPoints, npoints);
 					}
 				} else {
-					// Draw trace for all sweep types except list frequency (all segments)
-					drawBezierSpline(cr, pChannel->responsePoints, npoints);
-				}
-			} else {
-				// linear interpolation
-				if( pChannel->sweepType == eSWP_LSTFREQ && pChannel->chFlags.bAllSegments ) {
-					// Draw trace for sweep type list frequency (all segments)
-					for ( int seg=0, startPoint=0; seg < pChannel->nSegments; seg++ ) {
-						cairo_new_path( cr );
-						for ( int i=startPoint; i < startPoint+pChannel->segments[ seg ].nPoints; i++ ) {
+					// linear interpolation
+					if( pChannel->sweepType == eSWP_LSTFREQ && pChannel->chFlags.bAllSegments ) {
+						// Draw trace for sweep type list frequency (all segments)
+						tSegmentIndex *pIndex = getSegmentIndex( pChannel );
+						for ( int seg=0; seg < pIndex->nSegments; seg++ ) {
+							gint startPoint = pIndex->firstPoint[ seg ];
+							cairo_new_path( cr );
+							for ( int i=startPoint; i < MIN( pIndex->firstPoint[ seg+1 ], npoints ); i++ ) {
+								gammaReal = pChannel->responsePoints[i].r;
+								gammaImag = pChannel->responsePoints[i].i;
+								if ( i == startPoint )
+									cairo_move_to(cr, gammaReal, gammaImag);
+								else
+									cairo_line_to(cr, gammaReal, gammaImag);
+							}
+							cairo_stroke (cr);
+						}
+					} else {
+						// Draw trace for all sweep types except list frequency (all segments)
+						for ( int i=0; i < npoints; i++ ) {
 							gammaReal = pChannel->responsePoints[i].r;
 							gammaImag = pChannel->responsePoints[i].i;
 							if ( i == 0 )
@@ -536,19 +554,7 @@ plotSmithAndPolarTrace (cairo_t *cr, tGridParameters *pGrid, eChannel channel, t
 								cairo_line_to(cr, gammaReal, gammaImag);
 						}
 						cairo_stroke (cr);
-						startPoint += pChannel->segments[ seg ].nPoints;
 					}
-				} else {
-					// Draw trace for all sweep types except list frequency (all segments)
-					for ( int i=0; i < npoints; i++ ) {
-						gammaReal = pChannel->responsePoints[i].r;
-						gammaImag = pChannel->responsePoints[i].i;
-						if ( i == 0 )
-							cairo_move_to(cr, gammaReal, gammaImag);
-						else
-							cairo_line_to(cr, gammaReal, gammaImag);
-					}
-					cairo_stroke (cr);
 				}
 			}
 
@@ -563,7 +569,9 @@ plotSmithAndPolarTrace (cairo_t *cr, tGridParameters *pGrid, eChannel channel, t
             if( pGlobal->flags.bHoldLiveMarker )
                 xMouse = pGlobal->mouseXpercentHeld * pGrid->areaWidth;
 
-			if ( xMouse >= pGrid->leftGridPosn && xMouse <= pGrid->gridWidth+pGrid->leftGridPosn ) {
+			// the live marker is drawn over the (cached) grid and trace
+			if ( (pGrid->layers & PLOT_LAYER_LIVE)
+					&& xMouse >= pGrid->leftGridPosn && xMouse <= pGrid->gridWidth+pGrid->leftGridPosn ) {
 				xFract = (xMouse-pGrid->leftGridPosn) / pGrid->gridWidth;
 				cairo_reset_clip( cr);
 				// find out what sample corresponds to the x mouse position
@@ -575,40 +583,43 @@ plotSmithAndPolarTrace (cairo_t *cr, tGridParameters *pGrid, eChannel channel, t
 					// Determine what frequency the X coordinate of the mouse cursor corresponds to
 					sweepValue = LIN_INTERP(pChannel->sweepStart, pChannel->sweepStop, xFract);
 					// find what segment contains the frequency (if any)
-					for( int seg=0, segStartSample=0; seg < pChannel->nSegments; seg++ ) {
-						// see if we even have this sample frequency
-						if( sweepValue >= pChannel->segments[seg].startFreq && sweepValue <= pChannel->segments[seg].stopFreq ) {
-							// the frequency is in this sample.. find out where
-							searchForStimulusValueInSegment( segStartSample, segStartSample+pChannel->segments[seg].nPoints,
-									pChannel, sweepValue, &samplePoint );
-
-							if ( pGlobal->flags.bSmithSpline ){
-								tComplex result;
-								// interpolate within this segment
-								splineInterpolate( pChannel->segments[seg].nPoints,
-											&(pChannel->responsePoints[segStartSample]), samplePoint-segStartSample, &result );
-								gammaReal = result.r; gammaImag = result.i;
-							} else {
-								gint sampleLow, sampleHigh;
-								sampleLow = (gint)floor(samplePoint); sampleHigh = (gint)ceil(samplePoint);
-								xl = pChannel->responsePoints[sampleLow].r;
-								xu = pChannel->responsePoints[sampleHigh].r;
-								gammaReal = LIN_INTERP( xl, xu, (samplePoint-sampleLow));
-								yl = pChannel->responsePoints[sampleLow].i;
-								yu = pChannel->responsePoints[sampleHigh].i;
-								gammaImag = LIN_INTERP( yl, yu, (samplePoint-sampleLow));
-							}
-							bValidSample = TRUE;
-							break;
+					gint seg = findSegment( pChannel, sweepValue );
+					if( seg >= 0 ) {
+						tSegmentIndex *pIndex = getSegmentIndex( pChannel );
+						gint segStartSample = pIndex->firstPoint[ seg ];
+						gint segPoints = MIN( pIndex->firstPoint[ seg+1 ], npoints ) - segStartSample;
+
+						// the frequency is in this segment.. find out where
+						searchForStimulusValueInSegment( segStartSample, segStartSample + segPoints - 1,
+								pChannel, sweepValue, &samplePoint );
+
+						if ( pGlobal->flags.bSmithSpline ){
+							tComplex result;
+							// interpolate within this segment
+							splineInterpolate( segPoints,
+										&(pChannel->responsePoints[segStartSample]),
+										&(getSplineControlPoints( pChannel )[ 2 * segStartSample ]),
+										samplePoint-segStartSample, &result );
+							gammaReal = result.r; gammaImag = result.i;
+						} else {
+							gint sampleLow, sampleHigh;
+							sampleLow = (gint)floor(samplePoint); sampleHigh = (gint)ceil(samplePoint);
+							xl = pChannel->responsePoints[sampleLow].r;
+							xu = pChannel->responsePoints[sampleHigh].r;
+							gammaReal = LIN_INTERP( xl, xu, (samplePoint-sampleLow));
+							yl = pChannel->responsePoints[sampleLow].i;
+							yu = pChannel->responsePoints[sampleHigh].i;
+							gammaImag = LIN_INTERP( yl, yu, (samplePoint-sampleLow));
 						}
-						segStartSample += pChannel->segments[seg].nPoints;
+						bValidSample = TRUE;
 					}
 				} else {
 					// all sweep formats other than list frequency (all segments)
 					samplePoint = (npoints-1) * xFract;
 					if ( pGlobal->flags.bSmithSpline ){
 						tComplex result;
-						splineInterpolate( npoints, pGlobal->HP8753.channels[channel].responsePoints, samplePoint, &result );
+						splineInterpolate( npoints, pChannel->responsePoints, getSplineControlPoints( pChannel ),
+								samplePoint, &result );
 						gammaReal = result.r; gammaImag = result.i;
 					} else {
 						gint sampleLow, sampleHigh;
@@ -624,7 +635,7 @@ plotSmithAndPolarTrace (cairo_t *cr, tGridParameters *pGrid, eChannel channel, t
 				}
 
 				// draw circle around response point on trace
-				gdk_cairo_set_source_rgba (cr, &plotElementColors[ eColorLiveMkrCursor ] );
+				gdk_cairo_set_source_rgba (cr, &pGlobal->plotElementColors[ eColorLiveMkrCursor ] );
 				cairo_set_line_width (cr, (pGrid->areaWidth / 1000.0 * 3.0) / pGrid->scale);
 				cairo_new_path( cr );
 				if (bValidSample) {
@@ -637,7 +648,7 @@ plotSmithAndPolarTrace (cairo_t *cr, tGridParameters *pGrid, eChannel channel, t
 
 				// return to the initial transform
 				cairo_set_matrix (cr, &pGrid->initialMatrix);
-				gdk_cairo_set_source_rgba (cr, &plotElementColors[ eColorLiveMkrFreqTicks ] );
+				gdk_cairo_set_source_rgba (cr, &pGlobal->plotElementColors[ eColorLiveMkrFreqTicks ] );
 				cairo_set_line_width (cr, 0.5);
 
 				// draw frequency / seconds tick marks
@@ -709,8 +720,9 @@ plotSmithAndPolarTrace (cairo_t *cr, tGridParameters *pGrid, eChannel channel, t
 			}
 		}
 
-		if( channel == eCH_ONE || !pGlobal->HP8753.flags.bDualChannel )
-			showTitleAndTime( cr, pGrid, pGlobal->HP8753.sTitle,
+		if( (pGrid->layers & PLOT_LAYER_STATIC)
+				&& (channel == eCH_ONE || !pGlobal->HP8753.flags.bDualChannel) )
+			showTitleAndTime( cr, pGrid, pGlobal, pGlobal->HP8753.sTitle,
 					pGlobal->flags.bShowDateTime ? pGlobal->HP8753.dateTime : "" );
 	}
 	cairo_restore( cr );
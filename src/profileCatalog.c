@@ -0,0 +1,331 @@
+/*
+ * Copyright (c) 2026 Michael G. Katzmann
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/*! \file profileCatalog.c
+ * Indexed catalog of the calibration and trace profiles.
+ *
+ * The profile abstracts themselves remain in the sorted GLists held in tGlobal
+ * (pCalList & pTraceList) which own the memory. The catalog indexes those items
+ * so that a (project, name) lookup is a single hash probe and the profiles
+ * belonging to a project can be enumerated without walking the whole list.
+ *
+ * The names of the profiles in each project are held in a GtkStringList which
+ * is exposed as a GListModel. The model is kept sorted and is updated
+ * incrementally (one "items-changed" per insert/remove) so views bound to it
+ * only need to process what changed.
+ *
+ * Only the profiles of the projects that have been visited are read from the
+ * database (see inventoryProject). The catalog records which projects these are.
+ */
+
+#include <glib-2.0/glib.h>
+#include <gtk/gtk.h>
+#include <string.h>
+
+#include "hp8753.h"
+
+/*!     \brief  Get the project & name structure embedded in a catalog item
+ *
+ * \param  pCatalog     pointer to catalog
+ * \param  pItem        pointer to tHP8753cal or tHP8753traceAbstract
+ * \return              pointer to the tProjectAndName within the item
+ */
+static inline tProjectAndName *
+catalogItemProjectAndName( tCatalog *pCatalog, gpointer pItem ) {
+    return (tProjectAndName *)((guchar *)pItem + pCatalog->projectAndNameOffset);
+}
+
+/*!     \brief  Form the hash key for a project & name
+ *
+ * The key is the project and name separated by ETX (which cannot be typed
+ * into the entry widgets)
+ *
+ * \param  sProject     project name
+ * \param  sName        profile name
+ * \return              allocated key string
+ */
+static gchar *
+catalogKey( const gchar *sProject, const gchar *sName ) {
+    return g_strdup_printf( "%s%c%s", sProject ? sProject : "", ETX, sName ? sName : "" );
+}
+
+/*!     \brief  Create the hash tables of the catalog if not already done
+ *
+ * \param  pCatalog     pointer to catalog
+ */
+static void
+catalogEnsure( tCatalog *pCatalog ) {
+    if( pCatalog->pIndex == NULL )
+        pCatalog->pIndex = g_hash_table_new_full( g_str_hash, g_str_equal, g_free, NULL );
+    if( pCatalog->pProjects == NULL )
+        pCatalog->pProjects = g_hash_table_new_full( g_str_hash, g_str_equal, g_free, g_object_unref );
+    if( pCatalog->pLoaded == NULL )
+        pCatalog->pLoaded = g_hash_table_new_full( g_str_hash, g_str_equal, g_free, NULL );
+}
+
+/*!     \brief  Get (or create) the ordered name list of a project
+ *
+ * \param  pCatalog     pointer to catalog
+ * \param  sProject     project name
+ * \return              GtkStringList of names (owned by the catalog)
+ */
+static GtkStringList *
+catalogProjectList( tCatalog *pCatalog, const gchar *sProject ) {
+    GtkStringList *pNames;
+
+    catalogEnsure( pCatalog );
+    pNames = g_hash_table_lookup( pCatalog->pProjects, sProject ? sProject : "" );
+    if( pNames == NULL ) {
+        pNames = gtk_string_list_new( NULL );
+        g_hash_table_insert( pCatalog->pProjects, g_strdup( sProject ? sProject : "" ), pNames );
+    }
+    return pNames;
+}
+
+/*!     \brief  Binary search for the position of a name in a project list
+ *
+ * \param  pNames       GtkStringList of names (sorted)
+ * \param  sName        name to find
+ * \param  pbFound      set TRUE if the name is present
+ * \return              position of the name or the position at which it would be inserted
+ */
+static guint
+catalogSearch( GtkStringList *pNames, const gchar *sName, gboolean *pbFound ) {
+    guint low = 0, high = g_list_model_get_n_items( G_LIST_MODEL( pNames ) );
+
+    *pbFound = FALSE;
+    while( low < high ) {
+        guint mid = low + (high - low) / 2;
+        gint cmp = g_strcmp0( gtk_string_list_get_string( pNames, mid ), sName );
+        if( cmp == 0 ) {
+            *pbFound = TRUE;
+            return mid;
+        } else if( cmp < 0 ) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+/*!     \brief  Add an item to the catalog
+ *
+ * Index the item by project & name and insert the name into the ordered
+ * list for the project (emitting "items-changed" on the project model).
+ * If an item with the same project & name is already indexed it is replaced.
+ *
+ * \param  pCatalog     pointer to catalog
+ * \param  pItem        pointer to tHP8753cal or tHP8753traceAbstract
+ */
+void
+catalogAdd( tCatalog *pCatalog, gpointer pItem ) {
+    tProjectAndName *pProjectAndName = catalogItemProjectAndName( pCatalog, pItem );
+    GtkStringList *pNames = catalogProjectList( pCatalog, pProjectAndName->sProject );
+    gboolean bFound;
+    guint posn;
+
+    g_hash_table_replace( pCatalog->pIndex,
+            catalogKey( pProjectAndName->sProject, pProjectAndName->sName ), pItem );
+
+    posn = catalogSearch( pNames, pProjectAndName->sName, &bFound );
+    if( !bFound ) {
+        const gchar *sAdditions[] = { pProjectAndName->sName ? pProjectAndName->sName : "", NULL };
+        gtk_string_list_splice( pNames, posn, 0, sAdditions );
+    }
+}
+
+/*!     \brief  Remove an item from the catalog
+ *
+ * This must be called before the project or name of the item is changed
+ * (or the item freed) since the key is formed from the current values.
+ *
+ * \param  pCatalog     pointer to catalog
+ * \param  pItem        pointer to tHP8753cal or tHP8753traceAbstract
+ */
+void
+catalogRemove( tCatalog *pCatalog, gpointer pItem ) {
+    tProjectAndName *pProjectAndName = catalogItemProjectAndName( pCatalog, pItem );
+    GtkStringList *pNames;
+    gboolean bFound;
+    guint posn;
+
+    catalogEnsure( pCatalog );
+    gchar *sKey = catalogKey( pProjectAndName->sProject, pProjectAndName->sName );
+    if( g_hash_table_lookup( pCatalog->pIndex, sKey ) == pItem )
+        g_hash_table_remove( pCatalog->pIndex, sKey );
+    g_free( sKey );
+
+    pNames = g_hash_table_lookup( pCatalog->pProjects,
+            pProjectAndName->sProject ? pProjectAndName->sProject : "" );
+    if( pNames ) {
+        posn = catalogSearch( pNames, pProjectAndName->sName, &bFound );
+        if( bFound )
+            gtk_string_list_remove( pNames, posn );
+    }
+}
+
+/*!     \brief  Rebuild the catalog from a list of items
+ *
+ * Used after the list is (re)loaded from the database or after a bulk change
+ * (such as a project rename). The project models are retained (only emptied and
+ * refilled) so that views bound to them remain valid.
+ * No project is then considered loaded (see catalogSetProjectLoaded).
+ *
+ * \param  pCatalog     pointer to catalog
+ * \param  pList        list of tHP8753cal or tHP8753traceAbstract items (sorted by project & name)
+ */
+void
+catalogRebuild( tCatalog *pCatalog, GList *pList ) {
+    GHashTableIter iter;
+    gpointer pNames;
+    GPtrArray *pRun = g_ptr_array_new();
+    const gchar *sRunProject = NULL;
+
+    catalogEnsure( pCatalog );
+    g_hash_table_remove_all( pCatalog->pIndex );
+    g_hash_table_remove_all( pCatalog->pLoaded );
+
+    g_hash_table_iter_init( &iter, pCatalog->pProjects );
+    while( g_hash_table_iter_next( &iter, NULL, &pNames ) )
+        gtk_string_list_splice( GTK_STRING_LIST( pNames ), 0,
+                g_list_model_get_n_items( G_LIST_MODEL( pNames ) ), NULL );
+
+    // The list is sorted by project then name so each project is a contiguous run
+    // that we add to its model in one splice
+    for( GList *l = pList; ; l = l->next ) {
+        tProjectAndName *pProjectAndName = l ? catalogItemProjectAndName( pCatalog, l->data ) : NULL;
+
+        if( pRun->len > 0 && ( l == NULL || g_strcmp0( pProjectAndName->sProject, sRunProject ) != 0 ) ) {
+            GtkStringList *pRunNames = catalogProjectList( pCatalog, sRunProject );
+            g_ptr_array_add( pRun, NULL );
+            gtk_string_list_splice( pRunNames, g_list_model_get_n_items( G_LIST_MODEL( pRunNames ) ), 0,
+                    (const gchar * const *)pRun->pdata );
+            g_ptr_array_set_size( pRun, 0 );
+        }
+        if( l == NULL )
+            break;
+
+        sRunProject = pProjectAndName->sProject;
+        g_hash_table_replace( pCatalog->pIndex,
+                catalogKey( pProjectAndName->sProject, pProjectAndName->sName ), l->data );
+        g_ptr_array_add( pRun, pProjectAndName->sName ? pProjectAndName->sName : (gchar *)"" );
+    }
+    g_ptr_array_free( pRun, TRUE );
+}
+
+/*!     \brief  Find an item in the catalog
+ *
+ * \param  pCatalog     pointer to catalog
+ * \param  sProject     project name
+ * \param  sName        profile name
+ * \return              pointer to the tHP8753cal or tHP8753traceAbstract item or NULL if not found
+ */
+gpointer
+catalogLookup( tCatalog *pCatalog, const gchar *sProject, const gchar *sName ) {
+    gpointer pItem;
+
+    if( pCatalog->pIndex == NULL )
+        return NULL;
+    gchar *sKey = catalogKey( sProject, sName );
+    pItem = g_hash_table_lookup( pCatalog->pIndex, sKey );
+    g_free( sKey );
+    return pItem;
+}
+
+/*!     \brief  Find the item at a position in the ordered list of a project
+ *
+ * \param  pCatalog     pointer to catalog
+ * \param  sProject     project name
+ * \param  posn         position in the project (0 is first)
+ * \return              pointer to the item or NULL if out of range
+ */
+gpointer
+catalogNthInProject( tCatalog *pCatalog, const gchar *sProject, guint posn ) {
+    GtkStringList *pNames = GTK_STRING_LIST( catalogProjectModel( pCatalog, sProject ) );
+
+    if( posn >= g_list_model_get_n_items( G_LIST_MODEL( pNames ) ) )
+        return NULL;
+    return catalogLookup( pCatalog, sProject, gtk_string_list_get_string( pNames, posn ) );
+}
+
+/*!     \brief  Get the list model of profile names in a project
+ *
+ * The model is owned by the catalog and persists (possibly empty) for the life of
+ * the catalog, so it may be bound to a view. Callers wishing to keep it beyond that
+ * should take a reference.
+ *
+ * \param  pCatalog     pointer to catalog
+ * \param  sProject     project name
+ * \return              GListModel of GtkStringObject (names sorted)
+ */
+GListModel *
+catalogProjectModel( tCatalog *pCatalog, const gchar *sProject ) {
+    return G_LIST_MODEL( catalogProjectList( pCatalog, sProject ) );
+}
+
+/*!     \brief  Number of profiles in a project
+ *
+ * \param  pCatalog     pointer to catalog
+ * \param  sProject     project name
+ * \return              number of items in the project
+ */
+guint
+catalogProjectCount( tCatalog *pCatalog, const gchar *sProject ) {
+    GtkStringList *pNames;
+
+    if( pCatalog->pProjects == NULL )
+        return 0;
+    pNames = g_hash_table_lookup( pCatalog->pProjects, sProject ? sProject : "" );
+    return pNames ? g_list_model_get_n_items( G_LIST_MODEL( pNames ) ) : 0;
+}
+
+/*!     \brief  Record that the profiles of a project have been read from the database
+ *
+ * \param  pCatalog     pointer to catalog
+ * \param  sProject     project name
+ */
+void
+catalogSetProjectLoaded( tCatalog *pCatalog, const gchar *sProject ) {
+    catalogEnsure( pCatalog );
+    g_hash_table_add( pCatalog->pLoaded, g_strdup( sProject ? sProject : "" ) );
+}
+
+/*!     \brief  Have the profiles of a project been read from the database
+ *
+ * \param  pCatalog     pointer to catalog
+ * \param  sProject     project name
+ * \return              TRUE if catalogSetProjectLoaded has been called for the project
+ */
+gboolean
+catalogIsProjectLoaded( tCatalog *pCatalog, const gchar *sProject ) {
+    if( pCatalog->pLoaded == NULL )
+        return FALSE;
+    return g_hash_table_contains( pCatalog->pLoaded, sProject ? sProject : "" );
+}
+
+/*!     \brief  Release the catalog
+ *
+ * The items are not freed (they are owned by the list)
+ *
+ * \param  pCatalog     pointer to catalog
+ */
+void
+catalogFree( tCatalog *pCatalog ) {
+    g_clear_pointer( &pCatalog->pIndex, g_hash_table_destroy );
+    g_clear_pointer( &pCatalog->pProjects, g_hash_table_destroy );
+    g_clear_pointer( &pCatalog->pLoaded, g_hash_table_destroy );
+}
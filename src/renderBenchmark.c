@@ -0,0 +1,538 @@
+/*
+ * Copyright (c) 2026 Michael G. Katzmann
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/*! \file renderBenchmark.c
+ * Offscreen benchmark of the plot rendering.
+ *
+ * With --benchmark-render=<file> (or 'make benchmark') each fixture below is
+ * rendered with plotA (and plotB if the channels are split) into cairo image
+ * surfaces of several sizes. GTK is not initialized so no display is needed.
+ *
+ * The fixtures are synthesized (a three resonator bandpass filter and a series
+ * resonant load) so the results of different builds on one machine can be compared.
+ * Each fixture is rendered 'cold' (the plot caches, trace decimation, spline control
+ * points and HPGL recording discarded before each frame, as after a new capture)
+ * and 'warm' (as when the plot is redrawn with the same data).
+ *
+ * The results are written as JSON, one line per fixture and size, e.g.
+ *      { "fixture": "smith", "width": 777, "height": 600, "cold": { "min": 812, ... }, ... }
+ * Times are in µs. Heap use (if the C library has mallinfo2) is the change in bytes
+ * allocated over the cold frames (i.e. retained by the plot) and the growth of the heap.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <complex.h>
+#include <cairo/cairo.h>
+#include <glib-2.0/glib.h>
+#include <gtk/gtk.h>
+#ifdef HAVE_MALLINFO2
+#include <malloc.h>
+#endif
+
+#include "hp8753.h"
+#include "HPGLplot.h"
+
+#define RENDER_BENCHMARK_FRAMES     25
+
+#define BANDPASS_Q                  60.0
+#define LINE_DELAY                  2.0e-9      // of the cables to the filter
+#define LOAD_R                      35.0        // series resonant load
+#define LOAD_L                      22.0e-9
+
+static const struct {
+    guint width, height;
+} benchmarkSizes[] = {
+    { DRAWING_WIDTH, DRAWING_HEIGHT },          // initial size of the drawing areas
+    { 1280, 800 },
+    { 1920, 1200 },
+    { 3840, 2160 }
+};
+
+/*!     \brief  Transmission of a three resonator bandpass filter
+ *
+ * \param  freq     frequency (Hz)
+ * \return          S21
+ */
+static gdouble complex
+bandpassS21( gdouble freq ) {
+    static const gdouble f0[] = { MHz( 1490.0 ), MHz( 1500.0 ), MHz( 1510.0 ) };
+    gdouble complex S21 = 1.0;
+
+    for( gint i = 0; i < G_N_ELEMENTS( f0 ); i++ )
+        S21 /= 1.0 + I * BANDPASS_Q * (freq / f0[ i ] - f0[ i ] / freq);
+    return S21 * cexp( -I * 2.0 * M_PI * freq * LINE_DELAY );
+}
+
+/*!     \brief  Reflection of the bandpass filter (lossless)
+ *
+ * \param  freq     frequency (Hz)
+ * \return          S11
+ */
+static gdouble complex
+bandpassS11( gdouble freq ) {
+    gdouble complex S21 = bandpassS21( freq );
+
+    return sqrt( MAX( 1.0 - SQ( cabs( S21 ) ), 1.0e-12 ) ) * cexp( I * (carg( S21 ) + M_PI / 2.0) );
+}
+
+/*!     \brief  Reflection of a series resonant load (resonant at 1.5 GHz)
+ *
+ * \param  freq     frequency (Hz)
+ * \return          S11
+ */
+static gdouble complex
+seriesLoadS11( gdouble freq ) {
+    gdouble omega = 2.0 * M_PI * freq, omega0 = 2.0 * M_PI * MHz( 1500.0 );
+    gdouble C = 1.0 / (SQ( omega0 ) * LOAD_L);
+    gdouble complex Z = LOAD_R + I * (omega * LOAD_L - 1.0 / (omega * C));
+
+    return (Z - Z0) / (Z + Z0);
+}
+
+/*!     \brief  Fill a channel with the response of a model
+ *
+ * The response is converted to the channel's format (as the HP8753 would).
+ * The stimulus points are calculated from the sweep unless already set (list sweep).
+ * Markers 1 and 2 are placed at a quarter and half of the sweep.
+ *
+ * \param  pChannel     channel
+ * \param  format       display format
+ * \param  model        S parameter as a function of frequency
+ * \param  perDiv       scale per division (or full scale for Smith & polar)
+ * \param  refVal       reference value
+ * \param  refPos       reference position
+ */
+static void
+fillChannel( tChannel *pChannel, tFormat format, gdouble complex (*model)( gdouble ),
+        gdouble perDiv, gdouble refVal, gdouble refPos ) {
+    gdouble *stimulus;
+
+    pChannel->format = format;
+    pChannel->scaleVal = perDiv;
+    pChannel->scaleRefVal = refVal;
+    pChannel->scaleRefPos = refPos;
+    pChannel->responsePoints = g_new0( tComplex, pChannel->nPoints );
+    stimulus = getStimulusPoints( pChannel );
+
+    for( gint i = 0; i < pChannel->nPoints; i++ ) {
+        gdouble freq = stimulus[ i ];
+        gdouble complex S = model( freq );
+
+        switch( format ) {
+        case eFMT_LOGM:
+            pChannel->responsePoints[ i ].r = 20.0 * log10( MAX( cabs( S ), 1.0e-9 ) );
+            break;
+        case eFMT_PHASE:
+            pChannel->responsePoints[ i ].r = RAD2DEG( carg( S ) );
+            break;
+        case eFMT_DELAY:
+            // group delay from the change of phase over 200 kHz
+            pChannel->responsePoints[ i ].r = -carg( model( freq + kHz( 100.0 ) ) / model( freq - kHz( 100.0 ) ) )
+                    / (2.0 * M_PI * kHz( 200.0 ));
+            break;
+        case eFMT_SMITH:
+        case eFMT_POLAR:
+        default:
+            pChannel->responsePoints[ i ].r = creal( S );
+            pChannel->responsePoints[ i ].i = cimag( S );
+            break;
+        }
+    }
+
+    pChannel->chFlags.bbMkrs = 0x03;
+    pChannel->activeMarker = 0;
+    for( gint mkr = 0; mkr < 2; mkr++ ) {
+        gint i = pChannel->nPoints * (mkr + 1) / 4;
+
+        pChannel->numberedMarkers[ mkr ].sourceValue = stimulus[ i ];
+        pChannel->numberedMarkers[ mkr ].point = pChannel->responsePoints[ i ];
+    }
+    pChannel->chFlags.bValidData = TRUE;
+}
+
+/*!     \brief  Set the sweep of a channel
+ *
+ * \param  pChannel     channel
+ * \param  measurement  S parameter measured
+ * \param  sweepType    linear or log frequency sweep
+ * \param  start        start frequency
+ * \param  stop         stop frequency
+ * \param  nPoints      number of points
+ */
+static void
+setSweep( tChannel *pChannel, tMeasurement measurement, tSweepType sweepType,
+        gdouble start, gdouble stop, gint nPoints ) {
+    pChannel->measurementType = measurement;
+    pChannel->sweepType = sweepType;
+    pChannel->sweepStart = start;
+    pChannel->sweepStop = stop;
+    pChannel->nPoints = nPoints;
+}
+
+static void
+fixtureLogMag( tGlobal *pGlobal ) {
+    tChannel *pChannel = &pGlobal->HP8753.channels[ eCH_ONE ];
+
+    setSweep( pChannel, eMEAS_S21, eSWP_LINFREQ, kHz( 300.0 ), GHz( 3.0 ), 1601 );
+    fillChannel( pChannel, eFMT_LOGM, bandpassS21, 10.0, 0.0, 10.0 );
+}
+
+static void
+fixturePhase( tGlobal *pGlobal ) {
+    tChannel *pChannel = &pGlobal->HP8753.channels[ eCH_ONE ];
+
+    setSweep( pChannel, eMEAS_S21, eSWP_LINFREQ, MHz( 1400.0 ), MHz( 1600.0 ), 1601 );
+    fillChannel( pChannel, eFMT_PHASE, bandpassS21, 45.0, 0.0, 5.0 );
+}
+
+static void
+fixtureDelay( tGlobal *pGlobal ) {
+    tChannel *pChannel = &pGlobal->HP8753.channels[ eCH_ONE ];
+
+    setSweep( pChannel, eMEAS_S21, eSWP_LINFREQ, MHz( 1400.0 ), MHz( 1600.0 ), 801 );
+    fillChannel( pChannel, eFMT_DELAY, bandpassS21, 5.0e-9, 0.0, 0.0 );
+}
+
+static void
+fixtureSmith( tGlobal *pGlobal ) {
+    tChannel *pChannel = &pGlobal->HP8753.channels[ eCH_ONE ];
+
+    setSweep( pChannel, eMEAS_S11, eSWP_LINFREQ, GHz( 1.0 ), GHz( 2.0 ), 401 );
+    fillChannel( pChannel, eFMT_SMITH, seriesLoadS11, 1.0, 0.0, 0.0 );
+}
+
+static void
+fixtureSmithNoSpline( tGlobal *pGlobal ) {
+    fixtureSmith( pGlobal );
+    pGlobal->flags.bSmithSpline = FALSE;
+}
+
+static void
+fixturePolar( tGlobal *pGlobal ) {
+    tChannel *pChannel = &pGlobal->HP8753.channels[ eCH_ONE ];
+
+    setSweep( pChannel, eMEAS_S21, eSWP_LINFREQ, MHz( 1400.0 ), MHz( 1600.0 ), 801 );
+    fillChannel( pChannel, eFMT_POLAR, bandpassS21, 1.0, 0.0, 0.0 );
+}
+
+static void
+fixtureListSegments( tGlobal *pGlobal ) {
+    static const tSegment segments[] = {
+        { 101, MHz( 1000.0 ), MHz( 1200.0 ) },
+        { 401, MHz( 1450.0 ), MHz( 1550.0 ) },
+        { 101, MHz( 1800.0 ), MHz( 2000.0 ) }
+    };
+    tChannel *pChannel = &pGlobal->HP8753.channels[ eCH_ONE ];
+    gint nPoints = 0;
+
+    pChannel->nSegments = G_N_ELEMENTS( segments );
+    for( gint seg = 0; seg < G_N_ELEMENTS( segments ); seg++ ) {
+        pChannel->segments[ seg ] = segments[ seg ];
+        nPoints += segments[ seg ].nPoints;
+    }
+    setSweep( pChannel, eMEAS_S21, eSWP_LSTFREQ, segments[ 0 ].startFreq,
+            segments[ G_N_ELEMENTS( segments ) - 1 ].stopFreq, nPoints );
+
+    // the stimulus of each point (as getHP8753channelListFreqSegments)
+    pChannel->stimulusPoints = g_new( gdouble, nPoints );
+    nPoints = 0;
+    for( gint seg = 0; seg < G_N_ELEMENTS( segments ); seg++ )
+        for( gint i = 0; i < segments[ seg ].nPoints; i++ )
+            pChannel->stimulusPoints[ nPoints++ ] = segments[ seg ].startFreq
+                    + i * (segments[ seg ].stopFreq - segments[ seg ].startFreq) / (segments[ seg ].nPoints - 1);
+    pChannel->chFlags.bAllSegments = TRUE;
+    pChannel->chFlags.bValidSegments = TRUE;
+    indexSegments( pChannel );
+
+    fillChannel( pChannel, eFMT_LOGM, bandpassS21, 10.0, 0.0, 10.0 );
+}
+
+static void
+fixtureOverlay( tGlobal *pGlobal ) {
+    tChannel *pChannel = &pGlobal->HP8753.channels[ eCH_TWO ];
+
+    fixtureLogMag( pGlobal );
+    setSweep( pChannel, eMEAS_S11, eSWP_LINFREQ, kHz( 300.0 ), GHz( 3.0 ), 1601 );
+    fillChannel( pChannel, eFMT_LOGM, bandpassS11, 5.0, 0.0, 10.0 );
+    pGlobal->HP8753.flags.bDualChannel = TRUE;
+    pGlobal->HP8753.flags.bSourceCoupled = TRUE;
+}
+
+static void
+fixtureSplit( tGlobal *pGlobal ) {
+    tChannel *pChannel = &pGlobal->HP8753.channels[ eCH_TWO ];
+
+    fixtureLogMag( pGlobal );
+    setSweep( pChannel, eMEAS_S11, eSWP_LINFREQ, kHz( 300.0 ), GHz( 3.0 ), 1601 );
+    fillChannel( pChannel, eFMT_SMITH, bandpassS11, 1.0, 0.0, 0.0 );
+    pGlobal->HP8753.flags.bDualChannel = TRUE;
+    pGlobal->HP8753.flags.bSplitChannels = TRUE;
+    pGlobal->HP8753.flags.bSourceCoupled = TRUE;
+}
+
+/*!     \brief  Synthesize the HPGL plot of the bandpass filter
+ *
+ * The graticule, annotation and trace of a log magnitude plot (as OUTPPLOT;)
+ * are compiled with the HPGL parser.
+ */
+static void
+fixtureHPGL( tGlobal *pGlobal ) {
+#define HPGL_GRID_LEFT      300
+#define HPGL_GRID_BOTTOM    300
+#define HPGL_GRID_SIZE      3500
+#define HPGL_TRACE_POINTS   801
+    GString *sHPGL = g_string_new( "IN;DF;SC0,4095,0,4212;IP250,279,10250,7479;LT;SR1.04,1.88;SP5;" );
+    tHPGLparser parser;
+
+    fixtureLogMag( pGlobal );
+
+    for( gint i = 0; i <= NHGRIDS; i++ ) {
+        gint x = HPGL_GRID_LEFT + i * HPGL_GRID_SIZE / NHGRIDS;
+        gint y = HPGL_GRID_BOTTOM + i * HPGL_GRID_SIZE / NVGRIDS;
+
+        g_string_append_printf( sHPGL, "PU%d,%d;PD%d,%d;", x, HPGL_GRID_BOTTOM, x, HPGL_GRID_BOTTOM + HPGL_GRID_SIZE );
+        g_string_append_printf( sHPGL, "PU%d,%d;PD%d,%d;", HPGL_GRID_LEFT, y, HPGL_GRID_LEFT + HPGL_GRID_SIZE, y );
+    }
+    g_string_append_printf( sHPGL, "SP1;PU0,4000;LBCH1 S21 log MAG 10 dB/ REF 0 dB%c;", HPGL_LINE_TERMINATOR_CHARACTER );
+    g_string_append_printf( sHPGL, "PU0,3800;LBHld%c;", HPGL_LINE_TERMINATOR_CHARACTER );
+    g_string_append_printf( sHPGL, "PU%d,100;LBSTART .300 000 MHz%c;", HPGL_GRID_LEFT, HPGL_LINE_TERMINATOR_CHARACTER );
+    g_string_append_printf( sHPGL, "PU%d,100;LBSTOP 3 000.000 000 MHz%c;", HPGL_GRID_LEFT + HPGL_GRID_SIZE / 2,
+            HPGL_LINE_TERMINATOR_CHARACTER );
+
+    g_string_append( sHPGL, "SP2;" );
+    for( gint i = 0; i < HPGL_TRACE_POINTS; i++ ) {
+        tChannel *pChannel = &pGlobal->HP8753.channels[ eCH_ONE ];
+        gdouble dB = pChannel->responsePoints[ i * (pChannel->nPoints - 1) / (HPGL_TRACE_POINTS - 1) ].r;
+        gint x = HPGL_GRID_LEFT + i * HPGL_GRID_SIZE / (HPGL_TRACE_POINTS - 1);
+        gint y = HPGL_GRID_BOTTOM + HPGL_GRID_SIZE + (gint)(MAX( dB, -100.0 ) * HPGL_GRID_SIZE / 100.0);
+
+        g_string_append_printf( sHPGL, "%s%d,%d;", i == 0 ? "PU" : "PD", x, y );
+    }
+    g_string_append( sHPGL, "PU;SP0;" );
+
+    initHPGLparser( &parser, pGlobal );
+    parseHPGLstream( &parser, sHPGL->str, sHPGL->len );
+    g_free( pGlobal->HP8753.plotHPGL );
+    pGlobal->HP8753.plotHPGL = finishHPGLparser( &parser );
+    pGlobal->HP8753.HPGLgeneration++;
+    g_string_free( sHPGL, TRUE );
+
+    pGlobal->HP8753.flags.bHPGLdataValid = TRUE;
+    pGlobal->HP8753.flags.bShowHPGLplot = TRUE;
+}
+
+static const struct {
+    gchar   *sName;
+    void    (*setup)( tGlobal * );
+} renderFixtures[] = {
+    { "logmag",         fixtureLogMag },
+    { "phase",          fixturePhase },
+    { "delay",          fixtureDelay },
+    { "smith",          fixtureSmith },
+    { "smith-nospline", fixtureSmithNoSpline },
+    { "polar",          fixturePolar },
+    { "list-segments",  fixtureListSegments },
+    { "overlay",        fixtureOverlay },
+    { "split",          fixtureSplit },
+    { "hpgl",           fixtureHPGL }
+};
+
+/*!     \brief  Discard the data derived from the traces (as a new capture does)
+ *
+ * \param  pGlobal      pointer to global data
+ */
+static void
+discardDerivedPlotData( tGlobal *pGlobal ) {
+    invalidatePlotCache();
+    clearHPGLrecording();
+    for( eChannel channel = eCH_ONE; channel < eNUM_CH; channel++ )
+        clearDerivedTraceData( &pGlobal->HP8753.channels[ channel ] );
+}
+
+/*!     \brief  Render one frame as the screen would
+ *
+ * \param  cr           cairo context of the image surface
+ * \param  width        width of the surface
+ * \param  height       height of the surface
+ * \param  pGlobal      pointer to global data
+ * \return              time taken (µs)
+ */
+static gint64
+renderFrame( cairo_t *cr, guint width, guint height, tGlobal *pGlobal ) {
+    gboolean bHPGL = pGlobal->HP8753.flags.bShowHPGLplot && pGlobal->HP8753.flags.bHPGLdataValid;
+    gint64 start = g_get_monotonic_time();
+
+    cairo_save( cr ); {
+        cairo_set_source_rgb( cr, 1.0, 1.0, 1.0 );
+        cairo_paint( cr );
+        plotA( width, height, 0.0, cr, pGlobal );
+    } cairo_restore( cr );
+    if( pGlobal->HP8753.flags.bDualChannel && pGlobal->HP8753.flags.bSplitChannels && !bHPGL ) {
+        cairo_save( cr ); {
+            cairo_set_source_rgb( cr, 1.0, 1.0, 1.0 );
+            cairo_paint( cr );
+            plotB( width, height, 0.0, cr, pGlobal );
+        } cairo_restore( cr );
+    }
+    cairo_surface_flush( cairo_get_target( cr ) );
+
+    return g_get_monotonic_time() - start;
+}
+
+static gint
+compareFrameTimes( gconstpointer a, gconstpointer b ) {
+    gint64 timeA = *(gint64 *)a, timeB = *(gint64 *)b;
+
+    return timeA < timeB ? -1 : (timeA > timeB ? 1 : 0);
+}
+
+/*!     \brief  Append the statistics of the frame times as a JSON object
+ *
+ * \param  sJSON        JSON being built
+ * \param  sKey         key of the object
+ * \param  frameTimes   frame times (µs) (sorted)
+ * \param  nFrames      number of frames
+ */
+static void
+appendFrameStatistics( GString *sJSON, const gchar *sKey, gint64 *frameTimes, gint nFrames ) {
+    gint64 total = 0;
+
+    qsort( frameTimes, nFrames, sizeof( gint64 ), compareFrameTimes );
+    for( gint i = 0; i < nFrames; i++ )
+        total += frameTimes[ i ];
+    g_string_append_printf( sJSON, "\"%s\": { \"min\": %" G_GINT64_FORMAT ", \"median\": %" G_GINT64_FORMAT
+            ", \"mean\": %" G_GINT64_FORMAT ", \"max\": %" G_GINT64_FORMAT " }",
+            sKey, frameTimes[ 0 ], frameTimes[ nFrames / 2 ], total / nFrames, frameTimes[ nFrames - 1 ] );
+}
+
+/*!     \brief  Render each fixture at each size and report the time taken
+ *
+ * \param  pGlobal      pointer to global data
+ * \param  sJSONfile    file for the results (or "-" for stdout)
+ * \return              0 on success, 1 if the results cannot be written
+ */
+gint
+runRenderBenchmark( tGlobal *pGlobal, const gchar *sJSONfile ) {
+    GString *sJSON = g_string_new( NULL );
+    gint64 frameTimes[ RENDER_BENCHMARK_FRAMES ];
+    gboolean bStdout = (g_strcmp0( sJSONfile, "-" ) == 0);
+    GError *pError = NULL;
+    gint status = 0;
+
+    for( int i=0; i < NUM_HPGL_PENS; i++ ) {
+        HPGLpens[ i ] = HPGLpensFactory[ i ];
+    }
+    for( int i=0; i < eMAX_COLORS; i++ ) {
+        plotElementColors[ i ] = plotElementColorsFactory[ i ];
+    }
+
+    g_string_append_printf( sJSON, "{\n  \"version\": \"%s\",\n  \"cairo\": \"%s\",\n  \"frames\": %d,\n  \"results\": [\n",
+            VERSION, cairo_version_string(), RENDER_BENCHMARK_FRAMES );
+    if( !bStdout )
+        g_print( "%-16s %11s %10s %10s %12s\n", "fixture", "size", "cold µs", "warm µs", "retained B" );
+
+    for( gint f = 0; f < G_N_ELEMENTS( renderFixtures ); f++ ) {
+        // start from a clean slate (with the same options as a batch run)
+        clearHP8753traces( &pGlobal->HP8753 );
+        pGlobal->HP8753.flags.bDualChannel = pGlobal->HP8753.flags.bSplitChannels = FALSE;
+        pGlobal->HP8753.flags.bSourceCoupled = FALSE;
+        pGlobal->HP8753.flags.bShowHPGLplot = FALSE;
+        g_clear_pointer( &pGlobal->HP8753.plotHPGL, g_free );
+        pGlobal->HP8753.HPGLgeneration++;
+        g_free( pGlobal->HP8753.sTitle );
+        pGlobal->HP8753.sTitle = g_strdup_printf( "Render benchmark: %s", renderFixtures[ f ].sName );
+        g_free( pGlobal->HP8753.dateTime );
+        pGlobal->HP8753.dateTime = g_strdup( "Sat Jan  1 00:00:00 2000" );
+        pGlobal->flags.bSmithSpline = TRUE;
+        pGlobal->flags.bShowDateTime = TRUE;
+        pGlobal->flags.bHPlogo = TRUE;
+
+        renderFixtures[ f ].setup( pGlobal );
+
+        for( gint s = 0; s < G_N_ELEMENTS( benchmarkSizes ); s++ ) {
+            guint width = benchmarkSizes[ s ].width, height = benchmarkSizes[ s ].height;
+            cairo_surface_t *cs = cairo_image_surface_create( CAIRO_FORMAT_RGB24, width, height );
+            cairo_t *cr = cairo_create( cs );
+            gint64 coldMedian;
+#ifdef HAVE_MALLINFO2
+            struct mallinfo2 heapBefore, heapAfter;
+#endif
+
+            // the first frame loads the fonts etc.
+            discardDerivedPlotData( pGlobal );
+            renderFrame( cr, width, height, pGlobal );
+
+            g_string_append_printf( sJSON, "    { \"fixture\": \"%s\", \"width\": %u, \"height\": %u, ",
+                    renderFixtures[ f ].sName, width, height );
+#ifdef HAVE_MALLINFO2
+            heapBefore = mallinfo2();
+#endif
+            for( gint n = 0; n < RENDER_BENCHMARK_FRAMES; n++ ) {
+                discardDerivedPlotData( pGlobal );
+                frameTimes[ n ] = renderFrame( cr, width, height, pGlobal );
+            }
+#ifdef HAVE_MALLINFO2
+            heapAfter = mallinfo2();
+#endif
+            appendFrameStatistics( sJSON, "cold", frameTimes, RENDER_BENCHMARK_FRAMES );
+            coldMedian = frameTimes[ RENDER_BENCHMARK_FRAMES / 2 ];
+
+            for( gint n = 0; n < RENDER_BENCHMARK_FRAMES; n++ )
+                frameTimes[ n ] = renderFrame( cr, width, height, pGlobal );
+            g_string_append( sJSON, ", " );
+            appendFrameStatistics( sJSON, "warm", frameTimes, RENDER_BENCHMARK_FRAMES );
+
+#ifdef HAVE_MALLINFO2
+            g_string_append_printf( sJSON, ", \"heapRetained\": %ld, \"heapGrowth\": %ld }",
+                    (glong)(heapAfter.uordblks - heapBefore.uordblks),
+                    (glong)((heapAfter.arena + heapAfter.hblkhd) - (heapBefore.arena + heapBefore.hblkhd)) );
+            if( !bStdout )
+                g_print( "%-16s %5ux%-5u %10" G_GINT64_FORMAT " %10" G_GINT64_FORMAT " %12ld\n",
+                        renderFixtures[ f ].sName, width, height, coldMedian, frameTimes[ RENDER_BENCHMARK_FRAMES / 2 ],
+                        (glong)(heapAfter.uordblks - heapBefore.uordblks) );
+#else
+            g_string_append( sJSON, ", \"heapRetained\": null, \"heapGrowth\": null }" );
+            if( !bStdout )
+                g_print( "%-16s %5ux%-5u %10" G_GINT64_FORMAT " %10" G_GINT64_FORMAT " %12s\n",
+                        renderFixtures[ f ].sName, width, height, coldMedian, frameTimes[ RENDER_BENCHMARK_FRAMES / 2 ], "-" );
+#endif
+            g_string_append( sJSON, f == G_N_ELEMENTS( renderFixtures ) - 1
+                    && s == G_N_ELEMENTS( benchmarkSizes ) - 1 ? "\n" : ",\n" );
+
+            cairo_destroy( cr );
+            cairo_surface_destroy( cs );
+        }
+    }
+    g_string_append( sJSON, "  ]\n}\n" );
+
+    if( bStdout ) {
+        g_print( "%s", sJSON->str );
+    } else if( !g_file_set_contents( sJSONfile, sJSON->str, sJSON->len, &pError ) ) {
+        g_printerr( "%s\n", pError->message );
+        g_clear_error( &pError );
+        status = 1;
+    }
+
+    discardDerivedPlotData( pGlobal );
+    clearHP8753traces( &pGlobal->HP8753 );
+    g_clear_pointer( &pGlobal->HP8753.plotHPGL, g_free );
+    g_string_free( sJSON, TRUE );
+
+    return status;
+}
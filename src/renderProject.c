@@ -0,0 +1,347 @@
+/*
+ * Copyright (c) 2026 Michael G. Katzmann
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/*! \file renderProject.c
+ * Render the trace profiles of a project to a PDF report or to PNG or SVG files.
+ *
+ * The trace profiles (all of those in the project or those matching a search,
+ * as in the profile browser) are recovered and drawn by a number of worker threads,
+ * each with its own read only database connection and (for PNG) its own image surface.
+ * For a PDF report each plot is drawn to a cairo recording surface and the calling
+ * thread replays them into the report in the order of the profile names (the vector
+ * drawing is preserved), with an outline entry for each profile.
+ * PNG and SVG files are written by the workers into a directory, one file
+ * (or two if the channels are split) for each profile.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <glib-2.0/glib.h>
+#include <glib/gstdio.h>
+#include <gtk/gtk.h>
+#include <sqlite3.h>
+#include <cairo/cairo.h>
+#include <cairo/cairo-pdf.h>
+#include <cairo/cairo-svg.h>
+
+#include "hp8753.h"
+#include "messageEvent.h"
+#include "exportWorker.h"
+
+#define RENDER_MAX_THREADS  8
+
+// A trace profile to render
+typedef struct {
+    gchar           *sProject;
+    gchar           *sName;
+    gint            nPages;
+    cairo_surface_t *pPages[ 2 ];       // recorded plots (PDF)
+    gint            status;
+    gboolean        bRendered;
+} tRenderItem;
+
+typedef struct {
+    tGlobal         *pGlobal;           // plot options (not changed while rendering)
+    tFileType       fileType;
+    const gchar     *sDirectory;        // for PNG & SVG files
+    GPtrArray       *pItems;            // tRenderItem in the order of the report
+    gint            next;               // (atomic) index of the next item to render
+    gint            bCancel;            // (atomic) stop rendering
+    GAsyncQueue     *pRendered;         // items rendered (in any order)
+} tRenderProject;
+
+typedef struct {
+    tRenderProject  *pRender;
+    sqlite3         *pDB;
+} tRenderWorker;
+
+static void
+freeRenderItem( tRenderItem *pItem ) {
+    for( gint page = 0; page < G_N_ELEMENTS( pItem->pPages ); page++ )
+        if( pItem->pPages[ page ] )
+            cairo_surface_destroy( pItem->pPages[ page ] );
+    g_free( pItem->sProject );
+    g_free( pItem->sName );
+    g_free( pItem );
+}
+
+/*!     \brief  Draw the plot(s) of a recovered trace profile
+ *
+ * \param  pRender      the render
+ * \param  pItem        trace profile
+ * \param  pTrace       recovered traces
+ * \param  pcsImage     pointer to the worker's image surface (PNG) created when first needed
+ * \return              OK or ERROR if a file could not be written
+ */
+static gint
+renderItem( tRenderProject *pRender, tRenderItem *pItem, tGlobal *pTrace, cairo_surface_t **pcsImage ) {
+    gdouble width, height;
+    gchar *sBasename = NULL, *sBaseFilename = NULL;
+    gint rtn = OK;
+
+    plotFilePageSize( pTrace, pRender->fileType, &width, &height );
+    pItem->nPages = plotFilePageCount( pTrace );
+
+    if( pRender->fileType != ePDF ) {
+        sBasename = g_strdelimit( g_strdup( pItem->sName ), "/\\", '_' );
+        sBaseFilename = g_build_filename( pRender->sDirectory, sBasename, NULL );
+    }
+
+    for( gint page = 0; page < pItem->nPages && rtn == OK; page++ ) {
+        cairo_rectangle_t extents = { 0.0, 0.0, width, height };
+        cairo_surface_t *cs = NULL;
+        gchar *sFilename = NULL;
+        cairo_t *cr;
+
+        switch( pRender->fileType ) {
+        case ePDF:
+        default:
+            cs = pItem->pPages[ page ] = cairo_recording_surface_create( CAIRO_CONTENT_COLOR_ALPHA, &extents );
+            break;
+        case eSVG:
+            sFilename = plotFilePageName( sBaseFilename, eSVG, pItem->nPages, page );
+            cs = cairo_svg_surface_create( sFilename, width, height );
+            break;
+        case ePNG:
+            sFilename = plotFilePageName( sBaseFilename, ePNG, pItem->nPages, page );
+            if( *pcsImage == NULL )
+                *pcsImage = cairo_image_surface_create( CAIRO_FORMAT_ARGB32, width, height );
+            cs = *pcsImage;
+            break;
+        }
+
+        cr = cairo_create( cs );
+        if( pRender->fileType == ePNG ) {
+            // the surface is reused so start as a new one would
+            cairo_save( cr );
+            cairo_set_operator( cr, CAIRO_OPERATOR_CLEAR );
+            cairo_paint( cr );
+            cairo_restore( cr );
+        }
+        drawPlotFilePage( cr, pTrace, pRender->fileType, page );
+        cairo_show_page( cr );
+        cairo_destroy( cr );
+
+        if( cairo_surface_status( cs ) != CAIRO_STATUS_SUCCESS
+                || (pRender->fileType == ePNG
+                        && cairo_surface_write_to_png( cs, sFilename ) != CAIRO_STATUS_SUCCESS) ) {
+            gchar *sError = g_strdup_printf( "Cannot write: %s", sFilename ? sFilename : pItem->sName );
+            postError( sError );
+            g_free( sError );
+            rtn = ERROR;
+        }
+        if( pRender->fileType == eSVG )
+            cairo_surface_destroy( cs );
+        g_free( sFilename );
+    }
+
+    g_free( sBaseFilename );
+    g_free( sBasename );
+    return rtn;
+}
+
+/*!     \brief  Recover and draw trace profiles until there are none left (worker thread)
+ *
+ * \param  data     tRenderWorker (freed here)
+ * \return          NULL
+ */
+static gpointer
+renderProjectWorker( gpointer data ) {
+    tRenderWorker *pWorker = (tRenderWorker *)data;
+    tRenderProject *pRender = pWorker->pRender;
+    cairo_surface_t *csImage = NULL;
+    gint i;
+
+    while( (i = g_atomic_int_add( &pRender->next, 1 )) < (gint)pRender->pItems->len ) {
+        tRenderItem *pItem = g_ptr_array_index( pRender->pItems, i );
+        tGlobal *pTrace;
+
+        if( g_atomic_int_get( &pRender->bCancel ) ) {
+            pItem->status = ERROR;
+            g_async_queue_push( pRender->pRendered, pItem );
+            continue;
+        }
+
+        pTrace = g_new0( tGlobal, 1 );
+        if( recoverTraceDataFromDB( pWorker->pDB, pTrace, pItem->sProject, pItem->sName ) != TRUE ) {
+            gchar *sError = g_strdup_printf( "Cannot recover trace profile: %s", pItem->sName );
+            postError( sError );
+            g_free( sError );
+            pItem->status = ERROR;
+        } else {
+            // plot as the user would see it
+            snapshotPlotOptions( pTrace, pRender->pGlobal );
+            pTrace->HP8753.sProduct = g_strdup( pRender->pGlobal->HP8753.sProduct );
+            if( (pItem->status = renderItem( pRender, pItem, pTrace, &csImage )) != OK )
+                g_atomic_int_set( &pRender->bCancel, TRUE );
+        }
+        freeTraceSnapshot( pTrace );
+
+        g_async_queue_push( pRender->pRendered, pItem );
+    }
+
+    if( csImage )
+        cairo_surface_destroy( csImage );
+    sqlite3_close( pWorker->pDB );
+    g_free( pWorker );
+    return NULL;
+}
+
+/*!     \brief  Render the trace profiles of a project
+ *
+ * Each trace profile is recovered and its plot(s) drawn on worker threads.
+ * A PDF report has a page for each plot, in the order of the profile names.
+ * PNG and SVG files are named after the profiles.
+ * High resolution Smith charts are not made.
+ *
+ * \param  pGlobal      pointer to global data (for the plot options)
+ * \param  sProject     project (or NULL for all projects)
+ * \param  fileType     ePDF, eSVG or ePNG
+ * \param  sTarget      PDF report file or directory for the PNG or SVG files
+ * \param  sSearch      render only the profiles matching this search text (or NULL for all)
+ * \return              OK or ERROR
+ */
+gint
+renderProject( tGlobal *pGlobal, const gchar *sProject, tFileType fileType,
+        const gchar *sTarget, const gchar *sSearch ) {
+    tRenderProject render = { .pGlobal = pGlobal, .fileType = fileType, .sDirectory = sTarget };
+    GPtrArray *pWorkers;
+    gchar **sRowIDs, *sMessage;
+    cairo_surface_t *csReport = NULL;
+    cairo_t *crReport = NULL;
+    guint nThreads, nRendered = 0, nWritten = 0;
+    gint nPages = 0, rtn = OK;
+
+    if( (sRowIDs = searchProfiles( eDB_TRACE, sProject, sSearch, FALSE )) == NULL )
+        return ERROR;
+
+    render.pItems = g_ptr_array_new_with_free_func( (GDestroyNotify)freeRenderItem );
+    for( gint i = 0; sRowIDs[ i ] != NULL; i++ ) {
+        tProfileSearchRow *pRow = fetchProfileSearchRow( g_ascii_strtoll( sRowIDs[ i ], NULL, 10 ) );
+
+        if( pRow ) {
+            tRenderItem *pItem = g_new0( tRenderItem, 1 );
+            pItem->sProject = g_steal_pointer( &pRow->sProject );
+            pItem->sName = g_steal_pointer( &pRow->sName );
+            g_ptr_array_add( render.pItems, pItem );
+            freeProfileSearchRow( pRow );
+        }
+    }
+    g_strfreev( sRowIDs );
+
+    if( render.pItems->len == 0 ) {
+        postError( "No trace profiles to render" );
+        g_ptr_array_free( render.pItems, TRUE );
+        return ERROR;
+    }
+
+    if( fileType == ePDF ) {
+        gdouble width, height;
+
+        plotFilePageSize( pGlobal, ePDF, &width, &height );
+        csReport = cairo_pdf_surface_create( sTarget, width, height );
+        cairo_pdf_surface_set_metadata( csReport, CAIRO_PDF_METADATA_CREATOR, "HP8753 Network Analyzer" );
+        if( sProject )
+            cairo_pdf_surface_set_metadata( csReport, CAIRO_PDF_METADATA_TITLE, sProject );
+        crReport = cairo_create( csReport );
+        if( cairo_surface_status( csReport ) != CAIRO_STATUS_SUCCESS )
+            g_atomic_int_set( &render.bCancel, TRUE );
+    } else if( g_mkdir_with_parents( sTarget, 0755 ) != 0 ) {
+        g_atomic_int_set( &render.bCancel, TRUE );
+    }
+    if( g_atomic_int_get( &render.bCancel ) ) {
+        sMessage = g_strdup_printf( "Cannot write: %s", sTarget );
+        postError( sMessage );
+        g_free( sMessage );
+        rtn = ERROR;
+        goto cleanup;
+    }
+
+    render.pRendered = g_async_queue_new();
+    nThreads = MIN( CLAMP( g_get_num_processors(), 1, RENDER_MAX_THREADS ), (gint)render.pItems->len );
+    pWorkers = g_ptr_array_new();
+    for( guint i = 0; i < nThreads; i++ ) {
+        tRenderWorker *pWorker = g_new0( tRenderWorker, 1 );
+
+        pWorker->pRender = &render;
+        if( (pWorker->pDB = openReadOnlyDBconnection()) == NULL ) {
+            g_free( pWorker );
+            break;
+        }
+        g_ptr_array_add( pWorkers, g_thread_new( "render", renderProjectWorker, pWorker ) );
+    }
+    if( pWorkers->len == 0 ) {
+        postError( "Cannot open the database" );
+        rtn = ERROR;
+    }
+
+    // add the pages to the report in order as they are drawn
+    while( pWorkers->len > 0 && nRendered < render.pItems->len ) {
+        tRenderItem *pItem = g_async_queue_pop( render.pRendered );
+
+        pItem->bRendered = TRUE;
+        nRendered++;
+        if( pItem->status != OK )
+            rtn = ERROR;
+
+        for( ; nWritten < render.pItems->len
+                && ((tRenderItem *)g_ptr_array_index( render.pItems, nWritten ))->bRendered; nWritten++ ) {
+            tRenderItem *pNext = g_ptr_array_index( render.pItems, nWritten );
+
+            if( pNext->status != OK )
+                continue;
+            if( fileType == ePDF ) {
+                gchar *sLink = g_strdup_printf( "page=%d", nPages + 1 );
+                cairo_pdf_surface_add_outline( csReport, CAIRO_PDF_OUTLINE_ROOT, pNext->sName, sLink, 0 );
+                g_free( sLink );
+                for( gint page = 0; page < pNext->nPages; page++ ) {
+                    cairo_set_source_surface( crReport, pNext->pPages[ page ], 0.0, 0.0 );
+                    cairo_paint( crReport );
+                    cairo_show_page( crReport );
+                    g_clear_pointer( &pNext->pPages[ page ], cairo_surface_destroy );
+                }
+            }
+            nPages += pNext->nPages;
+        }
+    }
+
+    for( guint i = 0; i < pWorkers->len; i++ )
+        g_thread_join( g_ptr_array_index( pWorkers, i ) );
+    g_ptr_array_free( pWorkers, TRUE );
+    g_async_queue_unref( render.pRendered );
+
+    if( rtn == OK ) {
+        sMessage = g_strdup_printf( "Rendered %u trace profiles (%d pages) to %s", render.pItems->len, nPages, sTarget );
+        postInfo( sMessage );
+        g_free( sMessage );
+    }
+
+cleanup:
+    if( crReport ) {
+        cairo_destroy( crReport );
+        cairo_surface_finish( csReport );
+        if( cairo_surface_status( csReport ) != CAIRO_STATUS_SUCCESS && rtn == OK ) {
+            sMessage = g_strdup_printf( "Cannot write: %s", sTarget );
+            postError( sMessage );
+            g_free( sMessage );
+            rtn = ERROR;
+        }
+        cairo_surface_destroy( csReport );
+    }
+    g_ptr_array_free( render.pItems, TRUE );
+
+    return rtn;
+}
@@ -68,6 +68,10 @@ static int gsRunStringCont( void *minst, gchar *string, int *pexit_code) {
 	return gsapi_run_string_continue(minst, string, strlen(string), 0, pexit_code);
 }
 
+// Ghostscript allows only one instance at a time (unless built thread safe)
+// and exports run on worker threads
+static GMutex gsMutex;
+
 static gboolean showHRsmithStimulusInformation (void *minst, eChannel channel, tGlobal *pGlobal, gboolean bOverlay);
 static void showHRsmithBandwidth( void *minst, tGlobal *pGlobal, eChannel channel, gboolean bOverlay );
 static void drawSmithHRmarkers( void *minst, tGlobal *pGlobal, eChannel channel, gboolean bOverlay );
@@ -80,6 +84,7 @@ smithHighResPDF(tGlobal *pGlobal, gchar *filename, eChannel channel)
     gchar * gsargv[7];
     gint gsargc;
     gint npoints;
+    tComplex *controlPoints;
     void *minst = NULL;
     gchar sBuf[ BUFFER_SIZE_250 ];
     enum { eRX, eGB, eNone } eLastGrid = eNone;
@@ -99,9 +104,13 @@ smithHighResPDF(tGlobal *pGlobal, gchar *filename, eChannel channel)
 
 	gsargv[5] = g_strdup_printf( "-sOutputFile=%s", filename );
 
+	g_mutex_lock( &gsMutex );
 	code = gsapi_new_instance(&minst, NULL);
-	if (code < 0)
+	if (code < 0) {
+		g_mutex_unlock( &gsMutex );
+		g_free( gsargv[5] );
 		return 1;
+	}
 	code = gsapi_set_arg_encoding(minst, GS_ARG_ENCODING_UTF8);
 	gsapi_set_stdio(minst, gsdll_stdin, gsdll_stdout, gsdll_stderr);
 	if (code == 0)
@@ -158,23 +167,15 @@ smithHighResPDF(tGlobal *pGlobal, gchar *filename, eChannel channel)
 			gsRunStringCont(minst, "0.00 0.00 0.50 setrgbcolor [ ",&exit_code);
 
 		npoints = pGlobal->HP8753.channels[chan].nPoints;
+		controlPoints = getSplineControlPoints( &pGlobal->HP8753.channels[chan] );
 
 		for( int n=0; n < npoints; n++ ) {
 			if( pGlobal->flags.bSmithSpline && n != 0 ) {
-				// Helping variables for lines.
-				tLine g, l;
 				// Variables for control points.
-				tComplex c1, c2;
-			    g.A = pGlobal->HP8753.channels[chan].responsePoints[(n + npoints - 2) % npoints];
-			    g.B = pGlobal->HP8753.channels[chan].responsePoints[(n + npoints - 1) % npoints];
-			    l.A = pGlobal->HP8753.channels[chan].responsePoints[(n + npoints + 0) % npoints];
-			    l.B = pGlobal->HP8753.channels[chan].responsePoints[(n + npoints + 1) % npoints];
-
-			      // Calculate controls points for points pt[i-1] and pt[i].
-			    bezierControlPoints(&g, &l, &c1, &c2);
+				tComplex c1 = controlPoints[ 2*n ], c2 = controlPoints[ 2*n + 1 ];
 			    // Handle special case because points are not connected in a loop
-			    if (n == 1) c1 = g.B;
-			    if (n == npoints - 1) c2 = l.A;
+			    if (n == 1) c1 = pGlobal->HP8753.channels[chan].responsePoints[0];
+			    if (n == npoints - 1) c2 = pGlobal->HP8753.channels[chan].responsePoints[n];
 				g_snprintf( sBuf, BUFFER_SIZE_250, "%e %e  %e %e  %e %e ",
 						c1.r, c1.i, c2.r, c2.i,
 						pGlobal->HP8753.channels[chan].responsePoints[n].r,
@@ -220,7 +221,8 @@ smithHighResPDF(tGlobal *pGlobal, gchar *filename, eChannel channel)
 		code = code1;
 
 	gsapi_delete_instance(minst);
-
+	g_mutex_unlock( &gsMutex );
+	g_free( gsargv[5] );
 
     if ((code == 0) || (code == gs_error_Quit))
         return 0;
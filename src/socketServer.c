@@ -0,0 +1,494 @@
+/*
+ * Copyright (c) 2026 Michael G. Katzmann
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/*! \file socketServer.c
+ * Local server sharing the HP8753 among many clients.
+ *
+ * Only one process can own the GPIB device. With --server the program listens on
+ * a Unix socket ($XDG_RUNTIME_DIR/hp8753.socket) and with --server-port=<port> on
+ * a TCP port of the loopback interface. Clients send one request per line (a
+ * line longer than MAX_REQUEST_LENGTH closes the connection) and receive a reply
+ * that starts with "OK" or "ERR <reason>":
+ *
+ *      capture [1|2]           OK <points> <format>
+ *                              followed by one line per point: stimulus  real  imaginary
+ *      marker <1-5> [1|2]      OK <stimulus> <real> <imaginary>
+ *      recall <profile>        OK  (setup & calibration of the current project sent to the HP8753)
+ *      status                  OK <age of the capture in ms or -1> <clients waiting for a capture>
+ *      quit                    OK  (and the connection is closed)
+ *
+ * e.g.  echo "capture 1" | socat - UNIX-CONNECT:$XDG_RUNTIME_DIR/hp8753.socket
+ *
+ * tools/serverClient.py exercises each request against a running server.
+ *
+ * The requests are scheduled with those from D-Bus (see queueAutomationCommand)
+ * through the GPIB thread. Clients asking for a capture while one is in progress
+ * wait for that one and those asking within FRESH_CAPTURE_ms of a capture are
+ * answered from it.
+ */
+
+#include <gtk/gtk.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib-2.0/glib.h>
+#include <glib/gstdio.h>
+#include <gio/gio.h>
+#include <gio/gunixsocketaddress.h>
+
+#include "hp8753.h"
+#include "messageEvent.h"
+
+#define FRESH_CAPTURE_ms    1000
+#define SOCKET_NAME         "hp8753.socket"
+#define MAX_REQUEST_LENGTH  1024
+#define READ_CHUNK_SIZE     256
+
+typedef struct {
+    GSocketConnection   *pConnection;
+    GInputStream        *pInput;
+    GOutputStream       *pOutput;
+    GString             *sInput;        // received but not yet performed (at most MAX_REQUEST_LENGTH)
+    gchar               readBuffer[ READ_CHUNK_SIZE ];
+    GString             *sReply;        // reply being written
+    gboolean            bClose;         // close once the reply is written
+    tGlobal             *pGlobal;
+} tServerClient;
+
+typedef struct {
+    tServerClient   *pClient;
+    gint            marker;             // 0 for the trace or marker number (1 based)
+    eChannel        channel;
+} tCaptureWait;
+
+static GSocketService   *pSocketService = NULL;
+static gchar            *sSocketPath = NULL;
+
+static struct {
+    gint64      time;                   // monotonic time of the last capture (0 if none)
+    gchar       *sDateTime;             // time stamp of the trace data of that capture
+    gboolean    bInProgress;
+    GList       *pWaiting;              // tCaptureWait
+} serverCapture = { 0 };
+
+static void readClientRequest( tServerClient * );
+
+/*!     \brief  Free a client
+ *
+ * \param  pClient      client to free
+ */
+static void
+freeServerClient( tServerClient *pClient ) {
+    g_io_stream_close( G_IO_STREAM( pClient->pConnection ), NULL, NULL );
+    g_object_unref( pClient->pConnection );
+    g_string_free( pClient->sInput, TRUE );
+    if( pClient->sReply )
+        g_string_free( pClient->sReply, TRUE );
+    g_free( pClient );
+}
+
+/*!     \brief  Callback when the reply has been written to the client
+ *
+ * \param  source       output stream
+ * \param  res          result
+ * \param  gpClient     the client
+ */
+static void
+CB_replyWritten( GObject *source, GAsyncResult *res, gpointer gpClient ) {
+    tServerClient *pClient = (tServerClient *)gpClient;
+    gboolean bWritten = g_output_stream_write_all_finish( G_OUTPUT_STREAM( source ), res, NULL, NULL );
+
+    g_string_free( g_steal_pointer( &pClient->sReply ), TRUE );
+    if( !bWritten || pClient->bClose )
+        freeServerClient( pClient );
+    else
+        readClientRequest( pClient );
+}
+
+/*!     \brief  Send the reply to the client
+ *
+ * The next request is read once it has been written.
+ *
+ * \param  pClient      the client
+ * \param  sReply       reply (taken)
+ */
+static void
+sendReply( tServerClient *pClient, GString *sReply ) {
+    pClient->sReply = sReply;
+    g_output_stream_write_all_async( pClient->pOutput, sReply->str, sReply->len,
+            G_PRIORITY_DEFAULT, NULL, CB_replyWritten, pClient );
+}
+
+/*!     \brief  Send an error reply to the client
+ *
+ * \param  pClient      the client
+ * \param  sReason      reason for the error
+ */
+static void
+sendError( tServerClient *pClient, const gchar *sReason ) {
+    GString *sReply = g_string_new( "ERR " );
+
+    // the reply is one line
+    for( const gchar *s = sReason; *s; s++ )
+        g_string_append_c( sReply, *s == '\n' ? ' ' : *s );
+    g_string_append_c( sReply, '\n' );
+    sendReply( pClient, sReply );
+}
+
+/*!     \brief  Answer a trace or marker request from the last capture
+ *
+ * \param  pGlobal      pointer to global data
+ * \param  pWait        the request
+ */
+static void
+answerFromCapture( tGlobal *pGlobal, tCaptureWait *pWait ) {
+    tChannel *pChannel = &pGlobal->HP8753.channels[ pWait->channel ];
+    GString *sReply;
+
+    if( pWait->channel == eCH_TWO && !pGlobal->HP8753.flags.bDualChannel ) {
+        sendError( pWait->pClient, "channel 2 is not displayed" );
+        return;
+    }
+    if( !pChannel->chFlags.bValidData ) {
+        sendError( pWait->pClient, "no trace data" );
+        return;
+    }
+
+    sReply = g_string_new( NULL );
+    if( pWait->marker == 0 ) {
+        gdouble *stimulus = getStimulusPoints( pChannel );
+
+        g_string_append_printf( sReply, "OK %d %s\n", pChannel->nPoints, optFormat[ pChannel->format ].desc );
+        for( gint i = 0; i < pChannel->nPoints; i++ )
+            g_string_append_printf( sReply, "%.16lg\t%.16lg\t%.16lg\n",
+                    stimulus[i], pChannel->responsePoints[i].r, pChannel->responsePoints[i].i );
+    } else if( pChannel->chFlags.bbMkrs & (1 << (pWait->marker - 1)) ) {
+        tMarker *pMarker = &pChannel->numberedMarkers[ pWait->marker - 1 ];
+
+        g_string_append_printf( sReply, "OK %.16lg %.16lg %.16lg\n",
+                pMarker->sourceValue, pMarker->point.r, pMarker->point.i );
+    } else {
+        g_string_free( sReply, TRUE );
+        sendError( pWait->pClient, "marker is off" );
+        return;
+    }
+    sendReply( pWait->pClient, sReply );
+}
+
+/*!     \brief  Is the trace data that of a recent capture
+ *
+ * The trace data may have been replaced since (by a trace recalled in the GUI).
+ *
+ * \param  pGlobal      pointer to global data
+ * \return              TRUE if requests can be answered from it
+ */
+static gboolean
+isCaptureFresh( tGlobal *pGlobal ) {
+    return serverCapture.time != 0
+            && g_get_monotonic_time() - serverCapture.time < FRESH_CAPTURE_ms * 1000
+            && g_strcmp0( serverCapture.sDateTime, pGlobal->HP8753.dateTime ) == 0;
+}
+
+/*!     \brief  Called when the capture has completed
+ *
+ * All the clients waiting for the capture are answered.
+ *
+ * \param  pGlobal      pointer to global data
+ * \param  bSuccess     the capture succeeded
+ * \param  sMessage     error message
+ * \param  udata        unused
+ */
+static void
+captureDone( tGlobal *pGlobal, gboolean bSuccess, const gchar *sMessage, gpointer udata ) {
+    GList *pWaiting = g_steal_pointer( &serverCapture.pWaiting );
+
+    serverCapture.bInProgress = FALSE;
+    g_free( serverCapture.sDateTime );
+    if( bSuccess ) {
+        serverCapture.time = g_get_monotonic_time();
+        serverCapture.sDateTime = g_strdup( pGlobal->HP8753.dateTime );
+    } else {
+        serverCapture.time = 0;
+        serverCapture.sDateTime = NULL;
+    }
+
+    for( GList *l = pWaiting; l != NULL; l = l->next ) {
+        tCaptureWait *pWait = l->data;
+        if( bSuccess )
+            answerFromCapture( pGlobal, pWait );
+        else
+            sendError( pWait->pClient, sMessage );
+    }
+    g_list_free_full( pWaiting, g_free );
+}
+
+/*!     \brief  Answer a trace or marker request
+ *
+ * Answered from the last capture if it is fresh, otherwise once a capture
+ * (the one in progress or a new one) completes.
+ *
+ * \param  pClient      the client
+ * \param  marker       0 for the trace or the marker number
+ * \param  channel      channel
+ */
+static void
+requestCapture( tServerClient *pClient, gint marker, eChannel channel ) {
+    tGlobal *pGlobal = pClient->pGlobal;
+    tCaptureWait *pWait = g_new0( tCaptureWait, 1 );
+
+    pWait->pClient = pClient;
+    pWait->marker = marker;
+    pWait->channel = channel;
+
+    if( !serverCapture.bInProgress && isCaptureFresh( pGlobal ) ) {
+        answerFromCapture( pGlobal, pWait );
+        g_free( pWait );
+        return;
+    }
+
+    serverCapture.pWaiting = g_list_append( serverCapture.pWaiting, pWait );
+    if( !serverCapture.bInProgress ) {
+        serverCapture.bInProgress = TRUE;
+        queueAutomationCommand( pGlobal, eAUTO_GET_TRACE, NULL, captureDone, NULL );
+    }
+}
+
+/*!     \brief  Called when a recall has completed
+ *
+ * \param  pGlobal      pointer to global data
+ * \param  bSuccess     the recall succeeded
+ * \param  sMessage     error message
+ * \param  gpClient     the client
+ */
+static void
+recallDone( tGlobal *pGlobal, gboolean bSuccess, const gchar *sMessage, gpointer gpClient ) {
+    if( bSuccess )
+        sendReply( (tServerClient *)gpClient, g_string_new( "OK\n" ) );
+    else
+        sendError( (tServerClient *)gpClient, sMessage );
+}
+
+/*!     \brief  Perform a request from a client
+ *
+ * \param  pClient      the client
+ * \param  sRequest     the request line
+ */
+static void
+performRequest( tServerClient *pClient, gchar *sRequest ) {
+    tGlobal *pGlobal = pClient->pGlobal;
+    gchar **sArgs = g_strsplit_set( g_strstrip( sRequest ), " \t", 3 );
+    gint nArgs = g_strv_length( sArgs );
+    gint channel = 1, marker = 0;
+
+    if( nArgs == 0 || *sArgs[0] == 0 ) {
+        sendError( pClient, "empty request" );
+    } else if( g_strcmp0( sArgs[0], "capture" ) == 0 ) {
+        if( nArgs > 1 )
+            channel = atoi( sArgs[1] );
+        if( channel != 1 && channel != 2 )
+            sendError( pClient, "channel must be 1 or 2" );
+        else
+            requestCapture( pClient, 0, channel - 1 );
+    } else if( g_strcmp0( sArgs[0], "marker" ) == 0 ) {
+        if( nArgs > 1 )
+            marker = atoi( sArgs[1] );
+        if( nArgs > 2 )
+            channel = atoi( sArgs[2] );
+        if( marker < 1 || marker > MAX_MKRS )
+            sendError( pClient, "marker must be 1 to 5" );
+        else if( channel != 1 && channel != 2 )
+            sendError( pClient, "channel must be 1 or 2" );
+        else
+            requestCapture( pClient, marker, channel - 1 );
+    } else if( g_strcmp0( sArgs[0], "recall" ) == 0 ) {
+        // the profile name is the rest of the line
+        gchar *sProfile = g_strchug( sRequest + strlen( "recall" ) );
+        if( *sProfile == 0 ) {
+            sendError( pClient, "profile name required" );
+        } else {
+            // the analyzer will no longer have the setup of the last capture
+            serverCapture.time = 0;
+            queueAutomationCommand( pGlobal, eAUTO_RESTORE_SETUPandCAL, sProfile, recallDone, pClient );
+        }
+    } else if( g_strcmp0( sArgs[0], "status" ) == 0 ) {
+        GString *sReply = g_string_new( NULL );
+        gint64 age = serverCapture.time != 0
+                ? (g_get_monotonic_time() - serverCapture.time) / 1000 : -1;
+        g_string_printf( sReply, "OK %" G_GINT64_FORMAT " %u\n",
+                age, g_list_length( serverCapture.pWaiting ) );
+        sendReply( pClient, sReply );
+    } else if( g_strcmp0( sArgs[0], "quit" ) == 0 ) {
+        pClient->bClose = TRUE;
+        sendReply( pClient, g_string_new( "OK\n" ) );
+    } else {
+        sendError( pClient, "unknown request" );
+    }
+    g_strfreev( sArgs );
+}
+
+/*!     \brief  Callback when a chunk has been read from the client
+ *
+ * \param  source       input stream
+ * \param  res          result
+ * \param  gpClient     the client
+ */
+static void
+CB_requestRead( GObject *source, GAsyncResult *res, gpointer gpClient ) {
+    tServerClient *pClient = (tServerClient *)gpClient;
+    gssize nRead = g_input_stream_read_finish( G_INPUT_STREAM( source ), res, NULL );
+
+    if( nRead < 0 || (nRead == 0 && pClient->sInput->len == 0) ) {
+        // error or end of stream
+        freeServerClient( pClient );
+        return;
+    }
+
+    if( nRead == 0 )
+        // the last request was not terminated
+        g_string_append_c( pClient->sInput, '\n' );
+    else
+        g_string_append_len( pClient->sInput, pClient->readBuffer, nRead );
+    readClientRequest( pClient );
+}
+
+/*!     \brief  Perform the next request of a client
+ *
+ * The request is performed if a whole line has been received, otherwise more is
+ * read, a chunk at a time. A client sending more than MAX_REQUEST_LENGTH without a
+ * new line is refused and disconnected, so no more than that is ever buffered.
+ *
+ * \param  pClient      the client
+ */
+static void
+readClientRequest( tServerClient *pClient ) {
+    gchar *pEnd = memchr( pClient->sInput->str, '\n', pClient->sInput->len );
+    gsize length = pEnd ? (gsize)(pEnd - pClient->sInput->str) : pClient->sInput->len;
+
+    if( length > MAX_REQUEST_LENGTH ) {
+        pClient->bClose = TRUE;
+        sendError( pClient, "request too long" );
+    } else if( pEnd == NULL ) {
+        g_input_stream_read_async( pClient->pInput, pClient->readBuffer, sizeof( pClient->readBuffer ),
+                G_PRIORITY_DEFAULT, NULL, CB_requestRead, pClient );
+    } else {
+        gchar *sRequest = g_strndup( pClient->sInput->str, length );
+
+        g_string_erase( pClient->sInput, 0, length + 1 );
+        if( g_utf8_validate( sRequest, -1, NULL ) ) {
+            performRequest( pClient, sRequest );
+        } else {
+            pClient->bClose = TRUE;
+            sendError( pClient, "request is not UTF-8" );
+        }
+        g_free( sRequest );
+    }
+}
+
+/*!     \brief  Callback for a new connection
+ *
+ * \param  service          socket service
+ * \param  pConnection      the connection
+ * \param  sourceObject     unused
+ * \param  gpGlobal         pointer to global data
+ * \return                  TRUE (the connection is handled)
+ */
+static gboolean
+CB_incomingConnection( GSocketService *service, GSocketConnection *pConnection,
+        GObject *sourceObject, gpointer gpGlobal ) {
+    tServerClient *pClient = g_new0( tServerClient, 1 );
+
+    pClient->pGlobal = (tGlobal *)gpGlobal;
+    pClient->pConnection = g_object_ref( pConnection );
+    pClient->pInput = g_io_stream_get_input_stream( G_IO_STREAM( pConnection ) );
+    pClient->sInput = g_string_sized_new( READ_CHUNK_SIZE );
+    pClient->pOutput = g_io_stream_get_output_stream( G_IO_STREAM( pConnection ) );
+
+    readClientRequest( pClient );
+    return TRUE;
+}
+
+/*!     \brief  Start the local server
+ *
+ * \param  pGlobal      pointer to global data
+ * \param  bUnixSocket  listen on the Unix socket
+ * \param  port         TCP port on the loopback interface (or 0 for none)
+ * \return              OK or ERROR if the server could not listen as requested
+ */
+gint
+startSocketServer( tGlobal *pGlobal, gboolean bUnixSocket, gint port ) {
+    GError *err = NULL;
+    gint rtn = OK;
+
+    if( !bUnixSocket && port == 0 )
+        return OK;
+
+    pSocketService = g_socket_service_new();
+
+    if( bUnixSocket ) {
+        GSocketAddress *pAddress;
+
+        sSocketPath = g_build_filename( g_get_user_runtime_dir(), SOCKET_NAME, NULL );
+        // remove a socket left by a previous instance (only one instance runs)
+        g_unlink( sSocketPath );
+        pAddress = g_unix_socket_address_new( sSocketPath );
+        if( !g_socket_listener_add_address( G_SOCKET_LISTENER( pSocketService ), pAddress,
+                G_SOCKET_TYPE_STREAM, G_SOCKET_PROTOCOL_DEFAULT, NULL, NULL, &err ) ) {
+            LOG( G_LOG_LEVEL_WARNING, "Cannot listen on %s: %s", sSocketPath, err->message );
+            g_clear_error( &err );
+            g_clear_pointer( &sSocketPath, g_free );
+            rtn = ERROR;
+        }
+        g_object_unref( pAddress );
+    }
+
+    if( port != 0 ) {
+        GInetAddress *pLoopback = g_inet_address_new_loopback( G_SOCKET_FAMILY_IPV4 );
+        GSocketAddress *pAddress = g_inet_socket_address_new( pLoopback, port );
+
+        if( !g_socket_listener_add_address( G_SOCKET_LISTENER( pSocketService ), pAddress,
+                G_SOCKET_TYPE_STREAM, G_SOCKET_PROTOCOL_TCP, NULL, NULL, &err ) ) {
+            LOG( G_LOG_LEVEL_WARNING, "Cannot listen on port %d: %s", port, err->message );
+            g_clear_error( &err );
+            rtn = ERROR;
+        }
+        g_object_unref( pAddress );
+        g_object_unref( pLoopback );
+    }
+
+    g_signal_connect( pSocketService, "incoming", G_CALLBACK( CB_incomingConnection ), pGlobal );
+    g_socket_service_start( pSocketService );
+
+    return rtn;
+}
+
+/*!     \brief  Stop the local server
+ *
+ * Clients waiting for a capture have been answered (see finalizeAutomation).
+ */
+void
+stopSocketServer( void ) {
+    if( pSocketService == NULL )
+        return;
+
+    g_socket_service_stop( pSocketService );
+    g_socket_listener_close( G_SOCKET_LISTENER( pSocketService ) );
+    g_clear_object( &pSocketService );
+    if( sSocketPath ) {
+        g_unlink( sSocketPath );
+        g_clear_pointer( &sSocketPath, g_free );
+    }
+    g_clear_pointer( &serverCapture.sDateTime, g_free );
+}
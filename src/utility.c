@@ -95,11 +95,77 @@ bezierControlPoints(const tLine *g, const tLine *l, tComplex *p1, tComplex *p2)
 }
 
 
+/*!     \brief  Get the Bezier control points of the trace
+ *
+ * The two control points of the curve from responsePoints[i-1] to responsePoints[i]
+ * are at [2*i] and [2*i+1]. They are calculated once for the trace (when it is
+ * captured or recalled, or else when first needed) and freed with the trace.
+ * The control points at the ends of a curve (or list sweep segment) are not
+ * meaningful; the curve's end points are used instead (see drawBezierSpline).
+ *
+ * \param pChannel     pointer to channel
+ * \return             pointer to control points (or NULL if there is no trace)
+ */
+tComplex *
+getSplineControlPoints( tChannel *pChannel ) {
+   gint cnt = pChannel->nPoints;
+   const tComplex *pt = pChannel->responsePoints;
+
+   if( pChannel->splineControlPoints == NULL && pt != NULL && cnt > 1 ) {
+      tLine g, l;
+
+      pChannel->splineControlPoints = g_new( tComplex, 2 * cnt );
+      pChannel->splineControlPoints[0] = pChannel->splineControlPoints[1] = pt[0];
+      for (int i = 1; i < cnt; i++)
+      {
+         g.A = pt[(i + cnt - 2) % cnt];
+         g.B = pt[(i + cnt - 1) % cnt];
+         l.A = pt[(i + cnt + 0) % cnt];
+         l.B = pt[(i + cnt + 1) % cnt];
+
+         // Calculate controls points for points pt[i-1] and pt[i].
+         bezierControlPoints(&g, &l, &pChannel->splineControlPoints[ 2*i ],
+               &pChannel->splineControlPoints[ 2*i + 1 ]);
+      }
+   }
+   return pChannel->splineControlPoints;
+}
+
+/*!     \brief  Forget the Bezier control points of the trace
+ *
+ * Called whenever the response points change.
+ *
+ * \param pChannel     pointer to channel
+ */
+void
+clearSplineControlPoints( tChannel *pChannel ) {
+   g_clear_pointer( &pChannel->splineControlPoints, g_free );
+}
+
+/*!     \brief  Forget all of the data derived from the trace
+ *
+ * The Bezier control points and the decimated trace. Called whenever the
+ * response points change or are freed.
+ *
+ * \param pChannel     pointer to channel
+ */
 void
-drawBezierSpline(cairo_t *ctx, const tComplex *pt, gint cnt)
+clearDerivedTraceData( tChannel *pChannel ) {
+   clearSplineControlPoints( pChannel );
+   g_clear_pointer( &pChannel->decimated.indexes, g_array_unref );
+   pChannel->decimated.nColumns = 0;
+}
+
+/*!     \brief  Draw the trace (or a segment of it) as a Bezier spline
+ *
+ * \param ctx          cairo context
+ * \param pt           first point of the curve
+ * \param ctl          control points for the curve (at the offset of pt in getSplineControlPoints)
+ * \param cnt          number of points in the curve
+ */
+void
+drawBezierSpline(cairo_t *ctx, const tComplex *pt, const tComplex *ctl, gint cnt)
 {
-   // Helping variables for lines.
-   tLine g, l;
    // Variables for control points.
    tComplex c1, c2;
 
@@ -107,17 +173,12 @@ drawBezierSpline(cairo_t *ctx, const tComplex *pt, gint cnt)
    cairo_move_to(ctx, pt[0].r, pt[0].i);
    for (int i = 1; i < cnt; i++)
    {
-      g.A = pt[(i + cnt - 2) % cnt];
-      g.B = pt[(i + cnt - 1) % cnt];
-      l.A = pt[(i + cnt + 0) % cnt];
-      l.B = pt[(i + cnt + 1) % cnt];
-
-      // Calculate controls points for points pt[i-1] and pt[i].
-      bezierControlPoints(&g, &l, &c1, &c2);
+      c1 = ctl[ 2*i ];
+      c2 = ctl[ 2*i + 1 ];
 
       // Handle special case because points are not connected in a loop.
-      if (i == 1) c1 = g.B;
-      if (i == cnt - 1) c2 = l.A;
+      if (i == 1) c1 = pt[0];
+      if (i == cnt - 1) c2 = pt[i];
 
       // Create Cairo curve path.
       cairo_curve_to(ctx, c1.r, c1.i, c2.r, c2.i, pt[i].r, pt[i].i);
@@ -179,9 +240,8 @@ bezierInterpolate(
 // for non-integer position
 //
 gint
-splineInterpolate( gint npoints, tComplex curve[], gdouble samplePoint, tComplex *result ) {
+splineInterpolate( gint npoints, tComplex curve[], const tComplex ctl[], gdouble samplePoint, tComplex *result ) {
 
-    tLine g, l;
     tComplex c1, c2;
     gdouble dummy;
 
@@ -208,18 +268,14 @@ splineInterpolate( gint npoints, tComplex curve[], gdouble samplePoint, tComplex
         return( FALSE );
     }
 
-    g.A = curve[(n + npoints - 2) % npoints];
-    g.B = curve[(n + npoints - 1) % npoints];
-    l.A = curve[(n + npoints + 0) % npoints];
-    l.B = curve[(n + npoints + 1) % npoints];
-
-    // Calculate controls points for points pt[i-1] and pt[i].
-    bezierControlPoints(&g, &l, &c1, &c2);
+    // Control points for points pt[i-1] and pt[i] (see getSplineControlPoints)
+    c1 = ctl[ 2*n ];
+    c2 = ctl[ 2*n + 1 ];
     // Fix control points at the curve ends because points are not connected in a loop
     if (n == 1)
-        c1 = g.B;
+        c1 = curve[0];
     if (n == npoints - 1)
-        c2 = l.A;
+        c2 = curve[n];
 
     // now interpolate the bspline to find the point corresponding to sample
     *result = bezierInterpolate( curve[n-1], curve[n], c1, c2, modf( samplePoint, &dummy ) );
@@ -260,17 +316,14 @@ tColor hsv2rgb(tColor HSV)
 
 tHP8753traceAbstract *
 selectFirstTraceProfileInProject( tGlobal *pGlobal ) {
-    tHP8753traceAbstract *firstTraceProfile = NULL;
+    tHP8753traceAbstract *firstTraceProfile = NULL, *pTraceAbstract;
     pGlobal->pTraceAbstract=NULL;
-    for( GList *l = pGlobal->pTraceList; l != NULL; l = l->next ){
-        tHP8753traceAbstract *pTraceAbstract = (tHP8753traceAbstract *)(l->data);
-        if( g_strcmp0( pTraceAbstract->projectAndName.sProject, pGlobal->sProject )  == 0 ) {
-            if( firstTraceProfile == NULL ) {
-                firstTraceProfile = pTraceAbstract;
-                pTraceAbstract->projectAndName.bbFlags.bSelected = TRUE;
-            } else {
-                pTraceAbstract->projectAndName.bbFlags.bSelected = FALSE;
-            }
+    for( guint i = 0; (pTraceAbstract = catalogNthInProject( &pGlobal->traceCatalog, pGlobal->sProject, i )) != NULL; i++ ){
+        if( firstTraceProfile == NULL ) {
+            firstTraceProfile = pTraceAbstract;
+            pTraceAbstract->projectAndName.bbFlags.bSelected = TRUE;
+        } else {
+            pTraceAbstract->projectAndName.bbFlags.bSelected = FALSE;
         }
     }
     return firstTraceProfile;
@@ -278,17 +331,14 @@ selectFirstTraceProfileInProject( tGlobal *pGlobal ) {
 
 tHP8753cal *
 selectFirstCalibrationProfileInProject( tGlobal *pGlobal ) {
-    tHP8753cal *firstCalProfile = NULL;
+    tHP8753cal *firstCalProfile = NULL, *pCalibration;
     pGlobal->pCalibrationAbstract=NULL;
-    for( GList *l = pGlobal->pCalList; l != NULL; l = l->next ){
-        tHP8753cal *pCalibration = (tHP8753cal *)(l->data);
-        if( g_strcmp0( pCalibration->projectAndName.sProject, pGlobal->sProject )  == 0 ) {
-            if( firstCalProfile == NULL ) {
-                firstCalProfile = pCalibration;
-                pCalibration->projectAndName.bbFlags.bSelected = TRUE;
-            } else {
-                pCalibration->projectAndName.bbFlags.bSelected = FALSE;
-            }
+    for( guint i = 0; (pCalibration = catalogNthInProject( &pGlobal->calCatalog, pGlobal->sProject, i )) != NULL; i++ ){
+        if( firstCalProfile == NULL ) {
+            firstCalProfile = pCalibration;
+            pCalibration->projectAndName.bbFlags.bSelected = TRUE;
+        } else {
+            pCalibration->projectAndName.bbFlags.bSelected = FALSE;
         }
     }
     return firstCalProfile;
@@ -297,17 +347,12 @@ selectFirstCalibrationProfileInProject( tGlobal *pGlobal ) {
 tHP8753cal *
 selectCalibrationProfile( tGlobal *pGlobal, gchar *sProject, gchar *sName ) {
     // Find the calibration in the list
-    tHP8753cal *pSelectedCalibrationProfile = NULL;
-    tProjectAndName projectAndName = { sProject, sName };
+    tHP8753cal *pSelectedCalibrationProfile = NULL, *pCalibration;
 
-    for( GList *l = pGlobal->pCalList; l != NULL; l = l->next ) {
-        tHP8753cal *pCalibration = (tHP8753cal *)(l->data);
-        if( g_strcmp0( pCalibration->projectAndName.sProject, sProject )  == 0 )
-            pCalibration->projectAndName.bbFlags.bSelected = FALSE;
-    }
+    for( guint i = 0; (pCalibration = catalogNthInProject( &pGlobal->calCatalog, sProject, i )) != NULL; i++ )
+        pCalibration->projectAndName.bbFlags.bSelected = FALSE;
 
-    pSelectedCalibrationProfile =
-            g_list_find_custom( pGlobal->pCalList, &projectAndName, (GCompareFunc)compareCalItemsForFind )->data;
+    pSelectedCalibrationProfile = catalogLookup( &pGlobal->calCatalog, sProject, sName );
 
     if( pSelectedCalibrationProfile != NULL )
         pSelectedCalibrationProfile->projectAndName.bbFlags.bSelected = TRUE;
@@ -317,17 +362,12 @@ selectCalibrationProfile( tGlobal *pGlobal, gchar *sProject, gchar *sName ) {
 tHP8753traceAbstract *
 selectTraceProfile( tGlobal *pGlobal, gchar *sProject, gchar *sName ) {
     // Find the trace in the list, mark it as selected and clear selection of others
-    tHP8753traceAbstract *pSelectedTraceProfile = NULL;
-    tProjectAndName projectAndName = { sProject, sName };
+    tHP8753traceAbstract *pSelectedTraceProfile = NULL, *pTraceAbstract;
 
-    for( GList *l = pGlobal->pTraceList; l != NULL; l = l->next ) {
-        tHP8753traceAbstract *pTraceAbstract = (tHP8753traceAbstract *)(l->data);
-        if( g_strcmp0( pTraceAbstract->projectAndName.sProject, sProject )  == 0 )
-            pTraceAbstract->projectAndName.bbFlags.bSelected = FALSE;
-    }
+    for( guint i = 0; (pTraceAbstract = catalogNthInProject( &pGlobal->traceCatalog, sProject, i )) != NULL; i++ )
+        pTraceAbstract->projectAndName.bbFlags.bSelected = FALSE;
 
-    pSelectedTraceProfile =
-            g_list_find_custom( pGlobal->pTraceList, &projectAndName, (GCompareFunc)compareTraceItemsForFind )->data;
+    pSelectedTraceProfile = catalogLookup( &pGlobal->traceCatalog, sProject, sName );
 
     if( pSelectedTraceProfile != NULL )
         pSelectedTraceProfile->projectAndName.bbFlags.bSelected = TRUE;
@@ -401,6 +441,111 @@ getTimeStamp( gchar **psDateTime ) {
         return 0;
 }
 
+/*!     \brief  Get the stimulus value of each sample of a channel
+ *
+ *  Except for list frequency sweeps of all segments, the stimulus values are
+ *  determined by the sweep start, stop, type and number of points. They are not
+ *  saved with the trace and are regenerated here when first needed.
+ *
+ * \param  pChannel  pointer to channel data
+ * \return           pointer to the stimulus values (or NULL if there is no trace)
+ */
+gdouble *
+getStimulusPoints( tChannel *pChannel ) {
+        if( pChannel->stimulusPoints == NULL && pChannel->nPoints > 0 ) {
+                gdouble logSweepStart = log10( pChannel->sweepStart );
+                gdouble logSweepStop = log10( pChannel->sweepStop );
+
+                pChannel->stimulusPoints = g_new( gdouble, pChannel->nPoints );
+                for( gint i = 0; i < pChannel->nPoints; i++ ) {
+                        // n.b: 3 is the minimum number of points
+                        gdouble stimulusFraction = pChannel->nPoints > 1 ? (gdouble) i / (pChannel->nPoints-1) : 0.0;
+
+                        if( pChannel->sweepType == eSWP_LOGFREQ )
+                                pChannel->stimulusPoints[i] =
+                                        pow( 10.0, logSweepStart + (logSweepStop - logSweepStart) * stimulusFraction );
+                        else
+                                pChannel->stimulusPoints[i] =
+                                        pChannel->sweepStart + (pChannel->sweepStop - pChannel->sweepStart) * stimulusFraction;
+                }
+        }
+        return pChannel->stimulusPoints;
+}
+
+/*!     \brief  Index the list frequency segments of a channel
+ *
+ *  The first sample of each segment (so the segment boundaries need not be found by
+ *  comparing stimulus values) and the segments in order of start frequency (so the
+ *  segment holding a stimulus value can be found by a binary search) are recorded.
+ *  Called whenever the segments are read from the analyzer or recalled.
+ *
+ * \param  pChannel  pointer to channel data
+ */
+void
+indexSegments( tChannel *pChannel ) {
+        tSegmentIndex *pIndex = &pChannel->segmentIndex;
+        gint nSegments = CLAMP( pChannel->nSegments, 0, MAX_SEGMENTS );
+
+        pIndex->firstPoint[ 0 ] = 0;
+        for( gint seg = 0; seg < nSegments; seg++ ) {
+                pIndex->firstPoint[ seg + 1 ] = pIndex->firstPoint[ seg ] + MAX( pChannel->segments[ seg ].nPoints, 0 );
+
+                // insertion sort on start frequency (there are few segments)
+                gint n;
+                for( n = seg; n > 0
+                        && pChannel->segments[ pIndex->byStart[ n - 1 ] ].startFreq > pChannel->segments[ seg ].startFreq; n-- )
+                        pIndex->byStart[ n ] = pIndex->byStart[ n - 1 ];
+                pIndex->byStart[ n ] = seg;
+        }
+        for( gint n = 0; n < nSegments; n++ )
+                pIndex->maxStop[ n ] = MAX( n > 0 ? pIndex->maxStop[ n - 1 ] : -G_MAXDOUBLE,
+                                pChannel->segments[ pIndex->byStart[ n ] ].stopFreq );
+        pIndex->nSegments = nSegments;
+}
+
+/*!     \brief  Get the index of the list frequency segments of a channel
+ *
+ * \param  pChannel  pointer to channel data
+ * \return           pointer to the segment index
+ */
+tSegmentIndex *
+getSegmentIndex( tChannel *pChannel ) {
+        if( pChannel->segmentIndex.nSegments != CLAMP( pChannel->nSegments, 0, MAX_SEGMENTS ) )
+                indexSegments( pChannel );
+        return &pChannel->segmentIndex;
+}
+
+/*!     \brief  Find the list frequency segment that contains a stimulus value
+ *
+ *  Segments may overlap; the containing segment with the highest start
+ *  frequency is returned.
+ *
+ * \param  pChannel  pointer to channel data
+ * \param  stimulus  stimulus value
+ * \return           segment number or -1 if no segment contains the value
+ */
+gint
+findSegment( tChannel *pChannel, gdouble stimulus ) {
+        tSegmentIndex *pIndex = getSegmentIndex( pChannel );
+        gint nHead = 0, nTail = pIndex->nSegments - 1, n = -1;
+
+        // last segment (in start frequency order) that starts at or below the stimulus
+        while( nHead <= nTail ) {
+                gint nMid = (nHead + nTail) / 2;
+                if( pChannel->segments[ pIndex->byStart[ nMid ] ].startFreq <= stimulus ) {
+                        n = nMid;
+                        nHead = nMid + 1;
+                } else {
+                        nTail = nMid - 1;
+                }
+        }
+        // maxStop tells us if any segment up to n reaches the stimulus
+        for( ; n >= 0 && pIndex->maxStop[ n ] >= stimulus; n-- )
+                if( pChannel->segments[ pIndex->byStart[ n ] ].stopFreq >= stimulus )
+                        return pIndex->byStart[ n ];
+        return -1;
+}
+
 /*!     \brief  Create a string from a double with spaces (like 300 000 MHz)
  *
  *  Create a string from a double with spaces (like 300 000 MHz)
@@ -441,23 +586,8 @@ doubleToStringWithSpaces( gdouble value, gchar *sUnits ) {
  */
 gboolean
 isProjectEmpty( tGlobal *pGlobal, gchar *sProject ) {
-    gboolean bEmpty = TRUE;
-    GList *l;
-    tProjectAndName *pProjectAndName;
-
-    for( l = pGlobal->pCalList; l != NULL && bEmpty; l = l->next ){
-        pProjectAndName = &(((tHP8753cal *)l->data)->projectAndName);
-        if( g_strcmp0(  pProjectAndName->sProject, sProject ) == 0 )
-            bEmpty = FALSE;
-    }
-
-    for( l = pGlobal->pTraceList; l != NULL && bEmpty; l = l->next ){
-        pProjectAndName = &(((tHP8753traceAbstract *)l->data)->projectAndName);
-        if( g_strcmp0(  pProjectAndName->sProject, sProject ) == 0 )
-            bEmpty = FALSE;
-    }
-
-    return bEmpty;
+    return catalogProjectCount( &pGlobal->calCatalog, sProject ) == 0
+            && catalogProjectCount( &pGlobal->traceCatalog, sProject ) == 0;
 }
 
 /*!     \brief  handler for the 1 second timer tick
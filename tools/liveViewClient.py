@@ -0,0 +1,230 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2026 Michael G. Katzmann
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Check the live view frames against the captures.
+
+    tools/liveViewClient.py --live-view-port <port> [--port <port>] [--captures <n>]
+
+hp8753 must be running with --live-view-port and --server (or --server-port).
+A viewer connects to ws://localhost:<port>/ws and decodes the frames (see
+src/liveViewServer.c). Each capture is requested through the local server; the
+points the viewer reconstructs from the absolute and delta frames of channel 1
+must be those of the reply (to within float32 rounding). A second viewer that
+does not acknowledge its frames must then be sent an absolute frame with the
+current values once it catches up.
+Exits 0 if all the checks pass.
+"""
+
+import argparse
+import base64
+import os
+import socket
+import struct
+import sys
+import time
+
+HEADER_SIZE = 124
+ABSOLUTE = 0x01
+STIMULUS = 0x02
+MAX_BACKLOG = 8                 # LIVE_VIEW_MAX_BACKLOG in src/liveViewServer.c
+FRESH_CAPTURE = 1.0             # FRESH_CAPTURE_ms in src/socketServer.c
+
+failures = 0
+
+
+def check(bOK, sWhat):
+    global failures
+    print(("ok      " if bOK else "FAILED  ") + sWhat)
+    if not bOK:
+        failures += 1
+
+
+def f32(value):
+    return struct.unpack("<f", struct.pack("<f", value))[0]
+
+
+class Viewer:
+    """A minimal websocket client (no extensions, so the frames are not compressed)."""
+
+    def __init__(self, port, timeout):
+        self.sock = socket.create_connection(("127.0.0.1", port), timeout=timeout)
+        key = base64.b64encode(os.urandom(16)).decode()
+        self.sock.sendall(("GET /ws HTTP/1.1\r\nHost: localhost:%d\r\nUpgrade: websocket\r\n"
+                           "Connection: Upgrade\r\nSec-WebSocket-Key: %s\r\n"
+                           "Sec-WebSocket-Version: 13\r\n\r\n" % (port, key)).encode())
+        response = b""
+        while b"\r\n\r\n" not in response:
+            response += self.sock.recv(1)
+        if not response.startswith(b"HTTP/1.1 101"):
+            raise RuntimeError("websocket upgrade refused: " + response.decode().splitlines()[0])
+        self.channels = [{"points": None, "frame": None}, {"points": None, "frame": None}]
+
+    def recvExactly(self, n):
+        data = b""
+        while len(data) < n:
+            chunk = self.sock.recv(n - len(data))
+            if not chunk:
+                raise EOFError("live view closed")
+            data += chunk
+        return data
+
+    def message(self):
+        payload = b""
+        while True:
+            b0, b1 = self.recvExactly(2)
+            length = b1 & 0x7f
+            if length == 126:
+                length = struct.unpack(">H", self.recvExactly(2))[0]
+            elif length == 127:
+                length = struct.unpack(">Q", self.recvExactly(8))[0]
+            data = self.recvExactly(length)
+            opcode = b0 & 0x0f
+            if opcode == 0x8:
+                raise EOFError("live view closed")
+            if opcode in (0x9, 0xa):    # ping & pong
+                continue
+            payload += data
+            if b0 & 0x80:
+                return payload
+
+    def acknowledge(self):
+        mask = os.urandom(4)
+        data = b"ack"
+        self.sock.sendall(bytes([0x81, 0x80 | len(data)]) + mask
+                          + bytes(c ^ mask[i % 4] for i, c in enumerate(data)))
+
+    def frame(self, bAcknowledge=True):
+        """Read a frame and update the channel; return (channel, flags, frame number)."""
+        b = self.message()
+        if bAcknowledge:
+            self.acknowledge()
+        if b[0] != ord("V") or b[1] != 1:
+            raise RuntimeError("not a version 1 live view frame")
+        flags, channel = b[2], b[3] & 1
+        frameNumber, nPoints = struct.unpack_from("<IH", b, 4)
+        offset = HEADER_SIZE + (4 * nPoints if flags & STIMULUS else 0)
+        values = struct.unpack_from("<%df" % (2 * nPoints), b, offset)
+        ch = self.channels[channel]
+        if flags & ABSOLUTE:
+            ch["points"] = list(values)
+        elif ch["points"] is None or len(ch["points"]) != len(values):
+            raise RuntimeError("difference frame without the values it is relative to")
+        else:
+            # as the viewer (float32 arithmetic)
+            ch["points"] = [f32(p + d) for p, d in zip(ch["points"], values)]
+        ch["frame"] = frameNumber
+        return channel, flags, frameNumber
+
+    def close(self):
+        self.sock.close()
+
+
+def matches(reconstructed, points):
+    """The differences are float32, so each value may be out by a float32 rounding."""
+    if reconstructed is None or len(reconstructed) != len(points):
+        return False
+    tolerance = 4 * 2 ** -24 * max([abs(p) for p in points] + [1e-30])
+    return all(abs(a - b) <= tolerance for a, b in zip(reconstructed, points))
+
+
+def capture(args):
+    """Capture channel 1 through the local server; return the points as float32."""
+    # a request soon after a capture is answered from it (and nothing is sent to the viewers)
+    time.sleep(FRESH_CAPTURE + 0.1)
+    if args.port:
+        sock = socket.create_connection(("127.0.0.1", args.port), timeout=args.timeout)
+    else:
+        sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        sock.settimeout(args.timeout)
+        sock.connect(os.path.join(os.environ.get("XDG_RUNTIME_DIR", "/tmp"), "hp8753.socket"))
+    f = sock.makefile("rb")
+    sock.sendall(b"capture 1\n")
+    sReply = f.readline().decode().strip()
+    if not sReply.startswith("OK "):
+        raise RuntimeError("capture: " + sReply)
+    points = []
+    for _ in range(int(sReply.split()[1])):
+        _, re, im = f.readline().decode().split("\t")
+        points += [f32(float(re)), f32(float(im))]
+    sock.sendall(b"quit\n")
+    f.close()
+    sock.close()
+    return points
+
+
+def frameOfCapture(viewer, bAcknowledge=True):
+    """Read frames until the next one of channel 1; return its flags."""
+    while True:
+        channel, flags, _ = viewer.frame(bAcknowledge)
+        if channel == 0:
+            return flags
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--live-view-port", type=int, required=True, help="port of the live view")
+    parser.add_argument("--port", type=int, default=0, help="TCP port of the server (default: the Unix socket)")
+    parser.add_argument("--captures", type=int, default=5, help="captures to compare")
+    parser.add_argument("--timeout", type=float, default=60.0, help="seconds to wait")
+    args = parser.parse_args()
+
+    viewer = Viewer(args.live_view_port, args.timeout)
+    laggard = Viewer(args.live_view_port, args.timeout)
+    # the frames of the last capture (if any) are sent on connection
+    viewer.sock.settimeout(0.5)
+    try:
+        while True:
+            viewer.frame()
+    except socket.timeout:
+        pass
+    viewer.sock.settimeout(args.timeout)
+
+    kinds = set()
+    for n in range(max(args.captures, MAX_BACKLOG + 2)):
+        points = capture(args)
+        flags = frameOfCapture(viewer)
+        kinds.add("absolute" if flags & ABSOLUTE else "delta")
+        if n < args.captures:
+            check(matches(viewer.channels[0]["points"], points),
+                  "capture %d: %s frame %d, %d points match" % (n + 1, "absolute" if flags & ABSOLUTE else "delta",
+                                                              viewer.channels[0]["frame"], len(points) // 2))
+    check("delta" in kinds, "difference frames were sent")
+
+    # the laggard has not read (or acknowledged) anything .. it must have been skipped
+    # and, once it acknowledges, be resynchronized with an absolute frame
+    nFrames = 0
+    laggard.sock.settimeout(0.5)
+    try:
+        while True:
+            laggard.frame()
+            nFrames += 1
+    except socket.timeout:
+        pass
+    laggard.sock.settimeout(args.timeout)
+    check(nFrames <= MAX_BACKLOG, "the viewer not acknowledging was sent %d frames" % nFrames)
+    points = capture(args)
+    frameOfCapture(viewer)
+    flags = frameOfCapture(laggard)
+    check(flags & ABSOLUTE and matches(laggard.channels[0]["points"], points),
+          "the viewer that caught up was sent the absolute values")
+
+    viewer.close()
+    laggard.close()
+    return 1 if failures else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
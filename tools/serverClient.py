@@ -0,0 +1,147 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2026 Michael G. Katzmann
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Exercise the requests of the local server (hp8753 --server / --server-port).
+
+    tools/serverClient.py [--port <port>] [--recall <profile>] [--clients <n>]
+
+Connects to $XDG_RUNTIME_DIR/hp8753.socket (or the TCP port on localhost) and
+checks the replies to status, capture, marker, recall and quit. Several clients
+then ask for a capture at the same moment; they must all be answered from the
+same capture. Finally a request longer than the limit must be refused and the
+connection closed. The HP8753 must be connected and displaying a trace.
+Exits 0 if all the checks pass.
+"""
+
+import argparse
+import os
+import socket
+import sys
+import threading
+import time
+
+MAX_REQUEST_LENGTH = 1024       # as src/socketServer.c
+
+failures = 0
+
+
+def check(bOK, sWhat):
+    global failures
+    print(("ok      " if bOK else "FAILED  ") + sWhat)
+    if not bOK:
+        failures += 1
+
+
+class Client:
+    def __init__(self, args):
+        if args.port:
+            self.sock = socket.create_connection(("127.0.0.1", args.port))
+        else:
+            self.sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+            self.sock.connect(os.path.join(os.environ.get("XDG_RUNTIME_DIR", "/tmp"), "hp8753.socket"))
+        self.sock.settimeout(args.timeout)
+        self.file = self.sock.makefile("rb")
+
+    def send(self, sRequest):
+        self.sock.sendall(sRequest.encode() + b"\n")
+
+    def line(self):
+        return self.file.readline().decode().rstrip("\r\n")
+
+    def request(self, sRequest):
+        """Send a request and return the reply (the first line and any point lines)."""
+        self.send(sRequest)
+        sReply = self.line()
+        points = []
+        if sRequest.startswith("capture") and sReply.startswith("OK "):
+            for _ in range(int(sReply.split()[1])):
+                points.append(self.line())
+        return sReply, points
+
+    def close(self):
+        self.file.close()
+        self.sock.close()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--port", type=int, default=0, help="TCP port (default: the Unix socket)")
+    parser.add_argument("--recall", metavar="PROFILE", help="setup/calibration profile to recall")
+    parser.add_argument("--clients", type=int, default=4, help="clients capturing at once")
+    parser.add_argument("--timeout", type=float, default=60.0, help="seconds to wait for a reply")
+    args = parser.parse_args()
+
+    client = Client(args)
+
+    sReply, _ = client.request("status")
+    check(sReply.startswith("OK "), "status: " + sReply)
+
+    sReply, points = client.request("capture 1")
+    nPoints = int(sReply.split()[1]) if sReply.startswith("OK ") else 0
+    check(sReply.startswith("OK ") and len(points) == nPoints
+          and all(len(p.split("\t")) == 3 for p in points), "capture 1: %s (%d lines)" % (sReply, len(points)))
+
+    sReply, _ = client.request("marker 1 1")
+    check(sReply.startswith("OK ") or sReply == "ERR marker is off", "marker 1 1: " + sReply)
+    sReply, _ = client.request("marker 9")
+    check(sReply.startswith("ERR "), "marker 9: " + sReply)
+    sReply, _ = client.request("bogus")
+    check(sReply == "ERR unknown request", "bogus: " + sReply)
+
+    if args.recall:
+        sReply, _ = client.request("recall " + args.recall)
+        check(sReply == "OK", "recall %s: %s" % (args.recall, sReply))
+
+    # concurrent captures are answered from one capture
+    time.sleep(1.5)         # the last capture is no longer fresh (FRESH_CAPTURE_ms)
+    clients = [Client(args) for _ in range(args.clients)]
+    replies = [None] * len(clients)
+    start = threading.Barrier(len(clients))
+
+    def capture(i):
+        start.wait()
+        replies[i] = clients[i].request("capture 1")
+
+    threads = [threading.Thread(target=capture, args=(i,)) for i in range(len(clients))]
+    for t in threads:
+        t.start()
+    time.sleep(0.1)
+    sReply, _ = client.request("status")
+    waiting = int(sReply.split()[2]) if sReply.startswith("OK ") else -1
+    for t in threads:
+        t.join()
+    check(all(r is not None and r[0].startswith("OK ") for r in replies),
+          "%d concurrent captures answered (%d were waiting)" % (len(clients), waiting))
+    check(all(r == replies[0] for r in replies), "concurrent captures answered from the same capture")
+    for c in clients:
+        c.close()
+
+    # a request that is too long is refused and the connection closed
+    greedy = Client(args)
+    greedy.sock.sendall(b"x" * (MAX_REQUEST_LENGTH + 1))
+    sReply = greedy.line()
+    check(sReply == "ERR request too long" and greedy.line() == "", "long request: " + sReply)
+    greedy.close()
+
+    sReply, _ = client.request("quit")
+    check(sReply == "OK" and client.line() == "", "quit: " + sReply)
+    client.close()
+
+    return 1 if failures else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())